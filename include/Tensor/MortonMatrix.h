@@ -0,0 +1,323 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstdint>
+#include <vector>
+#include "Tensor/Tensor.h"
+#include "Tensor/TensorGemm.h"
+#include "Tensor/TensorParallel.h"
+#include "Tensor/TensorStrassen.h"
+
+/**
+ * @brief Matrix stored as square tiles laid out in Morton (Z) order, for recursive algorithms
+ * The tiles form a grid of 2^levels x 2^levels, each tile is row-major and the tiles follow each other in Z order:
+ * top-left, top-right, bottom-left, bottom-right quadrant, recursively. Every quadrant at every level of a recursion
+ * is therefore one contiguous range, and splitting a matrix costs nothing. Rows and columns beyond the matrix are
+ * zero, so rectangular matrices pay for the square grid that covers their larger side.
+ */
+template <typename T>
+class MortonMatrix {
+private:
+    uint32_t _rows;
+    uint32_t _cols;
+    uint32_t _tile;
+    uint32_t _levels;
+    std::vector<T, DefaultInitAllocator<T>> _data;
+
+    // Spreads the bits of value apart so that two spread values interleave into a Morton index
+    static uint64_t spreadBits(uint32_t value){
+        uint64_t x = value;
+        x = (x | (x << 16)) & 0x0000FFFF0000FFFFull;
+        x = (x | (x << 8)) & 0x00FF00FF00FF00FFull;
+        x = (x | (x << 4)) & 0x0F0F0F0F0F0F0F0Full;
+        x = (x | (x << 2)) & 0x3333333333333333ull;
+        x = (x | (x << 1)) & 0x5555555555555555ull;
+        return x;
+    }
+
+    /**
+     * @brief Calls fn(tile, firstRow, firstCol, rows, cols) for every tile, tiles spread over the thread pool
+     * rows and cols count the part of the tile inside the matrix, zero for a tile made only of padding.
+     */
+    template <typename Fn>
+    void forEachTile(Fn&& fn) const {
+        uint64_t tiles = static_cast<uint64_t>(side()) * side();
+        uint64_t minTiles = std::max<uint64_t>(1, TensorParallel::ElementwiseChunk / tileSize());
+        TensorParallel::parallelFor(0, tiles, minTiles, [&](uint64_t begin, uint64_t end) {
+            for (uint64_t t = begin; t < end; t++){
+                uint32_t tileRow = static_cast<uint32_t>(t / side());
+                uint32_t tileCol = static_cast<uint32_t>(t % side());
+                uint32_t firstRow = tileRow * _tile;
+                uint32_t firstCol = tileCol * _tile;
+                uint32_t rows = firstRow < _rows ? std::min(_tile, _rows - firstRow) : 0;
+                uint32_t cols = firstCol < _cols ? std::min(_tile, _cols - firstCol) : 0;
+                fn(index(tileRow, tileCol) * tileSize(), firstRow, firstCol, rows, cols);
+            }
+        });
+    }
+
+public:
+    // Side of a tile when none is given, a float tile then fills 16 KB
+    static constexpr uint32_t DefaultTile = 64;
+
+    // Smallest number of levels whose grid of tiles covers extent rows and columns
+    static uint32_t levelsFor(uint32_t extent, uint32_t tile){
+        uint32_t levels = 0;
+        while ((static_cast<uint64_t>(tile) << levels) < extent)
+            levels++;
+        return levels;
+    }
+
+    // Position of tile (tileRow, tileCol) in Z order
+    static uint64_t index(uint32_t tileRow, uint32_t tileCol){
+        return (spreadBits(tileRow) << 1) | spreadBits(tileCol);
+    }
+
+    /**
+     * @brief Zero matrix of the given shape
+     *
+     * @param levels Levels of the tile grid, at least levelsFor(max(rows, cols), tile). Operands of a product need the same.
+     */
+    MortonMatrix(uint32_t rows, uint32_t cols, uint32_t tile, uint32_t levels)
+        : _rows(rows), _cols(cols), _tile(tile), _levels(levels) {
+        assert(tile > 0 && "Tile size must be positive");
+        assert(levels >= levelsFor(std::max(rows, cols), tile) && "The tile grid does not cover the matrix");
+        _data.assign(static_cast<uint64_t>(side()) * side() * tileSize(), T(0));
+    }
+
+    MortonMatrix(uint32_t rows, uint32_t cols, uint32_t tile = DefaultTile)
+        : MortonMatrix(rows, cols, tile, levelsFor(std::max(rows, cols), tile)) {}
+
+    /**
+     * @brief Converts a row-major matrix, tiles are copied in parallel and padded with zeros
+     *
+     * @param levels Levels of the tile grid, 0 picks the smallest that covers the matrix
+     */
+    explicit MortonMatrix(const Tensor<T, 2>& matrix, uint32_t tile = DefaultTile, uint32_t levels = 0)
+        : _rows(matrix.getDimensions()[0]), _cols(matrix.getDimensions()[1]), _tile(tile) {
+        assert(tile > 0 && "Tile size must be positive");
+        _levels = std::max(levels, levelsFor(std::max(_rows, _cols), tile));
+        assert((levels == 0 || levels == _levels) && "The tile grid does not cover the matrix");
+        _data.resize(static_cast<uint64_t>(side()) * side() * tileSize());
+        const T* source = matrix.Data.data();
+        forEachTile([&](uint64_t offset, uint32_t firstRow, uint32_t firstCol, uint32_t rows, uint32_t cols) {
+            T* tile = _data.data() + offset;
+            for (uint32_t r = 0; r < rows; r++){
+                const T* line = source + (static_cast<uint64_t>(firstRow) + r) * _cols + firstCol;
+                std::copy(line, line + cols, tile + r * _tile);
+                std::fill(tile + r * _tile + cols, tile + (r + 1) * _tile, T(0));
+            }
+            std::fill(tile + static_cast<uint64_t>(rows) * _tile, tile + tileSize(), T(0));
+        });
+    }
+
+    // Converts back to a row-major matrix
+    Tensor<T, 2> toTensor() const {
+        std::array<uint32_t, 2> dims = {_rows, _cols};
+        Tensor<T, 2> result(dims, TensorUninitialized);
+        T* destination = result.Data.data();
+        forEachTile([&](uint64_t offset, uint32_t firstRow, uint32_t firstCol, uint32_t rows, uint32_t cols) {
+            const T* tile = _data.data() + offset;
+            for (uint32_t r = 0; r < rows; r++)
+                std::copy(tile + r * _tile, tile + r * _tile + cols, destination + (static_cast<uint64_t>(firstRow) + r) * _cols + firstCol);
+        });
+        return result;
+    }
+
+    uint32_t rows() const {
+        return _rows;
+    }
+
+    uint32_t cols() const {
+        return _cols;
+    }
+
+    uint32_t tile() const {
+        return _tile;
+    }
+
+    uint32_t levels() const {
+        return _levels;
+    }
+
+    // Tiles along each side of the grid
+    uint32_t side() const {
+        return 1u << _levels;
+    }
+
+    uint64_t tileSize() const {
+        return static_cast<uint64_t>(_tile) * _tile;
+    }
+
+    T* data() {
+        return _data.data();
+    }
+
+    const T* data() const {
+        return _data.data();
+    }
+
+    T& operator()(uint32_t row, uint32_t col){
+        assert(row < _rows && col < _cols && "Index out of bounds");
+        return _data[index(row / _tile, col / _tile) * tileSize() + (row % _tile) * _tile + col % _tile];
+    }
+
+    const T& operator()(uint32_t row, uint32_t col) const {
+        assert(row < _rows && col < _cols && "Index out of bounds");
+        return _data[index(row / _tile, col / _tile) * tileSize() + (row % _tile) * _tile + col % _tile];
+    }
+};
+
+namespace TensorMatmul {
+    // Algorithm a product of MortonMatrix operands runs
+    enum class MortonAlgorithm : uint8_t {
+        Recursive,  // Eight half-size products per level, quadrants of C in parallel
+        Strassen    // Seven half-size products per level, one shared workspace
+    };
+
+    namespace Morton {
+        /**
+         * @brief C = A * B, or C += A * B with accumulate, for square Morton blocks of 4^level tiles
+         * A C quadrant is the sum of two products, the first one overwrites it and the second one accumulates. Tiles go
+         * to the packed GEMM, which adds to C itself when accumulating.
+         */
+        template <typename T>
+        void multiply(const T* A, const T* B, T* C, uint32_t level, uint32_t tile, bool accumulate){
+            if (level == 0){
+                gemm(tile, tile, tile, A, tile, Transpose::No, B, tile, Transpose::No, C, tile, nullptr, false, accumulate);
+                return;
+            }
+            uint64_t quarter = (static_cast<uint64_t>(tile) * tile) << (2 * (level - 1));
+            for (uint32_t q = 0; q < 4; q++){
+                uint32_t i = q >> 1;
+                uint32_t j = q & 1;
+                multiply(A + (2 * i) * quarter, B + j * quarter, C + q * quarter, level - 1, tile, accumulate);
+                multiply(A + (2 * i + 1) * quarter, B + (2 + j) * quarter, C + q * quarter, level - 1, tile, true);
+            }
+        }
+
+        /**
+         * @brief Strassen product of square Morton blocks of 4^level tiles, see Strassen::multiply for the schedule
+         * Quadrants are contiguous, so the sums S and U, the product P and the quadrants of C are plain ranges.
+         */
+        template <typename T>
+        void strassen(const T* A, const T* B, T* C, uint32_t level, uint32_t tile, T* workspace){
+            if (level == 0){
+                gemm(tile, tile, tile, A, tile, Transpose::No, B, tile, Transpose::No, C, tile);
+                return;
+            }
+            uint64_t quarter = (static_cast<uint64_t>(tile) * tile) << (2 * (level - 1));
+            uint32_t rows = static_cast<uint32_t>(quarter / tile);
+            T* S = workspace;
+            T* U = S + quarter;
+            T* P = U + quarter;
+            T* below = P + quarter;
+            const T* A11 = A;
+            const T* A12 = A + quarter;
+            const T* A21 = A + 2 * quarter;
+            const T* A22 = A + 3 * quarter;
+            const T* B11 = B;
+            const T* B12 = B + quarter;
+            const T* B21 = B + 2 * quarter;
+            const T* B22 = B + 3 * quarter;
+            T* C11 = C;
+            T* C12 = C + quarter;
+            T* C21 = C + 2 * quarter;
+            T* C22 = C + 3 * quarter;
+
+            // A quarter is a rows x tile block without gaps, which is all combine needs
+            auto combine = [&](const T* X, const T* Y, T* Z, auto op) {
+                Strassen::combine(rows, tile, X, tile, Y, tile, Z, tile, op);
+            };
+            auto add = [](T x, T y) { return x + y; };
+            auto subtract = [](T x, T y) { return x - y; };
+            auto first = [](T x, T) { return x; };
+            auto product = [&](const T* X, const T* Y, T* Z) {
+                strassen(X, Y, Z, level - 1, tile, below);
+            };
+
+            combine(A11, A22, S, add);
+            combine(B11, B22, U, add);
+            product(S, U, C11);
+            combine(C11, C11, C22, first);
+            combine(A12, A22, S, subtract);
+            combine(B21, B22, U, add);
+            product(S, U, P);
+            combine(C11, P, C11, add);
+            combine(B21, B11, U, subtract);
+            product(A22, U, C21);
+            combine(C11, C21, C11, add);
+            combine(A11, A12, S, add);
+            product(S, B22, C12);
+            combine(C11, C12, C11, subtract);
+            combine(B12, B22, U, subtract);
+            product(A11, U, P);
+            combine(C12, P, C12, add);
+            combine(C22, P, C22, add);
+            combine(A21, A22, S, add);
+            product(S, B11, P);
+            combine(C21, P, C21, add);
+            combine(C22, P, C22, subtract);
+            combine(A21, A11, S, subtract);
+            combine(B11, B12, U, add);
+            product(S, U, P);
+            combine(C22, P, C22, add);
+        }
+    };
+
+    /**
+     * @brief Computes A * B natively on the Morton layout with the cache-oblivious recursive algorithm
+     * The four quadrants of C are independent and run in parallel, every tile product runs on the packed GEMM.
+     *
+     * @param A Left operand, M x N
+     * @param B Right operand, N x K with the tile size and levels of A
+     * @return The M x K product in the same layout
+     */
+    template <typename T>
+    MortonMatrix<T> matmul2d(const MortonMatrix<T>& A, const MortonMatrix<T>& B){
+        assert(A.cols() == B.rows() && "For 2D matrix multiplication matrices need to have shapes M*N and N*K");
+        assert(A.tile() == B.tile() && A.levels() == B.levels() && "Operands must share the tile size and the levels");
+        MortonMatrix<T> C(A.rows(), B.cols(), A.tile(), A.levels());
+        uint32_t level = A.levels();
+        if (level == 0){
+            Morton::multiply(A.data(), B.data(), C.data(), 0, A.tile(), false);
+            return C;
+        }
+        uint64_t quarter = A.tileSize() << (2 * (level - 1));
+        auto quadrant = [&](uint64_t q) {
+            uint64_t i = q >> 1;
+            uint64_t j = q & 1;
+            Morton::multiply(A.data() + (2 * i) * quarter, B.data() + j * quarter, C.data() + q * quarter, level - 1, A.tile(), false);
+            Morton::multiply(A.data() + (2 * i + 1) * quarter, B.data() + (2 + j) * quarter, C.data() + q * quarter, level - 1, A.tile(), true);
+        };
+        TensorParallel::pool().run(4, quadrant);
+        return C;
+    }
+
+    // Elements of workspace matmul2dStrassen needs on Morton operands: at most as many as one operand holds
+    template <typename T>
+    uint64_t strassenWorkspaceSize(const MortonMatrix<T>& A){
+        return A.levels() == 0 ? 0 : (A.tileSize() << (2 * A.levels())) - A.tileSize();
+    }
+
+    /**
+     * @brief Computes A * B with the Strassen algorithm natively on the Morton layout
+     * Quadrants are contiguous at every level, so nothing is copied to split the operands. The sums and products of all
+     * levels share one workspace of strassenWorkspaceSize(A) elements, and the tile products run on the packed GEMM.
+     *
+     * @param A Left operand, M x N
+     * @param B Right operand, N x K with the tile size and levels of A
+     * @return The M x K product in the same layout
+     */
+    template <typename T>
+    MortonMatrix<T> matmul2dStrassen(const MortonMatrix<T>& A, const MortonMatrix<T>& B){
+        assert(A.cols() == B.rows() && "For 2D matrix multiplication matrices need to have shapes M*N and N*K");
+        assert(A.tile() == B.tile() && A.levels() == B.levels() && "Operands must share the tile size and the levels");
+        MortonMatrix<T> C(A.rows(), B.cols(), A.tile(), A.levels());
+        std::vector<T, DefaultInitAllocator<T>> workspace(strassenWorkspaceSize(A));
+        Morton::strassen(A.data(), B.data(), C.data(), A.levels(), A.tile(), workspace.data());
+        return C;
+    }
+};
@@ -0,0 +1,158 @@
+#pragma once
+
+#include <array>
+#include <cassert>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+#include "Tensor/Tensor.h"
+#include "Tensor/TensorGemm.h"
+#include "Tensor/TensorMatmul.h"
+#include "Tensor/TensorParallel.h"
+
+namespace TensorMatmul {
+    // How a PackedMatrix keeps its values
+    enum class PackedStorage : uint8_t {
+        Native,     // The element type of the matrix
+        Half        // IEEE half precision, float matrices only. Halves the memory traffic, values beyond 65504 become infinite.
+    };
+
+    namespace Gemm {
+        // Rounds single-precision values to half precision, stored as raw 16-bit patterns
+        void convertToHalf(const float* src, uint16_t* dst, uint64_t size);
+        void convertFromHalf(const uint16_t* src, float* dst, uint64_t size);
+    };
+};
+
+/**
+ * @brief Right-hand operand of a matrix product packed once into the panel layout of the GEMM micro-kernel
+ * Weight matrices do not change between inferences, so packing them every call is wasted work. A PackedMatrix holds
+ * every KC x NC block of op(B) exactly as the GEMM driver would pack it, and matmul2d(A, packed) only packs A.
+ * The packing depends on Gemm::Blocking, a PackedMatrix is not meant to be stored across builds.
+ */
+template <typename T>
+class PackedMatrix {
+private:
+    using Block = TensorMatmul::Gemm::Blocking<T>;
+
+    uint32_t _rows;     // Depth of the product, rows of op(B)
+    uint32_t _cols;     // Columns of op(B) and of the product
+    TensorMatmul::PackedStorage _storage;
+    std::vector<uint64_t> _offsets;     // Start of each block, the blocks of a column range follow each other by depth
+    std::vector<T, DefaultInitAllocator<T>> _values;
+    std::vector<uint16_t, DefaultInitAllocator<uint16_t>> _half;
+
+    uint64_t depthBlocks() const {
+        return (_rows + Block::KC - 1) / Block::KC;
+    }
+
+public:
+    /**
+     * @param B Stored matrix: N x K when transB is No, K x N when it is Yes
+     * @param transB Whether op(B) is the transpose of B
+     * @param storage Native, or Half to keep a float matrix in half precision
+     */
+    explicit PackedMatrix(const Tensor<T, 2>& B, TensorMatmul::Transpose transB = TensorMatmul::Transpose::No,
+                          TensorMatmul::PackedStorage storage = TensorMatmul::PackedStorage::Native)
+        : _storage(storage) {
+        assert((storage == TensorMatmul::PackedStorage::Native || std::is_same_v<T, float>) && "Half storage needs a float matrix");
+        const auto& dims = B.getDimensions();
+        _rows = transB == TensorMatmul::Transpose::No ? dims[0] : dims[1];
+        _cols = transB == TensorMatmul::Transpose::No ? dims[1] : dims[0];
+
+        uint64_t total = 0;
+        for (uint32_t jc = 0; jc < _cols; jc += Block::NC){
+            uint32_t ncPadded = (std::min(Block::NC, _cols - jc) + Block::NR - 1) / Block::NR * Block::NR;
+            for (uint32_t pc = 0; pc < _rows; pc += Block::KC){
+                _offsets.push_back(total);
+                total += static_cast<uint64_t>(ncPadded) * std::min(Block::KC, _rows - pc);
+            }
+        }
+        _values.resize(total);
+
+        // Blocks are independent, the big ones of a large weight matrix are packed in parallel
+        uint64_t columnBlocks = (_cols + Block::NC - 1) / Block::NC;
+        uint64_t blocks = columnBlocks * depthBlocks();
+        TensorParallel::parallelFor(0, blocks, 1, [&](uint64_t begin, uint64_t end) {
+            for (uint64_t b = begin; b < end; b++){
+                uint32_t jc = static_cast<uint32_t>(b / depthBlocks()) * Block::NC;
+                uint32_t pc = static_cast<uint32_t>(b % depthBlocks()) * Block::KC;
+                TensorMatmul::Gemm::packB(B.Data.data(), dims[1], transB, pc, jc, std::min(Block::KC, _rows - pc),
+                                          std::min(Block::NC, _cols - jc), _values.data() + _offsets[b]);
+            }
+        });
+
+        if constexpr (std::is_same_v<T, float>){
+            if (storage == TensorMatmul::PackedStorage::Half){
+                _half.resize(total);
+                TensorMatmul::Gemm::convertToHalf(_values.data(), _half.data(), total);
+                _values = {};
+            }
+        }
+    }
+
+    uint32_t rows() const {
+        return _rows;
+    }
+
+    uint32_t cols() const {
+        return _cols;
+    }
+
+    TensorMatmul::PackedStorage storage() const {
+        return _storage;
+    }
+
+    // Memory taken by the packed values
+    uint64_t bytes() const {
+        return _values.size() * sizeof(T) + _half.size() * sizeof(uint16_t);
+    }
+
+    /**
+     * @brief Block of depth [p0, p0 + kc) and columns [j0, j0 + nc) in the layout of Gemm::packB, the packB of gemmWithPacking
+     * Half precision blocks are widened into buffer, native ones are returned where they are stored.
+     */
+    const T* block(uint64_t p0, uint64_t j0, uint32_t kc, uint32_t nc, T* buffer) const {
+        uint64_t index = j0 / Block::NC * depthBlocks() + p0 / Block::KC;
+        if constexpr (std::is_same_v<T, float>){
+            if (_storage == TensorMatmul::PackedStorage::Half){
+                uint64_t ncPadded = (nc + Block::NR - 1) / Block::NR * Block::NR;
+                TensorMatmul::Gemm::convertFromHalf(_half.data() + _offsets[index], buffer, ncPadded * kc);
+                return buffer;
+            }
+        }
+        return _values.data() + _offsets[index];
+    }
+};
+
+namespace TensorMatmul {
+    /**
+     * @brief Computes A * B for a pre-packed B, with an optional fused epilogue
+     * Only A is packed during the call.
+     *
+     * @param A Left operand, M x N
+     * @param B Packed right operand with N rows
+     * @param epilogue Optional bias, scale, residual and activation, see Epilogue
+     * @return The M x K product
+     */
+    template <typename T>
+    Tensor<T, 2> matmul2d(const Tensor<T, 2>& A, const PackedMatrix<T>& B, const Epilogue<T>* epilogue = nullptr) {
+        const auto& dimsA = A.getDimensions();
+        assert(dimsA[1] == B.rows() && "For 2D matrix multiplication matrices need to have shapes M*N and N*K");
+        std::array<uint32_t, 2> dims = {dimsA[0], B.cols()};
+        GemmEpilogue<T> gemmEpilogue = toGemmEpilogue(epilogue, dims);
+        Tensor<T, 2> result(dims, TensorUninitialized);
+        const T* a = A.Data.data();
+        uint64_t lda = dimsA[1];
+        gemmWithPacking(dims[0], dimsA[1], dims[1],
+            [=](uint64_t i0, uint64_t p0, uint32_t mc, uint32_t kc, T* packed) { Gemm::packA(a, lda, Transpose::No, i0, p0, mc, kc, packed); },
+            [&B](uint64_t p0, uint64_t j0, uint32_t kc, uint32_t nc, T* buffer) { return B.block(p0, j0, kc, nc, buffer); },
+            result.Data.data(), dims[1], epilogue ? &gemmEpilogue : nullptr);
+        return result;
+    }
+
+    template <typename T>
+    Tensor<T, 2> matmul2d(const Tensor<T, 2>& A, const PackedMatrix<T>& B, const Epilogue<T>& epilogue) {
+        return matmul2d(A, B, &epilogue);
+    }
+};
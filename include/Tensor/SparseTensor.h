@@ -0,0 +1,262 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+#include "Tensor/Tensor.h"
+#include "Tensor/TensorParallel.h"
+
+/**
+ * @brief Sparse matrix in block compressed sparse row (BSR) form
+ * The matrix is cut into blockRows x blockCols blocks and only blocks holding a nonzero are stored, each one as a dense
+ * row-major block. 1x1 blocks are plain CSR, 4x1 and 1x4 blocks match the width of a NEON register.
+ * Blocks on the bottom and right border may reach past the matrix, the part outside is stored as zeros.
+ */
+template <typename T>
+class SparseTensor {
+private:
+    std::array<uint32_t, 2> _dims;
+    uint32_t _blockRows;
+    uint32_t _blockCols;
+
+    static bool isKept(T value, T threshold) {
+        if constexpr (std::is_floating_point_v<T>)
+            return std::fabs(value) > threshold;
+        else
+            return value > threshold;
+    }
+
+public:
+    static_assert(std::is_floating_point_v<T> || std::is_unsigned_v<T>, "Tensors supports right nor only float");
+
+    std::vector<uint64_t> RowPointers;    // Block row r owns the stored blocks [RowPointers[r], RowPointers[r + 1])
+    std::vector<uint32_t> ColumnIndices;  // Block column of every stored block, increasing within a block row
+    std::vector<T> Values;                // blockRows * blockCols values per stored block
+
+    // Matrix without any stored block.
+    SparseTensor(const std::array<uint32_t, 2>& dims, uint32_t blockRows = 1, uint32_t blockCols = 1)
+        : _dims(dims), _blockRows(blockRows), _blockCols(blockCols) {
+        assert(blockRows > 0 && blockCols > 0 && "Sparse blocks must not be empty");
+        RowPointers.assign(blockRowCount() + 1, 0);
+    }
+
+    // Takes over arrays in BSR form, with 1x1 blocks these are the usual CSR arrays.
+    SparseTensor(const std::array<uint32_t, 2>& dims, std::vector<uint64_t> rowPointers, std::vector<uint32_t> columnIndices,
+                 std::vector<T> values, uint32_t blockRows = 1, uint32_t blockCols = 1)
+        : _dims(dims), _blockRows(blockRows), _blockCols(blockCols), RowPointers(std::move(rowPointers)),
+          ColumnIndices(std::move(columnIndices)), Values(std::move(values)) {
+        assert(blockRows > 0 && blockCols > 0 && "Sparse blocks must not be empty");
+        assert(RowPointers.size() == blockRowCount() + 1 && "Sparse tensor needs one row pointer per block row plus one");
+        assert(RowPointers.front() == 0 && RowPointers.back() == ColumnIndices.size() && "Row pointers must cover every stored block");
+        assert(Values.size() == ColumnIndices.size() * blockSize() && "Sparse tensor needs blockRows * blockCols values per block");
+        for (uint32_t column : ColumnIndices) {
+            assert(column < blockColCount() && "Sparse column index out of bounds");
+            (void)column;
+        }
+    }
+
+    /**
+     * @brief Sparse copy of a dense matrix keeping the elements whose magnitude is above threshold
+     * A block is stored when it keeps at least one element, the dropped elements inside it are stored as zeros.
+     */
+    static SparseTensor fromDense(const Tensor<T, 2>& dense, T threshold = T(0), uint32_t blockRows = 1, uint32_t blockCols = 1) {
+        SparseTensor sparse(dense.getDimensions(), blockRows, blockCols);
+        uint32_t rows = sparse._dims[0];
+        uint32_t cols = sparse._dims[1];
+        const T* data = dense.Data.data();
+        for (uint32_t br = 0; br < sparse.blockRowCount(); br++) {
+            for (uint32_t bc = 0; bc < sparse.blockColCount(); bc++) {
+                uint32_t rowEnd = std::min(rows, (br + 1) * blockRows);
+                uint32_t colEnd = std::min(cols, (bc + 1) * blockCols);
+                bool keep = false;
+                for (uint32_t i = br * blockRows; i < rowEnd && !keep; i++) {
+                    for (uint32_t j = bc * blockCols; j < colEnd && !keep; j++)
+                        keep = isKept(data[static_cast<uint64_t>(i) * cols + j], threshold);
+                }
+                if (!keep)
+                    continue;
+                uint64_t offset = sparse.Values.size();
+                sparse.Values.resize(offset + sparse.blockSize(), T(0));
+                for (uint32_t i = br * blockRows; i < rowEnd; i++) {
+                    for (uint32_t j = bc * blockCols; j < colEnd; j++) {
+                        T value = data[static_cast<uint64_t>(i) * cols + j];
+                        if (isKept(value, threshold))
+                            sparse.Values[offset + (i - br * blockRows) * blockCols + (j - bc * blockCols)] = value;
+                    }
+                }
+                sparse.ColumnIndices.push_back(bc);
+            }
+            sparse.RowPointers[br + 1] = sparse.ColumnIndices.size();
+        }
+        return sparse;
+    }
+
+    Tensor<T, 2> toDense() const {
+        Tensor<T, 2> dense(_dims);
+        uint32_t cols = _dims[1];
+        for (uint32_t br = 0; br < blockRowCount(); br++) {
+            for (uint64_t block = RowPointers[br]; block < RowPointers[br + 1]; block++) {
+                const T* values = Values.data() + block * blockSize();
+                uint32_t bc = ColumnIndices[block];
+                uint32_t rowEnd = std::min(_dims[0], (br + 1) * _blockRows);
+                uint32_t colEnd = std::min(cols, (bc + 1) * _blockCols);
+                for (uint32_t i = br * _blockRows; i < rowEnd; i++) {
+                    for (uint32_t j = bc * _blockCols; j < colEnd; j++)
+                        dense.Data[static_cast<uint64_t>(i) * cols + j] = values[(i - br * _blockRows) * _blockCols + (j - bc * _blockCols)];
+                }
+            }
+        }
+        return dense;
+    }
+
+    const std::array<uint32_t, 2>& getDimensions() const {
+        return _dims;
+    }
+
+    uint32_t blockRows() const { return _blockRows; }
+    uint32_t blockCols() const { return _blockCols; }
+    uint32_t blockSize() const { return _blockRows * _blockCols; }
+    uint32_t blockRowCount() const { return (_dims[0] + _blockRows - 1) / _blockRows; }
+    uint32_t blockColCount() const { return (_dims[1] + _blockCols - 1) / _blockCols; }
+    uint64_t blockCount() const { return ColumnIndices.size(); }
+    // Stored values, including the explicit zeros inside blocks
+    uint64_t storedValues() const { return Values.size(); }
+};
+
+namespace TensorSparse {
+    // Multiply-adds, stored values times dense columns, below which a sparse kernel is not worth giving its own thread
+    constexpr uint64_t ParallelValues = 1 << 15;
+
+    /**
+     * @brief Splits the block rows into ranges holding about the same number of stored values and runs fn(rowBegin, rowEnd) on them in parallel
+     * Balancing on values instead of rows keeps the threads even when a few rows are much denser than the rest.
+     *
+     * @param columns Dense columns every stored value is multiplied with, 1 for a SpMV and K for a SpMM
+     */
+    template <typename T, typename Fn>
+    void forBlockRowRanges(const SparseTensor<T>& A, uint64_t columns, Fn&& fn) {
+        uint32_t blockRows = A.blockRowCount();
+        uint64_t blocks = A.blockCount();
+        uint64_t parts = std::min<uint64_t>(TensorParallel::workerCount(), A.storedValues() * columns / ParallelValues);
+        if (parts < 2) {
+            fn(0u, blockRows);
+            return;
+        }
+        const uint64_t* rowPointers = A.RowPointers.data();
+        TensorParallel::parallelFor(0, parts, 1, [&](uint64_t partBegin, uint64_t partEnd) {
+            // First block row whose blocks start at or after the part's share of the blocks
+            auto rowAt = [&](uint64_t part) {
+                if (part == parts)
+                    return blockRows;
+                uint64_t target = blocks * part / parts;
+                return static_cast<uint32_t>(std::lower_bound(rowPointers, rowPointers + blockRows, target) - rowPointers);
+            };
+            uint32_t rowBegin = rowAt(partBegin);
+            uint32_t rowEnd = rowAt(partEnd);
+            if (rowBegin < rowEnd)
+                fn(rowBegin, rowEnd);
+        });
+    }
+
+    // y = A x on block rows [rowBegin, rowEnd), scalar version for any block shape
+    template <typename T>
+    void spmvRows(const SparseTensor<T>& A, const T* x, T* y, uint32_t rowBegin, uint32_t rowEnd) {
+        uint32_t br = A.blockRows();
+        uint32_t bc = A.blockCols();
+        uint32_t rows = A.getDimensions()[0];
+        uint32_t cols = A.getDimensions()[1];
+        for (uint32_t blockRow = rowBegin; blockRow < rowEnd; blockRow++) {
+            uint32_t i0 = blockRow * br;
+            uint32_t height = std::min(br, rows - i0);
+            std::fill(y + i0, y + i0 + height, T(0));
+            for (uint64_t block = A.RowPointers[blockRow]; block < A.RowPointers[blockRow + 1]; block++) {
+                const T* values = A.Values.data() + block * A.blockSize();
+                uint32_t j0 = A.ColumnIndices[block] * bc;
+                uint32_t width = std::min(bc, cols - j0);
+                for (uint32_t i = 0; i < height; i++) {
+                    T sum = T(0);
+                    for (uint32_t j = 0; j < width; j++)
+                        sum += values[i * bc + j] * x[j0 + j];
+                    y[i0 + i] += sum;
+                }
+            }
+        }
+    }
+
+    // C = A B on block rows [rowBegin, rowEnd) for a dense B with K columns, scalar version for any block shape
+    template <typename T>
+    void spmmRows(const SparseTensor<T>& A, const T* B, uint32_t K, uint64_t ldb, T* C, uint64_t ldc, uint32_t rowBegin, uint32_t rowEnd) {
+        uint32_t br = A.blockRows();
+        uint32_t bc = A.blockCols();
+        uint32_t rows = A.getDimensions()[0];
+        uint32_t cols = A.getDimensions()[1];
+        for (uint32_t blockRow = rowBegin; blockRow < rowEnd; blockRow++) {
+            uint32_t i0 = blockRow * br;
+            uint32_t height = std::min(br, rows - i0);
+            for (uint32_t i = 0; i < height; i++)
+                std::fill(C + (i0 + i) * ldc, C + (i0 + i) * ldc + K, T(0));
+            for (uint64_t block = A.RowPointers[blockRow]; block < A.RowPointers[blockRow + 1]; block++) {
+                const T* values = A.Values.data() + block * A.blockSize();
+                uint32_t j0 = A.ColumnIndices[block] * bc;
+                uint32_t width = std::min(bc, cols - j0);
+                for (uint32_t i = 0; i < height; i++) {
+                    T* row = C + (i0 + i) * ldc;
+                    for (uint32_t j = 0; j < width; j++) {
+                        T a = values[i * bc + j];
+                        const T* rowB = B + (j0 + j) * ldb;
+                        for (uint32_t k = 0; k < K; k++)
+                            row[k] += a * rowB[k];
+                    }
+                }
+            }
+        }
+    }
+
+    /**
+     * @brief Sparse matrix times dense vector, y = A x
+     *
+     * @param x Dense vector with one value per column of A
+     * @param y Output with one value per row of A, overwritten
+     */
+    template <typename T>
+    void spmv(const SparseTensor<T>& A, const T* x, T* y) {
+        forBlockRowRanges(A, 1, [&](uint32_t rowBegin, uint32_t rowEnd) { spmvRows(A, x, y, rowBegin, rowEnd); });
+    }
+
+    // NEON kernels with dedicated paths for 1x1, 4x1 and 1x4 blocks
+    void spmv(const SparseTensor<float>& A, const float* x, float* y);
+
+    /**
+     * @brief Sparse matrix times dense matrix, C = A B
+     *
+     * @param B Dense row-major matrix with one row per column of A and K columns
+     * @param C Output with one row per row of A and K columns, overwritten
+     */
+    template <typename T>
+    void spmm(const SparseTensor<T>& A, const T* B, uint32_t K, uint64_t ldb, T* C, uint64_t ldc) {
+        forBlockRowRanges(A, K, [&](uint32_t rowBegin, uint32_t rowEnd) { spmmRows(A, B, K, ldb, C, ldc, rowBegin, rowEnd); });
+    }
+
+    void spmm(const SparseTensor<float>& A, const float* B, uint32_t K, uint64_t ldb, float* C, uint64_t ldc);
+
+    template <typename T>
+    Tensor<T, 1> matmul(const SparseTensor<T>& A, const Tensor<T, 1>& x) {
+        assert(A.getDimensions()[1] == x.getDimensions()[0] && "Vector needs one value per column of the sparse matrix");
+        Tensor<T, 1> y({A.getDimensions()[0]}, TensorUninitialized);
+        spmv(A, x.Data.data(), y.Data.data());
+        return y;
+    }
+
+    template <typename T>
+    Tensor<T, 2> matmul(const SparseTensor<T>& A, const Tensor<T, 2>& B) {
+        const auto& dimsB = B.getDimensions();
+        assert(A.getDimensions()[1] == dimsB[0] && "Matrices need to have shapes M*N and N*K");
+        Tensor<T, 2> C({A.getDimensions()[0], dimsB[1]}, TensorUninitialized);
+        spmm(A, B.Data.data(), dimsB[1], dimsB[1], C.Data.data(), dimsB[1]);
+        return C;
+    }
+};
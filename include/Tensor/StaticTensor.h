@@ -0,0 +1,369 @@
+#pragma once
+
+#include <algorithm>
+#include <arm_neon.h>
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <type_traits>
+#include "Tensor/Tensor.h"
+#include "Tensor/TensorView.h"
+
+/**
+ * @brief Tensor whose shape is fixed at compile time, for the small matrices of control and geometry code
+ * The elements live inline in the object, so creating one never allocates, and every loop bound is a constant
+ * the compiler unrolls completely. There are no runtime dimensions or strides and no dispatch on the size.
+ * Tensor and StaticTensor exchange data through TensorView.
+ */
+template <typename T, uint32_t... Dims>
+class StaticTensor {
+public:
+    static constexpr uint16_t Rank = sizeof...(Dims);
+    static constexpr uint64_t Size = (static_cast<uint64_t>(1) * ... * Dims);
+    static constexpr std::array<uint32_t, Rank> Dimensions = { Dims... };
+
+private:
+    static_assert(Rank > 0, "StaticTensor needs at least one dimension");
+    static_assert(Size > 0, "StaticTensor dimensions must not be zero");
+    static_assert(std::is_floating_point_v<T> || std::is_unsigned_v<T>, "Tensors supports right nor only float");
+
+    static constexpr std::array<uint64_t, Rank> computeStrides() {
+        std::array<uint64_t, Rank> strides{};
+        strides[Rank - 1] = 1;
+        for (int i = Rank - 2; i >= 0; i--) {
+            strides[i] = static_cast<uint64_t>(Dimensions[i + 1]) * strides[i + 1];
+        }
+        return strides;
+    }
+
+public:
+    static constexpr std::array<uint64_t, Rank> Strides = computeStrides();
+
+    alignas(16) std::array<T, Size> Data;  // Inline storage for elements.
+
+    // All elements are set to zero, like Tensor.
+    StaticTensor() : Data{} {}
+
+    // Leaves the elements indeterminate until written.
+    StaticTensor(TensorUninitializedTag) {}
+
+    // Elements in row-major order.
+    explicit StaticTensor(const std::array<T, Size>& values) : Data(values) {}
+
+    // Copies the elements of a view with the same shape, such as a Tensor.
+    explicit StaticTensor(TensorView<const T, Rank> view) {
+        assert(view.getDimensions() == Dimensions && "View must have the dimensions of the StaticTensor");
+        std::copy(view.data(), view.data() + Size, Data.begin());
+    }
+
+    template<typename... Index>
+    T& operator()(Index... indices) {
+        static_assert(sizeof...(indices) == Rank, "Wrong number of indices");
+        return Data[linearIndex(indices...)];
+    }
+
+    template<typename... Index>
+    const T& operator()(Index... indices) const {
+        static_assert(sizeof...(indices) == Rank, "Wrong number of indices");
+        return Data[linearIndex(indices...)];
+    }
+
+    template<typename... Index>
+    static uint64_t linearIndex(Index... indices) {
+        std::array<uint32_t, Rank> idx = { static_cast<uint32_t>(indices)... };
+        uint64_t linear = 0;
+        for (uint16_t i = 0; i < Rank; i++) {
+            assert(idx[i] < Dimensions[i] && "Index out of bounds");
+            linear += static_cast<uint64_t>(idx[i]) * Strides[i];
+        }
+        return linear;
+    }
+
+    void fillWithValues(T value) {
+        Data.fill(value);
+    }
+
+    static constexpr const std::array<uint32_t, Rank>& getDimensions() {
+        return Dimensions;
+    }
+
+    TensorView<T, Rank> view() {
+        return TensorView<T, Rank>(Data.data(), Dimensions);
+    }
+
+    TensorView<const T, Rank> view() const {
+        return TensorView<const T, Rank>(Data.data(), Dimensions);
+    }
+
+    // Copy into a heap-allocated Tensor of the same shape.
+    Tensor<T, Rank> toTensor() const {
+        Tensor<T, Rank> tensor(Dimensions, TensorUninitialized);
+        std::copy(Data.begin(), Data.end(), tensor.Data.begin());
+        return tensor;
+    }
+
+    StaticTensor operator+(const StaticTensor& other) const {
+        StaticTensor result(TensorUninitialized);
+        uint64_t i = 0;
+        if constexpr (std::is_same_v<T, float>) {
+            for (; i + 3 < Size; i += 4) {
+                vst1q_f32(&result.Data[i], vaddq_f32(vld1q_f32(&Data[i]), vld1q_f32(&other.Data[i])));
+            }
+        }
+        for (; i < Size; i++) {
+            result.Data[i] = Data[i] + other.Data[i];
+        }
+        return result;
+    }
+
+    StaticTensor operator-(const StaticTensor& other) const {
+        StaticTensor result(TensorUninitialized);
+        uint64_t i = 0;
+        if constexpr (std::is_same_v<T, float>) {
+            for (; i + 3 < Size; i += 4) {
+                vst1q_f32(&result.Data[i], vsubq_f32(vld1q_f32(&Data[i]), vld1q_f32(&other.Data[i])));
+            }
+        }
+        for (; i < Size; i++) {
+            result.Data[i] = Data[i] - other.Data[i];
+        }
+        return result;
+    }
+};
+
+namespace StaticOps {
+    namespace detail {
+        /**
+         * @brief C = A B for row-major float matrices of fixed size
+         * Every row of C is accumulated in registers as a sum of rows of B scaled by one element of A.
+         */
+        template <uint32_t M, uint32_t K, uint32_t P>
+        inline void matmulFloat(const float* A, const float* B, float* C) {
+            constexpr uint32_t Vectors = P / 4;
+            constexpr bool Pair = P % 4 >= 2;
+            for (uint32_t i = 0; i < M; i++) {
+                float32x4_t acc[Vectors > 0 ? Vectors : 1];
+                float32x2_t accPair = vdup_n_f32(0.0f);
+                float accLast = 0.0f;
+                for (uint32_t v = 0; v < Vectors; v++) {
+                    acc[v] = vdupq_n_f32(0.0f);
+                }
+                for (uint32_t k = 0; k < K; k++) {
+                    float a = A[i * K + k];
+                    const float* row = B + k * P;
+                    for (uint32_t v = 0; v < Vectors; v++) {
+                        acc[v] = vmlaq_n_f32(acc[v], vld1q_f32(row + 4 * v), a);
+                    }
+                    if constexpr (Pair) {
+                        accPair = vmla_n_f32(accPair, vld1_f32(row + 4 * Vectors), a);
+                    }
+                    if constexpr (P % 2 == 1) {
+                        accLast += a * row[P - 1];
+                    }
+                }
+                float* out = C + i * P;
+                for (uint32_t v = 0; v < Vectors; v++) {
+                    vst1q_f32(out + 4 * v, acc[v]);
+                }
+                if constexpr (Pair) {
+                    vst1_f32(out + 4 * Vectors, accPair);
+                }
+                if constexpr (P % 2 == 1) {
+                    out[P - 1] = accLast;
+                }
+            }
+        }
+
+        // Gauss-Jordan elimination with partial pivoting, replaces A with its inverse
+        template <typename T, uint32_t Size>
+        inline void invertGaussJordan(std::array<T, Size * Size>& A) {
+            std::array<T, Size * Size> inv{};
+            for (uint32_t i = 0; i < Size; i++) {
+                inv[i * Size + i] = T(1);
+            }
+            for (uint32_t col = 0; col < Size; col++) {
+                uint32_t pivot = col;
+                for (uint32_t r = col + 1; r < Size; r++) {
+                    if (std::fabs(A[r * Size + col]) > std::fabs(A[pivot * Size + col]))
+                        pivot = r;
+                }
+                assert(A[pivot * Size + col] != T(0) && "Matrix is singular");
+                if (pivot != col) {
+                    for (uint32_t c = 0; c < Size; c++) {
+                        std::swap(A[pivot * Size + c], A[col * Size + c]);
+                        std::swap(inv[pivot * Size + c], inv[col * Size + c]);
+                    }
+                }
+                T invPivot = T(1) / A[col * Size + col];
+                for (uint32_t c = 0; c < Size; c++) {
+                    A[col * Size + c] *= invPivot;
+                    inv[col * Size + c] *= invPivot;
+                }
+                for (uint32_t r = 0; r < Size; r++) {
+                    if (r == col)
+                        continue;
+                    T factor = A[r * Size + col];
+                    for (uint32_t c = 0; c < Size; c++) {
+                        A[r * Size + c] -= factor * A[col * Size + c];
+                        inv[r * Size + c] -= factor * inv[col * Size + c];
+                    }
+                }
+            }
+            A = inv;
+        }
+    };
+
+    /**
+     * @brief Matrix product of fixed-size matrices, the shapes are checked at compile time
+     */
+    template <typename T, uint32_t M, uint32_t K, uint32_t P>
+    StaticTensor<T, M, P> matmul(const StaticTensor<T, M, K>& A, const StaticTensor<T, K, P>& B) {
+        StaticTensor<T, M, P> C(TensorUninitialized);
+        if constexpr (std::is_same_v<T, float>) {
+            detail::matmulFloat<M, K, P>(A.Data.data(), B.Data.data(), C.Data.data());
+        } else {
+            C.fillWithValues(T(0));
+            for (uint32_t i = 0; i < M; i++) {
+                for (uint32_t k = 0; k < K; k++) {
+                    T a = A.Data[i * K + k];
+                    for (uint32_t j = 0; j < P; j++) {
+                        C.Data[i * P + j] += a * B.Data[k * P + j];
+                    }
+                }
+            }
+        }
+        return C;
+    }
+
+    template <typename T, uint32_t M, uint32_t P>
+    StaticTensor<T, P, M> transpose(const StaticTensor<T, M, P>& A) {
+        StaticTensor<T, P, M> result(TensorUninitialized);
+        if constexpr (std::is_same_v<T, float> && M == 4 && P == 4) {
+            // De-interleaving load of the 4x4 block yields its columns
+            float32x4x4_t columns = vld4q_f32(A.Data.data());
+            vst1q_f32(result.Data.data(), columns.val[0]);
+            vst1q_f32(result.Data.data() + 4, columns.val[1]);
+            vst1q_f32(result.Data.data() + 8, columns.val[2]);
+            vst1q_f32(result.Data.data() + 12, columns.val[3]);
+        } else {
+            for (uint32_t i = 0; i < M; i++) {
+                for (uint32_t j = 0; j < P; j++) {
+                    result.Data[j * M + i] = A.Data[i * P + j];
+                }
+            }
+        }
+        return result;
+    }
+
+    template <typename T, uint32_t Size>
+    T determinant(const StaticTensor<T, Size, Size>& A) {
+        static_assert(std::is_floating_point_v<T>, "Determinant needs a floating point type");
+        const auto& a = A.Data;
+        if constexpr (Size == 1) {
+            return a[0];
+        } else if constexpr (Size == 2) {
+            return a[0] * a[3] - a[1] * a[2];
+        } else if constexpr (Size == 3) {
+            return a[0] * (a[4] * a[8] - a[5] * a[7])
+                 - a[1] * (a[3] * a[8] - a[5] * a[6])
+                 + a[2] * (a[3] * a[7] - a[4] * a[6]);
+        } else {
+            // LU elimination with partial pivoting
+            std::array<T, Size * Size> lu = a;
+            T det = T(1);
+            for (uint32_t col = 0; col < Size; col++) {
+                uint32_t pivot = col;
+                for (uint32_t r = col + 1; r < Size; r++) {
+                    if (std::fabs(lu[r * Size + col]) > std::fabs(lu[pivot * Size + col]))
+                        pivot = r;
+                }
+                if (lu[pivot * Size + col] == T(0))
+                    return T(0);
+                if (pivot != col) {
+                    for (uint32_t c = 0; c < Size; c++) {
+                        std::swap(lu[pivot * Size + c], lu[col * Size + c]);
+                    }
+                    det = -det;
+                }
+                det *= lu[col * Size + col];
+                for (uint32_t r = col + 1; r < Size; r++) {
+                    T factor = lu[r * Size + col] / lu[col * Size + col];
+                    for (uint32_t c = col + 1; c < Size; c++) {
+                        lu[r * Size + c] -= factor * lu[col * Size + c];
+                    }
+                }
+            }
+            return det;
+        }
+    }
+
+    /**
+     * @brief Inverse of a fixed-size square matrix
+     * Sizes up to 4 use the closed-form adjugate, larger ones Gauss-Jordan elimination with partial pivoting.
+     */
+    template <typename T, uint32_t Size>
+    StaticTensor<T, Size, Size> inverse(const StaticTensor<T, Size, Size>& A) {
+        static_assert(std::is_floating_point_v<T>, "Inverse needs a floating point type");
+        StaticTensor<T, Size, Size> result(TensorUninitialized);
+        const auto& a = A.Data;
+        auto& b = result.Data;
+        if constexpr (Size <= 3) {
+            T det = determinant(A);
+            assert(det != T(0) && "Matrix is singular");
+            T invDet = T(1) / det;
+            if constexpr (Size == 1) {
+                b[0] = invDet;
+            } else if constexpr (Size == 2) {
+                b = { a[3] * invDet, -a[1] * invDet, -a[2] * invDet, a[0] * invDet };
+            } else {
+                b[0] = (a[4] * a[8] - a[5] * a[7]) * invDet;
+                b[1] = (a[2] * a[7] - a[1] * a[8]) * invDet;
+                b[2] = (a[1] * a[5] - a[2] * a[4]) * invDet;
+                b[3] = (a[5] * a[6] - a[3] * a[8]) * invDet;
+                b[4] = (a[0] * a[8] - a[2] * a[6]) * invDet;
+                b[5] = (a[2] * a[3] - a[0] * a[5]) * invDet;
+                b[6] = (a[3] * a[7] - a[4] * a[6]) * invDet;
+                b[7] = (a[1] * a[6] - a[0] * a[7]) * invDet;
+                b[8] = (a[0] * a[4] - a[1] * a[3]) * invDet;
+            }
+        } else if constexpr (Size == 4) {
+            // 2x2 minors of the top two rows (s) and the bottom two rows (c)
+            T s0 = a[0] * a[5] - a[4] * a[1];
+            T s1 = a[0] * a[6] - a[4] * a[2];
+            T s2 = a[0] * a[7] - a[4] * a[3];
+            T s3 = a[1] * a[6] - a[5] * a[2];
+            T s4 = a[1] * a[7] - a[5] * a[3];
+            T s5 = a[2] * a[7] - a[6] * a[3];
+            T c5 = a[10] * a[15] - a[14] * a[11];
+            T c4 = a[9] * a[15] - a[13] * a[11];
+            T c3 = a[9] * a[14] - a[13] * a[10];
+            T c2 = a[8] * a[15] - a[12] * a[11];
+            T c1 = a[8] * a[14] - a[12] * a[10];
+            T c0 = a[8] * a[13] - a[12] * a[9];
+            T det = s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0;
+            assert(det != T(0) && "Matrix is singular");
+            T invDet = T(1) / det;
+            b[0] = (a[5] * c5 - a[6] * c4 + a[7] * c3) * invDet;
+            b[1] = (-a[1] * c5 + a[2] * c4 - a[3] * c3) * invDet;
+            b[2] = (a[13] * s5 - a[14] * s4 + a[15] * s3) * invDet;
+            b[3] = (-a[9] * s5 + a[10] * s4 - a[11] * s3) * invDet;
+            b[4] = (-a[4] * c5 + a[6] * c2 - a[7] * c1) * invDet;
+            b[5] = (a[0] * c5 - a[2] * c2 + a[3] * c1) * invDet;
+            b[6] = (-a[12] * s5 + a[14] * s2 - a[15] * s1) * invDet;
+            b[7] = (a[8] * s5 - a[10] * s2 + a[11] * s1) * invDet;
+            b[8] = (a[4] * c4 - a[5] * c2 + a[7] * c0) * invDet;
+            b[9] = (-a[0] * c4 + a[1] * c2 - a[3] * c0) * invDet;
+            b[10] = (a[12] * s4 - a[13] * s2 + a[15] * s0) * invDet;
+            b[11] = (-a[8] * s4 + a[9] * s2 - a[11] * s0) * invDet;
+            b[12] = (-a[4] * c3 + a[5] * c1 - a[6] * c0) * invDet;
+            b[13] = (a[0] * c3 - a[1] * c1 + a[2] * c0) * invDet;
+            b[14] = (-a[12] * s3 + a[13] * s1 - a[14] * s0) * invDet;
+            b[15] = (a[8] * s3 - a[9] * s1 + a[10] * s0) * invDet;
+        } else {
+            b = a;
+            detail::invertGaussJordan<T, Size>(b);
+        }
+        return result;
+    }
+};
@@ -2,39 +2,259 @@
 #include <sys/types.h>
 #include <type_traits>
 #include <vector>
+#include <algorithm>
 #include <array>
 #include <cassert>
 #include <cstdint>
+#include <memory>
+#include <span>
+#include <utility>
 #include <arm_neon.h>
+#include "Tensor/TensorIterator.h"
+#include "Tensor/TensorParallel.h"
 
 #pragma once
 
+// Allocator that default-initializes elements, so resize() of a trivial type leaves the memory untouched.
+template <typename T>
+struct DefaultInitAllocator : std::allocator<T> {
+    template <typename U>
+    struct rebind { using other = DefaultInitAllocator<U>; };
+
+    DefaultInitAllocator() noexcept = default;
+    template <typename U>
+    DefaultInitAllocator(const DefaultInitAllocator<U>&) noexcept {}
+
+    template <typename U>
+    void construct(U* ptr) noexcept(std::is_nothrow_default_constructible_v<U>) {
+        ::new (static_cast<void*>(ptr)) U;
+    }
+    template <typename U, typename... Args>
+    void construct(U* ptr, Args&&... args) {
+        ::new (static_cast<void*>(ptr)) U(std::forward<Args>(args)...);
+    }
+};
+
+// Tag selecting the Tensor constructor that allocates without initializing the elements.
+// Only use it when every element is written before it is read.
+struct TensorUninitializedTag {
+    explicit TensorUninitializedTag() = default;
+};
+inline constexpr TensorUninitializedTag TensorUninitialized{};
+
 // A flexible N-dimensional tensor class.
 template <typename T, uint16_t N>
 class Tensor {
 private:
-    std::array<uint32_t, N> _strides;  // Strides for converting N indices into a linear index.
-    std::array<uint32_t, N> _dims;     // Dimensions of the tensor.
+    std::array<uint64_t, N> _strides;  // Strides for converting N indices into a linear index, 64-bit so tensors may exceed 2^32 elements.
+    std::array<uint32_t, N> _dims;     // Dimensions of the tensor, each axis stays below 2^32.
+
+    uint64_t totalSize() const {
+        uint64_t total = 1;
+        for (int i = 0; i < N; i++) {
+            total *= _dims[i];
+        }
+        return total;
+    }
 
     // Compute strides assuming row-major order.
     void computeStrides() {
         _strides[N - 1] = 1;
         for (int i = N - 2; i >= 0; i--) {
-            _strides[i] = _dims[i + 1] * _strides[i + 1];
+            _strides[i] = static_cast<uint64_t>(_dims[i + 1]) * _strides[i + 1];
+        }
+    }
+
+    static void fillRange(uint32_t* data, uint64_t size, uint32_t value){
+        uint64_t i = 0;
+        uint32x4_t vec1 = vdupq_n_u32(value);
+        for(; i + 3 < size; i+=4){
+            vst1q_u32(data + i, vec1);
+        }
+        for(;i < size; i++){
+            data[i] = value;
+        }
+    }
+
+    static void fillRange(uint16_t* data, uint64_t size, uint16_t value){
+        uint64_t i = 0;
+        uint16x8_t vec1 = vdupq_n_u16(value);
+        for(; i + 7 < size; i+=8){
+            vst1q_u16(data + i, vec1);
+        }
+        for(;i < size; i++){
+            data[i] = value;
+        }
+    }
+
+    static void fillRange(uint8_t* data, uint64_t size, uint8_t value){
+        uint64_t i = 0;
+        uint8x16_t vec1 = vdupq_n_u8(value);
+        for(; i + 15 < size; i+=16){
+            vst1q_u8(data + i, vec1);
+        }
+        for(;i < size; i++){
+            data[i] = value;
+        }
+    }
+
+    static void fillRange(float* data, uint64_t size, float value){
+        uint64_t i = 0;
+        float32x4_t vec1 = vdupq_n_f32(value);
+        for(; i + 3 < size; i+=4){
+            vst1q_f32(data + i, vec1);
+        }
+        for(;i < size; i++){
+            data[i] = value;
+        }
+    }
+
+    static void addRange(const uint32_t* a, const uint32_t* b, uint32_t* c, uint64_t size){
+        uint64_t i = 0;
+        for (; i + 3 < size; i += 4) {                  // Loop over in chunks of 4
+            vst1q_u32(c + i, vaddq_u32(vld1q_u32(a + i), vld1q_u32(b + i)));
+        }
+        for (; i < size; ++i) {                         // Handle remaining elements if the size is not a multiple of 4
+            c[i] = a[i] + b[i];
+        }
+    }
+
+    static void addRange(const uint16_t* a, const uint16_t* b, uint16_t* c, uint64_t size){
+        uint64_t i = 0;
+        for (; i + 7 < size; i += 8) {                  // Loop over in chunks of 8
+            vst1q_u16(c + i, vaddq_u16(vld1q_u16(a + i), vld1q_u16(b + i)));
+        }
+        for (; i < size; ++i) {                         // Handle remaining elements if the size is not a multiple of 8
+            c[i] = a[i] + b[i];
+        }
+    }
+
+    static void addRange(const uint8_t* a, const uint8_t* b, uint8_t* c, uint64_t size){
+        uint64_t i = 0;
+        for (; i + 15 < size; i += 16) {                // Loop over in chunks of 16
+            vst1q_u8(c + i, vaddq_u8(vld1q_u8(a + i), vld1q_u8(b + i)));
+        }
+        for (; i < size; ++i) {                         // Handle remaining elements if the size is not a multiple of 16
+            c[i] = a[i] + b[i];
+        }
+    }
+
+    static void addRange(const float* a, const float* b, float* c, uint64_t size){
+        uint64_t i = 0;
+        for (; i + 3 < size; i += 4) {                  // Loop over in chunks of 4
+            vst1q_f32(c + i, vaddq_f32(vld1q_f32(a + i), vld1q_f32(b + i)));
+        }
+        for (; i < size; ++i) {                         // Handle remaining elements if the size is not a multiple of 4
+            c[i] = a[i] + b[i];
+        }
+    }
+
+    static void subtractRange(const uint32_t* a, const uint32_t* b, uint32_t* c, uint64_t size){
+        uint64_t i = 0;
+        for (; i + 3 < size; i += 4) {
+            vst1q_u32(c + i, vsubq_u32(vld1q_u32(a + i), vld1q_u32(b + i)));
+        }
+        for (; i < size; ++i) {
+            c[i] = a[i] - b[i];
+        }
+    }
+
+    static void subtractRange(const uint16_t* a, const uint16_t* b, uint16_t* c, uint64_t size){
+        uint64_t i = 0;
+        for (; i + 7 < size; i += 8) {
+            vst1q_u16(c + i, vsubq_u16(vld1q_u16(a + i), vld1q_u16(b + i)));
+        }
+        for (; i < size; ++i) {
+            c[i] = a[i] - b[i];
+        }
+    }
+
+    static void subtractRange(const uint8_t* a, const uint8_t* b, uint8_t* c, uint64_t size){
+        uint64_t i = 0;
+        for (; i + 15 < size; i += 16) {
+            vst1q_u8(c + i, vsubq_u8(vld1q_u8(a + i), vld1q_u8(b + i)));
+        }
+        for (; i < size; ++i) {
+            c[i] = a[i] - b[i];
+        }
+    }
+
+    static void subtractRange(const float* a, const float* b, float* c, uint64_t size){
+        uint64_t i = 0;
+        for (; i + 3 < size; i += 4) {
+            vst1q_f32(c + i, vsubq_f32(vld1q_f32(a + i), vld1q_f32(b + i)));
+        }
+        for (; i < size; ++i) {
+            c[i] = a[i] - b[i];
+        }
+    }
+
+    // Fills Data in chunks spread over the thread pool when the tensor is large.
+    template <typename V>
+    void fillParallel(V value){
+        T* data = Data.data();
+        TensorParallel::parallelElementwise(Data.size(), [data, value](uint64_t begin, uint64_t end) {
+            fillRange(data + begin, end - begin, value);
+        });
+    }
+
+    // Result of kernel(a, b, c, size) applied chunk by chunk to this tensor and other, across threads for large tensors.
+    template <typename Kernel>
+    Tensor elementwise(const Tensor& other, Kernel kernel) const {
+        Tensor result(_dims, TensorUninitialized);
+        const T* a = Data.data();
+        const T* b = other.Data.data();
+        T* c = result.Data.data();
+        TensorParallel::parallelElementwise(Data.size(), [=](uint64_t begin, uint64_t end) {
+            kernel(a + begin, b + begin, c + begin, end - begin);
+        });
+        return result;
+    }
+
+    template<typename... Index>
+    uint64_t lineOffset(Index... leading) const {
+        static_assert(sizeof...(leading) + 1 == N, "A row takes every index but the last");
+        std::array<uint32_t, N - 1> idx = { static_cast<uint32_t>(leading)... };
+        uint64_t linear = 0;
+        for (uint16_t i = 0; i + 1 < N; i++) {
+            assert(idx[i] < _dims[i] && "Index out of bounds");
+            linear += static_cast<uint64_t>(idx[i]) * _strides[i];
+        }
+        return linear;
+    }
+
+    // Copies a rows x cols block between row-major buffers one contiguous row at a time.
+    static void copyBlock(const T* src, uint64_t srcStride, T* dst, uint64_t dstStride, uint32_t rows, uint32_t cols){
+        for (uint32_t i = 0; i < rows; i++){
+            std::copy(src + i * srcStride, src + i * srcStride + cols, dst + i * dstStride);
         }
     }
 
 public:
-    std::vector<T> Data;              // Flat storage for elements.
+    // Storage of Data. It is not a std::vector<T>: its allocator skips value-initialization, so an uninitialized tensor
+    // costs no write pass. Copy it out with std::vector<T>(Data.begin(), Data.end()), or pass flat() where a span will do.
+    using Storage = std::vector<T, DefaultInitAllocator<T>>;
+    Storage Data;  // Flat storage for elements.
     static_assert(std::is_floating_point_v<T> || std::is_unsigned_v<T>, "Tensors supports right nor only float");
     
-    // Constructor: pass an array with N dimensions.
-    Tensor(const std::array<uint32_t, N>& dims) : _dims(dims) {
-        uint64_t total = 1;
-        for (int i = 0; i < N; i++) {
-            total *= _dims[i];
-        }
-        Data.resize(total);
+    // Constructor: pass an array with N dimensions. All elements are set to zero.
+    // Large tensors are zeroed in chunks across the thread pool, so their pages are first touched by the worker threads.
+    Tensor(const std::array<uint32_t, N>& dims) : _dims(dims), Data(totalSize()) {
+        computeStrides();
+        T* data = Data.data();
+        TensorParallel::parallelElementwise(Data.size(), [data](uint64_t begin, uint64_t end) {
+            std::fill(data + begin, data + end, T(0));
+        });
+    }
+
+    // Constructor that only allocates: the elements hold indeterminate values until written.
+    Tensor(const std::array<uint32_t, N>& dims, TensorUninitializedTag) : _dims(dims), Data(totalSize()) {
+        computeStrides();
+    }
+
+    // Constructor that takes over existing storage, which must hold exactly the elements of dims.
+    Tensor(const std::array<uint32_t, N>& dims, Storage&& data) : _dims(dims), Data(std::move(data)) {
+        assert(Data.size() == totalSize() && "Data must hold every element of the dimensions");
         computeStrides();
     }
 
@@ -46,7 +266,7 @@ public:
         uint64_t linear = 0;
         for (uint16_t i = 0; i < N; i++) {
             assert(idx[i] < _dims[i] && "Index out of bounds");
-            linear += idx[i] * _strides[i];
+            linear += static_cast<uint64_t>(idx[i]) * _strides[i];
         }
         return Data[linear];
     }
@@ -58,153 +278,117 @@ public:
         uint64_t linear = 0;
         for (uint16_t i = 0; i < N; i++) {
             assert(idx[i] < _dims[i] && "Index out of bounds");
-            linear += idx[i] * _strides[i];
+            linear += static_cast<uint64_t>(idx[i]) * _strides[i];
         }
         return Data[linear];
     }
 
 
     void fillWithValues(uint32_t value){
-        int i = 0;
-        for(; i + 3 < Data.size(); i+=4){
-            uint32x4_t vec1 = vdupq_n_u32(value);
-            vst1q_u32(&Data[i], vec1);
-        }
-        for(;i < Data.size(); i++){
-            Data[i] = value;
-        }
+        fillParallel(value);
     }
 
     void fillWithValues(uint16_t value){
-        int i = 0;
-        for(; i + 7 < Data.size(); i+=8){
-            uint16x8_t vec1 = vdupq_n_u16(value);
-            vst1q_u16(&Data[i], vec1);
-        }
-        for(;i < Data.size(); i++){
-            Data[i] = value;
-        }
+        fillParallel(value);
     }
 
-
     void fillWithValues(uint8_t value){
-        int i = 0;
-        for(; i + 7 < Data.size(); i+=8){
-            uint8x16_t vec1 = vdupq_n_u8(value);
-            vst1q_u8(&Data[i], vec1);
-        }
-        for(;i < Data.size(); i++){
-            Data[i] = value;
-        }
+        fillParallel(value);
     }
 
-
     void fillWithValues(float value){
-        int i = 0;
-        for(; i + 3 < Data.size(); i+=4){
-            float32x4_t vec1 = vdupq_n_f32(value);
-            vst1q_f32(&Data[i], vec1);
-        }
-
-        for(;i < Data.size(); i++){
-            Data[i] = value;
-        }
+        fillParallel(value);
     }
     
     const std::array<uint32_t, N>& getDimensions() const{
         return _dims;
     }
 
+    const std::array<uint64_t, N>& getStrides() const{
+        return _strides;
+    }
+
+    // The elements in storage order, for loops that do not need the indices.
+    std::span<T> flat(){
+        return std::span<T>(Data.data(), Data.size());
+    }
+
+    std::span<const T> flat() const{
+        return std::span<const T>(Data.data(), Data.size());
+    }
+
+    // Pointer to the innermost line at the given leading indices, row(i) of a matrix is its i-th row.
+    // The line holds getDimensions()[N - 1] contiguous elements.
+    template<typename... Index>
+    T* row(Index... leading){
+        return Data.data() + lineOffset(leading...);
+    }
+
+    template<typename... Index>
+    const T* row(Index... leading) const{
+        return Data.data() + lineOffset(leading...);
+    }
+
     Tensor<T, 2> LeftTopPart() const{
         uint32_t M_m = this->_dims[0]/2;
         uint32_t N_m = this->_dims[1]/2;
         std::array<uint32_t, 2> dims = {M_m, N_m};
-        Tensor<T, 2> leftTopPart(dims);
-        for (int i = 0; i < M_m; i++){
-            for (int j = 0; j < N_m; j++){
-                leftTopPart(i, j) = Data[i * this->_dims[1] + j];
-            }
-        }
+        Tensor<T, 2> leftTopPart(dims, TensorUninitialized);
+        copyBlock(Data.data(), this->_dims[1], leftTopPart.Data.data(), N_m, M_m, N_m);
         return leftTopPart;
     }
 
     void FillLeftTopPart(Tensor<T, 2> leftTopPart){
         uint32_t M_m = leftTopPart.getDimensions()[0];
         uint32_t N_m = leftTopPart.getDimensions()[1];
-        for (int i = 0; i < M_m; i++){
-            for (int j = 0; j < N_m; j++){
-                Data[i * this->_dims[1] + j] = leftTopPart(i, j);
-            }
-        }
+        copyBlock(leftTopPart.Data.data(), N_m, Data.data(), this->_dims[1], M_m, N_m);
     }
 
     Tensor<T, 2> RightTopPart() const {
         uint32_t M_m = this->_dims[0]/2;
         uint32_t N_m = this->_dims[1] - this->_dims[1]/2;
         std::array<uint32_t, 2> dims = {M_m, N_m};
-        Tensor<T, 2> rightTopPart(dims);
-        for (int i = 0; i < M_m; i++){
-            for (int j = 0; j < N_m; j++){
-                rightTopPart(i, j) = Data[i * this->_dims[1] + j + this->_dims[1]/2];
-            }
-        }
+        Tensor<T, 2> rightTopPart(dims, TensorUninitialized);
+        copyBlock(Data.data() + this->_dims[1]/2, this->_dims[1], rightTopPart.Data.data(), N_m, M_m, N_m);
         return rightTopPart;
     }
 
     void FillRightTopPart(Tensor<T, 2> rightTopPart){
         uint32_t M_m = rightTopPart.getDimensions()[0];
         uint32_t N_m = rightTopPart.getDimensions()[1];
-        for (int i = 0; i < M_m; i++){
-            for (int j = 0; j < N_m; j++){
-                Data[i * this->_dims[1] + j + this->_dims[1]/2] = rightTopPart(i, j);
-            }
-        }
+        copyBlock(rightTopPart.Data.data(), N_m, Data.data() + this->_dims[1]/2, this->_dims[1], M_m, N_m);
     }
 
     Tensor<T, 2> LeftBottomPart() const {
         uint32_t M_m = this->_dims[0] - this->_dims[0]/2;
         uint32_t N_m = this->_dims[1]/2;
         std::array<uint32_t, 2> dims = {M_m, N_m};
-        Tensor<T, 2> leftBottomPart(dims);
-        for (int i = 0; i < M_m; i++){
-            for (int j = 0; j < N_m; j++){
-                leftBottomPart(i, j) = Data[(i + this->_dims[0]/2) * this->_dims[1] + j];
-            }
-        }
+        Tensor<T, 2> leftBottomPart(dims, TensorUninitialized);
+        copyBlock(Data.data() + static_cast<uint64_t>(this->_dims[0]/2) * this->_dims[1], this->_dims[1], leftBottomPart.Data.data(), N_m, M_m, N_m);
         return leftBottomPart;
     }
 
     void FillLeftBottomPart(Tensor<T, 2> leftBottomPart){
         uint32_t M_m = leftBottomPart.getDimensions()[0];
         uint32_t N_m = leftBottomPart.getDimensions()[1];
-        for (int i = 0; i < M_m; i++){
-            for (int j = 0; j < N_m; j++){
-                Data[(i + this->_dims[0]/2) * this->_dims[1] + j] = leftBottomPart(i, j);
-            }
-        }
+        copyBlock(leftBottomPart.Data.data(), N_m, Data.data() + static_cast<uint64_t>(this->_dims[0]/2) * this->_dims[1], this->_dims[1], M_m, N_m);
     }
 
     Tensor<T, 2> RightBottomPart() const {
         uint32_t M_m = this->_dims[0] - this->_dims[0]/2;
         uint32_t N_m = this->_dims[1] - this->_dims[1]/2;
         std::array<uint32_t, 2> dims = {M_m, N_m};
-        Tensor<T, 2> rightBottomPart(dims);
-        for (int i = 0; i < M_m; i++){
-            for (int j = 0; j < N_m; j++){
-                rightBottomPart(i, j) = Data[(i + this->_dims[0]/2) * this->_dims[1] + j + this->_dims[1]/2];
-            }
-        }
+        Tensor<T, 2> rightBottomPart(dims, TensorUninitialized);
+        const T* corner = Data.data() + static_cast<uint64_t>(this->_dims[0]/2) * this->_dims[1] + this->_dims[1]/2;
+        copyBlock(corner, this->_dims[1], rightBottomPart.Data.data(), N_m, M_m, N_m);
         return rightBottomPart;
     }
 
     void FillRightBottomPart(Tensor<T, 2> rightBottomPart){
         uint32_t M_m = rightBottomPart.getDimensions()[0];
         uint32_t N_m = rightBottomPart.getDimensions()[1];
-        for (int i = 0; i < M_m; i++){
-            for (int j = 0; j < N_m; j++){
-                Data[(i + this->_dims[0]/2) * this->_dims[1] + j + this->_dims[1]/2] = rightBottomPart(i, j);
-            }
-        }
+        T* corner = Data.data() + static_cast<uint64_t>(this->_dims[0]/2) * this->_dims[1] + this->_dims[1]/2;
+        copyBlock(rightBottomPart.Data.data(), N_m, corner, this->_dims[1], M_m, N_m);
     }
 
     Tensor<T, 2> ExtendToDivisibleBy2(){
@@ -217,161 +401,80 @@ public:
         uint32_t N_m_new = N_m % 2 == 0 ? N_m : N_m + 1;
         std::array<uint32_t, 2> dims = {M_m_new, N_m_new};
         Tensor<T, 2> extendedTensor(dims);
-        for (int i = 0; i < M_m; i++){
-            for (int j = 0; j < N_m; j++){
-                extendedTensor(i, j) = Data[i * this->_dims[1] + j];
-            }
-        }
+        copyBlock(Data.data(), N_m, extendedTensor.Data.data(), N_m_new, M_m, N_m);
         return extendedTensor;
     }
 
     Tensor<T, 2> CutToDimensions(uint32_t M_m, uint32_t N_m){
         std::array<uint32_t, 2> dims = {M_m, N_m};
-        Tensor<T, 2> cutTensor(dims);
-        for (int i = 0; i < M_m; i++){
-            for (int j = 0; j < N_m; j++){
-                cutTensor(i, j) = Data[i * this->_dims[1] + j];
-            }
-        }
+        Tensor<T, 2> cutTensor(dims, TensorUninitialized);
+        copyBlock(Data.data(), this->_dims[1], cutTensor.Data.data(), N_m, M_m, N_m);
         return cutTensor;
     }
 
 
+    // Copy of the rows x cols block whose top left element is (row, col).
+    Tensor<T, 2> SubMatrix(uint32_t row, uint32_t col, uint32_t rows, uint32_t cols) const {
+        assert(row + rows <= this->_dims[0] && col + cols <= this->_dims[1] && "Block out of bounds");
+        std::array<uint32_t, 2> dims = {rows, cols};
+        Tensor<T, 2> block(dims, TensorUninitialized);
+        copyBlock(Data.data() + static_cast<uint64_t>(row) * this->_dims[1] + col, this->_dims[1], block.Data.data(), cols, rows, cols);
+        return block;
+    }
+
+    // Writes block into this matrix with its top left element at (row, col).
+    void FillSubMatrix(uint32_t row, uint32_t col, const Tensor<T, 2>& block){
+        uint32_t rows = block.getDimensions()[0];
+        uint32_t cols = block.getDimensions()[1];
+        assert(row + rows <= this->_dims[0] && col + cols <= this->_dims[1] && "Block out of bounds");
+        copyBlock(block.Data.data(), cols, Data.data() + static_cast<uint64_t>(row) * this->_dims[1] + col, this->_dims[1], rows, cols);
+    }
+
     Tensor<uint32_t, N> operator+(const Tensor<uint32_t, N>& other) const {
         assert(_dims == other._dims && "Tensors must have the same dimensions for addition");
-        Tensor<uint32_t, N> result(_dims);
-        uint64_t i = 0;
-        for (; i + 3 < Data.size(); i += 4) {          // Loop over in chunks of 4
-            uint32x4_t a = vld1q_u32(&Data[i]);        // Load 4 elements from tensor A
-            uint32x4_t b = vld1q_u32(&other.Data[i]);  // Load 4 elements from tensor B
-            uint32x4_t c = vaddq_u32(a, b);     // Element-wise addition
-            vst1q_u32(&result.Data[i], c);             // Store the result
-        }
-        for (; i < Data.size(); ++i) {                 // Handle remaining elements if the size is not a multiple of 4
-            result.Data[i] = Data[i] + other.Data[i];
-        }
-        return result;
+        return elementwise(other, [](const uint32_t* a, const uint32_t* b, uint32_t* c, uint64_t size) { addRange(a, b, c, size); });
     }
 
     Tensor<uint16_t, N> operator+(const Tensor<uint16_t, N>& other) const {
         assert(_dims == other._dims && "Tensors must have the same dimensions for addition");
-        Tensor<uint16_t, N> result(_dims);
-        uint64_t i = 0;
-        for (; i + 7 < Data.size(); i += 8) {          // Loop over in chunks of 8
-            uint16x8_t a = vld1q_u16(&Data[i]);        // Load 8 elements from tensor A
-            uint16x8_t b = vld1q_u16(&other.Data[i]);  // Load 8 elements from tensor B
-            uint16x8_t c = vaddq_u16(a, b);     // Element-wise addition
-            vst1q_u16(&result.Data[i], c);             // Store the result
-        }
-        for (; i < Data.size(); ++i) {                 // Handle remaining elements if the size is not a multiple of 8
-            result.Data[i] = Data[i] + other.Data[i];
-        }
-        return result;
+        return elementwise(other, [](const uint16_t* a, const uint16_t* b, uint16_t* c, uint64_t size) { addRange(a, b, c, size); });
     }
 
     Tensor<uint8_t, N> operator+(const Tensor<uint8_t, N>& other) const {
         assert(_dims == other._dims && "Tensors must have the same dimensions for addition");
-        Tensor<uint8_t, N> result(_dims);
-        uint64_t i = 0;
-        for (; i + 15 < Data.size(); i += 16) {       // Loop over in chunks of 16
-            uint8x16_t a = vld1q_u8(&Data[i]);        // Load 16 elements from tensor A
-            uint8x16_t b = vld1q_u8(&other.Data[i]);  // Load 16 elements from tensor B
-            uint8x16_t c = vaddq_u8(a, b);     // Element-wise addition
-            vst1q_u8(&result.Data[i], c);             // Store the result
-        }
-        for (; i < Data.size(); ++i) {                // Handle remaining elements if the size is not a multiple of 16
-            result.Data[i] = Data[i] + other.Data[i];
-        }
-        return result;
+        return elementwise(other, [](const uint8_t* a, const uint8_t* b, uint8_t* c, uint64_t size) { addRange(a, b, c, size); });
     }
 
     Tensor<float, N> operator+(const Tensor<float, N>& other) const {
         assert(_dims == other._dims && "Tensors must have the same dimensions for addition");
-        Tensor<float, N> result(_dims);
-        uint64_t i = 0;
-        for (; i + 3 < Data.size(); i += 4) {           // Loop over in chunks of 4
-            float32x4_t a = vld1q_f32(&Data[i]);        // Load 4 elements from tensor A
-            float32x4_t b = vld1q_f32(&other.Data[i]);  // Load 4 elements from tensor B
-            float32x4_t c = vaddq_f32(a, b);     // Element-wise addition
-            vst1q_f32(&result.Data[i], c);              // Store the result
-        }
-        for (; i < Data.size(); ++i) {                  // Handle remaining elements if the size is not a multiple of 4
-            result.Data[i] = Data[i] + other.Data[i];
-        }
-        return result;
+        return elementwise(other, [](const float* a, const float* b, float* c, uint64_t size) { addRange(a, b, c, size); });
     }
 
 
     Tensor<uint32_t, N> operator-(const Tensor<uint32_t,N>& other) const {
         assert(_dims == other._dims && "Tensors must have the same dimensions for substraction");
-        Tensor<uint32_t, N> result(_dims);
-        uint64_t size = Data.size();
-        uint64_t i = 0;
-        for (; i + 3 < size; i += 4) {
-            uint32x4_t a = vld1q_u32(&Data[i]);         // Load 4 elements from tensor A
-            uint32x4_t b = vld1q_u32(&other.Data[i]);   // Load 4 elements from tensor B
-            uint32x4_t c = vsubq_u32(a, b);      // Element-wise substraction
-            vst1q_u32(&result.Data[i], c);              // Store the result
-        }
-        for (; i < size; ++i) {                         // Handle remaining elements if the size is not a multiple of 4
-            result.Data[i] = Data[i] - other.Data[i];
-        }
-        return result;
+        return elementwise(other, [](const uint32_t* a, const uint32_t* b, uint32_t* c, uint64_t size) { subtractRange(a, b, c, size); });
     }
 
     Tensor<uint16_t, N> operator-(const Tensor<uint16_t, N>& other) const {
-        assert(_dims == other._dims && "Tensors must have the same dimensions for addition");
-        Tensor<uint16_t, N> result(_dims);
-        uint64_t i = 0;
-        for (; i + 7 < Data.size(); i += 8) {          // Loop over in chunks of 8
-            uint16x8_t a = vld1q_u16(&Data[i]);        // Load 8 elements from tensor A
-            uint16x8_t b = vld1q_u16(&other.Data[i]);  // Load 8 elements from tensor B
-            uint16x8_t c = vsubq_u16(a, b);     // Element-wise substraction
-            vst1q_u16(&result.Data[i], c);             // Store the result
-        }
-        for (; i < Data.size(); ++i) {                 // Handle remaining elements if the size is not a multiple of 8
-            result.Data[i] = Data[i] - other.Data[i];
-        }
-        return result;
+        assert(_dims == other._dims && "Tensors must have the same dimensions for substraction");
+        return elementwise(other, [](const uint16_t* a, const uint16_t* b, uint16_t* c, uint64_t size) { subtractRange(a, b, c, size); });
     }
 
     Tensor<uint8_t, N> operator-(const Tensor<uint8_t, N>& other) const {
-        assert(_dims == other._dims && "Tensors must have the same dimensions for addition");
-        Tensor<uint8_t, N> result(_dims);
-        uint64_t i = 0;
-        for (; i + 15 < Data.size(); i += 16) {       // Loop over in chunks of 16
-            uint8x16_t a = vld1q_u8(&Data[i]);        // Load 16 elements from tensor A
-            uint8x16_t b = vld1q_u8(&other.Data[i]);  // Load 16 elements from tensor B
-            uint8x16_t c = vsubq_u8(a, b);     // Element-wise substraction
-            vst1q_u8(&result.Data[i], c);             // Store the result
-        }
-        for (; i < Data.size(); ++i) {                // Handle remaining elements if the size is not a multiple of 16
-            result.Data[i] = Data[i] - other.Data[i];
-        }
-        return result;
+        assert(_dims == other._dims && "Tensors must have the same dimensions for substraction");
+        return elementwise(other, [](const uint8_t* a, const uint8_t* b, uint8_t* c, uint64_t size) { subtractRange(a, b, c, size); });
     }
 
     Tensor<float, N> operator-(const Tensor<float,N>& other) const {
         assert(_dims == other._dims && "Tensors must have the same dimensions for substraction");
-        Tensor<float, N> result(_dims);
-        uint64_t size = Data.size();
-        uint64_t i = 0;
-        for (; i + 3 < size; i += 4) {
-            float32x4_t a = vld1q_f32(&Data[i]);        // Load 4 elements from tensor A
-            float32x4_t b = vld1q_f32(&other.Data[i]);  // Load 4 elements from tensor B
-            float32x4_t c = vsubq_f32(a, b);     // Element-wise substraction
-            vst1q_f32(&result.Data[i], c);              // Store the result
-        }
-        for (; i < size; ++i) {                         // Handle remaining elements if the size is not a multiple of 4
-            result.Data[i] = Data[i] - other.Data[i];
-        }
-        return result;
+        return elementwise(other, [](const float* a, const float* b, float* c, uint64_t size) { subtractRange(a, b, c, size); });
     }
 
     // to string
     std::string toString() const {
         std::string str = "";
-        for (int i = 0; i < Data.size(); i++) {
+        for (uint64_t i = 0; i < Data.size(); i++) {
             str += std::to_string(Data[i]) + " ";
         }
         return str;
@@ -0,0 +1,156 @@
+#pragma once
+
+#include <condition_variable>
+#include <coroutine>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include "Tensor/Tensor.h"
+#include "Tensor/TensorOps.h"
+
+namespace TensorAsync {
+    template <typename R>
+    class Operation;
+
+    /**
+     * @brief Queue of tensor operations that run in submission order on a thread of their own
+     * Submitting returns right away with a future, so the caller can prepare the next input while earlier work computes.
+     * Operations of one stream never overlap and see the results of everything submitted before them. Different streams
+     * run at the same time. A stream's kernels still spread over the thread pool when it is free, otherwise they run on
+     * the stream's own thread.
+     * Coroutines awaiting an operation are resumed on a second thread of the stream, never inside the queue, so code
+     * after a co_await may block on the same stream, its futures or synchronize(), without stalling later operations.
+     * Operands are taken by value, move tensors in to avoid the copy.
+     */
+    class Stream {
+    public:
+        Stream();
+        // Finishes every queued operation and resumed coroutine, including the operations they queue, before returning
+        ~Stream();
+
+        Stream(const Stream&) = delete;
+        Stream& operator=(const Stream&) = delete;
+
+        /**
+         * @brief Queues fn() and returns a future for its result, an exception thrown by fn is rethrown by the future
+         */
+        template <typename Fn>
+        std::future<std::invoke_result_t<Fn&>> submit(Fn fn){
+            using R = std::invoke_result_t<Fn&>;
+            auto task = std::make_shared<std::packaged_task<R()>>(std::move(fn));
+            std::future<R> future = task->get_future();
+            enqueue([task]() { (*task)(); });
+            return future;
+        }
+
+        /**
+         * @brief Awaitable that runs fn() on the stream when a coroutine awaits it
+         * The coroutine resumes on the stream's continuation thread once fn() is done, with its result as value of the
+         * co_await. Coroutines of one stream are resumed one after the other.
+         */
+        template <typename Fn>
+        Operation<std::invoke_result_t<Fn&>> operation(Fn fn);
+
+        template <typename T>
+        std::future<Tensor<T, 2>> matmul(Tensor<T, 2> A, Tensor<T, 2> B){
+            return submit([A = std::move(A), B = std::move(B)]() { return TensorOps::matmul(A, B); });
+        }
+
+        template <typename T, uint16_t N>
+        std::future<Tensor<T, N>> add(Tensor<T, N> A, Tensor<T, N> B){
+            return submit([A = std::move(A), B = std::move(B)]() { return A + B; });
+        }
+
+        template <typename T, uint16_t N>
+        std::future<Tensor<T, N>> subtract(Tensor<T, N> A, Tensor<T, N> B){
+            return submit([A = std::move(A), B = std::move(B)]() { return A - B; });
+        }
+
+        // Blocks until every operation submitted so far has finished
+        void synchronize();
+
+        // Operations queued or running
+        uint64_t pending() const;
+
+    private:
+        template <typename R>
+        friend class Operation;
+
+        // Queues a job, every submission ends up here. A job must not throw, submit() and Operation catch for it.
+        void enqueue(std::function<void()> job);
+
+        // Queues a suspended coroutine to be resumed on the continuation thread
+        void resume(std::coroutine_handle<> handle);
+
+        void workerLoop();
+        void resumerLoop();
+
+        mutable std::mutex _mutex;
+        std::condition_variable _wake;
+        std::condition_variable _drained;
+        std::deque<std::function<void()>> _queue;
+        uint64_t _pending = 0;
+        std::condition_variable _resumeWake;
+        std::deque<std::coroutine_handle<>> _resumptions;
+        bool _resuming = false;
+        bool _stop = false;
+        std::thread _thread;
+        std::thread _resumer;
+    };
+
+    /**
+     * @brief Result of Stream::operation, co_await it to run the operation and get its result
+     * Awaiting suspends the coroutine and queues the operation, so nothing blocks while it waits its turn.
+     */
+    template <typename R>
+    class Operation {
+    public:
+        template <typename Fn>
+        Operation(Stream& stream, Fn fn) : _stream(stream), _fn(std::move(fn)) {}
+
+        bool await_ready() const noexcept { return false; }
+
+        void await_suspend(std::coroutine_handle<> handle){
+            _stream.enqueue([this, handle]() {
+                try {
+                    if constexpr (std::is_void_v<R>)
+                        _fn();
+                    else
+                        _result.emplace(_fn());
+                } catch (...) {
+                    _error = std::current_exception();
+                }
+                // Handed over rather than resumed here, the coroutine must not run inside the stream's queue
+                _stream.resume(handle);
+            });
+        }
+
+        R await_resume(){
+            if (_error)
+                std::rethrow_exception(_error);
+            if constexpr (!std::is_void_v<R>)
+                return std::move(*_result);
+        }
+
+    private:
+        using Stored = std::conditional_t<std::is_void_v<R>, char, R>;
+
+        Stream& _stream;
+        std::function<R()> _fn;
+        std::optional<Stored> _result;
+        std::exception_ptr _error;
+    };
+
+    template <typename Fn>
+    Operation<std::invoke_result_t<Fn&>> Stream::operation(Fn fn){
+        return Operation<std::invoke_result_t<Fn&>>(*this, std::move(fn));
+    }
+};
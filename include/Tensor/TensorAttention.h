@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cassert>
+#include <cstdint>
+#include "Tensor/Tensor.h"
+
+namespace TensorAttention {
+    struct AttentionParams {
+        // Query i only sees keys j <= i + seqK - seqQ, which is j <= i for self-attention
+        bool causal = false;
+        // Multiplies Q K^T, 0 selects 1 / sqrt(dim)
+        float scale = 0.0f;
+    };
+
+    // Queries handled by one task and keys streamed per step, the score block is QueryBlock x KeyBlock floats
+    constexpr uint32_t QueryBlock = 64;
+    constexpr uint32_t KeyBlock = 64;
+
+    /**
+     * @brief Scaled dot-product attention softmax(scale * Q K^T) V without materializing the score matrix
+     * Every task owns a block of queries and streams K and V through it one block of keys at a time.
+     * A running max and sum per query row rescale the partial output whenever a later block raises the max.
+     *
+     * @param Q Queries, batch x seqQ x dim
+     * @param K Keys, batch x seqK x dim
+     * @param V Values, batch x seqK x dimV
+     * @param O Output, batch x seqQ x dimV
+     * @param batch Number of independent (batch, head) pairs
+     */
+    void attention(const float* Q, const float* K, const float* V, float* O, uint64_t batch,
+                   uint32_t seqQ, uint32_t seqK, uint32_t dim, uint32_t dimV, const AttentionParams& params);
+
+    /**
+     * @brief Attention over [batch, seq, dim] or [batch, heads, seq, dim] tensors
+     *
+     * @return Tensor with the leading dimensions of Q and the last dimension of V
+     */
+    template <uint16_t N>
+    Tensor<float, N> attention(const Tensor<float,N>& Q, const Tensor<float,N>& K, const Tensor<float,N>& V, const AttentionParams& params = {}){
+        static_assert(N == 3 || N == 4, "Attention needs [batch, seq, dim] or [batch, heads, seq, dim] tensors");
+        const auto& dimsQ = Q.getDimensions();
+        const auto& dimsK = K.getDimensions();
+        const auto& dimsV = V.getDimensions();
+        uint64_t batch = 1;
+        for (uint16_t i = 0; i < N - 2; i++){
+            assert(dimsQ[i] == dimsK[i] && dimsQ[i] == dimsV[i] && "Q, K and V must share their batch and head dimensions");
+            batch *= dimsQ[i];
+        }
+        assert(dimsQ[N - 1] == dimsK[N - 1] && "Q and K must have the same head dimension");
+        assert(dimsK[N - 2] == dimsV[N - 2] && "K and V must have the same sequence length");
+        std::array<uint32_t, N> dimsO = dimsQ;
+        dimsO[N - 1] = dimsV[N - 1];
+        Tensor<float, N> result(dimsO, TensorUninitialized);
+        attention(Q.Data.data(), K.Data.data(), V.Data.data(), result.Data.data(), batch,
+                  dimsQ[N - 2], dimsK[N - 2], dimsQ[N - 1], dimsV[N - 1], params);
+        return result;
+    }
+};
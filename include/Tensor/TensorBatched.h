@@ -0,0 +1,140 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstdint>
+#include <type_traits>
+#include "Tensor/Tensor.h"
+#include "Tensor/TensorGemm.h"
+#include "Tensor/TensorParallel.h"
+
+namespace TensorMatmul {
+    // Largest M, N and K handled by the interleaved small-matrix kernel, bigger problems run one packed GEMM each
+    constexpr uint32_t BatchedSmallLimit = 64;
+    // Problems that share one set of registers in the interleaved kernel, one per lane
+    constexpr uint32_t BatchedGroup = 4;
+
+    namespace Gemm {
+        /**
+         * @brief C[l] = op(A[l]) * op(B[l]) for up to BatchedGroup problems of one small shape at once
+         * The operands are interleaved so that every register holds the same element of each problem, which keeps all
+         * lanes busy whatever the shape is. Lanes past the last problem compute a copy of problem 0 and are not stored.
+         *
+         * @param lanes Number of valid problems, 1 to BatchedGroup
+         */
+        void batchedGroup(uint32_t M, uint32_t N, uint32_t K,
+                          const float* const* A, uint64_t lda, Transpose transA,
+                          const float* const* B, uint64_t ldb, Transpose transB,
+                          float* const* C, uint64_t ldc, uint32_t lanes);
+
+        /**
+         * @brief Runs every problem of a batch, problem(b, A, B, C) sets the operand pointers of problem b
+         */
+        template <typename T, typename Problem>
+        void batched(uint32_t M, uint32_t N, uint32_t K, Transpose transA, uint64_t lda, Transpose transB, uint64_t ldb,
+                     uint64_t ldc, uint64_t batch, Problem&& problem){
+            if (batch == 0)
+                return;
+            uint64_t problemWork = std::max<uint64_t>(1, static_cast<uint64_t>(M) * N * K);
+            bool small = M <= BatchedSmallLimit && N <= BatchedSmallLimit && K <= BatchedSmallLimit;
+            if constexpr (std::is_same_v<T, float>){
+                if (small){
+                    uint64_t groups = (batch + BatchedGroup - 1) / BatchedGroup;
+                    uint64_t minGroups = std::max<uint64_t>(1, ParallelWorkThreshold / (problemWork * BatchedGroup));
+                    TensorParallel::parallelFor(0, groups, minGroups, [&](uint64_t groupBegin, uint64_t groupEnd) {
+                        for (uint64_t g = groupBegin; g < groupEnd; g++){
+                            const float* a[BatchedGroup];
+                            const float* b[BatchedGroup];
+                            float* c[BatchedGroup];
+                            uint32_t lanes = static_cast<uint32_t>(std::min<uint64_t>(BatchedGroup, batch - g * BatchedGroup));
+                            for (uint32_t l = 0; l < BatchedGroup; l++)
+                                problem(g * BatchedGroup + (l < lanes ? l : 0), a[l], b[l], c[l]);
+                            batchedGroup(M, N, K, a, lda, transA, b, ldb, transB, c, ldc, lanes);
+                        }
+                    });
+                    return;
+                }
+            }
+            if (small || batch >= TensorParallel::workerCount()){
+                // Enough problems to keep every thread busy, each one runs single-threaded
+                uint64_t minProblems = std::max<uint64_t>(1, ParallelWorkThreshold / problemWork);
+                TensorParallel::parallelFor(0, batch, minProblems, [&](uint64_t problemBegin, uint64_t problemEnd) {
+                    for (uint64_t p = problemBegin; p < problemEnd; p++){
+                        const T* a;
+                        const T* b;
+                        T* c;
+                        problem(p, a, b, c);
+                        gemm<T>(M, N, K, a, lda, transA, b, ldb, transB, c, ldc, nullptr, false);
+                    }
+                });
+                return;
+            }
+            for (uint64_t p = 0; p < batch; p++){
+                const T* a;
+                const T* b;
+                T* c;
+                problem(p, a, b, c);
+                gemm<T>(M, N, K, a, lda, transA, b, ldb, transB, c, ldc, nullptr, true);
+            }
+        }
+    };
+
+    /**
+     * @brief Independent products C[i] = op(A[i]) * op(B[i]) of one shape, with shapes and flags as in gemm()
+     * Small float problems are computed BatchedGroup at a time with one problem per SIMD lane, and the batch is spread
+     * over threads. Nothing is allocated per problem.
+     *
+     * @param A Array of batch pointers to the stored left operands
+     * @param B Array of batch pointers to the stored right operands
+     * @param C Array of batch pointers to the outputs, which are overwritten
+     */
+    template <typename T>
+    void gemmBatched(uint32_t M, uint32_t N, uint32_t K,
+                     const T* const* A, uint64_t lda, Transpose transA,
+                     const T* const* B, uint64_t ldb, Transpose transB,
+                     T* const* C, uint64_t ldc, uint64_t batch){
+        Gemm::batched<T>(M, N, K, transA, lda, transB, ldb, ldc, batch, [=](uint64_t p, const T*& a, const T*& b, T*& c) {
+            a = A[p];
+            b = B[p];
+            c = C[p];
+        });
+    }
+
+    /**
+     * @brief Batched products whose operands lie at fixed distances in memory, problem i uses A + i * strideA and so on
+     * A stride of 0 shares one operand, such as a weight matrix, between all problems.
+     */
+    template <typename T>
+    void gemmStridedBatched(uint32_t M, uint32_t N, uint32_t K,
+                            const T* A, uint64_t lda, uint64_t strideA, Transpose transA,
+                            const T* B, uint64_t ldb, uint64_t strideB, Transpose transB,
+                            T* C, uint64_t ldc, uint64_t strideC, uint64_t batch){
+        Gemm::batched<T>(M, N, K, transA, lda, transB, ldb, ldc, batch, [=](uint64_t p, const T*& a, const T*& b, T*& c) {
+            a = A + p * strideA;
+            b = B + p * strideB;
+            c = C + p * strideC;
+        });
+    }
+
+    /**
+     * @brief Batched matrix product of [batch, M, N] and [batch, N, K] tensors
+     *
+     * @return Tensor of shape [batch, M, K]
+     */
+    template <typename T>
+    Tensor<T, 3> matmulBatched(const Tensor<T, 3>& A, const Tensor<T, 3>& B){
+        const auto& dimsA = A.getDimensions();
+        const auto& dimsB = B.getDimensions();
+        assert(dimsA[0] == dimsB[0] && "Batched matmul needs the same number of matrices on both sides");
+        assert(dimsA[2] == dimsB[1] && "Matrices need to have shapes M*N and N*K");
+        std::array<uint32_t, 3> dims = {dimsA[0], dimsA[1], dimsB[2]};
+        Tensor<T, 3> result(dims, TensorUninitialized);
+        uint64_t strideA = static_cast<uint64_t>(dimsA[1]) * dimsA[2];
+        uint64_t strideB = static_cast<uint64_t>(dimsB[1]) * dimsB[2];
+        uint64_t strideC = static_cast<uint64_t>(dims[1]) * dims[2];
+        gemmStridedBatched<T>(dimsA[1], dimsA[2], dimsB[2], A.Data.data(), dimsA[2], strideA, Transpose::No,
+                              B.Data.data(), dimsB[2], strideB, Transpose::No, result.Data.data(), dims[2], strideC, dimsA[0]);
+        return result;
+    }
+};
@@ -0,0 +1,49 @@
+#pragma once
+
+/**
+ * @brief CBLAS interface to the DeepPi kernels
+ * Declares the single-precision CBLAS routines that libdeeppi_blas exports with their standard C names and enum values,
+ * so code written against cblas.h links against DeepPi instead of another BLAS. Matrix products run on the packed GEMM
+ * and every routine spreads large inputs over the DeepPi thread pool. Negative vector increments walk the vector
+ * backwards as in reference BLAS. Invalid arguments are caught by asserts instead of xerbla.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum CBLAS_ORDER {
+    CblasRowMajor = 101,
+    CblasColMajor = 102
+} CBLAS_ORDER;
+
+typedef CBLAS_ORDER CBLAS_LAYOUT;
+
+typedef enum CBLAS_TRANSPOSE {
+    CblasNoTrans = 111,
+    CblasTrans = 112,
+    CblasConjTrans = 113        // Same as CblasTrans for real matrices
+} CBLAS_TRANSPOSE;
+
+// C = alpha * op(A) * op(B) + beta * C with op(A) M x K, op(B) K x N and C M x N
+void cblas_sgemm(const enum CBLAS_ORDER Order, const enum CBLAS_TRANSPOSE TransA, const enum CBLAS_TRANSPOSE TransB,
+                 const int M, const int N, const int K, const float alpha, const float* A, const int lda,
+                 const float* B, const int ldb, const float beta, float* C, const int ldc);
+
+// y = alpha * op(A) * x + beta * y with A M x N
+void cblas_sgemv(const enum CBLAS_ORDER Order, const enum CBLAS_TRANSPOSE TransA, const int M, const int N,
+                 const float alpha, const float* A, const int lda, const float* X, const int incX,
+                 const float beta, float* Y, const int incY);
+
+// Sum of X[i] * Y[i]
+float cblas_sdot(const int N, const float* X, const int incX, const float* Y, const int incY);
+
+// Y = alpha * X + Y
+void cblas_saxpy(const int N, const float alpha, const float* X, const int incX, float* Y, const int incY);
+
+// X = alpha * X, computed as a multiplication even for alpha = 0, so NaN and Inf become NaN as in reference BLAS
+void cblas_sscal(const int N, const float alpha, float* X, const int incX);
+
+#ifdef __cplusplus
+}
+#endif
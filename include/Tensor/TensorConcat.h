@@ -0,0 +1,65 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+#include "Tensor/TensorParallel.h"
+
+namespace TensorConcat {
+    /**
+     * @brief One operand of a concatenation or a split: outer runs of length contiguous elements each
+     * Run o is read from src + o * srcStride and written to dst + o * dstStride.
+     */
+    template <typename T>
+    struct Block {
+        const T* src;
+        T* dst;
+        uint64_t length;
+        uint64_t srcStride;
+        uint64_t dstStride;
+    };
+
+    // Runs longer than this are cut so that a single long run still spreads over threads
+    constexpr uint64_t PieceSize = TensorParallel::ElementwiseChunk;
+
+    /**
+     * @brief Copies outer runs of every block with one bulk copy per run
+     * Concatenation reads every block densely and writes it at its offset inside each output row, splitting does the
+     * reverse. Copies of elementwiseThreshold() elements or more are spread over the thread pool.
+     *
+     * @param blocks Blocks to copy, all with the same number of runs
+     * @param outer Number of runs of every block
+     */
+    template <typename T>
+    void copyBlocks(const std::vector<Block<T>>& blocks, uint64_t outer){
+        struct Piece {
+            uint32_t block;
+            uint64_t begin;
+            uint64_t end;
+        };
+        std::vector<Piece> pieces;
+        uint64_t total = 0;
+        for (uint32_t b = 0; b < blocks.size(); b++){
+            for (uint64_t begin = 0; begin < blocks[b].length; begin += PieceSize)
+                pieces.push_back({b, begin, std::min(blocks[b].length, begin + PieceSize)});
+            total += blocks[b].length * outer;
+        }
+        auto copyItems = [&](uint64_t itemBegin, uint64_t itemEnd) {
+            for (uint64_t item = itemBegin; item < itemEnd; item++){
+                uint64_t o = item / pieces.size();
+                const Piece& piece = pieces[item % pieces.size()];
+                const Block<T>& block = blocks[piece.block];
+                const T* from = block.src + o * block.srcStride + piece.begin;
+                std::copy(from, from + (piece.end - piece.begin), block.dst + o * block.dstStride + piece.begin);
+            }
+        };
+        uint64_t items = outer * pieces.size();
+        if (total < TensorParallel::elementwiseThreshold()){
+            copyItems(0, items);
+            return;
+        }
+        // Runs of a few elements are grouped so that a task moves at least a piece worth of data
+        uint64_t minItems = std::max<uint64_t>(1, PieceSize * items / total);
+        TensorParallel::parallelFor(0, items, minItems, copyItems);
+    }
+};
@@ -0,0 +1,292 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstdint>
+#include <type_traits>
+#include "Tensor/Tensor.h"
+#include "Tensor/TensorGemm.h"
+#include "Tensor/TensorParallel.h"
+
+namespace TensorConv {
+    /**
+     * @brief Memory layout of 4D activations: batch, channels, rows, columns (NCHW) or batch, rows, columns, channels (NHWC)
+     * Weights are always stored as [outChannels, inChannels / groups, kernelH, kernelW].
+     */
+    enum class Layout : uint8_t {
+        NCHW,
+        NHWC
+    };
+
+    /**
+     * @brief Convolution kernels. Auto picks one from the shape, see selectAlgorithm.
+     */
+    enum class Algorithm : uint8_t {
+        Auto,
+        Im2colGemm,     // Implicit im2col: patches are gathered straight into GEMM panels
+        Depthwise3x3,   // Direct NEON kernel for 3x3 depthwise convolutions, float only
+        Winograd        // Winograd F(2x2, 3x3) for dense 3x3 stride 1 convolutions, float only
+    };
+
+    struct Conv2DParams {
+        uint32_t strideH = 1;
+        uint32_t strideW = 1;
+        uint32_t padH = 0;
+        uint32_t padW = 0;
+        uint32_t dilationH = 1;
+        uint32_t dilationW = 1;
+        uint32_t groups = 1;
+        Layout layout = Layout::NCHW;
+        Algorithm algorithm = Algorithm::Auto;
+    };
+
+    /**
+     * @brief Sizes of one convolution together with the element strides of its input and output
+     * Strides are ordered batch, channel, row, column whatever the layout, so kernels can address both layouts the same way.
+     */
+    struct Conv2DGeometry {
+        uint32_t batch, channels, height, width;
+        uint32_t outChannels, kernelH, kernelW;
+        uint32_t outHeight, outWidth;
+        std::array<uint64_t, 4> inStrides;
+        std::array<uint64_t, 4> outStrides;
+    };
+
+    /**
+     * @brief Computes the geometry of a convolution and checks that input, weights and parameters agree
+     *
+     * @param inputDims Input shape in params.layout
+     * @param weightDims Weight shape [outChannels, inChannels / groups, kernelH, kernelW]
+     */
+    inline Conv2DGeometry geometry(const std::array<uint32_t, 4>& inputDims, const std::array<uint32_t, 4>& weightDims, const Conv2DParams& params){
+        Conv2DGeometry g;
+        bool nchw = params.layout == Layout::NCHW;
+        g.batch = inputDims[0];
+        g.channels = nchw ? inputDims[1] : inputDims[3];
+        g.height = nchw ? inputDims[2] : inputDims[1];
+        g.width = nchw ? inputDims[3] : inputDims[2];
+        g.outChannels = weightDims[0];
+        g.kernelH = weightDims[2];
+        g.kernelW = weightDims[3];
+        assert(params.groups > 0 && params.strideH > 0 && params.strideW > 0 && params.dilationH > 0 && params.dilationW > 0 && "Convolution parameters must be positive");
+        assert(g.channels % params.groups == 0 && g.outChannels % params.groups == 0 && "Channels must be divisible by groups");
+        assert(weightDims[1] == g.channels / params.groups && "Weights must have shape [outChannels, inChannels / groups, kH, kW]");
+        int64_t spanH = static_cast<int64_t>(params.dilationH) * (g.kernelH - 1) + 1;
+        int64_t spanW = static_cast<int64_t>(params.dilationW) * (g.kernelW - 1) + 1;
+        assert(g.height + 2 * params.padH >= spanH && g.width + 2 * params.padW >= spanW && "Kernel is larger than the padded input");
+        g.outHeight = static_cast<uint32_t>((g.height + 2 * params.padH - spanH) / params.strideH + 1);
+        g.outWidth = static_cast<uint32_t>((g.width + 2 * params.padW - spanW) / params.strideW + 1);
+        uint64_t inPlane = static_cast<uint64_t>(g.height) * g.width;
+        uint64_t outPlane = static_cast<uint64_t>(g.outHeight) * g.outWidth;
+        if (nchw){
+            g.inStrides = {g.channels * inPlane, inPlane, g.width, 1};
+            g.outStrides = {g.outChannels * outPlane, outPlane, g.outWidth, 1};
+        } else {
+            g.inStrides = {g.channels * inPlane, 1, static_cast<uint64_t>(g.width) * g.channels, g.channels};
+            g.outStrides = {g.outChannels * outPlane, 1, static_cast<uint64_t>(g.outWidth) * g.outChannels, g.outChannels};
+        }
+        return g;
+    }
+
+    /**
+     * @brief Shape of the convolution output in params.layout
+     */
+    inline std::array<uint32_t, 4> outputShape(const std::array<uint32_t, 4>& inputDims, const std::array<uint32_t, 4>& weightDims, const Conv2DParams& params){
+        Conv2DGeometry g = geometry(inputDims, weightDims, params);
+        if (params.layout == Layout::NCHW)
+            return {g.batch, g.outChannels, g.outHeight, g.outWidth};
+        return {g.batch, g.outHeight, g.outWidth, g.outChannels};
+    }
+
+    /**
+     * @brief Chooses the kernel used for Algorithm::Auto
+     * Depthwise 3x3 goes to the direct kernel, dense 3x3 stride 1 layers with enough channels to Winograd, everything else to implicit im2col.
+     */
+    template <typename T>
+    Algorithm selectAlgorithm(const Conv2DGeometry& g, const Conv2DParams& params){
+        if (params.algorithm != Algorithm::Auto)
+            return params.algorithm;
+        if constexpr (std::is_same_v<T, float>){
+            bool kernel3x3 = g.kernelH == 3 && g.kernelW == 3 && params.dilationH == 1 && params.dilationW == 1;
+            if (kernel3x3 && params.groups == g.channels && g.outChannels == g.channels && params.strideH == params.strideW && params.strideH <= 2)
+                return Algorithm::Depthwise3x3;
+            if (kernel3x3 && params.groups == 1 && params.strideH == 1 && params.strideW == 1 && g.channels >= 8 && g.outChannels >= 8 &&
+                static_cast<uint64_t>(g.outHeight) * g.outWidth >= 64)
+                return Algorithm::Winograd;
+        }
+        return Algorithm::Im2colGemm;
+    }
+
+    // Output pixels handled by one task of the im2col path
+    constexpr uint32_t PixelsPerTask = 256;
+
+    /**
+     * @brief Gathers implicit im2col panels of P pixels straight from the input image
+     * Panel element (k, c) is stored at k * P + c, where k = (channel * kernelH + ky) * kernelW + kx and c is the pixel inside the panel.
+     * Pixels outside the image (padding) and missing pixels of the last panel are zero.
+     *
+     * @param input First channel of the group in the current image
+     * @param pixel0 First output pixel (row-major over outHeight x outWidth)
+     * @param count Number of output pixels to gather
+     * @param k0 First patch index
+     * @param kc Number of patch indices
+     */
+    template <uint32_t P, typename T>
+    void packPatchPanels(const T* input, const Conv2DGeometry& g, const Conv2DParams& params,
+                         uint64_t pixel0, uint32_t count, uint64_t k0, uint32_t kc, T* packed){
+        uint32_t taps = g.kernelH * g.kernelW;
+        for (uint32_t cp = 0; cp < count; cp += P){
+            uint32_t pixels = std::min(P, count - cp);
+            T* panel = packed + static_cast<uint64_t>(cp) * kc;
+            int64_t iy0[P];
+            int64_t ix0[P];
+            for (uint32_t c = 0; c < pixels; c++){
+                uint64_t pixel = pixel0 + cp + c;
+                iy0[c] = static_cast<int64_t>(pixel / g.outWidth) * params.strideH - params.padH;
+                ix0[c] = static_cast<int64_t>(pixel % g.outWidth) * params.strideW - params.padW;
+            }
+            for (uint32_t k = 0; k < kc; k++){
+                uint64_t patch = k0 + k;
+                uint32_t channel = static_cast<uint32_t>(patch / taps);
+                uint32_t tap = static_cast<uint32_t>(patch % taps);
+                int64_t dy = static_cast<int64_t>(tap / g.kernelW) * params.dilationH;
+                int64_t dx = static_cast<int64_t>(tap % g.kernelW) * params.dilationW;
+                const T* plane = input + channel * g.inStrides[1];
+                T* dst = panel + k * P;
+                for (uint32_t c = 0; c < pixels; c++){
+                    int64_t iy = iy0[c] + dy;
+                    int64_t ix = ix0[c] + dx;
+                    bool inside = iy >= 0 && iy < g.height && ix >= 0 && ix < g.width;
+                    dst[c] = inside ? plane[iy * g.inStrides[2] + ix * g.inStrides[3]] : T(0);
+                }
+                for (uint32_t c = pixels; c < P; c++)
+                    dst[c] = T(0);
+            }
+        }
+    }
+
+    /**
+     * @brief Convolution as one GEMM per (image, group, block of output pixels) with patches packed on the fly
+     * NCHW computes out[oc, pixel] = W[oc, patch] * patches[patch, pixel]; NHWC computes out[pixel, oc] = patches^T * W^T,
+     * so the output is always written with unit stride by the micro-kernel. Bias and activation run in the GEMM epilogue.
+     */
+    template <typename T>
+    void conv2dIm2col(const T* input, const T* weights, const T* bias, T* output,
+                      const Conv2DGeometry& g, const Conv2DParams& params, TensorMatmul::Activation activation){
+        using Block = TensorMatmul::Gemm::Blocking<T>;
+        uint32_t groups = params.groups;
+        uint32_t groupChannels = g.channels / groups;
+        uint32_t groupOutChannels = g.outChannels / groups;
+        uint32_t patchSize = groupChannels * g.kernelH * g.kernelW;
+        uint64_t pixels = static_cast<uint64_t>(g.outHeight) * g.outWidth;
+        uint64_t pixelTasks = (pixels + PixelsPerTask - 1) / PixelsPerTask;
+        uint64_t tasks = g.batch * groups * pixelTasks;
+        uint64_t taskWork = static_cast<uint64_t>(PixelsPerTask) * patchSize * groupOutChannels;
+        uint64_t minTasks = std::max<uint64_t>(1, TensorMatmul::Gemm::ParallelWorkThreshold / std::max<uint64_t>(taskWork, 1));
+        bool nchw = params.layout == Layout::NCHW;
+
+        TensorParallel::parallelFor(0, tasks, minTasks, [&](uint64_t taskBegin, uint64_t taskEnd) {
+            for (uint64_t task = taskBegin; task < taskEnd; task++){
+                uint64_t n = task / (groups * pixelTasks);
+                uint32_t group = static_cast<uint32_t>(task / pixelTasks % groups);
+                uint64_t pixel0 = task % pixelTasks * PixelsPerTask;
+                uint32_t count = static_cast<uint32_t>(std::min<uint64_t>(PixelsPerTask, pixels - pixel0));
+                const T* image = input + n * g.inStrides[0] + group * groupChannels * g.inStrides[1];
+                const T* groupWeights = weights + static_cast<uint64_t>(group) * groupOutChannels * patchSize;
+                T* out = output + n * g.outStrides[0] + group * groupOutChannels * g.outStrides[1];
+
+                TensorMatmul::GemmEpilogue<T> epilogue;
+                epilogue.activation = activation;
+                if (nchw){
+                    epilogue.rowBias = bias ? bias + group * groupOutChannels : nullptr;
+                    TensorMatmul::gemmWithPacking(groupOutChannels, patchSize, count,
+                        [&](uint64_t i0, uint64_t p0, uint32_t mc, uint32_t kc, T* packed) {
+                            TensorMatmul::Gemm::packA(groupWeights, patchSize, TensorMatmul::Transpose::No, i0, p0, mc, kc, packed);
+                        },
+                        [&](uint64_t p0, uint64_t j0, uint32_t kc, uint32_t nc, T* packed) {
+                            packPatchPanels<Block::NR>(image, g, params, pixel0 + j0, nc, p0, kc, packed);
+                        },
+                        out + pixel0, g.outStrides[1], &epilogue, false);
+                } else {
+                    epilogue.bias = bias ? bias + group * groupOutChannels : nullptr;
+                    TensorMatmul::gemmWithPacking(count, patchSize, groupOutChannels,
+                        [&](uint64_t i0, uint64_t p0, uint32_t mc, uint32_t kc, T* packed) {
+                            packPatchPanels<Block::MR>(image, g, params, pixel0 + i0, mc, p0, kc, packed);
+                        },
+                        [&](uint64_t p0, uint64_t j0, uint32_t kc, uint32_t nc, T* packed) {
+                            TensorMatmul::Gemm::packB(groupWeights, patchSize, TensorMatmul::Transpose::Yes, p0, j0, kc, nc, packed);
+                        },
+                        out + pixel0 * g.outStrides[3], g.outStrides[3], &epilogue, false);
+                }
+            }
+        });
+    }
+
+    /**
+     * @brief Direct NEON convolution for 3x3 depthwise layers (groups == channels == outChannels, stride 1 or 2)
+     */
+    void conv2dDepthwise3x3(const float* input, const float* weights, const float* bias, float* output,
+                            const Conv2DGeometry& g, const Conv2DParams& params, TensorMatmul::Activation activation);
+
+    /**
+     * @brief Winograd F(2x2, 3x3) convolution for dense 3x3 stride 1 layers
+     * Each 4x4 input tile is transformed once, the 16 transformed planes are multiplied by the transformed weights with the packed GEMM,
+     * and every product is turned back into a 2x2 output tile. This needs 2.25x fewer multiplications than direct convolution.
+     */
+    void conv2dWinograd(const float* input, const float* weights, const float* bias, float* output,
+                        const Conv2DGeometry& g, const Conv2DParams& params, TensorMatmul::Activation activation);
+
+    /**
+     * @brief 2D convolution on raw buffers
+     *
+     * @param input Input activations with shape inputDims in params.layout
+     * @param weights Weights with shape weightDims = [outChannels, inChannels / groups, kernelH, kernelW]
+     * @param bias One value per output channel, or nullptr
+     * @param output Output activations with shape outputShape(inputDims, weightDims, params)
+     * @param activation Activation applied to every output element
+     */
+    template <typename T>
+    void conv2d(const T* input, const std::array<uint32_t, 4>& inputDims, const T* weights, const std::array<uint32_t, 4>& weightDims,
+                const T* bias, T* output, const Conv2DParams& params, TensorMatmul::Activation activation = TensorMatmul::Activation::None){
+        Conv2DGeometry g = geometry(inputDims, weightDims, params);
+        Algorithm algorithm = selectAlgorithm<T>(g, params);
+        if constexpr (std::is_same_v<T, float>){
+            if (algorithm == Algorithm::Depthwise3x3){
+                assert(g.kernelH == 3 && g.kernelW == 3 && params.groups == g.channels && g.outChannels == g.channels &&
+                       params.dilationH == 1 && params.dilationW == 1 && params.strideH == params.strideW && params.strideH <= 2 &&
+                       "Depthwise3x3 needs a 3x3 depthwise kernel with stride 1 or 2 and no dilation");
+                conv2dDepthwise3x3(input, weights, bias, output, g, params, activation);
+                return;
+            }
+            if (algorithm == Algorithm::Winograd){
+                assert(g.kernelH == 3 && g.kernelW == 3 && params.groups == 1 && params.strideH == 1 && params.strideW == 1 &&
+                       params.dilationH == 1 && params.dilationW == 1 && "Winograd needs a dense 3x3 kernel with stride 1 and no dilation");
+                conv2dWinograd(input, weights, bias, output, g, params, activation);
+                return;
+            }
+        }
+        assert(algorithm == Algorithm::Im2colGemm && "Only the im2col algorithm is available for this type");
+        conv2dIm2col(input, weights, bias, output, g, params, activation);
+    }
+
+    /**
+     * @brief 2D convolution of a Tensor<T, 4> in NCHW or NHWC layout
+     *
+     * @param input Input activations in params.layout
+     * @param weights Weights [outChannels, inChannels / groups, kernelH, kernelW]
+     * @param params Stride, padding, dilation, groups, layout and algorithm
+     * @param bias Optional bias with one value per output channel
+     * @param activation Activation fused into the output store
+     * @return The output activations in params.layout
+     */
+    template <typename T>
+    Tensor<T, 4> conv2d(const Tensor<T, 4>& input, const Tensor<T, 4>& weights, const Conv2DParams& params = {},
+                        const Tensor<T, 1>* bias = nullptr, TensorMatmul::Activation activation = TensorMatmul::Activation::None){
+        assert((!bias || bias->getDimensions()[0] == weights.getDimensions()[0]) && "Bias must have one value per output channel");
+        Tensor<T, 4> output(outputShape(input.getDimensions(), weights.getDimensions(), params), TensorUninitialized);
+        conv2d(input.Data.data(), input.getDimensions(), weights.Data.data(), weights.getDimensions(),
+               bias ? bias->Data.data() : nullptr, output.Data.data(), params, activation);
+        return output;
+    }
+};
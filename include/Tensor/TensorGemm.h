@@ -0,0 +1,500 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+#include <vector>
+#include "Tensor/Tensor.h"
+#include "Tensor/TensorMath.h"
+#include "Tensor/TensorParallel.h"
+#include "Tensor/TensorSimd.h"
+#include "Tensor/TensorTranspose.h"
+
+namespace TensorMatmul {
+    /**
+     * @brief Tells the GEMM kernels whether an operand is stored as given or as its transpose
+     */
+    enum class Transpose : uint8_t {
+        No,
+        Yes
+    };
+
+    /**
+     * @brief Elementwise activation applied by a GEMM epilogue
+     * GELU uses the tanh approximation. Float tiles go through the vector math in TensorMath,
+     * integer types evaluate GELU and Sigmoid in single precision and round the result back.
+     */
+    enum class Activation : uint8_t {
+        None,
+        ReLU,
+        ReLU6,
+        GELU,
+        Sigmoid
+    };
+
+    /**
+     * @brief Work done on each output element of a GEMM before it is stored
+     * out = activation(scale * acc + bias[col] + rowBias[row] + residual[row, col]). Null pointers skip the corresponding step.
+     */
+    template <typename T>
+    struct GemmEpilogue {
+        const T* bias = nullptr;            // One value per output column
+        const T* rowBias = nullptr;         // One value per output row
+        T scale = T(1);                     // Multiplies the accumulated product
+        Activation activation = Activation::None;
+        const T* residual = nullptr;        // M x K matrix added to the output
+        uint64_t residualStride = 0;        // Distance in elements between two rows of residual
+    };
+
+    namespace Gemm {
+        /**
+         * @brief Register and cache blocking of the packed GEMM for one element type
+         * The micro-kernel computes an MR x NR tile of C held in 2*MR NEON registers.
+         * A is packed in MC x KC blocks (L2) and B in KC x NC blocks (shared L2/L3).
+         */
+        template <typename T>
+        struct Blocking {
+            static constexpr uint32_t MR = 8;
+            static constexpr uint32_t NR = TensorSimd::Vec<T>::Supported ? 2 * TensorSimd::Vec<T>::Lanes : 4;
+            static constexpr uint32_t MC = 128;
+            static constexpr uint32_t KC = 256;
+            static constexpr uint32_t NC = 512;
+        };
+
+        // Number of per-thread buffers handed out by workspace()
+        constexpr int WorkspaceSlots = 5;
+
+        // Multiply-adds below which a GEMM is not worth splitting between threads
+        constexpr uint64_t ParallelWorkThreshold = 1 << 20;
+
+        /**
+         * @brief Buffers handed out by workspace(), every thread has its own set unless one is bound with WorkspaceBinding
+         */
+        template <typename T>
+        struct Workspace {
+            std::vector<T, DefaultInitAllocator<T>> buffers[WorkspaceSlots];
+
+            // Grows every slot to at least the size given for it
+            void reserve(const uint64_t (&sizes)[WorkspaceSlots]){
+                for (int slot = 0; slot < WorkspaceSlots; slot++){
+                    if (buffers[slot].size() < sizes[slot])
+                        buffers[slot].resize(sizes[slot]);
+                }
+            }
+        };
+
+        namespace detail {
+            template <typename T>
+            Workspace<T>*& boundWorkspace(){
+                thread_local Workspace<T>* bound = nullptr;
+                return bound;
+            }
+
+            template <typename T>
+            Workspace<T>& threadWorkspace(){
+                thread_local Workspace<T> workspace;
+                return workspace;
+            }
+
+            // Largest size requested from each slot so far by any thread, only updated when a buffer grows
+            template <typename T>
+            std::atomic<uint64_t> (&largestRequests())[WorkspaceSlots]{
+                static std::atomic<uint64_t> sizes[WorkspaceSlots] = {};
+                return sizes;
+            }
+        };
+
+        /**
+         * @brief Per-thread packing buffer that only grows, so repeated GEMMs stop allocating after the first call
+         *
+         * @param slot 0 for the packed A block, 1 for the packed B block, higher slots for scratch of the callers of the GEMM
+         * @param size Number of elements needed
+         */
+        template <typename T>
+        T* workspace(int slot, uint64_t size){
+            Workspace<T>* bound = detail::boundWorkspace<T>();
+            auto& buffer = (bound ? *bound : detail::threadWorkspace<T>()).buffers[slot];
+            if (buffer.size() < size){
+                buffer.resize(size);
+                std::atomic<uint64_t>& largest = detail::largestRequests<T>()[slot];
+                uint64_t seen = largest.load(std::memory_order_relaxed);
+                while (seen < size && !largest.compare_exchange_weak(seen, size, std::memory_order_relaxed)) {}
+            }
+            return buffer.data();
+        }
+
+        /**
+         * @brief Makes workspace() of the calling thread hand out the buffers of workspace while alive
+         * Lets an object own the scratch of the kernels it calls, whichever thread calls them. Tasks that run on pool
+         * workers still use the workers' own buffers.
+         */
+        template <typename T>
+        class WorkspaceBinding {
+        public:
+            explicit WorkspaceBinding(Workspace<T>& workspace) : _previous(detail::boundWorkspace<T>()) {
+                detail::boundWorkspace<T>() = &workspace;
+            }
+            ~WorkspaceBinding(){ detail::boundWorkspace<T>() = _previous; }
+
+            WorkspaceBinding(const WorkspaceBinding&) = delete;
+            WorkspaceBinding& operator=(const WorkspaceBinding&) = delete;
+
+        private:
+            Workspace<T>* _previous;
+        };
+
+        /**
+         * @brief Grows workspace to the largest request any kernel has made so far, and the buffers of every pool worker too
+         * After a warm-up call of the kernels, later calls of the same shapes allocate neither on workspace's thread nor on
+         * the workers. TensorParallel::configure() starts new workers, call it again afterwards.
+         */
+        template <typename T>
+        void reserveLargestRequests(Workspace<T>& workspace){
+            uint64_t sizes[WorkspaceSlots];
+            for (int slot = 0; slot < WorkspaceSlots; slot++)
+                sizes[slot] = detail::largestRequests<T>()[slot].load(std::memory_order_relaxed);
+            workspace.reserve(sizes);
+            auto reserve = [&]() { detail::threadWorkspace<T>().reserve(sizes); };
+            TensorParallel::pool().broadcast(reserve);
+        }
+
+        /**
+         * @brief Packs rows [i0, i0 + mc) and columns [p0, p0 + kc) of op(A) into MR-row panels
+         * Inside a panel element (r, k) is stored at k * MR + r. Missing rows of the last panel are zero.
+         */
+        template <typename T>
+        void packA(const T* A, uint64_t lda, Transpose transA, uint64_t i0, uint64_t p0, uint32_t mc, uint32_t kc, T* packed){
+            constexpr uint32_t MR = Blocking<T>::MR;
+            for (uint32_t ip = 0; ip < mc; ip += MR){
+                uint32_t rows = std::min(MR, mc - ip);
+                T* panel = packed + static_cast<uint64_t>(ip) * kc;
+                if (transA == Transpose::No){
+                    // Rows of A become columns of the panel
+                    TensorTranspose::transpose(A + (i0 + ip) * lda + p0, rows, kc, lda, panel, MR);
+                } else {
+                    // op(A) = A^T, so a panel column is a contiguous piece of a stored row
+                    for (uint32_t k = 0; k < kc; k++){
+                        const T* src = A + (p0 + k) * lda + i0 + ip;
+                        std::copy(src, src + rows, panel + k * MR);
+                    }
+                }
+                if (rows < MR){
+                    for (uint32_t k = 0; k < kc; k++){
+                        std::fill(panel + k * MR + rows, panel + (k + 1) * MR, T(0));
+                    }
+                }
+            }
+        }
+
+        /**
+         * @brief Packs rows [p0, p0 + kc) and columns [j0, j0 + nc) of op(B) into NR-column panels
+         * Inside a panel element (k, c) is stored at k * NR + c. Missing columns of the last panel are zero.
+         */
+        template <typename T>
+        void packB(const T* B, uint64_t ldb, Transpose transB, uint64_t p0, uint64_t j0, uint32_t kc, uint32_t nc, T* packed){
+            constexpr uint32_t NR = Blocking<T>::NR;
+            for (uint32_t jp = 0; jp < nc; jp += NR){
+                uint32_t cols = std::min(NR, nc - jp);
+                T* panel = packed + static_cast<uint64_t>(jp) * kc;
+                if (transB == Transpose::No){
+                    for (uint32_t k = 0; k < kc; k++){
+                        const T* src = B + (p0 + k) * ldb + j0 + jp;
+                        std::copy(src, src + cols, panel + k * NR);
+                    }
+                } else {
+                    // op(B) = B^T, so the panel is the transpose of a cols x kc block of the stored matrix
+                    TensorTranspose::transpose(B + (j0 + jp) * ldb + p0, cols, kc, ldb, panel, NR);
+                }
+                if (cols < NR){
+                    for (uint32_t k = 0; k < kc; k++){
+                        std::fill(panel + k * NR + cols, panel + (k + 1) * NR, T(0));
+                    }
+                }
+            }
+        }
+
+        /**
+         * @brief Scalar activation, used on tile borders and for types without NEON support
+         */
+        template <typename T>
+        T activate(T value, Activation activation){
+            switch (activation){
+                case Activation::None:
+                    return value;
+                case Activation::ReLU:
+                    return std::max(value, T(0));
+                case Activation::ReLU6:
+                    return std::min(std::max(value, T(0)), T(6));
+                case Activation::GELU:
+                case Activation::Sigmoid: {
+                    float x = static_cast<float>(value);
+                    float y = activation == Activation::GELU
+                        ? 0.5f * x * (1.0f + std::tanh(0.7978845608f * (x + 0.044715f * x * x * x)))
+                        : 1.0f / (1.0f + std::exp(-x));
+                    if constexpr (std::is_floating_point_v<T>){
+                        return static_cast<T>(y);
+                    } else {
+                        y = std::nearbyint(y);
+                        return y <= 0.0f ? T(0) : y >= static_cast<float>(std::numeric_limits<T>::max()) ? std::numeric_limits<T>::max() : static_cast<T>(y);
+                    }
+                }
+            }
+            return value;
+        }
+
+        /**
+         * @brief Applies the epilogue to one output element at (row, col)
+         */
+        template <typename T>
+        T applyEpilogue(T value, const GemmEpilogue<T>& epilogue, uint64_t row, uint64_t col){
+            value = value * epilogue.scale;
+            if (epilogue.bias)
+                value += epilogue.bias[col];
+            if (epilogue.rowBias)
+                value += epilogue.rowBias[row];
+            if (epilogue.residual)
+                value += epilogue.residual[row * epilogue.residualStride + col];
+            return activate(value, epilogue.activation);
+        }
+
+        /**
+         * @brief Activation of all lanes of a register, matches the scalar activate()
+         */
+        template <typename T>
+        typename TensorSimd::Vec<T>::type activateVector(typename TensorSimd::Vec<T>::type value, Activation activation){
+            using V = TensorSimd::Vec<T>;
+            switch (activation){
+                case Activation::None:
+                    break;
+                case Activation::ReLU:
+                    value = V::max(value, V::dup(0));
+                    break;
+                case Activation::ReLU6:
+                    value = V::min(V::max(value, V::dup(0)), V::dup(6));
+                    break;
+                default: {
+                    if constexpr (std::is_same_v<T, float>){
+                        if (activation == Activation::Sigmoid)
+                            return TensorMath::vsigmoid(value);
+                        float32x4_t cube = vmulq_f32(vmulq_f32(value, value), value);
+                        float32x4_t inner = vmulq_f32(vmlaq_f32(value, cube, vdupq_n_f32(0.044715f)), vdupq_n_f32(0.7978845608f));
+                        float32x4_t half = vmulq_f32(value, vdupq_n_f32(0.5f));
+                        return vmlaq_f32(half, half, TensorMath::vtanh(inner));
+                    }
+                    T lanes[V::Lanes];
+                    V::store(lanes, value);
+                    for (uint32_t l = 0; l < V::Lanes; l++)
+                        lanes[l] = activate(lanes[l], activation);
+                    value = V::load(lanes);
+                }
+            }
+            return value;
+        }
+
+        /**
+         * @brief Applies the epilogue to Lanes consecutive output elements starting at (row, col) while they are in a register
+         */
+        template <typename T>
+        typename TensorSimd::Vec<T>::type applyEpilogue(typename TensorSimd::Vec<T>::type value, const GemmEpilogue<T>& epilogue, uint64_t row, uint64_t col){
+            using V = TensorSimd::Vec<T>;
+            if (epilogue.scale != T(1))
+                value = V::mul(value, V::dup(epilogue.scale));
+            if (epilogue.bias)
+                value = V::add(value, V::load(epilogue.bias + col));
+            if (epilogue.rowBias)
+                value = V::add(value, V::dup(epilogue.rowBias[row]));
+            if (epilogue.residual)
+                value = V::add(value, V::load(epilogue.residual + row * epilogue.residualStride + col));
+            return activateVector<T>(value, epilogue.activation);
+        }
+
+        /**
+         * @brief Writes (or adds, when accumulate is set) an MR x NR tile computed in registers to C
+         * Only the top-left mr x nr part is stored for tiles on the matrix border.
+         * When epilogue is set, it is applied to every stored element; (row, col) is the position of the tile in C.
+         */
+        template <typename T>
+        void storeTile(const T* tile, T* C, uint64_t ldc, uint32_t mr, uint32_t nr, bool accumulate,
+                       const GemmEpilogue<T>* epilogue, uint64_t row, uint64_t col){
+            constexpr uint32_t NR = Blocking<T>::NR;
+            for (uint32_t r = 0; r < mr; r++){
+                T* out = C + r * ldc;
+                for (uint32_t c = 0; c < nr; c++){
+                    T value = tile[r * NR + c];
+                    if (accumulate)
+                        value += out[c];
+                    if (epilogue)
+                        value = applyEpilogue(value, *epilogue, row + r, col + c);
+                    out[c] = value;
+                }
+            }
+        }
+
+        /**
+         * @brief Computes one MR x NR tile of C from an A panel and a B panel of depth kc
+         * The epilogue, when given, runs on the accumulators before they leave the registers; (row, col) locate the tile in C.
+         */
+        template <typename T>
+        void microKernel(uint32_t kc, const T* a, const T* b, T* C, uint64_t ldc, uint32_t mr, uint32_t nr, bool accumulate,
+                         const GemmEpilogue<T>* epilogue, uint64_t row, uint64_t col){
+            constexpr uint32_t MR = Blocking<T>::MR;
+            constexpr uint32_t NR = Blocking<T>::NR;
+            if constexpr (TensorSimd::Vec<T>::Supported){
+                using V = TensorSimd::Vec<T>;
+                constexpr uint32_t L = V::Lanes;
+                typename V::type acc0[MR];
+                typename V::type acc1[MR];
+                for (uint32_t r = 0; r < MR; r++){
+                    acc0[r] = V::dup(0);
+                    acc1[r] = V::dup(0);
+                }
+                for (uint32_t k = 0; k < kc; k++){
+                    typename V::type b0 = V::load(b);
+                    typename V::type b1 = V::load(b + L);
+                    for (uint32_t r = 0; r < MR; r++){
+                        typename V::type av = V::dup(a[r]);
+                        acc0[r] = V::mla(acc0[r], av, b0);
+                        acc1[r] = V::mla(acc1[r], av, b1);
+                    }
+                    a += MR;
+                    b += NR;
+                }
+                if (mr == MR && nr == NR){
+                    for (uint32_t r = 0; r < MR; r++){
+                        T* out = C + r * ldc;
+                        if (accumulate){
+                            acc0[r] = V::add(acc0[r], V::load(out));
+                            acc1[r] = V::add(acc1[r], V::load(out + L));
+                        }
+                        if (epilogue){
+                            acc0[r] = applyEpilogue<T>(acc0[r], *epilogue, row + r, col);
+                            acc1[r] = applyEpilogue<T>(acc1[r], *epilogue, row + r, col + L);
+                        }
+                        V::store(out, acc0[r]);
+                        V::store(out + L, acc1[r]);
+                    }
+                    return;
+                }
+                T tile[MR * NR];
+                for (uint32_t r = 0; r < MR; r++){
+                    V::store(tile + r * NR, acc0[r]);
+                    V::store(tile + r * NR + L, acc1[r]);
+                }
+                storeTile(tile, C, ldc, mr, nr, accumulate, epilogue, row, col);
+            } else {
+                T tile[MR * NR] = {};
+                for (uint32_t k = 0; k < kc; k++){
+                    for (uint32_t r = 0; r < MR; r++){
+                        for (uint32_t c = 0; c < NR; c++){
+                            tile[r * NR + c] += a[r] * b[c];
+                        }
+                    }
+                    a += MR;
+                    b += NR;
+                }
+                storeTile(tile, C, ldc, mr, nr, accumulate, epilogue, row, col);
+            }
+        }
+    };
+
+    /**
+     * @brief Cache-blocked GEMM driver where the caller supplies how operand blocks are packed
+     * This lets operands that are never stored as a matrix (implicit im2col, pre-packed weights, ...) run on the same micro-kernel.
+     *
+     * @param M Rows of C
+     * @param N Depth of the product
+     * @param K Columns of C
+     * @param packA Callable packA(uint64_t i0, uint64_t p0, uint32_t mc, uint32_t kc, T* packed) writing rows [i0, i0 + mc)
+     *              and depth [p0, p0 + kc) of the left operand in the layout of Gemm::packA
+     * @param packB Callable packB(uint64_t p0, uint64_t j0, uint32_t kc, uint32_t nc, T* packed) writing depth [p0, p0 + kc)
+     *              and columns [j0, j0 + nc) of the right operand in the layout of Gemm::packB. An operand that is packed
+     *              already returns a const T* to its block instead, and only uses packed when it has to convert the block.
+     * @param C Output, M x K with ldc elements between rows. It is overwritten, or added to with accumulate.
+     * @param epilogue Optional bias/scale/residual/activation fused into the store of the last K block
+     * @param parallel Whether row panels may be spread over threads; callers that already run in parallel pass false
+     * @param accumulate Whether the product is added to the values already in C
+     */
+    template <typename T, typename PackA, typename PackB>
+    void gemmWithPacking(uint32_t M, uint32_t N, uint32_t K, PackA&& packA, PackB&& packB,
+                         T* C, uint64_t ldc, const std::type_identity_t<GemmEpilogue<T>>* epilogue = nullptr, bool parallel = true,
+                         bool accumulate = false){
+        using Block = Gemm::Blocking<T>;
+        if (M == 0 || K == 0)
+            return;
+        if (N == 0){
+            for (uint32_t i = 0; i < M; i++){
+                for (uint32_t j = 0; j < K; j++){
+                    T value = accumulate ? C[i * ldc + j] : T(0);
+                    C[i * ldc + j] = epilogue ? Gemm::applyEpilogue(value, *epilogue, i, j) : value;
+                }
+            }
+            return;
+        }
+        uint64_t panelsM = (M + Block::MR - 1) / Block::MR;
+        for (uint32_t jc = 0; jc < K; jc += Block::NC){
+            uint32_t nc = std::min(Block::NC, K - jc);
+            uint32_t ncPadded = (nc + Block::NR - 1) / Block::NR * Block::NR;
+            for (uint32_t pc = 0; pc < N; pc += Block::KC){
+                uint32_t kc = std::min(Block::KC, N - pc);
+                bool accumulateBlock = accumulate || pc != 0;
+                const GemmEpilogue<T>* blockEpilogue = pc + kc == N ? epilogue : nullptr;
+                T* bBuffer = Gemm::workspace<T>(1, static_cast<uint64_t>(ncPadded) * kc);
+                const T* bPacked = bBuffer;
+                if constexpr (std::is_void_v<std::invoke_result_t<PackB&, uint64_t, uint64_t, uint32_t, uint32_t, T*>>)
+                    packB(static_cast<uint64_t>(pc), static_cast<uint64_t>(jc), kc, nc, bBuffer);
+                else
+                    bPacked = packB(static_cast<uint64_t>(pc), static_cast<uint64_t>(jc), kc, nc, bBuffer);
+
+                uint64_t panelWork = static_cast<uint64_t>(Block::MR) * kc * nc;
+                uint64_t minPanels = parallel ? std::max<uint64_t>(1, Gemm::ParallelWorkThreshold / panelWork) : panelsM;
+                TensorParallel::parallelFor(0, panelsM, minPanels, [&](uint64_t panelBegin, uint64_t panelEnd) {
+                    for (uint64_t pb = panelBegin; pb < panelEnd; pb += Block::MC / Block::MR){
+                        uint64_t pe = std::min<uint64_t>(panelEnd, pb + Block::MC / Block::MR);
+                        uint32_t ic = static_cast<uint32_t>(pb * Block::MR);
+                        uint32_t mc = static_cast<uint32_t>(std::min<uint64_t>(M, pe * Block::MR) - ic);
+                        T* aPacked = Gemm::workspace<T>(0, (pe - pb) * Block::MR * kc);
+                        packA(static_cast<uint64_t>(ic), static_cast<uint64_t>(pc), mc, kc, aPacked);
+                        for (uint32_t jr = 0; jr < nc; jr += Block::NR){
+                            uint32_t nr = std::min(Block::NR, nc - jr);
+                            for (uint32_t ir = 0; ir < mc; ir += Block::MR){
+                                uint32_t mr = std::min(Block::MR, mc - ir);
+                                Gemm::microKernel(kc, aPacked + static_cast<uint64_t>(ir) * kc, bPacked + static_cast<uint64_t>(jr) * kc,
+                                                  C + (ic + ir) * ldc + jc + jr, ldc, mr, nr, accumulateBlock,
+                                                  blockEpilogue, ic + ir, jc + jr);
+                            }
+                        }
+                    }
+                });
+            }
+        }
+    }
+
+    /**
+     * @brief Packed, cache-blocked matrix product C = op(A) * op(B) on raw row-major buffers
+     * op(X) is X or its transpose depending on the flag. op(A) is M x N, op(B) is N x K and C is M x K, matching matmul2d.
+     * Transposes are applied while packing, so no transposed copy of an operand is ever built.
+     *
+     * @param A Stored A: M x N when transA is No, N x M when it is Yes
+     * @param lda Distance in elements between two stored rows of A
+     * @param B Stored B: N x K when transB is No, K x N when it is Yes
+     * @param ldb Distance in elements between two stored rows of B
+     * @param C Output, M x K with ldc elements between rows. It is overwritten, or added to with accumulate.
+     * @param epilogue Optional bias/scale/residual/activation fused into the store of the last K block
+     * @param parallel Whether row panels may be spread over threads
+     * @param accumulate Whether the product is added to the values already in C
+     */
+    template <typename T>
+    void gemm(uint32_t M, uint32_t N, uint32_t K,
+              const T* A, uint64_t lda, Transpose transA,
+              const T* B, uint64_t ldb, Transpose transB,
+              T* C, uint64_t ldc, const std::type_identity_t<GemmEpilogue<T>>* epilogue = nullptr, bool parallel = true,
+              bool accumulate = false){
+        gemmWithPacking(M, N, K,
+            [=](uint64_t i0, uint64_t p0, uint32_t mc, uint32_t kc, T* packed) { Gemm::packA(A, lda, transA, i0, p0, mc, kc, packed); },
+            [=](uint64_t p0, uint64_t j0, uint32_t kc, uint32_t nc, T* packed) { Gemm::packB(B, ldb, transB, p0, j0, kc, nc, packed); },
+            C, ldc, epilogue, parallel, accumulate);
+    }
+};
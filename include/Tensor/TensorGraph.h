@@ -0,0 +1,214 @@
+#pragma once
+
+#include <array>
+#include <cassert>
+#include <cstdint>
+#include <vector>
+#include "Tensor/Tensor.h"
+#include "Tensor/TensorGemm.h"
+
+/**
+ * Optional graph mode for float models
+ * Ops are recorded on symbolic values, compile() fuses them into as few kernels as possible and plans every
+ * intermediate into one arena, and the compiled graph then runs any number of times without allocating tensors.
+ */
+namespace TensorGraph {
+    using Shape = std::vector<uint32_t>;
+    using TensorMatmul::Activation;
+
+    // Handle to a symbolic tensor recorded in a Graph
+    struct Value {
+        uint32_t id;
+    };
+
+    enum class OpKind : uint8_t {
+        Input,
+        Constant,
+        MatMul,
+        Add,
+        BiasAdd,
+        Sub,
+        Mul,
+        Scale,
+        Activation,
+        Exp,
+        Tanh,
+        Softmax
+    };
+
+    struct Node {
+        OpKind kind;
+        Shape shape;
+        uint32_t a = UINT32_MAX;            // First operand
+        uint32_t b = UINT32_MAX;            // Second operand
+        float scalar = 1.0f;                // Factor of Scale
+        Activation activation = Activation::None;
+        uint64_t constantOffset = 0;        // Start of the values of a Constant in the graph's constant storage
+    };
+
+    class CompiledGraph;
+
+    /**
+     * @brief Records ops on symbolic values, nothing is computed until the compiled graph runs
+     * Every op checks the shapes of its operands when it is recorded.
+     */
+    class Graph {
+    public:
+        /**
+         * @brief New graph input, its data is bound to the compiled graph before running
+         * Inputs are numbered in the order they are created.
+         */
+        Value input(const Shape& shape);
+
+        template <uint16_t N>
+        Value input(const std::array<uint32_t, N>& dims){
+            return input(Shape(dims.begin(), dims.end()));
+        }
+
+        /**
+         * @brief Constant such as a weight matrix, its values are copied into the graph
+         */
+        template <uint16_t N>
+        Value constant(const Tensor<float, N>& tensor){
+            const auto& dims = tensor.getDimensions();
+            return constant(Shape(dims.begin(), dims.end()), tensor.Data.data());
+        }
+
+        Value constant(const Shape& shape, const float* data);
+
+        // [M, N] x [N, K] matrix product
+        Value matmul(Value a, Value b);
+        // Same shapes, or b a vector with one value per element of the last axis of a
+        Value add(Value a, Value b);
+        Value sub(Value a, Value b);
+        Value mul(Value a, Value b);
+        Value scale(Value a, float factor);
+        // Same functions as the GEMM epilogue, GELU is the tanh approximation
+        Value activation(Value a, Activation activation);
+        Value exp(Value a);
+        Value tanh(Value a);
+        // Softmax over the last axis
+        Value softmax(Value a);
+
+        /**
+         * @brief Marks a value as graph output, outputs are numbered in the order they are marked
+         */
+        void output(Value value);
+
+        const Shape& shape(Value value) const;
+
+        /**
+         * @brief Fuses the recorded ops, plans the memory of every intermediate and returns the executable plan
+         * Ops that do not contribute to any output are dropped.
+         */
+        CompiledGraph compile() const;
+
+    private:
+        Value addNode(Node node);
+        Value binary(OpKind kind, Value a, Value b);
+        Value unary(OpKind kind, Value a);
+
+        std::vector<Node> _nodes;
+        std::vector<float> _constants;
+        std::vector<uint32_t> _inputs;
+        std::vector<uint32_t> _outputs;
+
+        friend class CompiledGraph;
+    };
+
+    /**
+     * @brief Executable plan produced by Graph::compile()
+     * run() only reads the bound inputs, the constants and the arena, and writes the bound outputs.
+     */
+    class CompiledGraph {
+    public:
+        // Kind of memory a value lives in
+        enum class Storage : uint8_t {
+            None,           // Fused into a kernel, never stored
+            Input,
+            Constant,
+            Arena,
+            Output
+        };
+
+        struct Buffer {
+            Storage storage = Storage::None;
+            uint64_t offset = 0;            // Input or output index, or float offset into the constants or the arena
+        };
+
+        enum class StepKind : uint8_t {
+            Gemm,
+            Elementwise,
+            Softmax
+        };
+
+        // One op of a fused elementwise chain applied to the running value x
+        struct ElementOp {
+            OpKind kind;
+            uint32_t operand = UINT32_MAX;
+            bool reversed = false;          // Sub computes operand - x instead of x - operand
+            float scalar = 1.0f;
+            Activation activation = Activation::None;
+        };
+
+        struct Step {
+            StepKind kind;
+            uint32_t output;
+            uint32_t a = UINT32_MAX;        // GEMM left operand, chain input or softmax input
+            uint32_t b = UINT32_MAX;        // GEMM right operand
+            uint32_t M = 0, N = 0, K = 0;   // GEMM shapes, op(A) is M x N and op(B) is N x K
+            uint64_t size = 0;              // Elements written
+            uint32_t cols = 0;              // Length of the last axis of the output
+            float scale = 1.0f;             // GEMM epilogue
+            uint32_t bias = UINT32_MAX;
+            uint32_t residual = UINT32_MAX;
+            Activation activation = Activation::None;
+            uint32_t opBegin = 0, opEnd = 0; // Range of ElementOps of an elementwise chain
+        };
+
+        void bindInput(uint32_t index, const float* data);
+        void bindOutput(uint32_t index, float* data);
+
+        template <uint16_t N>
+        void bindInput(uint32_t index, const Tensor<float, N>& tensor){
+            assert(index < _inputs.size() && "Input index out of range");
+            assert(tensor.Data.size() == _inputSizes[index] && "Tensor does not match the shape recorded for this input");
+            bindInput(index, tensor.Data.data());
+        }
+
+        template <uint16_t N>
+        void bindOutput(uint32_t index, Tensor<float, N>& tensor){
+            assert(index < _outputs.size() && "Output index out of range");
+            assert(tensor.Data.size() == _outputSizes[index] && "Tensor does not match the shape of this output");
+            bindOutput(index, tensor.Data.data());
+        }
+
+        /**
+         * @brief Executes the plan, every input and output has to be bound
+         */
+        void run();
+
+        // Floats of the arena shared by all intermediates
+        uint64_t arenaSize() const { return _arena.size(); }
+        // Number of kernels run() launches
+        uint64_t stepCount() const { return _steps.size(); }
+        const std::vector<Step>& steps() const { return _steps; }
+
+    private:
+        friend class Graph;
+
+        const float* address(uint32_t value) const;
+        float* mutableAddress(uint32_t value);
+        void runElementwise(const Step& step);
+
+        std::vector<float> _constants;
+        std::vector<float, DefaultInitAllocator<float>> _arena;
+        std::vector<Buffer> _buffers;
+        std::vector<Step> _steps;
+        std::vector<ElementOp> _ops;
+        std::vector<const float*> _inputs;
+        std::vector<float*> _outputs;
+        std::vector<uint64_t> _inputSizes;
+        std::vector<uint64_t> _outputSizes;
+    };
+};
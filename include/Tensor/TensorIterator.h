@@ -0,0 +1,116 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+/**
+ * @brief Walks every index of an N-dimensional shape in row-major order together with the offset of its element
+ * A step adds the stride of the innermost axis and only carries into the outer axes when it wraps around, so the
+ * offset is never recomputed from the whole index. The strides may describe any layout, a permuted one included.
+ * Loops usually walk the leading axes with a TensorIndex<N - 1> and handle the innermost axis as a plain inner loop.
+ */
+template <uint16_t N>
+class TensorIndex {
+private:
+    std::array<uint32_t, N> _dims;
+    std::array<uint64_t, N> _strides;
+    std::array<uint32_t, N> _index{};
+    uint64_t _offset = 0;
+    bool _done = false;
+
+public:
+    template <typename Stride>
+    TensorIndex(const std::array<uint32_t, N>& dims, const std::array<Stride, N>& strides) : _dims(dims) {
+        for (uint16_t axis = 0; axis < N; axis++) {
+            _strides[axis] = static_cast<uint64_t>(strides[axis]);
+            _done = _done || dims[axis] == 0;
+        }
+    }
+
+    // Row-major strides of a contiguous tensor of the given shape
+    explicit TensorIndex(const std::array<uint32_t, N>& dims) : _dims(dims) {
+        uint64_t stride = 1;
+        for (int axis = N - 1; axis >= 0; axis--) {
+            _strides[axis] = stride;
+            stride *= dims[axis];
+            _done = _done || dims[axis] == 0;
+        }
+    }
+
+    const std::array<uint32_t, N>& index() const {
+        return _index;
+    }
+
+    uint64_t offset() const {
+        return _offset;
+    }
+
+    // True once every index has been visited, or right away for a shape without elements
+    bool done() const {
+        return _done;
+    }
+
+    // Jumps to the index at the given row-major position, how a parallel chunk starts at its first element
+    void seek(uint64_t position) {
+        _offset = 0;
+        for (int axis = N - 1; axis >= 0; axis--) {
+            if (_dims[axis] == 0) {
+                _done = true;
+                return;
+            }
+            _index[axis] = static_cast<uint32_t>(position % _dims[axis]);
+            position /= _dims[axis];
+            _offset += _index[axis] * _strides[axis];
+        }
+        _done = position != 0;
+    }
+
+    // Moves to the next index, returns false when the last one has been passed
+    bool next() {
+        for (int axis = N - 1; axis >= 0; axis--) {
+            _offset += _strides[axis];
+            if (++_index[axis] < _dims[axis]) {
+                return true;
+            }
+            _offset -= static_cast<uint64_t>(_dims[axis]) * _strides[axis];
+            _index[axis] = 0;
+        }
+        _done = true;
+        return false;
+    }
+};
+
+// A shape of rank 0 has exactly one element, at offset 0
+template <>
+class TensorIndex<0> {
+private:
+    std::array<uint32_t, 0> _index{};
+    bool _done = false;
+
+public:
+    template <typename Stride>
+    TensorIndex(const std::array<uint32_t, 0>&, const std::array<Stride, 0>&) {}
+
+    explicit TensorIndex(const std::array<uint32_t, 0>&) {}
+
+    const std::array<uint32_t, 0>& index() const {
+        return _index;
+    }
+
+    uint64_t offset() const {
+        return 0;
+    }
+
+    bool done() const {
+        return _done;
+    }
+
+    void seek(uint64_t position) {
+        _done = position != 0;
+    }
+
+    bool next() {
+        _done = true;
+        return false;
+    }
+};
@@ -0,0 +1,292 @@
+#pragma once
+
+#include <arm_neon.h>
+#include <cstdint>
+
+/**
+ * Vectorized single precision math used by the elementwise kernels and by the fused activations
+ * Every function works on four lanes at once and has no branches, so it can be inlined into other kernels.
+ * Error bounds are the maximum distance in units in the last place (ULP) to the correctly rounded result,
+ * measured against double precision libm over the stated range.
+ */
+namespace TensorMath {
+    namespace detail {
+        inline float32x4_t fma(float32x4_t acc, float32x4_t a, float32x4_t b){
+#if defined(__aarch64__)
+            return vfmaq_f32(acc, a, b);
+#else
+            return vmlaq_f32(acc, a, b);
+#endif
+        }
+
+        inline float32x4_t div(float32x4_t a, float32x4_t b){
+#if defined(__aarch64__)
+            return vdivq_f32(a, b);
+#else
+            float32x4_t r = vrecpeq_f32(b);
+            r = vmulq_f32(r, vrecpsq_f32(b, r));
+            r = vmulq_f32(r, vrecpsq_f32(b, r));
+            return vmulq_f32(a, r);
+#endif
+        }
+
+        inline int32x4_t roundToInt(float32x4_t x){
+#if defined(__aarch64__)
+            return vcvtnq_s32_f32(x);
+#else
+            uint32x4_t sign = vandq_u32(vreinterpretq_u32_f32(x), vdupq_n_u32(0x80000000u));
+            float32x4_t half = vreinterpretq_f32_u32(vorrq_u32(vreinterpretq_u32_f32(vdupq_n_f32(0.5f)), sign));
+            return vcvtq_s32_f32(vaddq_f32(x, half));
+#endif
+        }
+
+        inline float32x4_t select(uint32x4_t mask, float32x4_t a, float32x4_t b){
+            return vbslq_f32(mask, a, b);
+        }
+
+        inline float32x4_t copySign(float32x4_t magnitude, float32x4_t sign){
+            return vbslq_f32(vdupq_n_u32(0x80000000u), sign, magnitude);
+        }
+
+        // 2^n for n in [-126, 127]
+        inline float32x4_t pow2(int32x4_t n){
+            return vreinterpretq_f32_s32(vshlq_n_s32(vaddq_s32(n, vdupq_n_s32(127)), 23));
+        }
+
+        // Keeps the upper 12 bits of the mantissa, the square of the result is exact
+        inline float32x4_t highHalf(float32x4_t x){
+            return vreinterpretq_f32_u32(vandq_u32(vreinterpretq_u32_f32(x), vdupq_n_u32(0xfffff000u)));
+        }
+
+        // erf(x) for |x| < 1, odd polynomial in x
+        inline float32x4_t erfSmall(float32x4_t x){
+            float32x4_t z = vmulq_f32(x, x);
+            float32x4_t p = vdupq_n_f32(7.853861353153693e-5f);
+            p = fma(vdupq_n_f32(-8.010193625184903e-4f), p, z);
+            p = fma(vdupq_n_f32(5.188327685732524e-3f), p, z);
+            p = fma(vdupq_n_f32(-2.685381193529856e-2f), p, z);
+            p = fma(vdupq_n_f32(1.128358514861418e-1f), p, z);
+            p = fma(vdupq_n_f32(-3.761262582423300e-1f), p, z);
+            p = fma(vdupq_n_f32(1.128379165726710e+0f), p, z);
+            return vmulq_f32(x, p);
+        }
+
+        // erfc(z) for z >= 1 given expNegZ2 = exp(-z * z), asymptotic form exp(-z^2) / z * P(1 / z^2)
+        inline float32x4_t erfcTail(float32x4_t z, float32x4_t expNegZ2){
+            float32x4_t q = div(vdupq_n_f32(1.0f), z);
+            float32x4_t y = vmulq_f32(q, q);
+            float32x4_t p = vdupq_n_f32(2.326819970068386e-2f);
+            p = fma(vdupq_n_f32(-1.387039388740657e-1f), p, y);
+            p = fma(vdupq_n_f32(3.687424674597105e-1f), p, y);
+            p = fma(vdupq_n_f32(-5.824733027278666e-1f), p, y);
+            p = fma(vdupq_n_f32(6.210004621745983e-1f), p, y);
+            p = fma(vdupq_n_f32(-4.944515323274145e-1f), p, y);
+            p = fma(vdupq_n_f32(3.404879937665872e-1f), p, y);
+            p = fma(vdupq_n_f32(-2.741127028184656e-1f), p, y);
+            p = fma(vdupq_n_f32(5.638259427386472e-1f), p, y);
+            float32x4_t r = vdupq_n_f32(-1.047766399936249e+1f);
+            r = fma(vdupq_n_f32(1.297719955372516e+1f), r, y);
+            r = fma(vdupq_n_f32(-7.495518717768503e+0f), r, y);
+            r = fma(vdupq_n_f32(2.921019019210786e+0f), r, y);
+            r = fma(vdupq_n_f32(-1.015265279202700e+0f), r, y);
+            r = fma(vdupq_n_f32(4.218463358204948e-1f), r, y);
+            r = fma(vdupq_n_f32(-2.820767439740514e-1f), r, y);
+            r = fma(vdupq_n_f32(5.641895067754075e-1f), r, y);
+            p = select(vcltq_f32(z, vdupq_n_f32(2.0f)), p, r);
+            return vmulq_f32(vmulq_f32(expNegZ2, q), p);
+        }
+    };
+
+    /**
+     * @brief e^x, max error 1.3 ULP over the whole float range including subnormal results
+     * Overflows to +inf above 88.72 and underflows to 0 below -103.97.
+     */
+    inline float32x4_t vexp(float32x4_t x){
+        x = vminq_f32(vmaxq_f32(x, vdupq_n_f32(-104.0f)), vdupq_n_f32(88.8f));
+        int32x4_t n = detail::roundToInt(vmulq_f32(x, vdupq_n_f32(1.44269504088896341f)));
+        float32x4_t nf = vcvtq_f32_s32(n);
+        // r = x - n * ln2 with ln2 split so the first product is exact
+        float32x4_t r = detail::fma(x, nf, vdupq_n_f32(-0.693359375f));
+        r = detail::fma(r, nf, vdupq_n_f32(2.12194440e-4f));
+        float32x4_t p = vdupq_n_f32(1.9875691500e-4f);
+        p = detail::fma(vdupq_n_f32(1.3981999507e-3f), p, r);
+        p = detail::fma(vdupq_n_f32(8.3334519073e-3f), p, r);
+        p = detail::fma(vdupq_n_f32(4.1665795894e-2f), p, r);
+        p = detail::fma(vdupq_n_f32(1.6666665459e-1f), p, r);
+        p = detail::fma(vdupq_n_f32(5.0000001201e-1f), p, r);
+        p = detail::fma(vaddq_f32(r, vdupq_n_f32(1.0f)), p, vmulq_f32(r, r));
+        // Scale in two steps so that n = 128 and subnormal results do not leave the exponent range
+        int32x4_t half = vshrq_n_s32(n, 1);
+        p = vmulq_f32(p, detail::pow2(half));
+        return vmulq_f32(p, detail::pow2(vsubq_s32(n, half)));
+    }
+
+    /**
+     * @brief Natural logarithm, max error 0.9 ULP for all positive inputs including subnormals
+     * Returns -inf for 0, +inf for +inf and NaN for negative inputs.
+     */
+    inline float32x4_t vlog(float32x4_t x){
+        uint32x4_t subnormal = vcltq_f32(x, vdupq_n_f32(1.17549435e-38f));
+        float32x4_t scaled = detail::select(subnormal, vmulq_f32(x, vdupq_n_f32(8388608.0f)), x);
+        int32x4_t bits = vreinterpretq_s32_f32(scaled);
+        int32x4_t e = vsubq_s32(vshrq_n_s32(bits, 23), vdupq_n_s32(126));
+        e = vsubq_s32(e, vandq_s32(vreinterpretq_s32_u32(subnormal), vdupq_n_s32(23)));
+        // Mantissa in [0.5, 1), moved to [sqrt(0.5), sqrt(2)) so the polynomial argument stays small
+        float32x4_t m = vreinterpretq_f32_s32(vorrq_s32(vandq_s32(bits, vdupq_n_s32(0x007fffff)), vdupq_n_s32(0x3f000000)));
+        uint32x4_t low = vcltq_f32(m, vdupq_n_f32(0.707106781186547524f));
+        e = vsubq_s32(e, vandq_s32(vreinterpretq_s32_u32(low), vdupq_n_s32(1)));
+        m = vsubq_f32(detail::select(low, vaddq_f32(m, m), m), vdupq_n_f32(1.0f));
+        float32x4_t ef = vcvtq_f32_s32(e);
+
+        float32x4_t z = vmulq_f32(m, m);
+        float32x4_t p = vdupq_n_f32(7.0376836292e-2f);
+        p = detail::fma(vdupq_n_f32(-1.1514610310e-1f), p, m);
+        p = detail::fma(vdupq_n_f32(1.1676998740e-1f), p, m);
+        p = detail::fma(vdupq_n_f32(-1.2420140846e-1f), p, m);
+        p = detail::fma(vdupq_n_f32(1.4249322787e-1f), p, m);
+        p = detail::fma(vdupq_n_f32(-1.6668057665e-1f), p, m);
+        p = detail::fma(vdupq_n_f32(2.0000714765e-1f), p, m);
+        p = detail::fma(vdupq_n_f32(-2.4999993993e-1f), p, m);
+        p = detail::fma(vdupq_n_f32(3.3333331174e-1f), p, m);
+        float32x4_t y = vmulq_f32(vmulq_f32(p, m), z);
+        y = detail::fma(y, ef, vdupq_n_f32(-2.12194440e-4f));
+        y = detail::fma(y, z, vdupq_n_f32(-0.5f));
+        float32x4_t result = vaddq_f32(m, y);
+        result = detail::fma(result, ef, vdupq_n_f32(0.693359375f));
+
+        result = detail::select(vceqq_f32(x, vdupq_n_f32(__builtin_inff())), x, result);
+        result = detail::select(vceqq_f32(x, vdupq_n_f32(0.0f)), vdupq_n_f32(-__builtin_inff()), result);
+        return detail::select(vcltq_f32(x, vdupq_n_f32(0.0f)), vdupq_n_f32(__builtin_nanf("")), result);
+    }
+
+    /**
+     * @brief Hyperbolic tangent, max error 2 ULP over the whole float range
+     */
+    inline float32x4_t vtanh(float32x4_t x){
+        float32x4_t ax = vabsq_f32(x);
+        float32x4_t z = vmulq_f32(x, x);
+        float32x4_t p = vdupq_n_f32(-5.70498872745e-3f);
+        p = detail::fma(vdupq_n_f32(2.06390887954e-2f), p, z);
+        p = detail::fma(vdupq_n_f32(-5.37397155531e-2f), p, z);
+        p = detail::fma(vdupq_n_f32(1.33314422036e-1f), p, z);
+        p = detail::fma(vdupq_n_f32(-3.33332819422e-1f), p, z);
+        float32x4_t small = detail::fma(x, vmulq_f32(x, z), p);
+        // 1 - 2 / (e^2|x| + 1), saturates to 1 once the exponential overflows
+        float32x4_t e = vexp(vaddq_f32(ax, ax));
+        float32x4_t large = vsubq_f32(vdupq_n_f32(1.0f), detail::div(vdupq_n_f32(2.0f), vaddq_f32(e, vdupq_n_f32(1.0f))));
+        return detail::select(vcltq_f32(ax, vdupq_n_f32(0.625f)), small, detail::copySign(large, x));
+    }
+
+    /**
+     * @brief Logistic function 1 / (1 + e^-x), max error 4 ULP for x > -87 (smaller inputs return 0)
+     */
+    inline float32x4_t vsigmoid(float32x4_t x){
+        float32x4_t e = vexp(vnegq_f32(x));
+        return detail::div(vdupq_n_f32(1.0f), vaddq_f32(e, vdupq_n_f32(1.0f)));
+    }
+
+    /**
+     * @brief Error function, max error 3 ULP over the whole float range
+     */
+    inline float32x4_t verf(float32x4_t x){
+        float32x4_t ax = vabsq_f32(x);
+        float32x4_t small = detail::erfSmall(x);
+        // Past 3.92 erfc is below half an ULP of 1
+        float32x4_t z = vminq_f32(vmaxq_f32(ax, vdupq_n_f32(1.0f)), vdupq_n_f32(3.92f));
+        float32x4_t tail = detail::erfcTail(z, vexp(vnegq_f32(vmulq_f32(z, z))));
+        float32x4_t large = vsubq_f32(vdupq_n_f32(1.0f), tail);
+        large = detail::select(vcgeq_f32(ax, vdupq_n_f32(3.92f)), vdupq_n_f32(1.0f), large);
+        return detail::select(vcltq_f32(ax, vdupq_n_f32(1.0f)), small, detail::copySign(large, x));
+    }
+
+    /**
+     * @brief Exact GELU x / 2 * (1 + erf(x / sqrt(2))), max error 16 ULP for x in [-10, 10]
+     * Negative inputs use erfc(|x| / sqrt(2)) directly so the tail does not lose precision to cancellation.
+     * The largest errors are around x = -1.4, where erfc is still computed as 1 - erf.
+     */
+    inline float32x4_t vgelu(float32x4_t x){
+        const float32x4_t invSqrt2 = vdupq_n_f32(0.70710678118654752f);
+        // Beyond 16 the negative tail underflows, clamping keeps infinities out of the split below
+        float32x4_t ax = vminq_f32(vabsq_f32(x), vdupq_n_f32(16.0f));
+        float32x4_t z = vmulq_f32(ax, invSqrt2);
+        float32x4_t erfcSmall = vsubq_f32(vdupq_n_f32(1.0f), detail::erfSmall(z));
+        // exp(-x^2 / 2) with x split into a high half whose square is exact and a small remainder
+        float32x4_t hi = detail::highHalf(ax);
+        float32x4_t lo = vsubq_f32(ax, hi);
+        float32x4_t expHi = vexp(vmulq_f32(vmulq_f32(hi, hi), vdupq_n_f32(-0.5f)));
+        float32x4_t expLo = vexp(vmulq_f32(vmulq_f32(lo, vaddq_f32(ax, hi)), vdupq_n_f32(-0.5f)));
+        float32x4_t zt = vmaxq_f32(z, vdupq_n_f32(1.0f));
+        float32x4_t erfcTail = detail::erfcTail(zt, vmulq_f32(expHi, expLo));
+        float32x4_t erfc = detail::select(vcltq_f32(z, vdupq_n_f32(1.0f)), erfcSmall, erfcTail);
+        // Phi(x) = 1 - erfc(z) / 2 for x >= 0 and erfc(z) / 2 for x < 0
+        float32x4_t halfErfc = vmulq_f32(erfc, vdupq_n_f32(0.5f));
+        float32x4_t phi = detail::select(vcltq_f32(x, vdupq_n_f32(0.0f)), halfErfc, vsubq_f32(vdupq_n_f32(1.0f), halfErfc));
+        return vmulq_f32(x, phi);
+    }
+
+    /**
+     * @brief Square root, correctly rounded on AArch64 and max error 3 ULP on 32-bit ARM
+     */
+    inline float32x4_t vsqrt(float32x4_t x){
+#if defined(__aarch64__)
+        return vsqrtq_f32(x);
+#else
+        float32x4_t r = vrsqrteq_f32(x);
+        r = vmulq_f32(r, vrsqrtsq_f32(vmulq_f32(x, r), r));
+        r = vmulq_f32(r, vrsqrtsq_f32(vmulq_f32(x, r), r));
+        float32x4_t s = vmulq_f32(x, r);
+        // Residual correction s + r / 2 * (x - s^2)
+        s = detail::fma(s, vmulq_f32(r, vdupq_n_f32(0.5f)), vmlsq_f32(x, s, s));
+        uint32x4_t special = vorrq_u32(vceqq_f32(x, vdupq_n_f32(0.0f)), vceqq_f32(x, vdupq_n_f32(__builtin_inff())));
+        return detail::select(special, x, s);
+#endif
+    }
+
+    /**
+     * @brief Reciprocal square root 1 / sqrt(x), max error 2 ULP for positive normal inputs
+     * Hardware estimate refined by two Newton-Raphson steps and a final residual correction.
+     */
+    inline float32x4_t vrsqrt(float32x4_t x){
+        float32x4_t r = vrsqrteq_f32(x);
+        r = vmulq_f32(r, vrsqrtsq_f32(vmulq_f32(x, r), r));
+        r = vmulq_f32(r, vrsqrtsq_f32(vmulq_f32(x, r), r));
+        // r + r / 2 * (1 - x * r^2)
+        float32x4_t residual = detail::fma(vdupq_n_f32(1.0f), vmulq_f32(x, r), vnegq_f32(r));
+        float32x4_t result = detail::fma(r, vmulq_f32(r, vdupq_n_f32(0.5f)), residual);
+        result = detail::select(vceqq_f32(x, vdupq_n_f32(0.0f)), vdupq_n_f32(__builtin_inff()), result);
+        return detail::select(vceqq_f32(x, vdupq_n_f32(__builtin_inff())), vdupq_n_f32(0.0f), result);
+    }
+
+    /**
+     * @brief Sum of the four lanes
+     */
+    inline float horizontalSum(float32x4_t v){
+        float32x2_t sum = vadd_f32(vget_low_f32(v), vget_high_f32(v));
+        sum = vpadd_f32(sum, sum);
+        return vget_lane_f32(sum, 0);
+    }
+
+    /**
+     * @brief Largest of the four lanes
+     */
+    inline float horizontalMax(float32x4_t v){
+        float32x2_t max = vmax_f32(vget_low_f32(v), vget_high_f32(v));
+        max = vpmax_f32(max, max);
+        return vget_lane_f32(max, 0);
+    }
+
+    /**
+     * Array kernels: apply the vector function to size floats from src and write them to dst
+     * dst may be the same pointer as src. Large arrays are split across worker threads.
+     */
+    constexpr uint64_t ParallelChunk = 1 << 15;
+
+    void exp(const float* src, float* dst, uint64_t size);
+    void log(const float* src, float* dst, uint64_t size);
+    void tanh(const float* src, float* dst, uint64_t size);
+    void sigmoid(const float* src, float* dst, uint64_t size);
+    void erf(const float* src, float* dst, uint64_t size);
+    void gelu(const float* src, float* dst, uint64_t size);
+    void sqrt(const float* src, float* dst, uint64_t size);
+    void rsqrt(const float* src, float* dst, uint64_t size);
+};
@@ -1,9 +1,14 @@
+#pragma once
+
 #include "Tensor/Tensor.h"
+#include "Tensor/TensorGemm.h"
+#include "Tensor/TensorStrassen.h"
+#include <algorithm>
 #include <arm_neon.h>
 #include <cassert>
 #include <cstdint>
 #include <array>
-#include <future>
+#include <optional>
 #include <type_traits>
 
 namespace TensorMatmul {
@@ -57,9 +62,8 @@ namespace TensorMatmul {
         // Check that A and B have the same size
         assert(A.Data.size() == B.Data.size() && "Vectors must have the same dimensions");
         T result = 0; // Initialize the result to zero
-        int i = 0;
-        for (int i = 0; i < A.Data.size(); i ++) {                     
-            result += A(i) * B(i);  
+        for (uint64_t i = 0; i < A.Data.size(); i++) {
+            result += A.Data[i] * B.Data[i];
         }
         return result;
     }
@@ -119,24 +123,38 @@ namespace TensorMatmul {
         uint32_t N_dim = dimsA[1];
         uint32_t K_dim = dimsB[1];
         std::array<uint32_t, 2> dims = {M_dim, K_dim};
-        Tensor<T, 2> result(dims); 
-        for(int i = 0; i < M_dim; i++){
-
-            for(int j = 0; j < K_dim; j+=1){
-                uint8_t sum = 0;
-                for(int k = 0; k < N_dim; k++){
-                    sum += A(i,k) * B(k, j);
+        Tensor<T, 2> result(dims);
+        // Row i of the result accumulates A(i, k) times row k of B, the inner loop runs over contiguous rows and vectorizes
+        for(uint32_t i = 0; i < M_dim; i++){
+            const T* rowA = A.row(i);
+            T* rowC = result.row(i);
+            for(uint32_t k = 0; k < N_dim; k++){
+                const T a = rowA[k];
+                const T* rowB = B.row(k);
+                for(uint32_t j = 0; j < K_dim; j++){
+                    rowC[j] += a * rowB[j];
                 }
-                result(i, j) = sum;
             }
         }
         return result;
     }
 
 
+    /**
+     * @brief Internal function adding the parts of A * B that the even Strassen core leaves out, see Strassen::peel
+     */
+    template <typename T>
+    void strassenPeel(const Tensor<T, 2>& A, const Tensor<T, 2>& B, Tensor<T, 2>& C){
+        uint32_t N_dim = A.getDimensions()[1];
+        uint32_t K_dim = B.getDimensions()[1];
+        Strassen::peel(A.getDimensions()[0], N_dim, K_dim, A.Data.data(), N_dim, B.Data.data(), K_dim, C.Data.data(), K_dim);
+    }
+
     /**
      * @brief Internal function for matrix multiplications using impoved Strassen algorithm
-     * 
+     * Odd dimensions are peeled: the recursion runs on the even core taken straight from A and B, and strassenPeel
+     * adds the last row, column and depth slice, so no operand is ever padded.
+     *
      * @param A First input tensor of type Tensor<T, 2>
      * @param B Second input tensor of type Tensor<T, 2>
      * @return The matrix multiplication product as a Tensor<T, 2> value
@@ -152,92 +170,62 @@ namespace TensorMatmul {
         if (dimsA[0] < 2 || dimsB[0] < 2 || dimsB[1] < 2)
             return naivematmul2d(A, B);
         // Or if matrices are small
-        if (dimsA[0] * dimsA[1] * dimsB[1] < 512)
+        if (static_cast<uint64_t>(dimsA[0]) * dimsA[1] * dimsB[1] < 512)
             return naivematmul2d(A, B);
 
+        // The quadrants cover the even core of the result and strassenPeel the rest, so it does not need zeroing
         std::array<uint32_t, 2> dims = {M_dim, K_dim};
-        Tensor<T, 2> result{dims};
-        // Set "correct matrices"
-        Tensor<T, 2> A_div2 = A;
-        Tensor<T, 2> B_div2 = B;
-
-        if (dimsA[0] % 2 == 1 || dimsA[1] % 2 == 1 || dimsB[1] % 2 == 1){
-            result = result.ExtendToDivisibleBy2();
-            A_div2 = A_div2.ExtendToDivisibleBy2();
-            B_div2 = B_div2.ExtendToDivisibleBy2();
-        }
-        
-
-        Tensor<T, 2> A11 = A_div2.LeftTopPart();
-        Tensor<T, 2> A12 = A_div2.RightTopPart();
-        Tensor<T, 2> A21 = A_div2.LeftBottomPart();
-        Tensor<T, 2> A22 = A_div2.RightBottomPart();
-        Tensor<T, 2> B11 = B_div2.LeftTopPart();
-        Tensor<T, 2> B12 = B_div2.RightTopPart();
-        Tensor<T, 2> B21 = B_div2.LeftBottomPart();
-        Tensor<T, 2> B22 = B_div2.RightBottomPart();
-
-        
+        Tensor<T, 2> result(dims, TensorUninitialized);
+        uint32_t M_half = M_dim / 2;
+        uint32_t N_half = N_dim / 2;
+        uint32_t K_half = K_dim / 2;
+
+        Tensor<T, 2> A11 = A.SubMatrix(0, 0, M_half, N_half);
+        Tensor<T, 2> A12 = A.SubMatrix(0, N_half, M_half, N_half);
+        Tensor<T, 2> A21 = A.SubMatrix(M_half, 0, M_half, N_half);
+        Tensor<T, 2> A22 = A.SubMatrix(M_half, N_half, M_half, N_half);
+        Tensor<T, 2> B11 = B.SubMatrix(0, 0, N_half, K_half);
+        Tensor<T, 2> B12 = B.SubMatrix(0, K_half, N_half, K_half);
+        Tensor<T, 2> B21 = B.SubMatrix(N_half, 0, N_half, K_half);
+        Tensor<T, 2> B22 = B.SubMatrix(N_half, K_half, N_half, K_half);
+
         // Compute M1 to M7
+        std::optional<Tensor<T, 2>> products[7];
+        auto product = [&](uint64_t index) {
+            switch (index){
+                case 0: products[0].emplace(matmul2dStrassen(A11 + A22, B11 + B22, level + 1)); break;
+                case 1: products[1].emplace(matmul2dStrassen(A21 + A22, B11, level + 1)); break;
+                case 2: products[2].emplace(matmul2dStrassen(A11, B12 - B22, level + 1)); break;
+                case 3: products[3].emplace(matmul2dStrassen(A22, B21 - B11, level + 1)); break;
+                case 4: products[4].emplace(matmul2dStrassen(A11 + A12, B22, level + 1)); break;
+                case 5: products[5].emplace(matmul2dStrassen(A21 - A11, B11 + B12, level + 1)); break;
+                default: products[6].emplace(matmul2dStrassen(A12 - A22, B21 + B22, level + 1)); break;
+            }
+        };
         if (level == 0){
-            auto futureM1 = std::async(std::launch::async, [&]() { return matmul2dStrassen(A11 + A22, B11 + B22, level++); });
-            auto futureM2 = std::async(std::launch::async, [&]() { return matmul2dStrassen(A21 + A22, B11, level++); });
-            auto futureM3 = std::async(std::launch::async, [&]() { return matmul2dStrassen(A11, B12 - B22, level++); });
-            auto futureM4 = std::async(std::launch::async, [&]() { return matmul2dStrassen(A22, B21 - B11, level++); });
-            auto futureM5 = std::async(std::launch::async, [&]() { return matmul2dStrassen(A11 + A12, B22, level++); });
-            auto futureM6 = std::async(std::launch::async, [&]() { return matmul2dStrassen(A21 - A11, B11 + B12, level++); });
-            auto futureM7 = std::async(std::launch::async, [&]() { return matmul2dStrassen(A12 - A22, B21 + B22, level++); });
-        
-            // Get the results from the futures
-            Tensor<T, 2> M1 = futureM1.get();
-            Tensor<T, 2> M2 = futureM2.get();
-            Tensor<T, 2> M3 = futureM3.get();
-            Tensor<T, 2> M4 = futureM4.get();
-            Tensor<T, 2> M5 = futureM5.get();
-            Tensor<T, 2> M6 = futureM6.get();
-            Tensor<T, 2> M7 = futureM7.get();
-
-            // Compute final submatrices of the result
-            Tensor<T, 2> C11 = M1 + M4 - M5 + M7;
-            Tensor<T, 2> C12 = M3 + M5;
-            Tensor<T, 2> C21 = M2 + M4;
-            Tensor<T, 2> C22 = M1 - M2 + M3 + M6;
-
-            // Combine the submatrices into the final result
-            result.FillLeftTopPart(C11);
-            result.FillRightTopPart(C12);
-            result.FillLeftBottomPart(C21);
-            result.FillRightBottomPart(C22);
-
-            result = result.CutToDimensions(M_dim, K_dim);
-            return result;
-        }else {
-            // Compute M1 to M7
-            Tensor<T, 2> M1 = matmul2dStrassen(A11 + A22, B11 + B22, level++);
-            Tensor<T, 2> M2 = matmul2dStrassen(A21 + A22, B11, level++);
-            Tensor<T, 2> M3 = matmul2dStrassen(A11, B12 - B22, level++);
-            Tensor<T, 2> M4 = matmul2dStrassen(A22, B21 - B11, level++);
-            Tensor<T, 2> M5 = matmul2dStrassen(A11 + A12, B22, level++);
-            Tensor<T, 2> M6 = matmul2dStrassen(A21 - A11, B11 + B12, level++);
-            Tensor<T, 2> M7 = matmul2dStrassen(A12 - A22, B21 + B22, level++);
-
-            // Compute final submatrices of the result
-            Tensor<T, 2> C11 = M1 + M4 - M5 + M7;
-            Tensor<T, 2> C12 = M3 + M5;
-            Tensor<T, 2> C21 = M2 + M4;
-            Tensor<T, 2> C22 = M1 - M2 + M3 + M6;
-
-            // Combine the submatrices into the final result
-            result.FillLeftTopPart(C11);
-            result.FillRightTopPart(C12);
-            result.FillLeftBottomPart(C21);
-            result.FillRightBottomPart(C22);
-
-            result = result.CutToDimensions(M_dim, K_dim);
-            return result;
+            // The seven products are tasks of the shared pool, so they run on the configured cores and faster cores take more of them
+            TensorParallel::pool().run(7, product);
+        } else {
+            for (uint64_t index = 0; index < 7; index++)
+                product(index);
         }
+        Tensor<T, 2>& M1 = *products[0];
+        Tensor<T, 2>& M2 = *products[1];
+        Tensor<T, 2>& M3 = *products[2];
+        Tensor<T, 2>& M4 = *products[3];
+        Tensor<T, 2>& M5 = *products[4];
+        Tensor<T, 2>& M6 = *products[5];
+        Tensor<T, 2>& M7 = *products[6];
+
+        // Combine the submatrices into the final result
+        result.FillSubMatrix(0, 0, M1 + M4 - M5 + M7);
+        result.FillSubMatrix(0, K_half, M3 + M5);
+        result.FillSubMatrix(M_half, 0, M2 + M4);
+        result.FillSubMatrix(M_half, K_half, M1 - M2 + M3 + M6);
+        strassenPeel(A, B, result);
+        return result;
     }
-     
+
     /**
      * @brief Computes the matrix product of two two-dimensional tensors with unknown type
      * It's just a wrapper for a real function
@@ -250,4 +238,94 @@ namespace TensorMatmul {
     Tensor<T, 2> matmul2d(const Tensor<T, 2>& A, const Tensor<T, 2>& B) {
         return matmul2dStrassen(A, B, 0);
     }
+
+    /**
+     * @brief Operations fused into the store of a matmul2d result, see GemmEpilogue
+     * out = activation(scale * A * B + bias[col] + residual[row, col]). Null tensors skip the corresponding step.
+     */
+    template <typename T>
+    struct Epilogue {
+        const Tensor<T, 1>* bias = nullptr;         // One value per output column
+        T scale = T(1);                             // Multiplies the product
+        Activation activation = Activation::None;
+        const Tensor<T, 2>* residual = nullptr;     // Same shape as the output
+    };
+
+    /**
+     * @brief Internal function checking a matmul2d epilogue against the output dimensions and turning it into a GemmEpilogue
+     */
+    template <typename T>
+    GemmEpilogue<T> toGemmEpilogue(const Epilogue<T>* epilogue, const std::array<uint32_t, 2>& dims) {
+        GemmEpilogue<T> gemmEpilogue;
+        if (epilogue){
+            assert((!epilogue->bias || epilogue->bias->getDimensions()[0] == dims[1]) && "Bias must have one value per output column");
+            assert((!epilogue->residual || epilogue->residual->getDimensions() == dims) && "Residual must have the shape of the output");
+            gemmEpilogue.bias = epilogue->bias ? epilogue->bias->Data.data() : nullptr;
+            gemmEpilogue.scale = epilogue->scale;
+            gemmEpilogue.activation = epilogue->activation;
+            gemmEpilogue.residual = epilogue->residual ? epilogue->residual->Data.data() : nullptr;
+            gemmEpilogue.residualStride = dims[1];
+        }
+        return gemmEpilogue;
+    }
+
+    /**
+     * @brief Internal function running op(A) * op(B) on the packed GEMM, with an optional fused epilogue
+     */
+    template <typename T>
+    Tensor<T, 2> matmul2dPacked(const Tensor<T, 2>& A, const Tensor<T, 2>& B, Transpose transA, Transpose transB, const Epilogue<T>* epilogue) {
+        const auto& dimsA = A.getDimensions();
+        const auto& dimsB = B.getDimensions();
+        uint32_t M_dim = transA == Transpose::No ? dimsA[0] : dimsA[1];
+        uint32_t N_dim = transA == Transpose::No ? dimsA[1] : dimsA[0];
+        uint32_t K_dim = transB == Transpose::No ? dimsB[1] : dimsB[0];
+        assert(N_dim == (transB == Transpose::No ? dimsB[0] : dimsB[1]) && "For 2D matrix multiplication matrices need to have shapes M*N and N*K");
+        std::array<uint32_t, 2> dims = {M_dim, K_dim};
+        GemmEpilogue<T> gemmEpilogue = toGemmEpilogue(epilogue, dims);
+        Tensor<T, 2> result(dims, TensorUninitialized);
+        gemm(M_dim, N_dim, K_dim, A.Data.data(), dimsA[1], transA, B.Data.data(), dimsB[1], transB,
+             result.Data.data(), K_dim, epilogue ? &gemmEpilogue : nullptr);
+        return result;
+    }
+
+    /**
+     * @brief Computes op(A) * op(B) where op transposes the operand when its flag is Transpose::Yes
+     * Transposed operands are read directly by the packing stage of the GEMM, no transposed copy is made.
+     *
+     * @param A First input tensor, M x N (or N x M when transA is Transpose::Yes)
+     * @param B Second input tensor, N x K (or K x N when transB is Transpose::Yes)
+     * @param transA Whether A is used transposed
+     * @param transB Whether B is used transposed
+     * @return The M x K matrix multiplication product as a Tensor<T, 2> value
+     */
+    template <typename T>
+    Tensor<T, 2> matmul2d(const Tensor<T, 2>& A, const Tensor<T, 2>& B, Transpose transA, Transpose transB) {
+        if (transA == Transpose::No && transB == Transpose::No)
+            return matmul2dStrassen(A, B, 0);
+        return matmul2dPacked<T>(A, B, transA, transB, nullptr);
+    }
+
+    /**
+     * @brief Computes op(A) * op(B) and applies the epilogue to each output tile while it is still in registers
+     * Bias, scale, residual and activation cost no extra pass over the result.
+     *
+     * @param A First input tensor, M x N (or N x M when transA is Transpose::Yes)
+     * @param B Second input tensor, N x K (or K x N when transB is Transpose::Yes)
+     * @param transA Whether A is used transposed
+     * @param transB Whether B is used transposed
+     * @param epilogue Bias (K values), scale, residual (M x K) and activation to fuse
+     * @return The M x K result as a Tensor<T, 2> value
+     */
+    template <typename T>
+    Tensor<T, 2> matmul2d(const Tensor<T, 2>& A, const Tensor<T, 2>& B, Transpose transA, Transpose transB, const Epilogue<T>& epilogue) {
+        return matmul2dPacked<T>(A, B, transA, transB, &epilogue);
+    }
+
+    /**
+     * @brief Computes A * B with a fused epilogue, see the overload with transpose flags
+     */
+    template <typename T>
+    Tensor<T, 2> matmul2d(const Tensor<T, 2>& A, const Tensor<T, 2>& B, const Epilogue<T>& epilogue) {
+        return matmul2dPacked<T>(A, B, Transpose::No, Transpose::No, &epilogue);
+    }
 };
\ No newline at end of file
@@ -0,0 +1,153 @@
+#pragma once
+
+#include <cassert>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "Tensor/PackedMatrix.h"
+#include "Tensor/Tensor.h"
+#include "Tensor/TensorConv.h"
+#include "Tensor/TensorGemm.h"
+
+/**
+ * Inference runtime for feed-forward float models
+ * A model is a list of layers applied one after the other. Shapes are inferred and checked as layers are added or
+ * loaded, every intermediate activation lives in one ping-pong arena sized for the largest of them, and run() reuses
+ * that memory for every frame. Activations are 2-D [batch, features] or 4-D NCHW.
+ */
+namespace TensorModel {
+    using Shape = std::vector<uint32_t>;
+    using TensorMatmul::Activation;
+
+    // Values are stored in model files, new kinds are only ever appended
+    enum class LayerKind : uint32_t {
+        Linear,
+        Conv2D,
+        MaxPool2D,
+        AvgPool2D,
+        Activation,
+        BatchNorm,
+        LayerNorm,
+        Softmax
+    };
+
+    /**
+     * @brief Window of a pooling layer
+     * Padding never wins a max pool, and an average pool divides by the full window including padding.
+     */
+    struct Pool2DParams {
+        uint32_t kernelH = 2;
+        uint32_t kernelW = 2;
+        uint32_t strideH = 2;
+        uint32_t strideW = 2;
+        uint32_t padH = 0;
+        uint32_t padW = 0;
+    };
+
+    struct Layer {
+        LayerKind kind;
+        Shape inputShape;
+        Shape outputShape;
+        Shape weightShape;                  // [out, in] of a Linear layer, [outChannels, inChannels / groups, kernelH, kernelW] of a Conv2D
+        uint64_t weights = 0;               // Float offset of the first parameter in the model's parameter storage
+        uint64_t bias = UINT64_MAX;         // Float offset of the bias, UINT64_MAX when there is none
+        uint64_t folded = UINT64_MAX;       // Float offset of the per-channel scale then shift a BatchNorm runs with
+        uint32_t packed = UINT32_MAX;       // Index of the pre-packed weights of a Linear layer
+        TensorConv::Conv2DParams conv;
+        Pool2DParams pool;
+        Activation activation = Activation::None;   // Own function of an Activation layer, fused one of Linear and Conv2D
+        bool fused = false;                 // Activation folded into the layer before it, run() skips it
+        float epsilon = 0.0f;
+    };
+
+    /**
+     * @brief Layer list built in code or loaded from a model file, ready to run
+     * Linear weights are packed once for the GEMM, batch norms are folded into a scale and a shift per channel and
+     * an activation right after a Linear or Conv2D layer is fused into that layer's output store.
+     */
+    class Model {
+    public:
+        /**
+         * @param inputShape Shape of the input of run(), [batch, features] or [batch, channels, height, width]
+         */
+        explicit Model(const Shape& inputShape);
+
+        /**
+         * @brief Reads a model written by save()
+         * The loaded model is warmed up, so its first run() allocates nothing either, on any thread.
+         * Throws std::runtime_error when the file cannot be read, is not a model file or does not fit the shapes it declares.
+         */
+        static Model load(const std::string& path);
+
+        /**
+         * @brief Writes the input shape and every layer with its parameters, in the original unfused form
+         * The format is little endian: "DPMD", version, input rank and dims, layer count, then per layer its kind,
+         * its integer fields and its float parameters. Throws std::runtime_error when the file cannot be written.
+         */
+        void save(const std::string& path) const;
+
+        // y = x W^T + b with W [outFeatures, inFeatures] as PyTorch stores it, every axis after the first is flattened
+        void linear(const Tensor<float, 2>& weights, const Tensor<float, 1>* bias = nullptr);
+        // NCHW convolution, weights [outChannels, inChannels / groups, kernelH, kernelW]. params.layout must be NCHW.
+        void conv2d(const Tensor<float, 4>& weights, const Tensor<float, 1>* bias = nullptr, const TensorConv::Conv2DParams& params = {});
+        void maxPool2d(const Pool2DParams& params = {});
+        void avgPool2d(const Pool2DParams& params = {});
+        void activation(Activation activation);
+        // Inference batch norm over axis 1 with the running statistics of training
+        void batchNorm(const Tensor<float, 1>& gamma, const Tensor<float, 1>& beta, const Tensor<float, 1>& mean,
+                       const Tensor<float, 1>& variance, float epsilon = 1e-5f);
+        // Normalizes the last axis
+        void layerNorm(const Tensor<float, 1>& gamma, const Tensor<float, 1>& beta, float epsilon = 1e-5f);
+        // Softmax over the last axis
+        void softmax();
+
+        /**
+         * @brief Runs every layer on input and writes the last activation to output, without allocating
+         * input and output hold inputShape() and outputShape() floats and must not overlap the arena.
+         */
+        void run(const float* input, float* output);
+
+        /**
+         * @brief Runs the model once on zeros and sizes the scratch buffers of the kernels for it
+         * The thread calling run() uses the model's own scratch, the pool workers their per-thread buffers, and both are
+         * grown here to the largest request of the warm-up. Call it once after building a model in code before the runs
+         * that must not allocate, and again after TensorParallel::configure() or a change of the parallel thresholds.
+         */
+        void warmUp();
+
+        template <uint16_t N, uint16_t M>
+        void run(const Tensor<float, N>& input, Tensor<float, M>& output){
+            assert(input.Data.size() == elementCount(_inputShape) && "Input does not match the input shape of the model");
+            assert(output.Data.size() == elementCount(outputShape()) && "Output does not match the output shape of the model");
+            run(input.Data.data(), output.Data.data());
+        }
+
+        const Shape& inputShape() const { return _inputShape; }
+        const Shape& outputShape() const { return _layers.empty() ? _inputShape : _layers.back().outputShape; }
+        const std::vector<Layer>& layers() const { return _layers; }
+        // Floats of the two halves of the ping-pong arena together
+        uint64_t arenaSize() const { return _arena.size(); }
+
+        // Milliseconds each layer took in the last run(), 0 for fused activations
+        const std::vector<double>& timings() const { return _timings; }
+        // One line per layer with its kind, output shape and time in the last run
+        std::string profile() const;
+
+        static const char* name(LayerKind kind);
+        static uint64_t elementCount(const Shape& shape);
+
+    private:
+        Layer& addLayer(LayerKind kind, const Shape& outputShape);
+        uint64_t addParameters(const float* values, uint64_t count);
+        void runLayer(const Layer& layer, const float* src, float* dst);
+
+        Shape _inputShape;
+        std::vector<Layer> _layers;
+        std::vector<float> _parameters;
+        std::vector<PackedMatrix<float>> _packed;
+        std::vector<float, DefaultInitAllocator<float>> _arena;
+        std::vector<double> _timings;
+        // Kernel scratch of whichever thread calls run()
+        TensorMatmul::Gemm::Workspace<float> _workspace;
+    };
+};
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdint>
+
+/**
+ * Fused kernels that normalize every row of a row-major [rows, cols] float matrix
+ * Each kernel reads a row once to collect its statistics and once more to write the result, dst may be the same pointer as src.
+ * Rows are split across worker threads.
+ */
+namespace TensorNorm {
+    // Smallest number of elements handed to one worker
+    constexpr uint64_t ParallelChunk = 1 << 14;
+
+    /**
+     * @brief dst = exp(x - max) / sum(exp(x - max)) for every row
+     * The first pass keeps a running max and rescales the running sum whenever the max grows, so max and sum come from one read.
+     */
+    void softmax(const float* src, float* dst, uint64_t rows, uint64_t cols);
+
+    /**
+     * @brief dst = x - max - log(sum(exp(x - max))) for every row, the second pass needs no exponentials
+     */
+    void logSoftmax(const float* src, float* dst, uint64_t rows, uint64_t cols);
+
+    /**
+     * @brief dst = (x - mean) / sqrt(var + epsilon) * gamma + beta for every row
+     *
+     * @param gamma Per column scale, nullptr for 1
+     * @param beta Per column shift, nullptr for 0
+     */
+    void layerNorm(const float* src, float* dst, uint64_t rows, uint64_t cols, const float* gamma, const float* beta, float epsilon);
+
+    /**
+     * @brief dst = x / sqrt(mean(x^2) + epsilon) * gamma for every row
+     *
+     * @param gamma Per column scale, nullptr for 1
+     */
+    void rmsNorm(const float* src, float* dst, uint64_t rows, uint64_t cols, const float* gamma, float epsilon);
+};
@@ -1,16 +1,29 @@
 #pragma once
 
 #include <cstdint>
+#include "Tensor/MortonMatrix.h"
+#include "Tensor/PackedMatrix.h"
+#include "Tensor/SparseTensor.h"
+#include "Tensor/TensorAttention.h"
+#include "Tensor/TensorBatched.h"
+#include "Tensor/TensorConcat.h"
+#include "Tensor/TensorConv.h"
+#include "Tensor/TensorMath.h"
 #include "Tensor/TensorMatmul.h"
+#include "Tensor/TensorNorm.h"
+#include "Tensor/TensorTranspose.h"
+#include "Tensor/TensorView.h"
 #include <Tensor/Tensor.h>
 #include <stdexcept>
+#include <type_traits>
+#include <vector>
 #include <sys/types.h>
 #include <exception>
 
 namespace TensorOps {
     template <typename T, uint16_t N> 
     Tensor<T, N> zeroes(const std::array<uint32_t, N>& dims) {
-        Tensor<T, N> result(dims);
+        Tensor<T, N> result(dims, TensorUninitialized);
         T value = 0;
         result.fillWithValues(value);
         return result;
@@ -18,7 +31,7 @@ namespace TensorOps {
 
     template <typename T, uint16_t N> 
     Tensor<T, N> ones(const std::array<uint32_t, N>& dims) {
-        Tensor<T, N> result(dims);
+        Tensor<T, N> result(dims, TensorUninitialized);
         T value = 1;
         result.fillWithValues(value);
         return result;
@@ -26,7 +39,7 @@ namespace TensorOps {
 
     template <typename T, uint16_t N>
     Tensor<T, N> full(const std::array<uint32_t, N>& dims, T value) {
-        Tensor<T, N> result(dims);
+        Tensor<T, N> result(dims, TensorUninitialized);
         result.fillWithValues(value);
         return result;
     }
@@ -63,8 +76,476 @@ namespace TensorOps {
         return TensorMatmul::matmul2d(A, B);
     }
 
+    // Independent products of [batch, M, N] and [batch, N, K] tensors
+    template <typename T>
+    Tensor<T, 3> matmul(const Tensor<T,3>& A, const Tensor<T,3>& B){
+        return TensorMatmul::matmulBatched(A, B);
+    }
+
+    // Sparse matrix times dense vector
+    template <typename T>
+    Tensor<T, 1> matmul(const SparseTensor<T>& A, const Tensor<T,1>& x){
+        return TensorSparse::matmul(A, x);
+    }
+
+    // Sparse matrix times dense matrix
+    template <typename T>
+    Tensor<T, 2> matmul(const SparseTensor<T>& A, const Tensor<T,2>& B){
+        return TensorSparse::matmul(A, B);
+    }
+
     template<typename T>
     T matmul(const Tensor<T,1>& A, const Tensor<T,1>& B){
         return TensorMatmul::dotproduct(A, B);
     }
+
+    template <typename T>
+    Tensor<T, 2> matmul(const Tensor<T,2>& A, const Tensor<T,2>& B, TensorMatmul::Transpose transA, TensorMatmul::Transpose transB){
+        return TensorMatmul::matmul2d(A, B, transA, transB);
+    }
+
+    template <typename T>
+    Tensor<T, 2> matmul(const Tensor<T,2>& A, const Tensor<T,2>& B, const TensorMatmul::Epilogue<T>& epilogue){
+        return TensorMatmul::matmul2d(A, B, epilogue);
+    }
+
+    // A * B for a weight matrix packed once with PackedMatrix
+    template <typename T>
+    Tensor<T, 2> matmul(const Tensor<T,2>& A, const PackedMatrix<T>& B){
+        return TensorMatmul::matmul2d(A, B);
+    }
+
+    template <typename T>
+    Tensor<T, 2> matmul(const Tensor<T,2>& A, const PackedMatrix<T>& B, const TensorMatmul::Epilogue<T>& epilogue){
+        return TensorMatmul::matmul2d(A, B, epilogue);
+    }
+
+    // A * B computed natively on the Morton layout
+    template <typename T>
+    MortonMatrix<T> matmul(const MortonMatrix<T>& A, const MortonMatrix<T>& B,
+                           TensorMatmul::MortonAlgorithm algorithm = TensorMatmul::MortonAlgorithm::Recursive){
+        if (algorithm == TensorMatmul::MortonAlgorithm::Strassen)
+            return TensorMatmul::matmul2dStrassen(A, B);
+        return TensorMatmul::matmul2d(A, B);
+    }
+
+    template <typename T>
+    Tensor<T, 4> conv2d(const Tensor<T,4>& input, const Tensor<T,4>& weights, const TensorConv::Conv2DParams& params = {},
+                        const Tensor<T,1>* bias = nullptr, TensorMatmul::Activation activation = TensorMatmul::Activation::None){
+        return TensorConv::conv2d(input, weights, params, bias, activation);
+    }
+
+    template <uint16_t N>
+    Tensor<float, N> attention(const Tensor<float,N>& Q, const Tensor<float,N>& K, const Tensor<float,N>& V,
+                               const TensorAttention::AttentionParams& params = {}){
+        return TensorAttention::attention(Q, K, V, params);
+    }
+
+    template <typename T>
+    Tensor<T, 2> transpose(const Tensor<T,2>& A){
+        const auto& dimsA = A.getDimensions();
+        uint64_t rows = dimsA[0];
+        uint64_t cols = dimsA[1];
+        std::array<uint32_t, 2> dims = {dimsA[1], dimsA[0]};
+        Tensor<T, 2> result(dims, TensorUninitialized);
+        const T* src = A.Data.data();
+        T* dst = result.Data.data();
+        // Each thread transposes a horizontal band of A into a vertical band of the result
+        uint64_t minRows = std::max<uint64_t>(TensorTranspose::BlockSize, (1 << 18) / std::max<uint64_t>(cols, 1));
+        TensorParallel::parallelFor(0, rows, minRows, [&](uint64_t rowBegin, uint64_t rowEnd) {
+            TensorTranspose::transpose(src + rowBegin * cols, rowEnd - rowBegin, cols, cols, dst + rowBegin, rows);
+        });
+        return result;
+    }
+
+    /**
+     * @brief Reorders the axes of A, axis i of the result is axis axes[i] of A
+     * permute(frames, {0, 3, 1, 2}) turns NHWC frames into NCHW. Details of the copy are on TensorTranspose::permute.
+     */
+    template <typename T, uint16_t N>
+    Tensor<T, N> permute(const Tensor<T,N>& A, const std::type_identity_t<std::array<uint16_t, N>>& axes){
+        const auto& dimsA = A.getDimensions();
+        std::array<uint32_t, N> dims;
+        for (uint16_t i = 0; i < N; i++){
+            assert(axes[i] < N && "Axes must be a permutation of the tensor's axes");
+            dims[i] = dimsA[axes[i]];
+        }
+        Tensor<T, N> result(dims, TensorUninitialized);
+        TensorTranspose::permute<T, N>(A.Data.data(), dimsA, A.getStrides(), axes, result.Data.data());
+        return result;
+    }
+
+    /**
+     * @brief Gives A new dimensions with the same number of elements, taking over its storage without copying
+     * Tensors are always stored densely in row-major order, so any shape with the same element count keeps the order.
+     */
+    template <uint16_t M, typename T, uint16_t N>
+    Tensor<T, M> reshape(Tensor<T,N>&& A, const std::array<uint32_t, M>& dims){
+        return Tensor<T, M>(dims, std::move(A.Data));
+    }
+
+    // Copy of A with new dimensions and the same number of elements
+    template <uint16_t M, typename T, uint16_t N>
+    Tensor<T, M> reshape(const Tensor<T,N>& A, const std::array<uint32_t, M>& dims){
+        return Tensor<T, M>(dims, std::vector<T, DefaultInitAllocator<T>>(A.Data));
+    }
+
+    // View of the same elements with new dimensions
+    template <uint16_t M, typename T, uint16_t N>
+    TensorView<T, M> reshape(const TensorView<T,N>& A, const std::array<uint32_t, M>& dims){
+        TensorView<T, M> view(A.data(), dims);
+        assert(view.size() == A.size() && "Reshape must keep the number of elements");
+        return view;
+    }
+
+    /**
+     * @brief Joins tensors along axis, they must have the same dimensions in every other axis
+     * Each part is copied with one bulk copy per run of its elements from axis inwards, large joins across threads.
+     */
+    template <typename T, uint16_t N>
+    Tensor<T, N> concat(const std::vector<TensorView<const T, N>>& parts, uint16_t axis){
+        assert(!parts.empty() && "Concatenation needs at least one tensor");
+        assert(axis < N && "Axis out of range");
+        std::array<uint32_t, N> dims = parts[0].getDimensions();
+        dims[axis] = 0;
+        for (const auto& part : parts){
+            for (uint16_t i = 0; i < N; i++)
+                assert((i == axis || part.getDimensions()[i] == dims[i]) && "Tensors must match in every axis but the concatenated one");
+            dims[axis] += part.getDimensions()[axis];
+        }
+        uint64_t outer = 1;
+        uint64_t inner = 1;
+        for (uint16_t i = 0; i < N; i++){
+            if (i < axis)
+                outer *= dims[i];
+            else if (i > axis)
+                inner *= dims[i];
+        }
+        Tensor<T, N> result(dims, TensorUninitialized);
+        std::vector<TensorConcat::Block<T>> blocks;
+        uint64_t offset = 0;
+        for (const auto& part : parts){
+            uint64_t length = part.getDimensions()[axis] * inner;
+            blocks.push_back({part.data(), result.Data.data() + offset, length, length, dims[axis] * inner});
+            offset += length;
+        }
+        TensorConcat::copyBlocks(blocks, outer);
+        return result;
+    }
+
+    template <typename T, uint16_t N>
+    Tensor<T, N> concat(const Tensor<T,N>& A, const Tensor<T,N>& B, uint16_t axis){
+        return concat<T, N>({A, B}, axis);
+    }
+
+    /**
+     * @brief Joins tensors of the same dimensions along a new axis, stack(frames, 0) builds a batch
+     */
+    template <typename T, uint16_t N>
+    Tensor<T, N + 1> stack(const std::vector<TensorView<const T, N>>& parts, uint16_t axis = 0){
+        assert(!parts.empty() && "Stacking needs at least one tensor");
+        assert(axis <= N && "Axis out of range");
+        const auto& partDims = parts[0].getDimensions();
+        std::array<uint32_t, N + 1> dims;
+        uint64_t outer = 1;
+        uint64_t length = 1;
+        for (uint16_t i = 0; i < N; i++){
+            dims[i < axis ? i : i + 1] = partDims[i];
+            if (i < axis)
+                outer *= partDims[i];
+            else
+                length *= partDims[i];
+        }
+        dims[axis] = static_cast<uint32_t>(parts.size());
+        Tensor<T, N + 1> result(dims, TensorUninitialized);
+        std::vector<TensorConcat::Block<T>> blocks;
+        for (uint64_t p = 0; p < parts.size(); p++){
+            assert(parts[p].getDimensions() == partDims && "Stacked tensors must have the same dimensions");
+            blocks.push_back({parts[p].data(), result.Data.data() + p * length, length, length, parts.size() * length});
+        }
+        TensorConcat::copyBlocks(blocks, outer);
+        return result;
+    }
+
+    /**
+     * @brief Cuts A along axis into parts of the given sizes, the reverse of concat
+     */
+    template <typename T, uint16_t N>
+    std::vector<Tensor<T, N>> split(const Tensor<T,N>& A, uint16_t axis, const std::vector<uint32_t>& sizes){
+        assert(axis < N && "Axis out of range");
+        const auto& dimsA = A.getDimensions();
+        uint64_t outer = 1;
+        uint64_t inner = 1;
+        for (uint16_t i = 0; i < N; i++){
+            if (i < axis)
+                outer *= dimsA[i];
+            else if (i > axis)
+                inner *= dimsA[i];
+        }
+        std::vector<Tensor<T, N>> parts;
+        parts.reserve(sizes.size());
+        std::vector<TensorConcat::Block<T>> blocks;
+        uint64_t offset = 0;
+        for (uint32_t size : sizes){
+            std::array<uint32_t, N> dims = dimsA;
+            dims[axis] = size;
+            parts.emplace_back(dims, TensorUninitialized);
+            uint64_t length = size * inner;
+            blocks.push_back({A.Data.data() + offset, parts.back().Data.data(), length, dimsA[axis] * inner, length});
+            offset += length;
+        }
+        assert(offset == dimsA[axis] * inner && "Split sizes must add up to the dimension of the axis");
+        TensorConcat::copyBlocks(blocks, outer);
+        return parts;
+    }
+
+    /**
+     * @brief Cuts A along axis into views that share its storage
+     * Only possible when every axis before axis has size 1, as for the outermost axis, because each part must be one
+     * contiguous range of elements.
+     */
+    template <typename V, uint16_t N>
+    std::vector<TensorView<V, N>> splitViews(const TensorView<V, N>& A, uint16_t axis, const std::vector<uint32_t>& sizes){
+        assert(axis < N && "Axis out of range");
+        const auto& dimsA = A.getDimensions();
+        uint64_t inner = 1;
+        for (uint16_t i = 0; i < N; i++){
+            assert((i >= axis || dimsA[i] == 1) && "Views need the split axis to be the outermost one");
+            if (i > axis)
+                inner *= dimsA[i];
+        }
+        std::vector<TensorView<V, N>> parts;
+        uint64_t offset = 0;
+        for (uint32_t size : sizes){
+            std::array<uint32_t, N> dims = dimsA;
+            dims[axis] = size;
+            parts.emplace_back(A.data() + offset, dims);
+            offset += size * inner;
+        }
+        assert(offset == dimsA[axis] * inner && "Split sizes must add up to the dimension of the axis");
+        return parts;
+    }
+
+    template <typename T, uint16_t N>
+    std::vector<TensorView<T, N>> splitViews(Tensor<T,N>& A, uint16_t axis, const std::vector<uint32_t>& sizes){
+        return splitViews(TensorView<T, N>(A), axis, sizes);
+    }
+
+    template <typename T, uint16_t N>
+    std::vector<TensorView<const T, N>> splitViews(const Tensor<T,N>& A, uint16_t axis, const std::vector<uint32_t>& sizes){
+        return splitViews(TensorView<const T, N>(A), axis, sizes);
+    }
+
+    /**
+     * @brief Runs one of the TensorMath array kernels over A and writes the values into result
+     *
+     * @param A Input tensor
+     * @param result Output tensor with the dimensions of A, may be A itself
+     * @param kernel TensorMath array function
+     */
+    template <uint16_t N>
+    void mapFloat(const Tensor<float,N>& A, Tensor<float,N>& result, void (*kernel)(const float*, float*, uint64_t)){
+        assert(A.getDimensions() == result.getDimensions() && "Result must have the same dimensions as the input");
+        kernel(A.Data.data(), result.Data.data(), A.Data.size());
+    }
+
+    /**
+     * @brief Elementwise e^x, error bound documented on TensorMath::vexp
+     */
+    template <uint16_t N>
+    Tensor<float, N> exp(const Tensor<float,N>& A){
+        Tensor<float, N> result(A.getDimensions(), TensorUninitialized);
+        mapFloat(A, result, TensorMath::exp);
+        return result;
+    }
+
+    template <uint16_t N>
+    void exp(const Tensor<float,N>& A, Tensor<float,N>& result){
+        mapFloat(A, result, TensorMath::exp);
+    }
+
+    /**
+     * @brief Elementwise natural logarithm, error bound documented on TensorMath::vlog
+     */
+    template <uint16_t N>
+    Tensor<float, N> log(const Tensor<float,N>& A){
+        Tensor<float, N> result(A.getDimensions(), TensorUninitialized);
+        mapFloat(A, result, TensorMath::log);
+        return result;
+    }
+
+    template <uint16_t N>
+    void log(const Tensor<float,N>& A, Tensor<float,N>& result){
+        mapFloat(A, result, TensorMath::log);
+    }
+
+    /**
+     * @brief Elementwise hyperbolic tangent, error bound documented on TensorMath::vtanh
+     */
+    template <uint16_t N>
+    Tensor<float, N> tanh(const Tensor<float,N>& A){
+        Tensor<float, N> result(A.getDimensions(), TensorUninitialized);
+        mapFloat(A, result, TensorMath::tanh);
+        return result;
+    }
+
+    template <uint16_t N>
+    void tanh(const Tensor<float,N>& A, Tensor<float,N>& result){
+        mapFloat(A, result, TensorMath::tanh);
+    }
+
+    /**
+     * @brief Elementwise logistic function 1 / (1 + e^-x), error bound documented on TensorMath::vsigmoid
+     */
+    template <uint16_t N>
+    Tensor<float, N> sigmoid(const Tensor<float,N>& A){
+        Tensor<float, N> result(A.getDimensions(), TensorUninitialized);
+        mapFloat(A, result, TensorMath::sigmoid);
+        return result;
+    }
+
+    template <uint16_t N>
+    void sigmoid(const Tensor<float,N>& A, Tensor<float,N>& result){
+        mapFloat(A, result, TensorMath::sigmoid);
+    }
+
+    /**
+     * @brief Elementwise error function, error bound documented on TensorMath::verf
+     */
+    template <uint16_t N>
+    Tensor<float, N> erf(const Tensor<float,N>& A){
+        Tensor<float, N> result(A.getDimensions(), TensorUninitialized);
+        mapFloat(A, result, TensorMath::erf);
+        return result;
+    }
+
+    template <uint16_t N>
+    void erf(const Tensor<float,N>& A, Tensor<float,N>& result){
+        mapFloat(A, result, TensorMath::erf);
+    }
+
+    /**
+     * @brief Elementwise GELU x / 2 * (1 + erf(x / sqrt(2))), error bound documented on TensorMath::vgelu
+     */
+    template <uint16_t N>
+    Tensor<float, N> gelu(const Tensor<float,N>& A){
+        Tensor<float, N> result(A.getDimensions(), TensorUninitialized);
+        mapFloat(A, result, TensorMath::gelu);
+        return result;
+    }
+
+    template <uint16_t N>
+    void gelu(const Tensor<float,N>& A, Tensor<float,N>& result){
+        mapFloat(A, result, TensorMath::gelu);
+    }
+
+    /**
+     * @brief Elementwise square root, error bound documented on TensorMath::vsqrt
+     */
+    template <uint16_t N>
+    Tensor<float, N> sqrt(const Tensor<float,N>& A){
+        Tensor<float, N> result(A.getDimensions(), TensorUninitialized);
+        mapFloat(A, result, TensorMath::sqrt);
+        return result;
+    }
+
+    template <uint16_t N>
+    void sqrt(const Tensor<float,N>& A, Tensor<float,N>& result){
+        mapFloat(A, result, TensorMath::sqrt);
+    }
+
+    /**
+     * @brief Elementwise reciprocal square root, error bound documented on TensorMath::vrsqrt
+     */
+    template <uint16_t N>
+    Tensor<float, N> rsqrt(const Tensor<float,N>& A){
+        Tensor<float, N> result(A.getDimensions(), TensorUninitialized);
+        mapFloat(A, result, TensorMath::rsqrt);
+        return result;
+    }
+
+    template <uint16_t N>
+    void rsqrt(const Tensor<float,N>& A, Tensor<float,N>& result){
+        mapFloat(A, result, TensorMath::rsqrt);
+    }
+
+    /**
+     * @brief Softmax over the last axis, see TensorNorm::softmax
+     */
+    template <uint16_t N>
+    void softmax(const Tensor<float,N>& A, Tensor<float,N>& result){
+        assert(A.getDimensions() == result.getDimensions() && "Result must have the same dimensions as the input");
+        uint64_t cols = A.getDimensions()[N - 1];
+        TensorNorm::softmax(A.Data.data(), result.Data.data(), cols == 0 ? 0 : A.Data.size() / cols, cols);
+    }
+
+    template <uint16_t N>
+    Tensor<float, N> softmax(const Tensor<float,N>& A){
+        Tensor<float, N> result(A.getDimensions(), TensorUninitialized);
+        softmax(A, result);
+        return result;
+    }
+
+    /**
+     * @brief Log-softmax over the last axis, see TensorNorm::logSoftmax
+     */
+    template <uint16_t N>
+    void logSoftmax(const Tensor<float,N>& A, Tensor<float,N>& result){
+        assert(A.getDimensions() == result.getDimensions() && "Result must have the same dimensions as the input");
+        uint64_t cols = A.getDimensions()[N - 1];
+        TensorNorm::logSoftmax(A.Data.data(), result.Data.data(), cols == 0 ? 0 : A.Data.size() / cols, cols);
+    }
+
+    template <uint16_t N>
+    Tensor<float, N> logSoftmax(const Tensor<float,N>& A){
+        Tensor<float, N> result(A.getDimensions(), TensorUninitialized);
+        logSoftmax(A, result);
+        return result;
+    }
+
+    /**
+     * @brief LayerNorm over the last axis, see TensorNorm::layerNorm
+     *
+     * @param gamma Optional scale with one value per element of the last axis
+     * @param beta Optional shift with one value per element of the last axis
+     */
+    template <uint16_t N>
+    void layerNorm(const Tensor<float,N>& A, Tensor<float,N>& result, const Tensor<float,1>* gamma = nullptr,
+                   const Tensor<float,1>* beta = nullptr, float epsilon = 1e-5f){
+        assert(A.getDimensions() == result.getDimensions() && "Result must have the same dimensions as the input");
+        uint64_t cols = A.getDimensions()[N - 1];
+        assert((!gamma || gamma->getDimensions()[0] == cols) && "Gamma must have one value per element of the last axis");
+        assert((!beta || beta->getDimensions()[0] == cols) && "Beta must have one value per element of the last axis");
+        TensorNorm::layerNorm(A.Data.data(), result.Data.data(), cols == 0 ? 0 : A.Data.size() / cols, cols,
+                              gamma ? gamma->Data.data() : nullptr, beta ? beta->Data.data() : nullptr, epsilon);
+    }
+
+    template <uint16_t N>
+    Tensor<float, N> layerNorm(const Tensor<float,N>& A, const Tensor<float,1>* gamma = nullptr,
+                               const Tensor<float,1>* beta = nullptr, float epsilon = 1e-5f){
+        Tensor<float, N> result(A.getDimensions(), TensorUninitialized);
+        layerNorm(A, result, gamma, beta, epsilon);
+        return result;
+    }
+
+    /**
+     * @brief RMSNorm over the last axis, see TensorNorm::rmsNorm
+     *
+     * @param gamma Optional scale with one value per element of the last axis
+     */
+    template <uint16_t N>
+    void rmsNorm(const Tensor<float,N>& A, Tensor<float,N>& result, const Tensor<float,1>* gamma = nullptr, float epsilon = 1e-6f){
+        assert(A.getDimensions() == result.getDimensions() && "Result must have the same dimensions as the input");
+        uint64_t cols = A.getDimensions()[N - 1];
+        assert((!gamma || gamma->getDimensions()[0] == cols) && "Gamma must have one value per element of the last axis");
+        TensorNorm::rmsNorm(A.Data.data(), result.Data.data(), cols == 0 ? 0 : A.Data.size() / cols, cols,
+                            gamma ? gamma->Data.data() : nullptr, epsilon);
+    }
+
+    template <uint16_t N>
+    Tensor<float, N> rmsNorm(const Tensor<float,N>& A, const Tensor<float,1>* gamma = nullptr, float epsilon = 1e-6f){
+        Tensor<float, N> result(A.getDimensions(), TensorUninitialized);
+        rmsNorm(A, result, gamma, epsilon);
+        return result;
+    }
 };
\ No newline at end of file
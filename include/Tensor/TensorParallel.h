@@ -0,0 +1,360 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace TensorParallel {
+    class ThreadPool;
+
+    namespace detail {
+        // Threads set by configure(), 0 until then
+        inline std::atomic<unsigned> configuredWorkers{0};
+        // Tasks a parallel loop is cut into, 0 for one per worker
+        inline std::atomic<unsigned> taskGranularity{0};
+        inline std::atomic<ThreadPool*> poolPointer{nullptr};
+
+        // Creates the pool for the default configuration on first use
+        ThreadPool& createPool();
+    };
+
+    /**
+     * @brief Number of threads parallel kernels split their work into
+     *
+     * @return The number of cores given to configure(), otherwise std::thread::hardware_concurrency() or 1 when it is unknown
+     */
+    inline unsigned workerCount(){
+        unsigned configured = detail::configuredWorkers.load(std::memory_order_relaxed);
+        if (configured != 0)
+            return configured;
+        unsigned count = std::thread::hardware_concurrency();
+        return count == 0 ? 1 : count;
+    }
+
+    /**
+     * @brief One online CPU core as described by sysfs
+     */
+    struct CoreInfo {
+        unsigned id;
+        uint32_t capacity;  // Relative speed, 1024 for the fastest cores like the kernel's cpu_capacity
+        uint32_t cluster;   // Cores of equal capacity share a cluster, 0 is the fastest one
+    };
+
+    /**
+     * @brief Reads the online cores and their capacity, which tells big and LITTLE clusters apart
+     * The capacity comes from cpuN/cpu_capacity, or from the maximum frequency in cpuN/cpufreq/cpuinfo_max_freq when the
+     * kernel does not report it. Without either every core gets capacity 1024.
+     *
+     * @param sysfsRoot Directory holding the cpuN directories and the online list
+     * @return Cores sorted by id
+     */
+    std::vector<CoreInfo> detectCores(const std::string& sysfsRoot = "/sys/devices/system/cpu");
+
+    /**
+     * @brief Restricts the calling thread to one core
+     *
+     * @return false when the platform does not support it or the core is not available
+     */
+    bool pinCurrentThread(unsigned core);
+
+    struct ThreadConfig {
+        // Cores DeepPi runs on, every core of detectCores() when empty
+        std::vector<unsigned> cores;
+        // Pins every worker thread to its own core of the list, the first core is left for the calling thread
+        bool pinWorkers = true;
+        // Also pins the calling thread to the first core of the list
+        bool pinCaller = false;
+        // Cuts parallel loops into more tasks when the cores differ in capacity, so faster cores take on more of them
+        bool weightByCapacity = true;
+    };
+
+    /**
+     * @brief Replaces the worker threads with ones that follow config
+     * Must not be called while a parallel kernel is running.
+     */
+    void configure(const ThreadConfig& config);
+
+    /**
+     * @brief Undoes configure(): the next parallel kernel recreates the default pool, unpinned with workerCount() threads
+     * Must not be called while a parallel kernel is running.
+     */
+    void resetConfiguration();
+
+    /**
+     * @brief Persistent worker threads that run the tasks of one parallel loop at a time
+     * The threads are started once and sleep between loops, so a parallel loop costs a wake-up instead of creating threads
+     * and nothing is allocated per loop. The calling thread works on the tasks too.
+     * A loop started from inside a task, or while another thread is using the pool, runs on the calling thread.
+     */
+    class ThreadPool {
+    public:
+        /**
+         * @param threads Number of worker threads
+         * @param pinnedCores Core each worker is pinned to, workers past the end of the list are not pinned
+         */
+        explicit ThreadPool(unsigned threads, const std::vector<unsigned>& pinnedCores = {}){
+            _threads.reserve(threads);
+            for (unsigned t = 0; t < threads; t++){
+                int core = t < pinnedCores.size() ? static_cast<int>(pinnedCores[t]) : -1;
+                _threads.emplace_back([this, core]() {
+                    if (core >= 0)
+                        pinCurrentThread(static_cast<unsigned>(core));
+                    workerLoop();
+                });
+            }
+        }
+
+        ~ThreadPool(){
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                _stop = true;
+            }
+            _wake.notify_all();
+            for (auto& thread : _threads)
+                thread.join();
+        }
+
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        // Worker threads, not counting the calling thread
+        unsigned size() const { return static_cast<unsigned>(_threads.size()); }
+
+        /**
+         * @brief Runs task(index) for every index in [0, count) and returns once all of them have finished
+         * Tasks are handed out one at a time, so workers that finish early pick up the remaining ones.
+         * When a task throws, the tasks not yet started are skipped and the first exception is rethrown once every
+         * thread has left the loop.
+         */
+        template <typename Task>
+        void run(uint64_t count, Task& task){
+            if (count == 0)
+                return;
+            if (count == 1 || _threads.empty() || insideTask() || !_submit.try_lock()){
+                for (uint64_t index = 0; index < count; index++)
+                    task(index);
+                return;
+            }
+            runSubmitted(count, task);
+        }
+
+        /**
+         * @brief Runs fn() once on every worker thread and once on the calling thread
+         * Waits for the pool when another thread's loop is running. Called from inside a task only the calling thread
+         * runs fn(), the workers are busy with the loop around it.
+         */
+        template <typename Fn>
+        void broadcast(Fn& fn){
+            if (_threads.empty() || insideTask()){
+                fn();
+                return;
+            }
+            _submit.lock();
+            uint64_t threads = _threads.size() + 1;
+            std::atomic<uint64_t> arrived{0};
+            auto task = [&](uint64_t) {
+                // A thread waiting here claims no other task, so once all have arrived every thread holds exactly one
+                arrived.fetch_add(1, std::memory_order_acq_rel);
+                while (arrived.load(std::memory_order_acquire) < threads)
+                    std::this_thread::yield();
+                fn();
+            };
+            runSubmitted(threads, task);
+        }
+
+    private:
+        using Invoke = void (*)(void*, uint64_t);
+
+        static bool& insideTask(){
+            thread_local bool inside = false;
+            return inside;
+        }
+
+        // Runs a loop on the pool, the calling thread holds _submit and it is released on return
+        template <typename Task>
+        void runSubmitted(uint64_t count, Task& task){
+            // Leaves the pool usable for the next loop however this one ends
+            struct Submission {
+                std::mutex& submit;
+                ~Submission(){
+                    insideTask() = false;
+                    submit.unlock();
+                }
+            } submission{_submit};
+            {
+                std::unique_lock<std::mutex> lock(_mutex);
+                // Workers still leaving the previous loop hold its task, wait until they are gone
+                _idle.wait(lock, [this]() { return _active == 0; });
+                _invoke = [](void* context, uint64_t index) { (*static_cast<Task*>(context))(index); };
+                _context = &task;
+                _count = count;
+                _error = nullptr;
+                _failed.store(false, std::memory_order_relaxed);
+                _next.store(0, std::memory_order_relaxed);
+                _remaining.store(count, std::memory_order_relaxed);
+                _generation++;
+            }
+            _wake.notify_all();
+            insideTask() = true;
+            drain(_invoke, _context, count);
+            std::exception_ptr error;
+            {
+                std::unique_lock<std::mutex> lock(_mutex);
+                // task lives in the caller's frame, so no worker may still be running it when run() returns or throws
+                _idle.wait(lock, [this]() { return _remaining.load(std::memory_order_acquire) == 0; });
+                error = std::exchange(_error, nullptr);
+            }
+            if (error)
+                std::rethrow_exception(error);
+        }
+
+        // Claims and runs tasks of the current loop until none are left, keeping the first exception for run()
+        void drain(Invoke invoke, void* context, uint64_t count){
+            for (;;){
+                uint64_t index = _next.fetch_add(1, std::memory_order_relaxed);
+                if (index >= count)
+                    return;
+                if (!_failed.load(std::memory_order_relaxed)){
+                    try {
+                        invoke(context, index);
+                    } catch (...) {
+                        std::lock_guard<std::mutex> lock(_mutex);
+                        if (!_error)
+                            _error = std::current_exception();
+                        _failed.store(true, std::memory_order_relaxed);
+                    }
+                }
+                // A skipped or failed task still counts as finished, run() waits for all of them
+                if (_remaining.fetch_sub(1, std::memory_order_acq_rel) == 1){
+                    std::lock_guard<std::mutex> lock(_mutex);
+                    _idle.notify_all();
+                }
+            }
+        }
+
+        void workerLoop(){
+            insideTask() = true;
+            uint64_t seen = 0;
+            for (;;){
+                Invoke invoke;
+                void* context;
+                uint64_t count;
+                {
+                    std::unique_lock<std::mutex> lock(_mutex);
+                    _wake.wait(lock, [&]() { return _stop || _generation != seen; });
+                    if (_stop)
+                        return;
+                    seen = _generation;
+                    invoke = _invoke;
+                    context = _context;
+                    count = _count;
+                    _active++;
+                }
+                drain(invoke, context, count);
+                {
+                    std::lock_guard<std::mutex> lock(_mutex);
+                    if (--_active == 0)
+                        _idle.notify_all();
+                }
+            }
+        }
+
+        std::vector<std::thread> _threads;
+        std::mutex _submit;                 // Held by the thread whose loop is running
+        std::mutex _mutex;
+        std::condition_variable _wake;
+        std::condition_variable _idle;
+        bool _stop = false;
+        uint64_t _generation = 0;
+        unsigned _active = 0;               // Workers that joined the current loop and have not left it
+        Invoke _invoke = nullptr;
+        void* _context = nullptr;
+        uint64_t _count = 0;
+        std::exception_ptr _error;          // First exception thrown by a task of the current loop
+        std::atomic<bool> _failed{false};   // Set once a task threw, the tasks claimed after it are skipped
+        std::atomic<uint64_t> _next{0};
+        std::atomic<uint64_t> _remaining{0};
+    };
+
+    /**
+     * @brief Pool shared by all parallel kernels, with one thread less than workerCount() because the caller takes part
+     */
+    inline ThreadPool& pool(){
+        ThreadPool* instance = detail::poolPointer.load(std::memory_order_acquire);
+        return instance ? *instance : detail::createPool();
+    }
+
+    /**
+     * @brief Splits [begin, end) into contiguous chunks and runs fn(chunkBegin, chunkEnd) on every chunk in parallel
+     * There is one chunk per worker, or more when the cores differ in capacity so that faster cores claim more of them.
+     * Ranges shorter than 2 * minChunk run on the calling thread.
+     *
+     * @param begin First index of the range
+     * @param end One past the last index of the range
+     * @param minChunk Smallest chunk worth handing to another thread
+     * @param fn Callable invoked as fn(uint64_t chunkBegin, uint64_t chunkEnd)
+     */
+    template <typename Fn>
+    void parallelFor(uint64_t begin, uint64_t end, uint64_t minChunk, Fn&& fn){
+        if (end <= begin)
+            return;
+        uint64_t size = end - begin;
+        uint64_t maxChunks = size / std::max<uint64_t>(minChunk, 1);
+        uint64_t chunks = std::min<uint64_t>(workerCount(), maxChunks);
+        if (chunks < 2){
+            fn(begin, end);
+            return;
+        }
+        ThreadPool& workers = pool();
+        chunks = std::max<uint64_t>(chunks, std::min<uint64_t>(detail::taskGranularity.load(std::memory_order_relaxed), maxChunks));
+        uint64_t chunk = (size + chunks - 1) / chunks;
+        auto task = [&](uint64_t index) {
+            uint64_t chunkBegin = begin + index * chunk;
+            fn(chunkBegin, std::min(end, chunkBegin + chunk));
+        };
+        workers.run((size + chunk - 1) / chunk, task);
+    }
+
+    // Elements an elementwise task handles at once, small enough for the L2 cache of one core
+    constexpr uint64_t ElementwiseChunk = 1 << 14;
+
+    namespace detail {
+        inline std::atomic<uint64_t> elementwiseThreshold{1 << 20};
+    };
+
+    // Number of elements from which elementwise operations and fills are spread over threads
+    inline uint64_t elementwiseThreshold(){
+        return detail::elementwiseThreshold.load(std::memory_order_relaxed);
+    }
+
+    inline void setElementwiseThreshold(uint64_t elements){
+        detail::elementwiseThreshold.store(elements, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Runs fn(chunkBegin, chunkEnd) over [0, size) for an elementwise operation
+     * Below elementwiseThreshold() the whole range runs on the calling thread without touching the pool. Above it the
+     * range is cut into ElementwiseChunk pieces that idle threads keep claiming until all are done.
+     */
+    template <typename Fn>
+    void parallelElementwise(uint64_t size, Fn&& fn){
+        if (size < elementwiseThreshold() || size < 2 * ElementwiseChunk){
+            if (size > 0)
+                fn(uint64_t(0), size);
+            return;
+        }
+        auto task = [&](uint64_t index) {
+            uint64_t chunkBegin = index * ElementwiseChunk;
+            fn(chunkBegin, std::min(size, chunkBegin + ElementwiseChunk));
+        };
+        pool().run((size + ElementwiseChunk - 1) / ElementwiseChunk, task);
+    }
+};
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <arm_neon.h>
+#include <cstdint>
+
+namespace TensorSimd {
+    /**
+     * @brief Uniform view of the NEON registers and instructions for an element type
+     * Generic kernels are written once against Vec<T> and instantiated for every type that has a specialization.
+     * Types without a specialization report Supported = false and kernels fall back to scalar code.
+     */
+    template <typename T>
+    struct Vec {
+        static constexpr bool Supported = false;
+        static constexpr uint32_t Lanes = 1;
+    };
+
+    template <>
+    struct Vec<float> {
+        using type = float32x4_t;
+        static constexpr bool Supported = true;
+        static constexpr uint32_t Lanes = 4;
+        static type load(const float* ptr) { return vld1q_f32(ptr); }
+        static void store(float* ptr, type value) { vst1q_f32(ptr, value); }
+        static type dup(float value) { return vdupq_n_f32(value); }
+        static type add(type a, type b) { return vaddq_f32(a, b); }
+        static type sub(type a, type b) { return vsubq_f32(a, b); }
+        static type mul(type a, type b) { return vmulq_f32(a, b); }
+        static type mla(type acc, type a, type b) { return vmlaq_f32(acc, a, b); }
+        static type max(type a, type b) { return vmaxq_f32(a, b); }
+        static type min(type a, type b) { return vminq_f32(a, b); }
+    };
+
+    template <>
+    struct Vec<uint32_t> {
+        using type = uint32x4_t;
+        static constexpr bool Supported = true;
+        static constexpr uint32_t Lanes = 4;
+        static type load(const uint32_t* ptr) { return vld1q_u32(ptr); }
+        static void store(uint32_t* ptr, type value) { vst1q_u32(ptr, value); }
+        static type dup(uint32_t value) { return vdupq_n_u32(value); }
+        static type add(type a, type b) { return vaddq_u32(a, b); }
+        static type sub(type a, type b) { return vsubq_u32(a, b); }
+        static type mul(type a, type b) { return vmulq_u32(a, b); }
+        static type mla(type acc, type a, type b) { return vmlaq_u32(acc, a, b); }
+        static type max(type a, type b) { return vmaxq_u32(a, b); }
+        static type min(type a, type b) { return vminq_u32(a, b); }
+    };
+
+    template <>
+    struct Vec<uint16_t> {
+        using type = uint16x8_t;
+        static constexpr bool Supported = true;
+        static constexpr uint32_t Lanes = 8;
+        static type load(const uint16_t* ptr) { return vld1q_u16(ptr); }
+        static void store(uint16_t* ptr, type value) { vst1q_u16(ptr, value); }
+        static type dup(uint16_t value) { return vdupq_n_u16(value); }
+        static type add(type a, type b) { return vaddq_u16(a, b); }
+        static type sub(type a, type b) { return vsubq_u16(a, b); }
+        static type mul(type a, type b) { return vmulq_u16(a, b); }
+        static type mla(type acc, type a, type b) { return vmlaq_u16(acc, a, b); }
+        static type max(type a, type b) { return vmaxq_u16(a, b); }
+        static type min(type a, type b) { return vminq_u16(a, b); }
+    };
+
+    template <>
+    struct Vec<uint8_t> {
+        using type = uint8x16_t;
+        static constexpr bool Supported = true;
+        static constexpr uint32_t Lanes = 16;
+        static type load(const uint8_t* ptr) { return vld1q_u8(ptr); }
+        static void store(uint8_t* ptr, type value) { vst1q_u8(ptr, value); }
+        static type dup(uint8_t value) { return vdupq_n_u8(value); }
+        static type add(type a, type b) { return vaddq_u8(a, b); }
+        static type sub(type a, type b) { return vsubq_u8(a, b); }
+        static type mul(type a, type b) { return vmulq_u8(a, b); }
+        static type mla(type acc, type a, type b) { return vmlaq_u8(acc, a, b); }
+        static type max(type a, type b) { return vmaxq_u8(a, b); }
+        static type min(type a, type b) { return vminq_u8(a, b); }
+    };
+};
@@ -0,0 +1,217 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <span>
+#include <type_traits>
+#include <vector>
+#include "Tensor/Tensor.h"
+#include "Tensor/TensorGemm.h"
+#include "Tensor/TensorParallel.h"
+
+namespace TensorMatmul {
+    namespace Strassen {
+        // Smallest dimension from which a level of the recursion still pays off over the packed GEMM
+        constexpr uint32_t Leaf = 256;
+
+        inline bool recurses(uint32_t M, uint32_t N, uint32_t K, uint32_t leaf){
+            return std::min({M, N, K}) > leaf;
+        }
+
+        /**
+         * @brief Z = op(X, Y) over a rows x cols block, every operand with its own row stride
+         * Z may alias X or Y. Blocks of elementwiseThreshold() elements or more are split by rows over the thread pool.
+         */
+        template <typename T, typename Op>
+        void combine(uint32_t rows, uint32_t cols, const T* X, uint64_t ldx, const T* Y, uint64_t ldy, T* Z, uint64_t ldz, Op op){
+            auto combineRows = [&](uint64_t begin, uint64_t end) {
+                for (uint64_t i = begin; i < end; i++){
+                    const T* x = X + i * ldx;
+                    const T* y = Y + i * ldy;
+                    T* z = Z + i * ldz;
+                    for (uint32_t j = 0; j < cols; j++)
+                        z[j] = op(x[j], y[j]);
+                }
+            };
+            uint64_t size = static_cast<uint64_t>(rows) * cols;
+            if (size < TensorParallel::elementwiseThreshold()){
+                combineRows(0, rows);
+                return;
+            }
+            uint64_t minRows = std::max<uint64_t>(1, TensorParallel::ElementwiseChunk / std::max<uint32_t>(cols, 1));
+            TensorParallel::parallelFor(0, rows, minRows, combineRows);
+        }
+
+        /**
+         * @brief Adds the parts of A * B that the even Strassen core leaves out
+         * With M, N, K the dimensions rounded down to even, the core computed C[0:M, 0:K] from A[0:M, 0:N] * B[0:N, 0:K].
+         * An odd depth adds the rank-1 product of the last column of A and the last row of B to the core, an odd width
+         * computes the last column of C as a matrix-vector product and an odd height the last row as a vector-matrix product.
+         */
+        template <typename T>
+        void peel(uint32_t M, uint32_t N, uint32_t K, const T* A, uint64_t lda, const T* B, uint64_t ldb, T* C, uint64_t ldc){
+            uint32_t M_even = M & ~1u;
+            uint32_t N_even = N & ~1u;
+            uint32_t K_even = K & ~1u;
+            if (N_even != N){
+                const T* lastRowB = B + (N - 1) * ldb;
+                for (uint32_t i = 0; i < M_even; i++){
+                    const T a = A[i * lda + N - 1];
+                    T* rowC = C + i * ldc;
+                    for (uint32_t j = 0; j < K_even; j++)
+                        rowC[j] += a * lastRowB[j];
+                }
+            }
+            if (K_even != K){
+                for (uint32_t i = 0; i < M_even; i++){
+                    const T* rowA = A + i * lda;
+                    T sum = 0;
+                    for (uint32_t k = 0; k < N; k++)
+                        sum += rowA[k] * B[k * ldb + K - 1];
+                    C[i * ldc + K - 1] = sum;
+                }
+            }
+            if (M_even != M){
+                const T* rowA = A + (M - 1) * lda;
+                T* rowC = C + (M - 1) * ldc;
+                std::fill(rowC, rowC + K, T(0));
+                for (uint32_t k = 0; k < N; k++){
+                    const T a = rowA[k];
+                    const T* rowB = B + k * ldb;
+                    for (uint32_t j = 0; j < K; j++)
+                        rowC[j] += a * rowB[j];
+                }
+            }
+        }
+
+        /**
+         * @brief C = A * B on raw row-major blocks, every intermediate result kept in workspace or in C itself
+         * A level holds one sum of A quadrants (S), one sum of B quadrants (U) and one product (P), and hands the rest of
+         * the workspace to the level below. The products that a quadrant of C starts from are computed straight into it,
+         * the others go through P and are added where they belong before the next one overwrites it.
+         */
+        template <typename T>
+        void multiply(uint32_t M, uint32_t N, uint32_t K, const T* A, uint64_t lda, const T* B, uint64_t ldb,
+                      T* C, uint64_t ldc, T* workspace, uint32_t leaf){
+            if (!recurses(M, N, K, leaf)){
+                gemm(M, N, K, A, lda, Transpose::No, B, ldb, Transpose::No, C, ldc);
+                return;
+            }
+            uint32_t M_half = M / 2;
+            uint32_t N_half = N / 2;
+            uint32_t K_half = K / 2;
+            T* S = workspace;
+            T* U = S + static_cast<uint64_t>(M_half) * N_half;
+            T* P = U + static_cast<uint64_t>(N_half) * K_half;
+            T* below = P + static_cast<uint64_t>(M_half) * K_half;
+
+            const T* A11 = A;
+            const T* A12 = A + N_half;
+            const T* A21 = A + M_half * lda;
+            const T* A22 = A21 + N_half;
+            const T* B11 = B;
+            const T* B12 = B + K_half;
+            const T* B21 = B + N_half * ldb;
+            const T* B22 = B21 + K_half;
+            T* C11 = C;
+            T* C12 = C + K_half;
+            T* C21 = C + M_half * ldc;
+            T* C22 = C21 + K_half;
+
+            auto add = [](T x, T y) { return x + y; };
+            auto subtract = [](T x, T y) { return x - y; };
+            auto first = [](T x, T) { return x; };
+            auto product = [&](const T* X, uint64_t ldx, const T* Y, uint64_t ldy, T* Z, uint64_t ldz) {
+                multiply(M_half, N_half, K_half, X, ldx, Y, ldy, Z, ldz, below, leaf);
+            };
+
+            // M1 = (A11 + A22)(B11 + B22) starts C11 and C22
+            combine(M_half, N_half, A11, lda, A22, lda, S, N_half, add);
+            combine(N_half, K_half, B11, ldb, B22, ldb, U, K_half, add);
+            product(S, N_half, U, K_half, C11, ldc);
+            combine(M_half, K_half, C11, ldc, C11, ldc, C22, ldc, first);
+            // M7 = (A12 - A22)(B21 + B22) goes to C11
+            combine(M_half, N_half, A12, lda, A22, lda, S, N_half, subtract);
+            combine(N_half, K_half, B21, ldb, B22, ldb, U, K_half, add);
+            product(S, N_half, U, K_half, P, K_half);
+            combine(M_half, K_half, C11, ldc, P, K_half, C11, ldc, add);
+            // M4 = A22(B21 - B11) starts C21 and goes to C11
+            combine(N_half, K_half, B21, ldb, B11, ldb, U, K_half, subtract);
+            product(A22, lda, U, K_half, C21, ldc);
+            combine(M_half, K_half, C11, ldc, C21, ldc, C11, ldc, add);
+            // M5 = (A11 + A12)B22 starts C12 and leaves C11
+            combine(M_half, N_half, A11, lda, A12, lda, S, N_half, add);
+            product(S, N_half, B22, ldb, C12, ldc);
+            combine(M_half, K_half, C11, ldc, C12, ldc, C11, ldc, subtract);
+            // M3 = A11(B12 - B22) goes to C12 and C22
+            combine(N_half, K_half, B12, ldb, B22, ldb, U, K_half, subtract);
+            product(A11, lda, U, K_half, P, K_half);
+            combine(M_half, K_half, C12, ldc, P, K_half, C12, ldc, add);
+            combine(M_half, K_half, C22, ldc, P, K_half, C22, ldc, add);
+            // M2 = (A21 + A22)B11 goes to C21 and leaves C22
+            combine(M_half, N_half, A21, lda, A22, lda, S, N_half, add);
+            product(S, N_half, B11, ldb, P, K_half);
+            combine(M_half, K_half, C21, ldc, P, K_half, C21, ldc, add);
+            combine(M_half, K_half, C22, ldc, P, K_half, C22, ldc, subtract);
+            // M6 = (A21 - A11)(B11 + B12) goes to C22
+            combine(M_half, N_half, A21, lda, A11, lda, S, N_half, subtract);
+            combine(N_half, K_half, B11, ldb, B12, ldb, U, K_half, add);
+            product(S, N_half, U, K_half, P, K_half);
+            combine(M_half, K_half, C22, ldc, P, K_half, C22, ldc, add);
+
+            peel(M, N, K, A, lda, B, ldb, C, ldc);
+        }
+    };
+
+    /**
+     * @brief Number of elements of workspace the fixed-workspace Strassen needs for an M x N by N x K product
+     * Every level takes (M*N + N*K + M*K) / 4 of its own dimensions, a quarter of the level above, so the total never
+     * exceeds (M*N + N*K + M*K) / 3. For square n x n operands that is at most n^2 elements, the size of one operand.
+     *
+     * @param leaf Dimension at or below which the recursion hands the block to the packed GEMM
+     */
+    inline uint64_t strassenWorkspaceSize(uint32_t M, uint32_t N, uint32_t K, uint32_t leaf = Strassen::Leaf){
+        uint64_t size = 0;
+        while (Strassen::recurses(M, N, K, leaf)){
+            M /= 2;
+            N /= 2;
+            K /= 2;
+            size += static_cast<uint64_t>(M) * N + static_cast<uint64_t>(N) * K + static_cast<uint64_t>(M) * K;
+        }
+        return size;
+    }
+
+    /**
+     * @brief Computes A * B into C with the Strassen algorithm, using only the given workspace as scratch memory
+     * Nothing is allocated: quadrants are read in place from A and B, products are written into C or the workspace,
+     * and odd dimensions are peeled rather than padded. The leaves run on the packed GEMM and the thread pool.
+     *
+     * @param A First input tensor, M x N
+     * @param B Second input tensor, N x K
+     * @param C Destination, M x K. It is overwritten and must not share memory with A or B.
+     * @param workspace At least strassenWorkspaceSize(M, N, K, leaf) elements
+     * @param leaf Dimension at or below which the recursion hands the block to the packed GEMM
+     */
+    template <typename T>
+    void matmul2dStrassen(const Tensor<T, 2>& A, const Tensor<T, 2>& B, Tensor<T, 2>& C,
+                          std::type_identity_t<std::span<T>> workspace, uint32_t leaf = Strassen::Leaf){
+        const auto& dimsA = A.getDimensions();
+        const auto& dimsB = B.getDimensions();
+        assert(dimsA[1] == dimsB[0] && "For 2D matrix multiplication matrices need to have shapes M*N and N*K");
+        assert(C.getDimensions()[0] == dimsA[0] && C.getDimensions()[1] == dimsB[1] && "Destination must have shape M*K");
+        assert(leaf > 0 && "Leaf size must be positive");
+        assert(workspace.size() >= strassenWorkspaceSize(dimsA[0], dimsA[1], dimsB[1], leaf) && "Workspace is smaller than strassenWorkspaceSize");
+        Strassen::multiply(dimsA[0], dimsA[1], dimsB[1], A.Data.data(), dimsA[1], B.Data.data(), dimsB[1],
+                           C.Data.data(), dimsB[1], workspace.data(), leaf);
+    }
+
+    /**
+     * @brief Computes A * B into C with the Strassen algorithm, allocating the workspace once for the whole product
+     */
+    template <typename T>
+    void matmul2dStrassen(const Tensor<T, 2>& A, const Tensor<T, 2>& B, Tensor<T, 2>& C, uint32_t leaf = Strassen::Leaf){
+        std::vector<T, DefaultInitAllocator<T>> workspace(strassenWorkspaceSize(A.getDimensions()[0], A.getDimensions()[1], B.getDimensions()[1], leaf));
+        matmul2dStrassen(A, B, C, std::span<T>(workspace.data(), workspace.size()), leaf);
+    }
+};
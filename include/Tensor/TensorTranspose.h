@@ -0,0 +1,211 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstdint>
+#include "Tensor/TensorIterator.h"
+#include "Tensor/TensorParallel.h"
+
+namespace TensorTranspose {
+    // Side of the square cache blocks. A source and a destination block of 4-byte elements take 8 KB together, which fits L1.
+    constexpr uint32_t BlockSize = 32;
+
+    /**
+     * @brief Walks the matrix in BlockSize x BlockSize cache blocks and transposes every full Tile x Tile tile with tileFn
+     * Elements that do not fill a whole tile are copied one by one.
+     *
+     * @param src Row-major source matrix with rows x cols elements
+     * @param srcStride Distance in elements between two source rows
+     * @param dst Destination matrix with cols x rows elements
+     * @param dstStride Distance in elements between two destination rows
+     * @param tileFn Callable invoked as tileFn(const T* src, uint64_t srcStride, T* dst, uint64_t dstStride) for one tile
+     */
+    template <uint32_t Tile, typename T, typename TileFn>
+    void transposeBlocked(const T* src, uint64_t rows, uint64_t cols, uint64_t srcStride, T* dst, uint64_t dstStride, TileFn tileFn){
+        for (uint64_t ib = 0; ib < rows; ib += BlockSize){
+            uint64_t ie = std::min<uint64_t>(ib + BlockSize, rows);
+            for (uint64_t jb = 0; jb < cols; jb += BlockSize){
+                uint64_t je = std::min<uint64_t>(jb + BlockSize, cols);
+                uint64_t i = ib;
+                for (; i + Tile <= ie; i += Tile){
+                    uint64_t j = jb;
+                    for (; j + Tile <= je; j += Tile){
+                        tileFn(src + i * srcStride + j, srcStride, dst + j * dstStride + i, dstStride);
+                    }
+                    for (; j < je; j++){
+                        for (uint64_t r = i; r < i + Tile; r++){
+                            dst[j * dstStride + r] = src[r * srcStride + j];
+                        }
+                    }
+                }
+                for (; i < ie; i++){
+                    for (uint64_t j = jb; j < je; j++){
+                        dst[j * dstStride + i] = src[i * srcStride + j];
+                    }
+                }
+            }
+        }
+    }
+
+    /**
+     * @brief Transposes a rows x cols single-precision matrix with cache blocking and NEON 4x4 tiles
+     *
+     * @param src Source matrix, row-major with srcStride elements between rows
+     * @param rows Number of source rows
+     * @param cols Number of source columns
+     * @param srcStride Distance in elements between two source rows
+     * @param dst Destination matrix (cols x rows), row-major with dstStride elements between rows
+     * @param dstStride Distance in elements between two destination rows
+     */
+    void transpose(const float* src, uint64_t rows, uint64_t cols, uint64_t srcStride, float* dst, uint64_t dstStride);
+
+    /**
+     * @brief Transposes a rows x cols uint32_t matrix with cache blocking and NEON 4x4 tiles
+     */
+    void transpose(const uint32_t* src, uint64_t rows, uint64_t cols, uint64_t srcStride, uint32_t* dst, uint64_t dstStride);
+
+    /**
+     * @brief Transposes a rows x cols uint16_t matrix with cache blocking and NEON 8x8 tiles
+     */
+    void transpose(const uint16_t* src, uint64_t rows, uint64_t cols, uint64_t srcStride, uint16_t* dst, uint64_t dstStride);
+
+    /**
+     * @brief Transposes a rows x cols uint8_t matrix with cache blocking and 8x8 tiles
+     */
+    void transpose(const uint8_t* src, uint64_t rows, uint64_t cols, uint64_t srcStride, uint8_t* dst, uint64_t dstStride);
+
+    /**
+     * @brief Fallback cache-blocked transpose for types without a NEON tile kernel
+     */
+    template <typename T>
+    void transpose(const T* src, uint64_t rows, uint64_t cols, uint64_t srcStride, T* dst, uint64_t dstStride){
+        transposeBlocked<1>(src, rows, cols, srcStride, dst, dstStride, [](const T* s, uint64_t, T* d, uint64_t) { *d = *s; });
+    }
+
+    /**
+     * @brief Copies an N-dimensional array into dst with its axes reordered, axis i of dst being axis axes[i] of src
+     * Axes of size 1 are dropped and neighbouring destination axes that are also neighbours in src are merged first, so
+     * an NHWC to NCHW permute becomes a batch of (H*W) x C transposes. When the innermost destination axis is contiguous
+     * in src every line is a plain copy, otherwise the source axis with stride 1 and the innermost destination axis are
+     * swapped with the cache-blocked transpose. The outer axes are walked with TensorIndex and spread over threads.
+     *
+     * @param src First element of the source
+     * @param dims Source dimensions
+     * @param strides Source strides in elements
+     * @param axes Permutation of [0, N)
+     * @param dst Row-major destination with dimensions dims[axes[0]], ..., dims[axes[N - 1]]
+     */
+    template <typename T, uint16_t N>
+    void permute(const T* src, const std::array<uint32_t, N>& dims, const std::array<uint64_t, N>& strides,
+                 const std::array<uint16_t, N>& axes, T* dst){
+        std::array<bool, N> used{};
+        for (uint16_t i = 0; i < N; i++){
+            assert(axes[i] < N && !used[axes[i]] && "Axes must be a permutation of the tensor's axes");
+            used[axes[i]] = true;
+        }
+
+        // Destination axes without those of size 1 and with source neighbours merged, outermost first
+        std::array<uint32_t, N> size;
+        std::array<uint64_t, N> srcStride;
+        uint16_t rank = 0;
+        for (uint16_t i = 0; i < N; i++){
+            uint32_t dim = dims[axes[i]];
+            if (dim == 0)
+                return;
+            if (dim == 1)
+                continue;
+            uint64_t stride = strides[axes[i]];
+            uint64_t merged = rank > 0 ? static_cast<uint64_t>(size[rank - 1]) * dim : 0;
+            if (rank > 0 && srcStride[rank - 1] == stride * dim && merged <= UINT32_MAX){
+                size[rank - 1] = static_cast<uint32_t>(merged);
+                srcStride[rank - 1] = stride;
+            } else {
+                size[rank] = dim;
+                srcStride[rank] = stride;
+                rank++;
+            }
+        }
+        if (rank == 0){
+            *dst = *src;
+            return;
+        }
+        std::array<uint64_t, N> dstStride;
+        dstStride[rank - 1] = 1;
+        for (int i = rank - 2; i >= 0; i--)
+            dstStride[i] = dstStride[i + 1] * size[i + 1];
+
+        // The innermost destination axis becomes the lines of every item. When it is not contiguous in src the axis that
+        // is becomes the second side of a transpose.
+        uint16_t last = rank - 1;
+        int swapped = -1;
+        if (srcStride[last] != 1){
+            for (uint16_t i = 0; i < last; i++){
+                if (srcStride[i] == 1)
+                    swapped = i;
+            }
+        }
+        uint64_t lineStride = srcStride[last];
+        uint64_t lineLength = swapped >= 0 ? size[swapped] : 1;
+
+        // The remaining axes are walked by two indices in step, padded with leading axes of size 1
+        std::array<uint32_t, N> outerDims;
+        std::array<uint64_t, N> outerSrc;
+        std::array<uint64_t, N> outerDst;
+        outerDims.fill(1);
+        outerSrc.fill(0);
+        outerDst.fill(0);
+        uint16_t slot = N;
+        uint64_t outer = 1;
+        for (int i = last - 1; i >= 0; i--){
+            if (i == swapped)
+                continue;
+            slot--;
+            outerDims[slot] = size[i];
+            outerSrc[slot] = srcStride[i];
+            outerDst[slot] = dstStride[i];
+            outer *= size[i];
+        }
+
+        // Lines [begin, end) of the item whose first elements are at srcOffset and dstOffset
+        auto item = [&](uint64_t srcOffset, uint64_t dstOffset, uint64_t begin, uint64_t end) {
+            const T* from = src + srcOffset + begin * lineStride;
+            T* to = dst + dstOffset + begin;
+            if (swapped >= 0){
+                transpose(from, end - begin, lineLength, lineStride, to, dstStride[swapped]);
+            } else if (lineStride == 1){
+                std::copy(from, from + (end - begin), to);
+            } else {
+                for (uint64_t j = 0; j < end - begin; j++)
+                    to[j] = from[j * lineStride];
+            }
+        };
+
+        uint64_t lines = size[last];
+        uint64_t minElements = 1 << 16;
+        if (outer >= TensorParallel::workerCount()){
+            uint64_t minItems = std::max<uint64_t>(1, minElements / (lines * lineLength));
+            TensorParallel::parallelFor(0, outer, minItems, [&](uint64_t itemBegin, uint64_t itemEnd) {
+                TensorIndex<N> from(outerDims, outerSrc);
+                TensorIndex<N> to(outerDims, outerDst);
+                from.seek(itemBegin);
+                to.seek(itemBegin);
+                for (uint64_t index = itemBegin; index < itemEnd; index++){
+                    item(from.offset(), to.offset(), 0, lines);
+                    from.next();
+                    to.next();
+                }
+            });
+        } else {
+            // Too few items to go around, the lines of each item are split instead
+            uint64_t minLines = std::max<uint64_t>(BlockSize, minElements / lineLength);
+            TensorIndex<N> from(outerDims, outerSrc);
+            TensorIndex<N> to(outerDims, outerDst);
+            for (; !from.done(); from.next(), to.next()){
+                TensorParallel::parallelFor(0, lines, minLines, [&](uint64_t lineBegin, uint64_t lineEnd) {
+                    item(from.offset(), to.offset(), lineBegin, lineEnd);
+                });
+            }
+        }
+    }
+};
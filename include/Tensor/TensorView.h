@@ -0,0 +1,78 @@
+#pragma once
+
+#include <array>
+#include <cassert>
+#include <cstdint>
+#include <type_traits>
+#include "Tensor/Tensor.h"
+
+/**
+ * @brief Non-owning row-major view of N-dimensional data
+ * Views are how tensors with different storage, like Tensor and StaticTensor, read and write each other's elements
+ * without copying. A view with a const element type is read-only. The viewed storage has to outlive the view.
+ */
+template <typename T, uint16_t N>
+class TensorView {
+private:
+    T* _data;
+    std::array<uint32_t, N> _dims;
+    std::array<uint64_t, N> _strides;
+
+    void computeStrides() {
+        _strides[N - 1] = 1;
+        for (int i = N - 2; i >= 0; i--) {
+            _strides[i] = static_cast<uint64_t>(_dims[i + 1]) * _strides[i + 1];
+        }
+    }
+
+public:
+    using ValueType = std::remove_const_t<T>;
+
+    TensorView(T* data, const std::array<uint32_t, N>& dims) : _data(data), _dims(dims) {
+        computeStrides();
+    }
+
+    TensorView(Tensor<ValueType, N>& tensor) : TensorView(tensor.Data.data(), tensor.getDimensions()) {}
+
+    TensorView(const Tensor<ValueType, N>& tensor) requires std::is_const_v<T>
+        : TensorView(tensor.Data.data(), tensor.getDimensions()) {}
+
+    TensorView(const TensorView&) = default;
+    TensorView& operator=(const TensorView&) = default;
+
+    // A writable view converts to a read-only one
+    TensorView(const TensorView<ValueType, N>& other) requires std::is_const_v<T>
+        : TensorView(other.data(), other.getDimensions()) {}
+
+    template<typename... Index>
+    T& operator()(Index... indices) const {
+        static_assert(sizeof...(indices) == N, "Wrong number of indices");
+        std::array<uint32_t, N> idx = { static_cast<uint32_t>(indices)... };
+        uint64_t linear = 0;
+        for (uint16_t i = 0; i < N; i++) {
+            assert(idx[i] < _dims[i] && "Index out of bounds");
+            linear += static_cast<uint64_t>(idx[i]) * _strides[i];
+        }
+        return _data[linear];
+    }
+
+    T* data() const {
+        return _data;
+    }
+
+    uint64_t size() const {
+        uint64_t total = 1;
+        for (uint16_t i = 0; i < N; i++) {
+            total *= _dims[i];
+        }
+        return total;
+    }
+
+    const std::array<uint32_t, N>& getDimensions() const {
+        return _dims;
+    }
+
+    const std::array<uint64_t, N>& getStrides() const {
+        return _strides;
+    }
+};
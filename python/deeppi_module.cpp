@@ -0,0 +1,514 @@
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+#include <array>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <new>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "Tensor/Tensor.h"
+#include "Tensor/TensorGemm.h"
+#include "Tensor/TensorParallel.h"
+
+/**
+ * @brief CPython extension module deeppi
+ * deeppi.Tensor owns DeepPi storage and exports it through the buffer protocol, so numpy.asarray(tensor) and
+ * memoryview(tensor) share its memory. In the other direction every operation accepts any C-contiguous buffer, a
+ * NumPy array included, reads it in place and can write its result into a writable buffer passed as out. The GIL is
+ * released while DeepPi computes, so Python threads run products in parallel. No C++ exception crosses into Python:
+ * std::bad_alloc is raised as MemoryError and any other exception as RuntimeError.
+ */
+
+namespace {
+    enum class DType {
+        Float32,
+        Float64,
+        UInt8,
+        UInt16,
+        UInt32
+    };
+
+    struct DTypeInfo {
+        DType dtype;
+        const char* name;
+        const char* format;     // struct module format character of the element
+        Py_ssize_t itemsize;
+    };
+
+    constexpr std::array<DTypeInfo, 5> dtypes = {{
+        {DType::Float32, "float32", "f", 4},
+        {DType::Float64, "float64", "d", 8},
+        {DType::UInt8, "uint8", "B", 1},
+        {DType::UInt16, "uint16", "H", 2},
+        {DType::UInt32, "uint32", "I", 4},
+    }};
+
+    const DTypeInfo& info(DType dtype){
+        return dtypes[static_cast<int>(dtype)];
+    }
+
+    // Calls fn with a value of the element type of dtype, the one place where a runtime dtype becomes a template argument
+    template <typename Fn>
+    auto dispatch(DType dtype, Fn&& fn){
+        switch (dtype){
+            case DType::Float32: return fn(float());
+            case DType::Float64: return fn(double());
+            case DType::UInt8: return fn(uint8_t());
+            case DType::UInt16: return fn(uint16_t());
+            default: return fn(uint32_t());
+        }
+    }
+
+    // Element type of a buffer format, native byte order only. NumPy may describe uint32 as L where long has 32 bits.
+    bool parseFormat(const char* format, Py_ssize_t itemsize, DType& dtype){
+        std::string_view text = format ? format : "B";
+        if (!text.empty() && (text[0] == '@' || text[0] == '='))
+            text.remove_prefix(1);
+        if (text.size() != 1)
+            return false;
+        for (const auto& candidate : dtypes){
+            if (text[0] == candidate.format[0] && itemsize == candidate.itemsize){
+                dtype = candidate.dtype;
+                return true;
+            }
+        }
+        if (text[0] == 'L' && itemsize == 4){
+            dtype = DType::UInt32;
+            return true;
+        }
+        return false;
+    }
+
+    // Sets the Python error matching a caught C++ exception, the GIL must be held
+    void setError(std::exception_ptr error){
+        try {
+            std::rethrow_exception(error);
+        } catch (const std::bad_alloc&) {
+            PyErr_NoMemory();
+        } catch (const std::exception& exception) {
+            PyErr_SetString(PyExc_RuntimeError, exception.what());
+        } catch (...) {
+            PyErr_SetString(PyExc_RuntimeError, "Unknown C++ exception");
+        }
+    }
+
+    // Body of a Python entry point, a C++ exception escaping fn becomes a Python error and a nullptr result
+    template <typename Fn>
+    PyObject* guarded(Fn&& fn){
+        try {
+            return fn();
+        } catch (...) {
+            setError(std::current_exception());
+            return nullptr;
+        }
+    }
+
+    // Runs fn with the GIL released, an exception thrown by fn is rethrown once the GIL is held again
+    template <typename Fn>
+    void withoutGil(Fn&& fn){
+        std::exception_ptr error;
+        Py_BEGIN_ALLOW_THREADS
+        try {
+            fn();
+        } catch (...) {
+            error = std::current_exception();
+        }
+        Py_END_ALLOW_THREADS
+        if (error)
+            std::rethrow_exception(error);
+    }
+
+    // Whether the memory of two buffers shares at least one byte
+    bool overlaps(const Py_buffer& x, const Py_buffer& y){
+        const char* xBegin = static_cast<const char*>(x.buf);
+        const char* yBegin = static_cast<const char*>(y.buf);
+        return x.len > 0 && y.len > 0 && xBegin < yBegin + y.len && yBegin < xBegin + x.len;
+    }
+
+    // Flat DeepPi storage of a deeppi.Tensor, any rank is viewed through the shape kept by the Python object
+    struct Storage {
+        virtual ~Storage() = default;
+        virtual void* data() = 0;
+    };
+
+    template <typename T>
+    struct TypedStorage : Storage {
+        Tensor<T, 1> tensor;
+
+        explicit TypedStorage(uint32_t size) : tensor(std::array<uint32_t, 1>{size}) {}
+
+        void* data() override {
+            return tensor.Data.data();
+        }
+    };
+
+    struct PyTensor {
+        PyObject_HEAD
+        DType dtype;
+        Storage* storage;
+        std::vector<Py_ssize_t>* shape;
+        std::vector<Py_ssize_t>* strides;   // In bytes, as the buffer protocol wants them
+    };
+
+    extern PyTypeObject PyTensorType;
+
+    PyTensor* newTensor(DType dtype, const std::vector<Py_ssize_t>& shape){
+        Py_ssize_t size = 1;
+        for (Py_ssize_t extent : shape){
+            if (extent < 0 || extent > UINT32_MAX){
+                PyErr_SetString(PyExc_ValueError, "Every axis must hold between 0 and 2^32 - 1 elements");
+                return nullptr;
+            }
+            // Checked before multiplying, the product of two large axes would overflow Py_ssize_t
+            if (extent != 0 && size > UINT32_MAX / extent){
+                PyErr_SetString(PyExc_ValueError, "Tensor is too large");
+                return nullptr;
+            }
+            size *= extent;
+        }
+        PyTensor* self = PyObject_New(PyTensor, &PyTensorType);
+        if (!self)
+            return nullptr;
+        self->dtype = dtype;
+        self->storage = nullptr;
+        self->shape = nullptr;
+        self->strides = nullptr;
+        try {
+            self->storage = dispatch(dtype, [&](auto value) -> Storage* { return new TypedStorage<decltype(value)>(static_cast<uint32_t>(size)); });
+            self->shape = new std::vector<Py_ssize_t>(shape);
+            self->strides = new std::vector<Py_ssize_t>(shape.size());
+        } catch (...) {
+            Py_DECREF(self);
+            throw;
+        }
+        Py_ssize_t stride = info(dtype).itemsize;
+        for (int axis = static_cast<int>(shape.size()) - 1; axis >= 0; axis--){
+            (*self->strides)[axis] = stride;
+            stride *= shape[axis];
+        }
+        return self;
+    }
+
+    /**
+     * @brief Read or write access to the memory of a buffer-protocol object, released when it goes out of scope
+     * Only C-contiguous buffers are accepted, so an operation can hand the pointer straight to the DeepPi kernels.
+     */
+    struct Buffer {
+        Py_buffer view{};
+        bool held = false;
+        DType dtype = DType::Float32;
+
+        bool acquire(PyObject* object, bool writable, const char* name){
+            int flags = PyBUF_C_CONTIGUOUS | PyBUF_FORMAT | (writable ? PyBUF_WRITABLE : 0);
+            if (PyObject_GetBuffer(object, &view, flags) != 0){
+                PyErr_Format(PyExc_TypeError, "%s must be a C-contiguous%s buffer", name, writable ? " writable" : "");
+                return false;
+            }
+            held = true;
+            if (!parseFormat(view.format, view.itemsize, dtype)){
+                PyErr_Format(PyExc_TypeError, "%s has an unsupported element type '%s'", name, view.format ? view.format : "B");
+                return false;
+            }
+            return true;
+        }
+
+        ~Buffer(){
+            if (held)
+                PyBuffer_Release(&view);
+        }
+
+        std::vector<Py_ssize_t> shape() const {
+            return std::vector<Py_ssize_t>(view.shape, view.shape + view.ndim);
+        }
+
+        uint64_t size() const {
+            return static_cast<uint64_t>(view.len / view.itemsize);
+        }
+    };
+
+    // Output of an operation: the out buffer when one is given, a new tensor otherwise. The result is dropped unless released.
+    struct Output {
+        Buffer buffer;
+        PyObject* result = nullptr;
+        void* data = nullptr;
+
+        ~Output(){
+            Py_XDECREF(result);
+        }
+
+        PyObject* release(){
+            return std::exchange(result, nullptr);
+        }
+
+        bool prepare(PyObject* out, DType dtype, const std::vector<Py_ssize_t>& shape){
+            if (out && out != Py_None){
+                if (!buffer.acquire(out, true, "out"))
+                    return false;
+                if (buffer.dtype != dtype || buffer.shape() != shape){
+                    PyErr_SetString(PyExc_ValueError, "out must have the element type and shape of the result");
+                    return false;
+                }
+                Py_INCREF(out);
+                result = out;
+                data = buffer.view.buf;
+                return true;
+            }
+            PyTensor* tensor = newTensor(dtype, shape);
+            if (!tensor)
+                return false;
+            result = reinterpret_cast<PyObject*>(tensor);
+            data = tensor->storage->data();
+            return true;
+        }
+    };
+
+    void PyTensor_dealloc(PyTensor* self){
+        delete self->storage;
+        delete self->shape;
+        delete self->strides;
+        Py_TYPE(self)->tp_free(reinterpret_cast<PyObject*>(self));
+    }
+
+    PyObject* tensorNew(PyObject* args, PyObject* kwargs){
+        static const char* keywords[] = {"shape", "dtype", nullptr};
+        PyObject* shapeObject = nullptr;
+        const char* name = "float32";
+        if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O|s", const_cast<char**>(keywords), &shapeObject, &name))
+            return nullptr;
+        const DTypeInfo* found = nullptr;
+        for (const auto& candidate : dtypes){
+            if (std::string_view(name) == candidate.name)
+                found = &candidate;
+        }
+        if (!found){
+            PyErr_Format(PyExc_ValueError, "Unknown dtype '%s'", name);
+            return nullptr;
+        }
+        PyObject* sequence = PySequence_Fast(shapeObject, "shape must be a sequence of integers");
+        if (!sequence)
+            return nullptr;
+        std::vector<Py_ssize_t> shape;
+        try {
+            shape.resize(PySequence_Fast_GET_SIZE(sequence));
+        } catch (...) {
+            Py_DECREF(sequence);
+            throw;
+        }
+        for (size_t axis = 0; axis < shape.size(); axis++){
+            shape[axis] = PyLong_AsSsize_t(PySequence_Fast_GET_ITEM(sequence, axis));
+            if (shape[axis] == -1 && PyErr_Occurred()){
+                Py_DECREF(sequence);
+                return nullptr;
+            }
+        }
+        Py_DECREF(sequence);
+        return reinterpret_cast<PyObject*>(newTensor(found->dtype, shape));
+    }
+
+    PyObject* PyTensor_new(PyTypeObject*, PyObject* args, PyObject* kwargs){
+        return guarded([&] { return tensorNew(args, kwargs); });
+    }
+
+    // The storage is always writable and C-contiguous, so every request is served, with the fields the flags ask for
+    int PyTensor_getbuffer(PyTensor* self, Py_buffer* view, int flags){
+        view->obj = reinterpret_cast<PyObject*>(self);
+        Py_INCREF(self);
+        view->buf = self->storage->data();
+        view->itemsize = info(self->dtype).itemsize;
+        view->len = view->itemsize;
+        for (Py_ssize_t extent : *self->shape)
+            view->len *= extent;
+        view->readonly = 0;
+        view->format = (flags & PyBUF_FORMAT) ? const_cast<char*>(info(self->dtype).format) : nullptr;
+        view->ndim = static_cast<int>(self->shape->size());
+        view->shape = (flags & PyBUF_ND) ? self->shape->data() : nullptr;
+        view->strides = (flags & PyBUF_STRIDES) == PyBUF_STRIDES ? self->strides->data() : nullptr;
+        view->suboffsets = nullptr;
+        view->internal = nullptr;
+        return 0;
+    }
+
+    PyObject* PyTensor_shape(PyTensor* self, void*){
+        PyObject* shape = PyTuple_New(static_cast<Py_ssize_t>(self->shape->size()));
+        for (size_t axis = 0; shape && axis < self->shape->size(); axis++)
+            PyTuple_SET_ITEM(shape, axis, PyLong_FromSsize_t((*self->shape)[axis]));
+        return shape;
+    }
+
+    PyObject* PyTensor_dtype(PyTensor* self, void*){
+        return PyUnicode_FromString(info(self->dtype).name);
+    }
+
+    PyObject* PyTensor_repr(PyTensor* self){
+        PyObject* shape = PyTensor_shape(self, nullptr);
+        if (!shape)
+            return nullptr;
+        PyObject* repr = PyUnicode_FromFormat("deeppi.Tensor(shape=%R, dtype='%s')", shape, info(self->dtype).name);
+        Py_DECREF(shape);
+        return repr;
+    }
+
+    PyBufferProcs PyTensorBuffer = {
+        reinterpret_cast<getbufferproc>(PyTensor_getbuffer),
+        nullptr
+    };
+
+    PyGetSetDef PyTensorGetSet[] = {
+        {"shape", reinterpret_cast<getter>(PyTensor_shape), nullptr, "Extent of every axis", nullptr},
+        {"dtype", reinterpret_cast<getter>(PyTensor_dtype), nullptr, "Name of the element type", nullptr},
+        {nullptr, nullptr, nullptr, nullptr, nullptr}
+    };
+
+    PyTypeObject PyTensorType = [] {
+        PyTypeObject type{PyVarObject_HEAD_INIT(nullptr, 0)};
+        type.tp_name = "deeppi.Tensor";
+        type.tp_basicsize = sizeof(PyTensor);
+        type.tp_dealloc = reinterpret_cast<destructor>(PyTensor_dealloc);
+        type.tp_repr = reinterpret_cast<reprfunc>(PyTensor_repr);
+        type.tp_as_buffer = &PyTensorBuffer;
+        type.tp_flags = Py_TPFLAGS_DEFAULT;
+        type.tp_doc = PyDoc_STR("Tensor(shape, dtype='float32')\n\nZero-filled DeepPi tensor exporting its memory through the buffer protocol.");
+        type.tp_getset = PyTensorGetSet;
+        type.tp_new = PyTensor_new;
+        return type;
+    }();
+
+    // matmul(a, b, out=None): product of two 2-D buffers on the packed GEMM, out must not overlap a or b
+    PyObject* matmul(PyObject* args, PyObject* kwargs){
+        static const char* keywords[] = {"a", "b", "out", nullptr};
+        PyObject* a = nullptr;
+        PyObject* b = nullptr;
+        PyObject* out = nullptr;
+        if (!PyArg_ParseTupleAndKeywords(args, kwargs, "OO|O", const_cast<char**>(keywords), &a, &b, &out))
+            return nullptr;
+        Buffer A;
+        Buffer B;
+        if (!A.acquire(a, false, "a") || !B.acquire(b, false, "b"))
+            return nullptr;
+        if (A.view.ndim != 2 || B.view.ndim != 2 || A.view.shape[1] != B.view.shape[0]){
+            PyErr_SetString(PyExc_ValueError, "For 2D matrix multiplication matrices need to have shapes M*N and N*K");
+            return nullptr;
+        }
+        if (A.dtype != B.dtype){
+            PyErr_SetString(PyExc_TypeError, "Operands must have the same element type");
+            return nullptr;
+        }
+        if (A.view.shape[0] > UINT32_MAX || A.view.shape[1] > UINT32_MAX || B.view.shape[1] > UINT32_MAX){
+            PyErr_SetString(PyExc_ValueError, "Every axis must hold between 0 and 2^32 - 1 elements");
+            return nullptr;
+        }
+        uint32_t M = static_cast<uint32_t>(A.view.shape[0]);
+        uint32_t N = static_cast<uint32_t>(A.view.shape[1]);
+        uint32_t K = static_cast<uint32_t>(B.view.shape[1]);
+        Output C;
+        if (!C.prepare(out, A.dtype, {A.view.shape[0], B.view.shape[1]}))
+            return nullptr;
+        // The GEMM reads a and b while it writes C, an aliased out would feed it partial results
+        if (C.buffer.held && (overlaps(C.buffer.view, A.view) || overlaps(C.buffer.view, B.view))){
+            PyErr_SetString(PyExc_ValueError, "out must not overlap a or b");
+            return nullptr;
+        }
+        withoutGil([&] {
+            dispatch(A.dtype, [&](auto value) {
+                using T = decltype(value);
+                TensorMatmul::gemm<T>(M, N, K, static_cast<const T*>(A.view.buf), N, TensorMatmul::Transpose::No,
+                                      static_cast<const T*>(B.view.buf), K, TensorMatmul::Transpose::No, static_cast<T*>(C.data), K);
+            });
+        });
+        return C.release();
+    }
+
+    PyObject* deeppi_matmul(PyObject*, PyObject* args, PyObject* kwargs){
+        return guarded([&] { return matmul(args, kwargs); });
+    }
+
+    // Elementwise operation on two buffers of the same shape, op is applied to every pair of elements
+    template <typename Op>
+    PyObject* elementwise(PyObject* args, PyObject* kwargs, Op op){
+        static const char* keywords[] = {"a", "b", "out", nullptr};
+        PyObject* a = nullptr;
+        PyObject* b = nullptr;
+        PyObject* out = nullptr;
+        if (!PyArg_ParseTupleAndKeywords(args, kwargs, "OO|O", const_cast<char**>(keywords), &a, &b, &out))
+            return nullptr;
+        Buffer A;
+        Buffer B;
+        if (!A.acquire(a, false, "a") || !B.acquire(b, false, "b"))
+            return nullptr;
+        if (A.shape() != B.shape()){
+            PyErr_SetString(PyExc_ValueError, "Tensors must have the same shape");
+            return nullptr;
+        }
+        if (A.dtype != B.dtype){
+            PyErr_SetString(PyExc_TypeError, "Operands must have the same element type");
+            return nullptr;
+        }
+        Output C;
+        if (!C.prepare(out, A.dtype, A.shape()))
+            return nullptr;
+        uint64_t size = A.size();
+        withoutGil([&] {
+            dispatch(A.dtype, [&](auto value) {
+                using T = decltype(value);
+                const T* x = static_cast<const T*>(A.view.buf);
+                const T* y = static_cast<const T*>(B.view.buf);
+                T* z = static_cast<T*>(C.data);
+                TensorParallel::parallelElementwise(size, [&](uint64_t begin, uint64_t end) {
+                    for (uint64_t i = begin; i < end; i++)
+                        z[i] = op(x[i], y[i]);
+                });
+            });
+        });
+        return C.release();
+    }
+
+    PyObject* deeppi_add(PyObject*, PyObject* args, PyObject* kwargs){
+        return guarded([&] { return elementwise(args, kwargs, [](auto x, auto y) { return static_cast<decltype(x)>(x + y); }); });
+    }
+
+    PyObject* deeppi_subtract(PyObject*, PyObject* args, PyObject* kwargs){
+        return guarded([&] { return elementwise(args, kwargs, [](auto x, auto y) { return static_cast<decltype(x)>(x - y); }); });
+    }
+
+    PyObject* deeppi_multiply(PyObject*, PyObject* args, PyObject* kwargs){
+        return guarded([&] { return elementwise(args, kwargs, [](auto x, auto y) { return static_cast<decltype(x)>(x * y); }); });
+    }
+
+    PyMethodDef deeppiMethods[] = {
+        {"matmul", reinterpret_cast<PyCFunction>(reinterpret_cast<void(*)(void)>(deeppi_matmul)), METH_VARARGS | METH_KEYWORDS,
+         PyDoc_STR("matmul(a, b, out=None)\n\nMatrix product of two 2-D buffers of the same element type.")},
+        {"add", reinterpret_cast<PyCFunction>(reinterpret_cast<void(*)(void)>(deeppi_add)), METH_VARARGS | METH_KEYWORDS,
+         PyDoc_STR("add(a, b, out=None)\n\nElementwise a + b.")},
+        {"subtract", reinterpret_cast<PyCFunction>(reinterpret_cast<void(*)(void)>(deeppi_subtract)), METH_VARARGS | METH_KEYWORDS,
+         PyDoc_STR("subtract(a, b, out=None)\n\nElementwise a - b.")},
+        {"multiply", reinterpret_cast<PyCFunction>(reinterpret_cast<void(*)(void)>(deeppi_multiply)), METH_VARARGS | METH_KEYWORDS,
+         PyDoc_STR("multiply(a, b, out=None)\n\nElementwise a * b.")},
+        {nullptr, nullptr, 0, nullptr}
+    };
+
+    PyModuleDef deeppiModule = {
+        PyModuleDef_HEAD_INIT,
+        "deeppi",
+        PyDoc_STR("DeepPi tensors and kernels sharing memory with NumPy through the buffer protocol."),
+        -1,
+        deeppiMethods,
+        nullptr, nullptr, nullptr, nullptr
+    };
+};
+
+PyMODINIT_FUNC PyInit_deeppi(void){
+    if (PyType_Ready(&PyTensorType) < 0)
+        return nullptr;
+    PyObject* module = PyModule_Create(&deeppiModule);
+    if (!module)
+        return nullptr;
+    Py_INCREF(&PyTensorType);
+    if (PyModule_AddObject(module, "Tensor", reinterpret_cast<PyObject*>(&PyTensorType)) < 0){
+        Py_DECREF(&PyTensorType);
+        Py_DECREF(module);
+        return nullptr;
+    }
+    return module;
+}
@@ -0,0 +1,92 @@
+#include "Tensor/TensorAsync.h"
+#include <coroutine>
+#include <functional>
+#include <mutex>
+#include <utility>
+
+namespace TensorAsync {
+    Stream::Stream() : _thread([this]() { workerLoop(); }), _resumer([this]() { resumerLoop(); }) {}
+
+    Stream::~Stream(){
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            // A resumed coroutine may queue more operations, so both threads stop only once neither has work left
+            _drained.wait(lock, [this]() { return _pending == 0 && _resumptions.empty() && !_resuming; });
+            _stop = true;
+        }
+        _wake.notify_one();
+        _resumeWake.notify_one();
+        _thread.join();
+        _resumer.join();
+    }
+
+    void Stream::enqueue(std::function<void()> job){
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _queue.push_back(std::move(job));
+            _pending++;
+        }
+        _wake.notify_one();
+    }
+
+    void Stream::resume(std::coroutine_handle<> handle){
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _resumptions.push_back(handle);
+        }
+        _resumeWake.notify_one();
+    }
+
+    void Stream::synchronize(){
+        std::unique_lock<std::mutex> lock(_mutex);
+        _drained.wait(lock, [this]() { return _pending == 0; });
+    }
+
+    uint64_t Stream::pending() const {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _pending;
+    }
+
+    void Stream::workerLoop(){
+        for (;;){
+            std::function<void()> job;
+            {
+                std::unique_lock<std::mutex> lock(_mutex);
+                // The queue is drained before stopping, so no future is left without a value
+                _wake.wait(lock, [this]() { return _stop || !_queue.empty(); });
+                if (_queue.empty())
+                    return;
+                job = std::move(_queue.front());
+                _queue.pop_front();
+            }
+            job();
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                if (--_pending == 0)
+                    _drained.notify_all();
+            }
+        }
+    }
+
+    void Stream::resumerLoop(){
+        for (;;){
+            std::coroutine_handle<> handle;
+            {
+                std::unique_lock<std::mutex> lock(_mutex);
+                _resumeWake.wait(lock, [this]() { return _stop || !_resumptions.empty(); });
+                if (_resumptions.empty())
+                    return;
+                handle = _resumptions.front();
+                _resumptions.pop_front();
+                _resuming = true;
+            }
+            handle.resume();
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                _resuming = false;
+                if (_pending == 0 && _resumptions.empty())
+                    _drained.notify_all();
+            }
+        }
+    }
+};
@@ -0,0 +1,133 @@
+#include "Tensor/TensorAttention.h"
+#include "Tensor/TensorGemm.h"
+#include "Tensor/TensorMath.h"
+#include "Tensor/TensorParallel.h"
+#include <algorithm>
+#include <arm_neon.h>
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+
+namespace {
+    using TensorAttention::KeyBlock;
+    using TensorAttention::QueryBlock;
+    using TensorMatmul::Transpose;
+
+    // Multiply-adds one task should have before it is worth its own thread
+    constexpr uint64_t MinTaskWork = 1 << 18;
+
+    /**
+     * @brief Turns one row of scores into probabilities relative to the updated running max
+     * Only the first valid scores take part, the rest of the row is set to 0 so the P V product ignores it.
+     *
+     * @return Factor exp(oldMax - newMax) the accumulated output of the row has to be rescaled by
+     */
+    float softmaxStep(float* scores, uint32_t valid, uint32_t count, float& runningMax, float& runningSum){
+        float32x4_t maxV = vdupq_n_f32(runningMax);
+        uint32_t c = 0;
+        for (; c + 4 <= valid; c += 4)
+            maxV = vmaxq_f32(maxV, vld1q_f32(scores + c));
+        float newMax = TensorMath::horizontalMax(maxV);
+        for (; c < valid; c++)
+            newMax = std::max(newMax, scores[c]);
+
+        float32x4_t shift = vdupq_n_f32(newMax);
+        float32x4_t sumV = vdupq_n_f32(0.0f);
+        c = 0;
+        for (; c + 4 <= valid; c += 4){
+            float32x4_t p = TensorMath::vexp(vsubq_f32(vld1q_f32(scores + c), shift));
+            vst1q_f32(scores + c, p);
+            sumV = vaddq_f32(sumV, p);
+        }
+        float sum = TensorMath::horizontalSum(sumV);
+        for (; c < valid; c++){
+            scores[c] = std::exp(scores[c] - newMax);
+            sum += scores[c];
+        }
+        std::fill(scores + valid, scores + count, 0.0f);
+
+        float alpha = std::exp(runningMax - newMax);
+        runningSum = runningSum * alpha + sum;
+        runningMax = newMax;
+        return alpha;
+    }
+
+    // acc = acc * alpha + pv for one row of the output accumulator
+    void rescaleAndAdd(float* acc, const float* pv, uint32_t count, float alpha){
+        float32x4_t alphaV = vdupq_n_f32(alpha);
+        uint32_t c = 0;
+        for (; c + 4 <= count; c += 4)
+            vst1q_f32(acc + c, vmlaq_f32(vld1q_f32(pv + c), vld1q_f32(acc + c), alphaV));
+        for (; c < count; c++)
+            acc[c] = acc[c] * alpha + pv[c];
+    }
+
+    /**
+     * @brief Attention for queries [q0, q0 + rows) of one (batch, head) pair
+     * Scores, the output accumulator and the P V product live in the thread's GEMM scratch slots 2 to 4.
+     */
+    void attendBlock(const float* Q, const float* K, const float* V, float* O, uint32_t q0, uint32_t rows,
+                     uint32_t seqQ, uint32_t seqK, uint32_t dim, uint32_t dimV, float scale, bool causal){
+        float* scores = TensorMatmul::Gemm::workspace<float>(2, static_cast<uint64_t>(QueryBlock) * KeyBlock);
+        float* acc = TensorMatmul::Gemm::workspace<float>(3, static_cast<uint64_t>(QueryBlock) * dimV);
+        float* pv = TensorMatmul::Gemm::workspace<float>(4, static_cast<uint64_t>(QueryBlock) * dimV);
+        float runningMax[QueryBlock];
+        float runningSum[QueryBlock];
+        float alpha[QueryBlock];
+        std::fill(runningMax, runningMax + rows, -FLT_MAX);
+        std::fill(runningSum, runningSum + rows, 0.0f);
+        std::fill(acc, acc + static_cast<uint64_t>(rows) * dimV, 0.0f);
+
+        // With a causal mask query i sees keys up to i + offset, later key blocks are skipped entirely
+        int64_t offset = static_cast<int64_t>(seqK) - seqQ;
+        uint32_t keyEnd = causal
+            ? static_cast<uint32_t>(std::clamp<int64_t>(static_cast<int64_t>(q0) + rows + offset, 0, seqK))
+            : seqK;
+        TensorMatmul::GemmEpilogue<float> scaleScores;
+        scaleScores.scale = scale;
+        for (uint32_t k0 = 0; k0 < keyEnd; k0 += KeyBlock){
+            uint32_t cols = std::min(KeyBlock, keyEnd - k0);
+            // scores = scale * Q K^T for this block of keys
+            TensorMatmul::gemm<float>(rows, dim, cols, Q, dim, Transpose::No, K + static_cast<uint64_t>(k0) * dim, dim, Transpose::Yes,
+                                      scores, KeyBlock, &scaleScores, false);
+            for (uint32_t r = 0; r < rows; r++){
+                uint32_t valid = cols;
+                if (causal)
+                    valid = static_cast<uint32_t>(std::clamp<int64_t>(static_cast<int64_t>(q0) + r + offset + 1 - k0, 0, cols));
+                alpha[r] = softmaxStep(scores + static_cast<uint64_t>(r) * KeyBlock, valid, cols, runningMax[r], runningSum[r]);
+            }
+            TensorMatmul::gemm<float>(rows, cols, dimV, scores, KeyBlock, Transpose::No, V + static_cast<uint64_t>(k0) * dimV, dimV, Transpose::No,
+                                      pv, dimV, nullptr, false);
+            for (uint32_t r = 0; r < rows; r++)
+                rescaleAndAdd(acc + static_cast<uint64_t>(r) * dimV, pv + static_cast<uint64_t>(r) * dimV, dimV, alpha[r]);
+        }
+
+        for (uint32_t r = 0; r < rows; r++){
+            // Queries that see no key at all produce zeros
+            float invSum = runningSum[r] > 0.0f ? 1.0f / runningSum[r] : 0.0f;
+            const float* accRow = acc + static_cast<uint64_t>(r) * dimV;
+            float* outRow = O + static_cast<uint64_t>(r) * dimV;
+            for (uint32_t c = 0; c < dimV; c++)
+                outRow[c] = accRow[c] * invSum;
+        }
+    }
+};
+
+namespace TensorAttention {
+    void attention(const float* Q, const float* K, const float* V, float* O, uint64_t batch,
+                   uint32_t seqQ, uint32_t seqK, uint32_t dim, uint32_t dimV, const AttentionParams& params){
+        float scale = params.scale != 0.0f ? params.scale : 1.0f / std::sqrt(static_cast<float>(std::max<uint32_t>(dim, 1)));
+        uint64_t queryBlocks = (static_cast<uint64_t>(seqQ) + QueryBlock - 1) / QueryBlock;
+        uint64_t taskWork = static_cast<uint64_t>(QueryBlock) * seqK * (dim + dimV);
+        uint64_t minTasks = std::max<uint64_t>(1, MinTaskWork / std::max<uint64_t>(taskWork, 1));
+        TensorParallel::parallelFor(0, batch * queryBlocks, minTasks, [&](uint64_t taskBegin, uint64_t taskEnd) {
+            for (uint64_t task = taskBegin; task < taskEnd; task++){
+                uint64_t b = task / queryBlocks;
+                uint32_t q0 = static_cast<uint32_t>(task % queryBlocks) * QueryBlock;
+                uint32_t rows = std::min(QueryBlock, seqQ - q0);
+                attendBlock(Q + (b * seqQ + q0) * dim, K + b * seqK * dim, V + b * seqK * dimV, O + (b * seqQ + q0) * dimV,
+                            q0, rows, seqQ, seqK, dim, dimV, scale, params.causal);
+            }
+        });
+    }
+};
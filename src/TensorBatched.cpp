@@ -0,0 +1,142 @@
+#include "Tensor/TensorBatched.h"
+#include "Tensor/TensorGemm.h"
+#include <algorithm>
+#include <arm_neon.h>
+#include <cstdint>
+
+namespace {
+    using TensorMatmul::BatchedGroup;
+    using TensorMatmul::Transpose;
+
+    static_assert(BatchedGroup == 4, "The interleaved kernel keeps one problem per lane of a float32x4_t");
+
+    /**
+     * @brief Interleaves op(X) of BatchedGroup problems, element (r, c) of problem l is stored at packed[(r * cols + c) * 4 + l]
+     */
+    void packInterleaved(const float* const* X, uint64_t ld, Transpose trans, uint32_t rows, uint32_t cols, float* packed){
+        if (trans == Transpose::No){
+            for (uint32_t r = 0; r < rows; r++){
+                const float* src0 = X[0] + r * ld;
+                const float* src1 = X[1] + r * ld;
+                const float* src2 = X[2] + r * ld;
+                const float* src3 = X[3] + r * ld;
+                float* dst = packed + static_cast<uint64_t>(r) * cols * BatchedGroup;
+                uint32_t c = 0;
+                for (; c + 4 <= cols; c += 4){
+                    // The interleaving store puts the same element of the four problems next to each other
+                    float32x4x4_t rowsOfProblems;
+                    rowsOfProblems.val[0] = vld1q_f32(src0 + c);
+                    rowsOfProblems.val[1] = vld1q_f32(src1 + c);
+                    rowsOfProblems.val[2] = vld1q_f32(src2 + c);
+                    rowsOfProblems.val[3] = vld1q_f32(src3 + c);
+                    vst4q_f32(dst + c * BatchedGroup, rowsOfProblems);
+                }
+                for (; c < cols; c++){
+                    dst[c * BatchedGroup] = src0[c];
+                    dst[c * BatchedGroup + 1] = src1[c];
+                    dst[c * BatchedGroup + 2] = src2[c];
+                    dst[c * BatchedGroup + 3] = src3[c];
+                }
+            }
+        } else {
+            // op(X)(r, c) is X[c * ld + r], walk the stored rows so every read is contiguous
+            for (uint32_t c = 0; c < cols; c++){
+                for (uint32_t l = 0; l < BatchedGroup; l++){
+                    const float* src = X[l] + c * ld;
+                    float* dst = packed + static_cast<uint64_t>(c) * BatchedGroup + l;
+                    for (uint32_t r = 0; r < rows; r++)
+                        dst[static_cast<uint64_t>(r) * cols * BatchedGroup] = src[r];
+                }
+            }
+        }
+    }
+
+    /**
+     * @brief Computes a Rows x Cols block of the interleaved output, every accumulator covers all problems of the group
+     *
+     * @param a Interleaved op(A) at the first row of the block
+     * @param b Interleaved op(B) at the first column of the block
+     * @param c Interleaved C at the first element of the block
+     */
+    template <uint32_t Rows, uint32_t Cols>
+    void interleavedTile(const float* a, const float* b, float* c, uint32_t N, uint32_t K){
+        float32x4_t acc[Rows][Cols];
+        for (uint32_t r = 0; r < Rows; r++){
+            for (uint32_t q = 0; q < Cols; q++)
+                acc[r][q] = vdupq_n_f32(0.0f);
+        }
+        for (uint32_t p = 0; p < N; p++){
+            float32x4_t bv[Cols];
+            for (uint32_t q = 0; q < Cols; q++)
+                bv[q] = vld1q_f32(b + (static_cast<uint64_t>(p) * K + q) * BatchedGroup);
+            for (uint32_t r = 0; r < Rows; r++){
+                float32x4_t av = vld1q_f32(a + (static_cast<uint64_t>(r) * N + p) * BatchedGroup);
+                for (uint32_t q = 0; q < Cols; q++)
+                    acc[r][q] = vmlaq_f32(acc[r][q], av, bv[q]);
+            }
+        }
+        for (uint32_t r = 0; r < Rows; r++){
+            for (uint32_t q = 0; q < Cols; q++)
+                vst1q_f32(c + (static_cast<uint64_t>(r) * K + q) * BatchedGroup, acc[r][q]);
+        }
+    }
+
+    template <uint32_t Cols>
+    void interleavedRows(uint32_t rows, const float* a, const float* b, float* c, uint32_t N, uint32_t K){
+        switch (rows){
+            case 4: interleavedTile<4, Cols>(a, b, c, N, K); break;
+            case 3: interleavedTile<3, Cols>(a, b, c, N, K); break;
+            case 2: interleavedTile<2, Cols>(a, b, c, N, K); break;
+            default: interleavedTile<1, Cols>(a, b, c, N, K); break;
+        }
+    }
+
+    // Copies the interleaved C of the valid problems out to their row-major outputs
+    void unpackInterleaved(const float* packed, uint32_t rows, uint32_t cols, float* const* C, uint64_t ldc, uint32_t lanes){
+        for (uint32_t r = 0; r < rows; r++){
+            const float* src = packed + static_cast<uint64_t>(r) * cols * BatchedGroup;
+            uint32_t c = 0;
+            for (; c + 4 <= cols; c += 4){
+                float32x4x4_t rowsOfProblems = vld4q_f32(src + c * BatchedGroup);
+                for (uint32_t l = 0; l < lanes; l++)
+                    vst1q_f32(C[l] + r * ldc + c, rowsOfProblems.val[l]);
+            }
+            for (; c < cols; c++){
+                for (uint32_t l = 0; l < lanes; l++)
+                    C[l][r * ldc + c] = src[c * BatchedGroup + l];
+            }
+        }
+    }
+};
+
+namespace TensorMatmul {
+    namespace Gemm {
+        void batchedGroup(uint32_t M, uint32_t N, uint32_t K,
+                          const float* const* A, uint64_t lda, Transpose transA,
+                          const float* const* B, uint64_t ldb, Transpose transB,
+                          float* const* C, uint64_t ldc, uint32_t lanes){
+            uint64_t sizeA = static_cast<uint64_t>(M) * N * BatchedGroup;
+            uint64_t sizeB = static_cast<uint64_t>(N) * K * BatchedGroup;
+            uint64_t sizeC = static_cast<uint64_t>(M) * K * BatchedGroup;
+            float* packedA = workspace<float>(2, sizeA + sizeB + sizeC);
+            float* packedB = packedA + sizeA;
+            float* packedC = packedB + sizeB;
+            packInterleaved(A, lda, transA, M, N, packedA);
+            packInterleaved(B, ldb, transB, N, K, packedB);
+
+            // Four rows by two columns of accumulators, plus their operands, fit the 16 registers of A32 NEON
+            for (uint32_t i = 0; i < M; i += 4){
+                uint32_t rows = std::min<uint32_t>(4, M - i);
+                const float* a = packedA + static_cast<uint64_t>(i) * N * BatchedGroup;
+                uint32_t j = 0;
+                for (; j + 2 <= K; j += 2)
+                    interleavedRows<2>(rows, a, packedB + static_cast<uint64_t>(j) * BatchedGroup,
+                                       packedC + (static_cast<uint64_t>(i) * K + j) * BatchedGroup, N, K);
+                if (j < K)
+                    interleavedRows<1>(rows, a, packedB + static_cast<uint64_t>(j) * BatchedGroup,
+                                       packedC + (static_cast<uint64_t>(i) * K + j) * BatchedGroup, N, K);
+            }
+            unpackInterleaved(packedC, M, K, C, ldc, lanes);
+        }
+    };
+};
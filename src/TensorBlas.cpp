@@ -0,0 +1,243 @@
+#include "Tensor/TensorBlas.h"
+#include "Tensor/TensorGemm.h"
+#include "Tensor/TensorMath.h"
+#include "Tensor/TensorParallel.h"
+#include <algorithm>
+#include <arm_neon.h>
+#include <cassert>
+#include <cstdint>
+#include <vector>
+
+namespace {
+    using TensorMatmul::Transpose;
+
+    Transpose toTranspose(CBLAS_TRANSPOSE trans){
+        assert((trans == CblasNoTrans || trans == CblasTrans || trans == CblasConjTrans) && "Unknown CBLAS transpose");
+        return trans == CblasNoTrans ? Transpose::No : Transpose::Yes;
+    }
+
+    // Element i of a BLAS vector, a negative increment starts from the end
+    template <typename T>
+    T* element(T* base, int n, int inc, int i){
+        return inc > 0 ? base + static_cast<int64_t>(i) * inc : base + static_cast<int64_t>(n - 1 - i) * -inc;
+    }
+
+    float dot(const float* x, const float* y, uint64_t n){
+        float32x4_t acc0 = vdupq_n_f32(0.0f);
+        float32x4_t acc1 = vdupq_n_f32(0.0f);
+        uint64_t i = 0;
+        for (; i + 8 <= n; i += 8){
+            acc0 = vmlaq_f32(acc0, vld1q_f32(x + i), vld1q_f32(y + i));
+            acc1 = vmlaq_f32(acc1, vld1q_f32(x + i + 4), vld1q_f32(y + i + 4));
+        }
+        float sum = TensorMath::horizontalSum(vaddq_f32(acc0, acc1));
+        for (; i < n; i++)
+            sum += x[i] * y[i];
+        return sum;
+    }
+
+    void axpy(float alpha, const float* x, float* y, uint64_t n){
+        float32x4_t a = vdupq_n_f32(alpha);
+        uint64_t i = 0;
+        for (; i + 4 <= n; i += 4)
+            vst1q_f32(y + i, vmlaq_f32(vld1q_f32(y + i), a, vld1q_f32(x + i)));
+        for (; i < n; i++)
+            y[i] += alpha * x[i];
+    }
+
+    // x = alpha * x, alpha = 0 keeps NaN and turns Inf into NaN like the multiplication of reference BLAS sscal
+    void multiply(float alpha, float* x, uint64_t n){
+        if (alpha == 1.0f)
+            return;
+        float32x4_t a = vdupq_n_f32(alpha);
+        uint64_t i = 0;
+        for (; i + 4 <= n; i += 4)
+            vst1q_f32(x + i, vmulq_f32(vld1q_f32(x + i), a));
+        for (; i < n; i++)
+            x[i] *= alpha;
+    }
+
+    // y = beta * y for the beta of gemm and gemv, beta = 0 clears y even when it holds NaN as BLAS requires
+    void scale(float beta, float* y, uint64_t n){
+        if (beta == 0.0f){
+            std::fill(y, y + n, 0.0f);
+            return;
+        }
+        multiply(beta, y, n);
+    }
+
+    // C = beta * C over a rows x cols block, beta = 0 clears C even when it holds NaN as BLAS requires
+    void scaleRows(uint64_t rows, uint64_t cols, float beta, float* C, uint64_t ldc){
+        uint64_t minRows = std::max<uint64_t>(1, TensorParallel::ElementwiseChunk / std::max<uint64_t>(cols, 1));
+        auto scaleChunk = [&](uint64_t begin, uint64_t end) {
+            for (uint64_t i = begin; i < end; i++)
+                scale(beta, C + i * ldc, cols);
+        };
+        if (rows * cols < TensorParallel::elementwiseThreshold())
+            scaleChunk(0, rows);
+        else
+            TensorParallel::parallelFor(0, rows, minRows, scaleChunk);
+    }
+
+    // C = alpha * op(A) * op(B) + beta * C on row-major storage, C is M x N and the depth is K as in CBLAS
+    void gemmRowMajor(Transpose transA, Transpose transB, int M, int N, int K, float alpha, const float* A, int lda,
+                      const float* B, int ldb, float beta, float* C, int ldc){
+        assert(M >= 0 && N >= 0 && K >= 0 && "Dimensions must not be negative");
+        assert(lda >= std::max(1, transA == Transpose::No ? K : M) && "lda is smaller than a stored row of A");
+        assert(ldb >= std::max(1, transB == Transpose::No ? N : K) && "ldb is smaller than a stored row of B");
+        assert(ldc >= std::max(1, N) && "ldc is smaller than a row of C");
+        if (M == 0 || N == 0)
+            return;
+        if (alpha == 0.0f || K == 0){
+            scaleRows(M, N, beta, C, ldc);
+            return;
+        }
+        if (beta == 0.0f){
+            TensorMatmul::GemmEpilogue<float> epilogue;
+            epilogue.scale = alpha;
+            TensorMatmul::gemm<float>(M, K, N, A, lda, transA, B, ldb, transB, C, ldc, alpha != 1.0f ? &epilogue : nullptr);
+            return;
+        }
+        // The product is added to beta * C, so alpha cannot be applied on the store and scales the packed A blocks instead
+        scaleRows(M, N, beta, C, ldc);
+        constexpr uint32_t MR = TensorMatmul::Gemm::Blocking<float>::MR;
+        TensorMatmul::gemmWithPacking<float>(M, K, N,
+            [=](uint64_t i0, uint64_t p0, uint32_t mc, uint32_t kc, float* packed) {
+                TensorMatmul::Gemm::packA(A, lda, transA, i0, p0, mc, kc, packed);
+                if (alpha != 1.0f)
+                    multiply(alpha, packed, static_cast<uint64_t>((mc + MR - 1) / MR * MR) * kc);
+            },
+            [=](uint64_t p0, uint64_t j0, uint32_t kc, uint32_t nc, float* packed) {
+                TensorMatmul::Gemm::packB(B, ldb, transB, p0, j0, kc, nc, packed);
+            },
+            C, ldc, nullptr, true, true);
+    }
+
+    /**
+     * @brief y = alpha * op(A) * x + beta * y on row-major storage with contiguous x and y, A is rows x cols
+     * Without transpose every y element is the dot product of a row. With transpose y is built from scaled rows of A,
+     * each thread owning a range of columns so that its part of y stays in cache.
+     */
+    void gemvRowMajor(Transpose trans, uint32_t rows, uint32_t cols, float alpha, const float* A, uint64_t lda,
+                      const float* x, float beta, float* y){
+        if (trans == Transpose::No){
+            uint64_t minRows = std::max<uint64_t>(1, TensorMatmul::Gemm::ParallelWorkThreshold / std::max<uint32_t>(cols, 1));
+            TensorParallel::parallelFor(0, rows, minRows, [&](uint64_t begin, uint64_t end) {
+                for (uint64_t i = begin; i < end; i++){
+                    float value = alpha * dot(A + i * lda, x, cols);
+                    y[i] = beta == 0.0f ? value : value + beta * y[i];
+                }
+            });
+            return;
+        }
+        uint64_t minCols = std::max<uint64_t>(16, TensorMatmul::Gemm::ParallelWorkThreshold / std::max<uint32_t>(rows, 1));
+        TensorParallel::parallelFor(0, cols, minCols, [&](uint64_t begin, uint64_t end) {
+            scale(beta, y + begin, end - begin);
+            for (uint32_t i = 0; i < rows; i++)
+                axpy(alpha * x[i], A + i * lda + begin, y + begin, end - begin);
+        });
+    }
+};
+
+void cblas_sgemm(const enum CBLAS_ORDER Order, const enum CBLAS_TRANSPOSE TransA, const enum CBLAS_TRANSPOSE TransB,
+                 const int M, const int N, const int K, const float alpha, const float* A, const int lda,
+                 const float* B, const int ldb, const float beta, float* C, const int ldc){
+    assert((Order == CblasRowMajor || Order == CblasColMajor) && "Unknown CBLAS order");
+    // A column-major C is the row-major C^T = op(B)^T * op(A)^T, and a column-major operand read row by row is its transpose
+    if (Order == CblasColMajor)
+        gemmRowMajor(toTranspose(TransB), toTranspose(TransA), N, M, K, alpha, B, ldb, A, lda, beta, C, ldc);
+    else
+        gemmRowMajor(toTranspose(TransA), toTranspose(TransB), M, N, K, alpha, A, lda, B, ldb, beta, C, ldc);
+}
+
+void cblas_sgemv(const enum CBLAS_ORDER Order, const enum CBLAS_TRANSPOSE TransA, const int M, const int N,
+                 const float alpha, const float* A, const int lda, const float* X, const int incX,
+                 const float beta, float* Y, const int incY){
+    assert((Order == CblasRowMajor || Order == CblasColMajor) && "Unknown CBLAS order");
+    assert(M >= 0 && N >= 0 && "Dimensions must not be negative");
+    assert(incX != 0 && incY != 0 && "Vector increments must not be zero");
+    Transpose trans = toTranspose(TransA);
+    int lengthX = trans == Transpose::No ? N : M;
+    int lengthY = trans == Transpose::No ? M : N;
+    if (lengthY == 0)
+        return;
+    // Column-major A is the row-major N x M matrix A^T, so it runs with the opposite transpose
+    uint32_t rows = Order == CblasRowMajor ? M : N;
+    uint32_t cols = Order == CblasRowMajor ? N : M;
+    assert(lda >= std::max<int>(1, cols) && "lda is smaller than a stored row of A");
+    if (Order == CblasColMajor)
+        trans = trans == Transpose::No ? Transpose::Yes : Transpose::No;
+
+    std::vector<float> gatheredX;
+    std::vector<float> gatheredY;
+    const float* x = X;
+    float* y = Y;
+    if (incX != 1){
+        gatheredX.resize(lengthX);
+        for (int i = 0; i < lengthX; i++)
+            gatheredX[i] = *element(X, lengthX, incX, i);
+        x = gatheredX.data();
+    }
+    if (incY != 1){
+        gatheredY.resize(lengthY);
+        for (int i = 0; i < lengthY; i++)
+            gatheredY[i] = *element(Y, lengthY, incY, i);
+        y = gatheredY.data();
+    }
+    if (alpha == 0.0f || lengthX == 0)
+        scale(beta, y, lengthY);
+    else
+        gemvRowMajor(trans, rows, cols, alpha, A, lda, x, beta, y);
+    if (incY != 1){
+        for (int i = 0; i < lengthY; i++)
+            *element(Y, lengthY, incY, i) = y[i];
+    }
+}
+
+float cblas_sdot(const int N, const float* X, const int incX, const float* Y, const int incY){
+    if (N <= 0)
+        return 0.0f;
+    if (incX != 1 || incY != 1){
+        float sum = 0.0f;
+        for (int i = 0; i < N; i++)
+            sum += *element(X, N, incX, i) * *element(Y, N, incY, i);
+        return sum;
+    }
+    // One partial sum per chunk, added in order so that the result does not depend on the thread count
+    std::vector<float> partial((N + TensorParallel::ElementwiseChunk - 1) / TensorParallel::ElementwiseChunk);
+    TensorParallel::parallelElementwise(N, [&](uint64_t begin, uint64_t end) {
+        for (uint64_t chunk = begin; chunk < end; chunk += TensorParallel::ElementwiseChunk)
+            partial[chunk / TensorParallel::ElementwiseChunk] = dot(X + chunk, Y + chunk, std::min(end, chunk + TensorParallel::ElementwiseChunk) - chunk);
+    });
+    float sum = 0.0f;
+    for (float value : partial)
+        sum += value;
+    return sum;
+}
+
+void cblas_saxpy(const int N, const float alpha, const float* X, const int incX, float* Y, const int incY){
+    if (N <= 0 || alpha == 0.0f)
+        return;
+    if (incX != 1 || incY != 1){
+        for (int i = 0; i < N; i++)
+            *element(Y, N, incY, i) += alpha * *element(X, N, incX, i);
+        return;
+    }
+    TensorParallel::parallelElementwise(N, [&](uint64_t begin, uint64_t end) {
+        axpy(alpha, X + begin, Y + begin, end - begin);
+    });
+}
+
+void cblas_sscal(const int N, const float alpha, float* X, const int incX){
+    // Reference BLAS does nothing for a non-positive increment
+    if (N <= 0 || incX <= 0)
+        return;
+    if (incX != 1){
+        for (int i = 0; i < N; i++)
+            X[static_cast<int64_t>(i) * incX] *= alpha;
+        return;
+    }
+    TensorParallel::parallelElementwise(N, [&](uint64_t begin, uint64_t end) {
+        multiply(alpha, X + begin, end - begin);
+    });
+}
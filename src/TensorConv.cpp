@@ -0,0 +1,263 @@
+#include "Tensor/TensorConv.h"
+#include <arm_neon.h>
+#include <algorithm>
+#include <cstdint>
+
+using TensorMatmul::Activation;
+using TensorMatmul::GemmEpilogue;
+
+namespace {
+    // 3x3 depthwise convolution of NCHW planes: four neighbouring output columns per NEON register
+    void depthwise3x3NCHW(const float* input, const float* weights, const float* bias, float* output,
+                          const TensorConv::Conv2DGeometry& g, const TensorConv::Conv2DParams& params, Activation activation){
+        uint32_t stride = params.strideH;
+        int64_t padH = params.padH;
+        int64_t padW = params.padW;
+        // Last element read by a vector step relative to its first input column
+        int64_t lastRead = stride == 1 ? 5 : 9;
+        GemmEpilogue<float> epilogue;
+        epilogue.rowBias = bias;
+        epilogue.activation = activation;
+        uint64_t planes = static_cast<uint64_t>(g.batch) * g.channels;
+        uint64_t minPlanes = std::max<uint64_t>(1, (1 << 16) / (static_cast<uint64_t>(g.outHeight) * g.outWidth));
+
+        TensorParallel::parallelFor(0, planes, minPlanes, [&](uint64_t planeBegin, uint64_t planeEnd) {
+            for (uint64_t plane = planeBegin; plane < planeEnd; plane++){
+                uint64_t n = plane / g.channels;
+                uint32_t c = static_cast<uint32_t>(plane % g.channels);
+                const float* in = input + n * g.inStrides[0] + c * g.inStrides[1];
+                float* out = output + n * g.outStrides[0] + c * g.outStrides[1];
+                const float* w = weights + c * 9;
+                float32x4_t wv[9];
+                for (int t = 0; t < 9; t++)
+                    wv[t] = vdupq_n_f32(w[t]);
+
+                for (uint32_t oy = 0; oy < g.outHeight; oy++){
+                    int64_t iyBase = static_cast<int64_t>(oy) * stride - padH;
+                    float* outRow = out + oy * g.outStrides[2];
+                    uint32_t ox = 0;
+                    while (ox < g.outWidth){
+                        int64_t ixBase = static_cast<int64_t>(ox) * stride - padW;
+                        if (ox + 4 <= g.outWidth && ixBase >= 0 && ixBase + lastRead < g.width){
+                            float32x4_t acc = vdupq_n_f32(0.0f);
+                            for (int ky = 0; ky < 3; ky++){
+                                int64_t iy = iyBase + ky;
+                                if (iy < 0 || iy >= g.height)
+                                    continue;
+                                const float* row = in + iy * g.inStrides[2] + ixBase;
+                                if (stride == 1){
+                                    acc = vmlaq_f32(acc, vld1q_f32(row), wv[ky * 3]);
+                                    acc = vmlaq_f32(acc, vld1q_f32(row + 1), wv[ky * 3 + 1]);
+                                    acc = vmlaq_f32(acc, vld1q_f32(row + 2), wv[ky * 3 + 2]);
+                                } else {
+                                    // Deinterleave even and odd columns so stride 2 still fills whole registers
+                                    float32x4x2_t first = vld2q_f32(row);
+                                    float32x4x2_t second = vld2q_f32(row + 2);
+                                    acc = vmlaq_f32(acc, first.val[0], wv[ky * 3]);
+                                    acc = vmlaq_f32(acc, first.val[1], wv[ky * 3 + 1]);
+                                    acc = vmlaq_f32(acc, second.val[0], wv[ky * 3 + 2]);
+                                }
+                            }
+                            vst1q_f32(outRow + ox, TensorMatmul::Gemm::applyEpilogue<float>(acc, epilogue, c, 0));
+                            ox += 4;
+                            continue;
+                        }
+                        // Border column: skip the taps that fall into the padding
+                        float sum = 0.0f;
+                        for (int ky = 0; ky < 3; ky++){
+                            int64_t iy = iyBase + ky;
+                            if (iy < 0 || iy >= g.height)
+                                continue;
+                            for (int kx = 0; kx < 3; kx++){
+                                int64_t ix = ixBase + kx;
+                                if (ix >= 0 && ix < g.width)
+                                    sum += in[iy * g.inStrides[2] + ix] * w[ky * 3 + kx];
+                            }
+                        }
+                        outRow[ox] = TensorMatmul::Gemm::applyEpilogue(sum, epilogue, c, 0);
+                        ox++;
+                    }
+                }
+            }
+        });
+    }
+
+    // 3x3 depthwise convolution of NHWC rows: four neighbouring channels per NEON register
+    void depthwise3x3NHWC(const float* input, const float* weights, const float* bias, float* output,
+                          const TensorConv::Conv2DGeometry& g, const TensorConv::Conv2DParams& params, Activation activation){
+        uint32_t channels = g.channels;
+        // Tap-major copy of the weights so that four channels of one tap are contiguous
+        float* tapWeights = TensorMatmul::Gemm::workspace<float>(2, 9 * static_cast<uint64_t>(channels));
+        for (uint32_t c = 0; c < channels; c++){
+            for (int t = 0; t < 9; t++)
+                tapWeights[t * channels + c] = weights[c * 9 + t];
+        }
+        GemmEpilogue<float> epilogue;
+        epilogue.bias = bias;
+        epilogue.activation = activation;
+        uint64_t rows = static_cast<uint64_t>(g.batch) * g.outHeight;
+        uint64_t minRows = std::max<uint64_t>(1, (1 << 16) / (static_cast<uint64_t>(g.outWidth) * channels));
+
+        TensorParallel::parallelFor(0, rows, minRows, [&](uint64_t rowBegin, uint64_t rowEnd) {
+            for (uint64_t r = rowBegin; r < rowEnd; r++){
+                uint64_t n = r / g.outHeight;
+                uint32_t oy = static_cast<uint32_t>(r % g.outHeight);
+                const float* image = input + n * g.inStrides[0];
+                float* outRow = output + n * g.outStrides[0] + oy * g.outStrides[2];
+                int64_t iyBase = static_cast<int64_t>(oy) * params.strideH - params.padH;
+                for (uint32_t ox = 0; ox < g.outWidth; ox++){
+                    int64_t ixBase = static_cast<int64_t>(ox) * params.strideW - params.padW;
+                    const float* taps[9];
+                    int tapIndex[9];
+                    int valid = 0;
+                    for (int t = 0; t < 9; t++){
+                        int64_t iy = iyBase + t / 3;
+                        int64_t ix = ixBase + t % 3;
+                        if (iy >= 0 && iy < g.height && ix >= 0 && ix < g.width){
+                            taps[valid] = image + iy * g.inStrides[2] + ix * g.inStrides[3];
+                            tapIndex[valid] = t;
+                            valid++;
+                        }
+                    }
+                    float* out = outRow + ox * g.outStrides[3];
+                    uint32_t c = 0;
+                    for (; c + 3 < channels; c += 4){
+                        float32x4_t acc = vdupq_n_f32(0.0f);
+                        for (int v = 0; v < valid; v++)
+                            acc = vmlaq_f32(acc, vld1q_f32(taps[v] + c), vld1q_f32(tapWeights + tapIndex[v] * channels + c));
+                        vst1q_f32(out + c, TensorMatmul::Gemm::applyEpilogue<float>(acc, epilogue, 0, c));
+                    }
+                    for (; c < channels; c++){
+                        float sum = 0.0f;
+                        for (int v = 0; v < valid; v++)
+                            sum += taps[v][c] * tapWeights[tapIndex[v] * channels + c];
+                        out[c] = TensorMatmul::Gemm::applyEpilogue(sum, epilogue, 0, c);
+                    }
+                }
+            }
+        });
+    }
+
+    // Tiles transformed and multiplied together by one Winograd task
+    constexpr uint32_t WinogradTilesPerTask = 32;
+}
+
+void TensorConv::conv2dDepthwise3x3(const float* input, const float* weights, const float* bias, float* output,
+                                    const Conv2DGeometry& g, const Conv2DParams& params, Activation activation){
+    if (params.layout == Layout::NCHW)
+        depthwise3x3NCHW(input, weights, bias, output, g, params, activation);
+    else
+        depthwise3x3NHWC(input, weights, bias, output, g, params, activation);
+}
+
+void TensorConv::conv2dWinograd(const float* input, const float* weights, const float* bias, float* output,
+                                const Conv2DGeometry& g, const Conv2DParams& params, Activation activation){
+    uint32_t C = g.channels;
+    uint32_t OC = g.outChannels;
+    uint64_t planeU = static_cast<uint64_t>(OC) * C;
+    // U = G w G^T for every (oc, c), stored as 16 matrices OC x C
+    float* U = TensorMatmul::Gemm::workspace<float>(2, 16 * planeU);
+    for (uint32_t oc = 0; oc < OC; oc++){
+        for (uint32_t c = 0; c < C; c++){
+            const float* w = weights + (static_cast<uint64_t>(oc) * C + c) * 9;
+            float gw[4][3];
+            for (int j = 0; j < 3; j++){
+                gw[0][j] = w[j];
+                gw[1][j] = 0.5f * (w[j] + w[3 + j] + w[6 + j]);
+                gw[2][j] = 0.5f * (w[j] - w[3 + j] + w[6 + j]);
+                gw[3][j] = w[6 + j];
+            }
+            for (int i = 0; i < 4; i++){
+                float u[4] = {gw[i][0], 0.5f * (gw[i][0] + gw[i][1] + gw[i][2]), 0.5f * (gw[i][0] - gw[i][1] + gw[i][2]), gw[i][2]};
+                for (int j = 0; j < 4; j++)
+                    U[(i * 4 + j) * planeU + static_cast<uint64_t>(oc) * C + c] = u[j];
+            }
+        }
+    }
+
+    uint32_t tilesY = (g.outHeight + 1) / 2;
+    uint32_t tilesX = (g.outWidth + 1) / 2;
+    uint64_t tilesPerImage = static_cast<uint64_t>(tilesY) * tilesX;
+    uint64_t tiles = g.batch * tilesPerImage;
+    uint64_t tasks = (tiles + WinogradTilesPerTask - 1) / WinogradTilesPerTask;
+    uint64_t taskWork = 16ull * WinogradTilesPerTask * C * OC;
+    uint64_t minTasks = std::max<uint64_t>(1, TensorMatmul::Gemm::ParallelWorkThreshold / taskWork);
+    GemmEpilogue<float> epilogue;
+    epilogue.rowBias = bias;
+    epilogue.activation = activation;
+
+    TensorParallel::parallelFor(0, tasks, minTasks, [&](uint64_t taskBegin, uint64_t taskEnd) {
+        float* V = TensorMatmul::Gemm::workspace<float>(3, 16ull * C * WinogradTilesPerTask);
+        float* M = TensorMatmul::Gemm::workspace<float>(4, 16ull * OC * WinogradTilesPerTask);
+        for (uint64_t task = taskBegin; task < taskEnd; task++){
+            uint64_t tile0 = task * WinogradTilesPerTask;
+            uint32_t count = static_cast<uint32_t>(std::min<uint64_t>(WinogradTilesPerTask, tiles - tile0));
+            uint64_t planeV = static_cast<uint64_t>(C) * count;
+            uint64_t planeM = static_cast<uint64_t>(OC) * count;
+
+            // V = B^T d B for every 4x4 input tile d and channel
+            for (uint32_t t = 0; t < count; t++){
+                uint64_t tile = tile0 + t;
+                uint64_t n = tile / tilesPerImage;
+                int64_t y0 = static_cast<int64_t>(tile % tilesPerImage / tilesX) * 2 - params.padH;
+                int64_t x0 = static_cast<int64_t>(tile % tilesX) * 2 - params.padW;
+                for (uint32_t c = 0; c < C; c++){
+                    const float* plane = input + n * g.inStrides[0] + c * g.inStrides[1];
+                    float d[4][4];
+                    for (int i = 0; i < 4; i++){
+                        int64_t y = y0 + i;
+                        for (int j = 0; j < 4; j++){
+                            int64_t x = x0 + j;
+                            bool inside = y >= 0 && y < g.height && x >= 0 && x < g.width;
+                            d[i][j] = inside ? plane[y * g.inStrides[2] + x * g.inStrides[3]] : 0.0f;
+                        }
+                    }
+                    float bd[4][4];
+                    for (int j = 0; j < 4; j++){
+                        bd[0][j] = d[0][j] - d[2][j];
+                        bd[1][j] = d[1][j] + d[2][j];
+                        bd[2][j] = d[2][j] - d[1][j];
+                        bd[3][j] = d[1][j] - d[3][j];
+                    }
+                    for (int i = 0; i < 4; i++){
+                        float v[4] = {bd[i][0] - bd[i][2], bd[i][1] + bd[i][2], bd[i][2] - bd[i][1], bd[i][1] - bd[i][3]};
+                        for (int j = 0; j < 4; j++)
+                            V[(i * 4 + j) * planeV + static_cast<uint64_t>(c) * count + t] = v[j];
+                    }
+                }
+            }
+
+            // One GEMM per transformed position: M[xi] = U[xi] * V[xi]
+            for (int xi = 0; xi < 16; xi++){
+                TensorMatmul::gemm(OC, C, count, U + xi * planeU, C, TensorMatmul::Transpose::No,
+                                   V + xi * planeV, count, TensorMatmul::Transpose::No, M + xi * planeM, count, nullptr, false);
+            }
+
+            // Y = A^T m A gives the 2x2 output tile
+            for (uint32_t t = 0; t < count; t++){
+                uint64_t tile = tile0 + t;
+                uint64_t n = tile / tilesPerImage;
+                uint32_t oy0 = static_cast<uint32_t>(tile % tilesPerImage / tilesX) * 2;
+                uint32_t ox0 = static_cast<uint32_t>(tile % tilesX) * 2;
+                for (uint32_t oc = 0; oc < OC; oc++){
+                    float m[4][4];
+                    for (int xi = 0; xi < 16; xi++)
+                        m[xi / 4][xi % 4] = M[xi * planeM + static_cast<uint64_t>(oc) * count + t];
+                    float am[2][4];
+                    for (int j = 0; j < 4; j++){
+                        am[0][j] = m[0][j] + m[1][j] + m[2][j];
+                        am[1][j] = m[1][j] - m[2][j] - m[3][j];
+                    }
+                    float* out = output + n * g.outStrides[0] + oc * g.outStrides[1];
+                    for (uint32_t i = 0; i < 2 && oy0 + i < g.outHeight; i++){
+                        float y[2] = {am[i][0] + am[i][1] + am[i][2], am[i][1] - am[i][2] - am[i][3]};
+                        for (uint32_t j = 0; j < 2 && ox0 + j < g.outWidth; j++){
+                            out[(oy0 + i) * g.outStrides[2] + (ox0 + j) * g.outStrides[3]] =
+                                TensorMatmul::Gemm::applyEpilogue(y[j], epilogue, oc, 0);
+                        }
+                    }
+                }
+            }
+        }
+    });
+}
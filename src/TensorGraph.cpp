@@ -0,0 +1,505 @@
+#include "Tensor/TensorGraph.h"
+#include "Tensor/TensorMath.h"
+#include "Tensor/TensorNorm.h"
+#include "Tensor/TensorParallel.h"
+#include <algorithm>
+#include <arm_neon.h>
+#include <cstring>
+
+namespace {
+    using TensorGraph::CompiledGraph;
+    using TensorGraph::OpKind;
+
+    // Elementwise chains run on tiles of this many floats that stay in L1 between the ops of the chain
+    constexpr uint32_t TileSize = 256;
+    // Tiles handed to one worker at least
+    constexpr uint64_t MinTilesPerWorker = 64;
+    // Arena offsets are rounded up to this many floats, 64 bytes past the start of the arena. The arena itself only
+    // has the alignment of malloc, 16 bytes on AArch64, so buffers start NEON aligned but not cache line aligned.
+    constexpr uint64_t ArenaAlignment = 16;
+
+    uint64_t elementCount(const TensorGraph::Shape& shape){
+        uint64_t count = 1;
+        for (uint32_t dim : shape)
+            count *= dim;
+        return count;
+    }
+
+    bool isElementwise(OpKind kind){
+        switch (kind){
+            case OpKind::Add:
+            case OpKind::BiasAdd:
+            case OpKind::Sub:
+            case OpKind::Mul:
+            case OpKind::Scale:
+            case OpKind::Activation:
+            case OpKind::Exp:
+            case OpKind::Tanh:
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    // tile[i] = fn(tile[i], operand[i]) for count values, operand may be nullptr for unary ops
+    template <typename Fn>
+    void mapTile(float* tile, const float* operand, uint32_t count, Fn fn){
+        uint32_t i = 0;
+        for (; i + 4 <= count; i += 4){
+            float32x4_t y = operand ? vld1q_f32(operand + i) : vdupq_n_f32(0.0f);
+            vst1q_f32(tile + i, fn(vld1q_f32(tile + i), y));
+        }
+        if (i < count){
+            float x[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+            float y[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+            for (uint32_t l = 0; l < count - i; l++){
+                x[l] = tile[i + l];
+                y[l] = operand ? operand[i + l] : 0.0f;
+            }
+            vst1q_f32(x, fn(vld1q_f32(x), vld1q_f32(y)));
+            for (uint32_t l = 0; l < count - i; l++)
+                tile[i + l] = x[l];
+        }
+    }
+
+    // Applies one op of a chain to the tile holding elements [begin, begin + count) of the output
+    void applyOp(const CompiledGraph::ElementOp& op, const float* operand, float* tile, uint64_t begin, uint32_t count, uint32_t cols){
+        switch (op.kind){
+            case OpKind::Add:
+                mapTile(tile, operand + begin, count, [](float32x4_t x, float32x4_t y) { return vaddq_f32(x, y); });
+                break;
+            case OpKind::Sub:
+                if (op.reversed)
+                    mapTile(tile, operand + begin, count, [](float32x4_t x, float32x4_t y) { return vsubq_f32(y, x); });
+                else
+                    mapTile(tile, operand + begin, count, [](float32x4_t x, float32x4_t y) { return vsubq_f32(x, y); });
+                break;
+            case OpKind::Mul:
+                mapTile(tile, operand + begin, count, [](float32x4_t x, float32x4_t y) { return vmulq_f32(x, y); });
+                break;
+            case OpKind::BiasAdd: {
+                // Tiles do not line up with rows, so the column wraps around inside the tile
+                uint32_t col = static_cast<uint32_t>(begin % cols);
+                for (uint32_t i = 0; i < count; i++){
+                    tile[i] += operand[col];
+                    if (++col == cols)
+                        col = 0;
+                }
+                break;
+            }
+            case OpKind::Scale: {
+                float32x4_t factor = vdupq_n_f32(op.scalar);
+                mapTile(tile, nullptr, count, [factor](float32x4_t x, float32x4_t) { return vmulq_f32(x, factor); });
+                break;
+            }
+            case OpKind::Activation: {
+                auto activation = op.activation;
+                mapTile(tile, nullptr, count, [activation](float32x4_t x, float32x4_t) {
+                    return TensorMatmul::Gemm::activateVector<float>(x, activation);
+                });
+                break;
+            }
+            case OpKind::Exp:
+                mapTile(tile, nullptr, count, [](float32x4_t x, float32x4_t) { return TensorMath::vexp(x); });
+                break;
+            case OpKind::Tanh:
+                mapTile(tile, nullptr, count, [](float32x4_t x, float32x4_t) { return TensorMath::vtanh(x); });
+                break;
+            default:
+                assert(false && "Op cannot be part of an elementwise chain");
+        }
+    }
+};
+
+namespace TensorGraph {
+    Value Graph::addNode(Node node){
+        _nodes.push_back(std::move(node));
+        return Value{static_cast<uint32_t>(_nodes.size() - 1)};
+    }
+
+    Value Graph::input(const Shape& shape){
+        Node node;
+        node.kind = OpKind::Input;
+        node.shape = shape;
+        Value value = addNode(std::move(node));
+        _inputs.push_back(value.id);
+        return value;
+    }
+
+    Value Graph::constant(const Shape& shape, const float* data){
+        Node node;
+        node.kind = OpKind::Constant;
+        node.shape = shape;
+        node.constantOffset = _constants.size();
+        _constants.insert(_constants.end(), data, data + elementCount(shape));
+        return addNode(std::move(node));
+    }
+
+    const Shape& Graph::shape(Value value) const{
+        assert(value.id < _nodes.size() && "Value does not belong to this graph");
+        return _nodes[value.id].shape;
+    }
+
+    Value Graph::matmul(Value a, Value b){
+        const Shape& shapeA = shape(a);
+        const Shape& shapeB = shape(b);
+        assert(shapeA.size() == 2 && shapeB.size() == 2 && "Graph matmul needs two matrices");
+        assert(shapeA[1] == shapeB[0] && "need to have shapes M*N and N*K");
+        Node node;
+        node.kind = OpKind::MatMul;
+        node.shape = {shapeA[0], shapeB[1]};
+        node.a = a.id;
+        node.b = b.id;
+        return addNode(std::move(node));
+    }
+
+    Value Graph::binary(OpKind kind, Value a, Value b){
+        assert(shape(a) == shape(b) && "Operands must have the same shape");
+        Node node;
+        node.kind = kind;
+        node.shape = shape(a);
+        node.a = a.id;
+        node.b = b.id;
+        return addNode(std::move(node));
+    }
+
+    Value Graph::unary(OpKind kind, Value a){
+        Node node;
+        node.kind = kind;
+        node.shape = shape(a);
+        node.a = a.id;
+        return addNode(std::move(node));
+    }
+
+    Value Graph::add(Value a, Value b){
+        const Shape& shapeA = shape(a);
+        const Shape& shapeB = shape(b);
+        if (shapeA == shapeB)
+            return binary(OpKind::Add, a, b);
+        assert(shapeB.size() == 1 && !shapeA.empty() && shapeB[0] == shapeA.back()
+               && "Operands must have the same shape or the second must be a vector over the last axis");
+        Node node;
+        node.kind = OpKind::BiasAdd;
+        node.shape = shapeA;
+        node.a = a.id;
+        node.b = b.id;
+        return addNode(std::move(node));
+    }
+
+    Value Graph::sub(Value a, Value b){
+        return binary(OpKind::Sub, a, b);
+    }
+
+    Value Graph::mul(Value a, Value b){
+        return binary(OpKind::Mul, a, b);
+    }
+
+    Value Graph::scale(Value a, float factor){
+        Value value = unary(OpKind::Scale, a);
+        _nodes[value.id].scalar = factor;
+        return value;
+    }
+
+    Value Graph::activation(Value a, Activation activation){
+        Value value = unary(OpKind::Activation, a);
+        _nodes[value.id].activation = activation;
+        return value;
+    }
+
+    Value Graph::exp(Value a){
+        return unary(OpKind::Exp, a);
+    }
+
+    Value Graph::tanh(Value a){
+        return unary(OpKind::Tanh, a);
+    }
+
+    Value Graph::softmax(Value a){
+        return unary(OpKind::Softmax, a);
+    }
+
+    void Graph::output(Value value){
+        OpKind kind = _nodes[value.id].kind;
+        assert(kind != OpKind::Input && kind != OpKind::Constant && "Graph outputs must be computed values");
+        assert(std::find(_outputs.begin(), _outputs.end(), value.id) == _outputs.end() && "Value is already an output");
+        _outputs.push_back(value.id);
+    }
+
+    CompiledGraph Graph::compile() const{
+        using Step = CompiledGraph::Step;
+        using StepKind = CompiledGraph::StepKind;
+        using ElementOp = CompiledGraph::ElementOp;
+        const uint32_t count = static_cast<uint32_t>(_nodes.size());
+
+        // Only ops some output depends on are compiled
+        std::vector<bool> live(count, false);
+        std::vector<bool> isOutput(count, false);
+        for (uint32_t out : _outputs)
+            live[out] = isOutput[out] = true;
+        for (uint32_t i = count; i-- > 0;){
+            if (!live[i])
+                continue;
+            if (_nodes[i].a != UINT32_MAX) live[_nodes[i].a] = true;
+            if (_nodes[i].b != UINT32_MAX) live[_nodes[i].b] = true;
+        }
+        std::vector<uint32_t> uses(count, 0);
+        std::vector<uint32_t> consumer(count, UINT32_MAX);
+        for (uint32_t i = 0; i < count; i++){
+            if (!live[i])
+                continue;
+            for (uint32_t operand : {_nodes[i].a, _nodes[i].b}){
+                if (operand != UINT32_MAX){
+                    uses[operand]++;
+                    consumer[operand] = i;
+                }
+            }
+        }
+        // A value can disappear into a kernel when exactly one op reads it and it is not an output
+        auto fusable = [&](uint32_t value) { return uses[value] == 1 && !isOutput[value]; };
+
+        // Group the ops into kernels, every group ends in the value it writes
+        std::vector<Step> steps;
+        std::vector<std::vector<ElementOp>> chains;
+        std::vector<int32_t> group(count, -1);
+        for (uint32_t i = 0; i < count; i++){
+            const Node& node = _nodes[i];
+            if (!live[i] || group[i] >= 0 || node.kind == OpKind::Input || node.kind == OpKind::Constant)
+                continue;
+            int32_t g = static_cast<int32_t>(steps.size());
+            if (node.kind == OpKind::MatMul){
+                Step step;
+                step.kind = StepKind::Gemm;
+                step.a = node.a;
+                step.b = node.b;
+                step.M = _nodes[node.a].shape[0];
+                step.N = _nodes[node.a].shape[1];
+                step.K = _nodes[node.b].shape[1];
+                // Pull scale, bias, residual and activation that follow the product into the GEMM epilogue,
+                // in the order the epilogue applies them
+                uint32_t current = i;
+                group[i] = g;
+                while (fusable(current)){
+                    uint32_t next = consumer[current];
+                    const Node& op = _nodes[next];
+                    if (group[next] >= 0)
+                        break;
+                    bool nothingAfterScale = step.bias == UINT32_MAX && step.residual == UINT32_MAX && step.activation == Activation::None;
+                    if (op.kind == OpKind::Scale && step.scale == 1.0f && nothingAfterScale)
+                        step.scale = op.scalar;
+                    else if (op.kind == OpKind::BiasAdd && op.a == current && step.bias == UINT32_MAX && step.activation == Activation::None)
+                        step.bias = op.b;
+                    else if (op.kind == OpKind::Add && step.residual == UINT32_MAX && step.activation == Activation::None)
+                        step.residual = op.a == current ? op.b : op.a;
+                    else if (op.kind == OpKind::Activation && step.activation == Activation::None)
+                        step.activation = op.activation;
+                    else
+                        break;
+                    group[next] = g;
+                    current = next;
+                }
+                step.output = current;
+                steps.push_back(step);
+                chains.emplace_back();
+            } else if (node.kind == OpKind::Softmax){
+                Step step;
+                step.kind = StepKind::Softmax;
+                step.a = node.a;
+                step.output = i;
+                group[i] = g;
+                steps.push_back(step);
+                chains.emplace_back();
+            } else {
+                assert(isElementwise(node.kind) && "Unknown op");
+                ElementOp op;
+                op.kind = node.kind;
+                op.scalar = node.scalar;
+                op.activation = node.activation;
+                // Continue the elementwise chain that produced one of the operands, the bias vector can not carry a chain
+                uint32_t chained = UINT32_MAX;
+                for (uint32_t operand : {node.a, node.b}){
+                    if (operand == UINT32_MAX || !fusable(operand) || group[operand] < 0)
+                        continue;
+                    if (steps[group[operand]].kind != StepKind::Elementwise || (node.kind == OpKind::BiasAdd && operand != node.a))
+                        continue;
+                    chained = operand;
+                    break;
+                }
+                if (chained != UINT32_MAX){
+                    g = group[chained];
+                    op.operand = chained == node.a ? node.b : node.a;
+                    op.reversed = node.kind == OpKind::Sub && chained == node.b;
+                } else {
+                    Step step;
+                    step.kind = StepKind::Elementwise;
+                    step.a = node.a;
+                    steps.push_back(step);
+                    chains.emplace_back();
+                    op.operand = node.b;
+                }
+                chains[g].push_back(op);
+                steps[g].output = i;
+                group[i] = g;
+            }
+        }
+
+        // Kernels run in the order their results appear in the graph, by then every operand they read exists
+        std::vector<uint32_t> order(steps.size());
+        for (uint32_t s = 0; s < order.size(); s++)
+            order[s] = s;
+        std::sort(order.begin(), order.end(), [&](uint32_t x, uint32_t y) { return steps[x].output < steps[y].output; });
+
+        CompiledGraph compiled;
+        compiled._constants = _constants;
+        compiled._buffers.resize(count);
+        compiled._inputs.assign(_inputs.size(), nullptr);
+        compiled._outputs.assign(_outputs.size(), nullptr);
+        for (uint32_t index = 0; index < _inputs.size(); index++){
+            compiled._buffers[_inputs[index]] = {CompiledGraph::Storage::Input, index};
+            compiled._inputSizes.push_back(elementCount(_nodes[_inputs[index]].shape));
+        }
+        for (uint32_t index = 0; index < _outputs.size(); index++){
+            compiled._buffers[_outputs[index]] = {CompiledGraph::Storage::Output, index};
+            compiled._outputSizes.push_back(elementCount(_nodes[_outputs[index]].shape));
+        }
+        for (uint32_t i = 0; i < count; i++){
+            if (_nodes[i].kind == OpKind::Constant)
+                compiled._buffers[i] = {CompiledGraph::Storage::Constant, _nodes[i].constantOffset};
+        }
+
+        // Live range of every intermediate in kernel positions, from the kernel writing it to the last one reading it
+        std::vector<uint32_t> defined(count, UINT32_MAX);
+        std::vector<uint32_t> lastUse(count, 0);
+        for (uint32_t position = 0; position < order.size(); position++){
+            Step step = steps[order[position]];
+            step.size = elementCount(_nodes[step.output].shape);
+            step.cols = _nodes[step.output].shape.empty() ? 1 : _nodes[step.output].shape.back();
+            step.opBegin = static_cast<uint32_t>(compiled._ops.size());
+            compiled._ops.insert(compiled._ops.end(), chains[order[position]].begin(), chains[order[position]].end());
+            step.opEnd = static_cast<uint32_t>(compiled._ops.size());
+            compiled._steps.push_back(step);
+
+            defined[step.output] = position;
+            std::vector<uint32_t> reads = {step.a, step.b, step.bias, step.residual};
+            for (uint32_t o = step.opBegin; o < step.opEnd; o++)
+                reads.push_back(compiled._ops[o].operand);
+            for (uint32_t value : reads){
+                if (value != UINT32_MAX)
+                    lastUse[value] = std::max(lastUse[value], position);
+            }
+        }
+
+        // Greedy first fit, largest buffers first: a buffer may reuse arena space of any buffer whose live range it does not overlap
+        std::vector<uint32_t> intermediates;
+        for (uint32_t i = 0; i < count; i++){
+            if (defined[i] != UINT32_MAX && !isOutput[i])
+                intermediates.push_back(i);
+        }
+        auto paddedSize = [&](uint32_t value) { return (elementCount(_nodes[value].shape) + ArenaAlignment - 1) / ArenaAlignment * ArenaAlignment; };
+        std::sort(intermediates.begin(), intermediates.end(), [&](uint32_t x, uint32_t y) {
+            return paddedSize(x) != paddedSize(y) ? paddedSize(x) > paddedSize(y) : x < y;
+        });
+        std::vector<uint32_t> placed;
+        uint64_t arenaSize = 0;
+        for (uint32_t value : intermediates){
+            std::vector<uint32_t> overlapping;
+            for (uint32_t other : placed){
+                if (defined[other] <= lastUse[value] && defined[value] <= lastUse[other])
+                    overlapping.push_back(other);
+            }
+            std::sort(overlapping.begin(), overlapping.end(), [&](uint32_t x, uint32_t y) {
+                return compiled._buffers[x].offset < compiled._buffers[y].offset;
+            });
+            uint64_t size = paddedSize(value);
+            uint64_t offset = 0;
+            for (uint32_t other : overlapping){
+                uint64_t otherOffset = compiled._buffers[other].offset;
+                if (offset + size <= otherOffset)
+                    break;
+                offset = std::max(offset, otherOffset + paddedSize(other));
+            }
+            compiled._buffers[value] = {CompiledGraph::Storage::Arena, offset};
+            placed.push_back(value);
+            arenaSize = std::max(arenaSize, offset + size);
+        }
+        compiled._arena.resize(arenaSize);
+        return compiled;
+    }
+
+    void CompiledGraph::bindInput(uint32_t index, const float* data){
+        assert(index < _inputs.size() && "Input index out of range");
+        _inputs[index] = data;
+    }
+
+    void CompiledGraph::bindOutput(uint32_t index, float* data){
+        assert(index < _outputs.size() && "Output index out of range");
+        _outputs[index] = data;
+    }
+
+    const float* CompiledGraph::address(uint32_t value) const{
+        const Buffer& buffer = _buffers[value];
+        switch (buffer.storage){
+            case Storage::Input:
+                return _inputs[buffer.offset];
+            case Storage::Constant:
+                return _constants.data() + buffer.offset;
+            case Storage::Arena:
+                return _arena.data() + buffer.offset;
+            case Storage::Output:
+                return _outputs[buffer.offset];
+            default:
+                assert(false && "Value was fused into a kernel and has no storage");
+                return nullptr;
+        }
+    }
+
+    float* CompiledGraph::mutableAddress(uint32_t value){
+        return const_cast<float*>(address(value));
+    }
+
+    void CompiledGraph::runElementwise(const Step& step){
+        const float* src = address(step.a);
+        float* dst = mutableAddress(step.output);
+        uint64_t tiles = (step.size + TileSize - 1) / TileSize;
+        TensorParallel::parallelFor(0, tiles, MinTilesPerWorker, [&](uint64_t tileBegin, uint64_t tileEnd) {
+            float tile[TileSize];
+            for (uint64_t t = tileBegin; t < tileEnd; t++){
+                uint64_t begin = t * TileSize;
+                uint32_t tileCount = static_cast<uint32_t>(std::min<uint64_t>(TileSize, step.size - begin));
+                std::memcpy(tile, src + begin, tileCount * sizeof(float));
+                for (uint32_t o = step.opBegin; o < step.opEnd; o++){
+                    const ElementOp& op = _ops[o];
+                    applyOp(op, op.operand == UINT32_MAX ? nullptr : address(op.operand), tile, begin, tileCount, step.cols);
+                }
+                std::memcpy(dst + begin, tile, tileCount * sizeof(float));
+            }
+        });
+    }
+
+    void CompiledGraph::run(){
+        for (const float* input : _inputs)
+            assert(input && "Every input must be bound before run");
+        for (float* output : _outputs)
+            assert(output && "Every output must be bound before run");
+        for (const Step& step : _steps){
+            switch (step.kind){
+                case StepKind::Gemm: {
+                    TensorMatmul::GemmEpilogue<float> epilogue;
+                    epilogue.scale = step.scale;
+                    epilogue.bias = step.bias == UINT32_MAX ? nullptr : address(step.bias);
+                    epilogue.residual = step.residual == UINT32_MAX ? nullptr : address(step.residual);
+                    epilogue.residualStride = step.K;
+                    epilogue.activation = step.activation;
+                    TensorMatmul::gemm<float>(step.M, step.N, step.K, address(step.a), step.N, TensorMatmul::Transpose::No,
+                                              address(step.b), step.K, TensorMatmul::Transpose::No, mutableAddress(step.output), step.K, &epilogue);
+                    break;
+                }
+                case StepKind::Softmax:
+                    TensorNorm::softmax(address(step.a), mutableAddress(step.output), step.size / std::max<uint32_t>(step.cols, 1), step.cols);
+                    break;
+                case StepKind::Elementwise:
+                    runElementwise(step);
+                    break;
+            }
+        }
+    }
+};
@@ -0,0 +1,65 @@
+#include "Tensor/TensorMath.h"
+#include "Tensor/TensorParallel.h"
+#include <arm_neon.h>
+#include <cstdint>
+
+namespace {
+    // Runs fn over src in groups of eight floats, the two independent vectors hide the latency of the polynomial chains
+    template <typename Fn>
+    void mapArray(const float* src, float* dst, uint64_t size, Fn fn){
+        uint64_t blocks = size / 8;
+        TensorParallel::parallelFor(0, blocks, TensorMath::ParallelChunk / 8, [&](uint64_t blockBegin, uint64_t blockEnd) {
+            for (uint64_t i = blockBegin * 8; i < blockEnd * 8; i += 8){
+                float32x4_t a = fn(vld1q_f32(src + i));
+                float32x4_t b = fn(vld1q_f32(src + i + 4));
+                vst1q_f32(dst + i, a);
+                vst1q_f32(dst + i + 4, b);
+            }
+        });
+        uint64_t tail = blocks * 8;
+        for (; tail + 4 <= size; tail += 4)
+            vst1q_f32(dst + tail, fn(vld1q_f32(src + tail)));
+        if (tail < size){
+            float lanes[4] = {1.0f, 1.0f, 1.0f, 1.0f};
+            for (uint64_t i = tail; i < size; i++)
+                lanes[i - tail] = src[i];
+            vst1q_f32(lanes, fn(vld1q_f32(lanes)));
+            for (uint64_t i = tail; i < size; i++)
+                dst[i] = lanes[i - tail];
+        }
+    }
+};
+
+namespace TensorMath {
+    void exp(const float* src, float* dst, uint64_t size){
+        mapArray(src, dst, size, [](float32x4_t x) { return vexp(x); });
+    }
+
+    void log(const float* src, float* dst, uint64_t size){
+        mapArray(src, dst, size, [](float32x4_t x) { return vlog(x); });
+    }
+
+    void tanh(const float* src, float* dst, uint64_t size){
+        mapArray(src, dst, size, [](float32x4_t x) { return vtanh(x); });
+    }
+
+    void sigmoid(const float* src, float* dst, uint64_t size){
+        mapArray(src, dst, size, [](float32x4_t x) { return vsigmoid(x); });
+    }
+
+    void erf(const float* src, float* dst, uint64_t size){
+        mapArray(src, dst, size, [](float32x4_t x) { return verf(x); });
+    }
+
+    void gelu(const float* src, float* dst, uint64_t size){
+        mapArray(src, dst, size, [](float32x4_t x) { return vgelu(x); });
+    }
+
+    void sqrt(const float* src, float* dst, uint64_t size){
+        mapArray(src, dst, size, [](float32x4_t x) { return vsqrt(x); });
+    }
+
+    void rsqrt(const float* src, float* dst, uint64_t size){
+        mapArray(src, dst, size, [](float32x4_t x) { return vrsqrt(x); });
+    }
+};
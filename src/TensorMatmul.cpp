@@ -1,6 +1,7 @@
 #include "Tensor/TensorOps.h"
 #include <arm_neon.h>
 #include <cstdint>
+#include <cstring>
 
 /**
 * @brief Computes the dot product of two single-precision floating point tensors with SIMD operations
@@ -9,11 +10,11 @@ float TensorMatmul::dotproduct(const Tensor<float, 1> &A, const Tensor<float, 1>
     // Check that A and B have the same size
     assert(A.Data.size() == B.Data.size() && "Vectors must have the same dimensions");
     float result = 0.0f; // Initialize the result to zero
-    int i = 0;
+    uint64_t i = 0;
     for (; i + 3 < A.Data.size(); i += 4) {
         // Load 4 elements from tensor A and tensor B
-        float32x4_t a = vld1q_f32(&A(i));
-        float32x4_t b = vld1q_f32(&B(i));
+        float32x4_t a = vld1q_f32(A.Data.data() + i);
+        float32x4_t b = vld1q_f32(B.Data.data() + i);
         float32x4_t prod = vmulq_f32(a, b);
         // Perform a horizontal addition to sum the 4 values in the prod vector
         // Add the low and high parts
@@ -24,7 +25,7 @@ float TensorMatmul::dotproduct(const Tensor<float, 1> &A, const Tensor<float, 1>
         result += vget_lane_f32(sum, 0);  
     }
     for (; i < A.Data.size(); ++i) {
-        result += A(i) * B(i);
+        result += A.Data[i] * B.Data[i];
     }
     return result;
 }
@@ -36,11 +37,11 @@ uint32_t TensorMatmul::dotproduct(const Tensor<uint32_t, 1> &A, const Tensor<uin
     // Check that A and B have the same size
     assert(A.Data.size() == B.Data.size() && "Vectors must have the same dimensions");
     uint32_t result = 0; // Initialize the result to zero
-    int i = 0;
+    uint64_t i = 0;
     for (; i + 3 < A.Data.size(); i += 4) {
         // Load 4 elements from tensor A and tensor B
-        uint32x4_t a = vld1q_u32(&A(i));
-        uint32x4_t b = vld1q_u32(&B(i));
+        uint32x4_t a = vld1q_u32(A.Data.data() + i);
+        uint32x4_t b = vld1q_u32(B.Data.data() + i);
         uint32x4_t prod = vmulq_u32(a, b);
         // Perform a horizontal addition to sum the 4 values in the prod vector
         // Add the low and high parts
@@ -51,7 +52,7 @@ uint32_t TensorMatmul::dotproduct(const Tensor<uint32_t, 1> &A, const Tensor<uin
         result += vget_lane_u32(sum, 0);  
     }
     for (; i < A.Data.size(); ++i) {
-        result += A(i) * B(i);
+        result += A.Data[i] * B.Data[i];
     }
     return result;
 }
@@ -63,11 +64,11 @@ uint32_t TensorMatmul::dotproduct(const Tensor<uint16_t, 1> &A, const Tensor<uin
     // Check that A and B have the same size
     assert(A.Data.size() == B.Data.size() && "Vectors must have the same dimensions");
     uint32_t result = 0; // Initialize the result to zero
-    int i = 0;
+    uint64_t i = 0;
     for (; i + 7 < A.Data.size(); i += 8) {
         // Load 8 elements from tensor A and tensor B
-        uint16x8_t a = vld1q_u16(&A(i));
-        uint16x8_t b = vld1q_u16(&B(i));
+        uint16x8_t a = vld1q_u16(A.Data.data() + i);
+        uint16x8_t b = vld1q_u16(B.Data.data() + i);
         uint16x8_t prod = vmulq_u16(a, b);
         // Perform a horizontal addition to sum the 8 values in the prod vector
         // Add the low and high parts
@@ -78,7 +79,7 @@ uint32_t TensorMatmul::dotproduct(const Tensor<uint16_t, 1> &A, const Tensor<uin
         result += vget_lane_u16(sum, 0);  
     }
     for (; i < A.Data.size(); ++i) {
-        result += A(i) * B(i);
+        result += A.Data[i] * B.Data[i];
     }
     return result;
 }
@@ -90,11 +91,11 @@ uint32_t TensorMatmul::dotproduct(const Tensor<uint8_t, 1> &A, const Tensor<uint
     // Check that A and B have the same size
     assert(A.Data.size() == B.Data.size() && "Vectors must have the same dimensions");
     uint32_t result = 0; // Initialize the result to zero
-    int i = 0;
+    uint64_t i = 0;
     for (; i + 15 < A.Data.size(); i += 16) {
         // Load 4 elements from tensor A and tensor B
-        uint8x16_t a = vld1q_u8(&A(i));
-        uint8x16_t b = vld1q_u8(&B(i));
+        uint8x16_t a = vld1q_u8(A.Data.data() + i);
+        uint8x16_t b = vld1q_u8(B.Data.data() + i);
         uint8x16_t prod = vmulq_u8(a, b);
         // Perform a horizontal addition to sum the 16 values in the prod vector
         // Add the low and high parts
@@ -106,7 +107,7 @@ uint32_t TensorMatmul::dotproduct(const Tensor<uint8_t, 1> &A, const Tensor<uint
         result += vget_lane_u8(sum, 0);  
     }
     for (; i < A.Data.size(); ++i) {
-        result += A(i) * B(i);
+        result += A.Data[i] * B.Data[i];
     }
     return result;
 }
@@ -119,31 +120,33 @@ Tensor<float, 2> TensorMatmul::naivematmul2d(const Tensor<float, 2>& A, const Te
     uint32_t N_dim = dimsA[1];
     uint32_t K_dim = dimsB[1];
     std::array<uint32_t, 2> dims = {M_dim, K_dim};
-    Tensor<float, 2> result(dims); 
-    for(int i = 0; i < M_dim; i++){
-        int j = 0;
+    Tensor<float, 2> result(dims, TensorUninitialized);
+    for(uint32_t i = 0; i < M_dim; i++){
+        const float* rowA = A.row(i);
+        float* rowC = result.row(i);
+        uint32_t j = 0;
         for(; j+3 < K_dim; j+=4){ 
             // Initialize sum vector for 4 elements of row i of C
             float32x4_t sum = vdupq_n_f32(0.0f);
-            for(int k = 0; k < N_dim; k++){
+            for(uint32_t k = 0; k < N_dim; k++){
                 // Load A(i,k) and broadcast it into a vector.
-                float a_val = A(i, k);
+                float a_val = rowA[k];
                 float32x4_t a_vec = vdupq_n_f32(a_val);
                 // Load 4 contiguous floats from row k of B, starting at column j.
                 // Since B is row-major, row k starts at index k*K.
-                float32x4_t b_vec = vld1q_f32(&B(k,j));
+                float32x4_t b_vec = vld1q_f32(B.row(k) + j);
                 // Accumulate: sum += a_vec * b_vec
                 sum = vmlaq_f32(sum, a_vec, b_vec);
             }
             // Store the computed 4 floats back into matrixC
-            vst1q_f32(&result(i, j), sum);
+            vst1q_f32(rowC + j, sum);
         }
         for(; j < K_dim; j+=1){
             float sum = 0;
-            for(int k = 0; k < N_dim; k++){
-                sum += A(i,k) * B(k, j);
+            for(uint32_t k = 0; k < N_dim; k++){
+                sum += rowA[k] * B.Data[static_cast<uint64_t>(k) * K_dim + j];
             }
-            result(i, j) = sum;
+            rowC[j] = sum;
         }
     }
     return result;
@@ -157,31 +160,33 @@ Tensor<uint32_t, 2> TensorMatmul::naivematmul2d(const Tensor<uint32_t, 2>& A, co
     uint32_t N_dim = dimsA[1];
     uint32_t K_dim = dimsB[1];
     std::array<uint32_t, 2> dims = {M_dim, K_dim};
-    Tensor<uint32_t, 2> result(dims); 
-    for(int i = 0; i < M_dim; i++){
-        int j = 0;
+    Tensor<uint32_t, 2> result(dims, TensorUninitialized);
+    for(uint32_t i = 0; i < M_dim; i++){
+        const uint32_t* rowA = A.row(i);
+        uint32_t* rowC = result.row(i);
+        uint32_t j = 0;
         for(; j+3 < K_dim; j+=4){ 
             // Initialize sum vector for 4 elements of row i of C
             uint32x4_t sum = vdupq_n_u32(0);
-            for(int k = 0; k < N_dim; k++){
+            for(uint32_t k = 0; k < N_dim; k++){
                 // Load A(i,k) and broadcast it into a vector.
-                uint32_t a_val = A(i, k);
+                uint32_t a_val = rowA[k];
                 uint32x4_t a_vec = vdupq_n_u32(a_val);
                 // Load 4 contiguous floats from row k of B, starting at column j.
                 // Since B is row-major, row k starts at index k*K.
-                uint32x4_t b_vec = vld1q_u32(&B(k,j));
+                uint32x4_t b_vec = vld1q_u32(B.row(k) + j);
                 // Accumulate: sum += a_vec * b_vec
                 sum = vmlaq_u32(sum, a_vec, b_vec);
             }
             // Store the computed 4 floats back into matrixC
-            vst1q_u32(&result(i, j), sum);
+            vst1q_u32(rowC + j, sum);
         }
         for(; j < K_dim; j+=1){
             uint32_t sum = 0;
-            for(int k = 0; k < N_dim; k++){
-                sum += A(i,k) * B(k, j);
+            for(uint32_t k = 0; k < N_dim; k++){
+                sum += rowA[k] * B.Data[static_cast<uint64_t>(k) * K_dim + j];
             }
-            result(i, j) = sum;
+            rowC[j] = sum;
         }
     }
     return result;
@@ -195,31 +200,33 @@ Tensor<uint16_t, 2> TensorMatmul::naivematmul2d(const Tensor<uint16_t, 2>& A, co
     uint32_t N_dim = dimsA[1];
     uint32_t K_dim = dimsB[1];
     std::array<uint32_t, 2> dims = {M_dim, K_dim};
-    Tensor<uint16_t, 2> result(dims); 
-    for(int i = 0; i < M_dim; i++){
-        int j = 0;
+    Tensor<uint16_t, 2> result(dims, TensorUninitialized);
+    for(uint32_t i = 0; i < M_dim; i++){
+        const uint16_t* rowA = A.row(i);
+        uint16_t* rowC = result.row(i);
+        uint32_t j = 0;
         for(; j+7 < K_dim; j+=8){ 
             // Initialize sum vector for 4 elements of row i of C
             uint16x8_t sum = vdupq_n_u16(0);
-            for(int k = 0; k < N_dim; k++){
+            for(uint32_t k = 0; k < N_dim; k++){
                 // Load A(i,k) and broadcast it into a vector.
-                uint16_t a_val = A(i, k);
+                uint16_t a_val = rowA[k];
                 uint16x8_t a_vec = vdupq_n_u16(a_val);
                 // Load 4 contiguous floats from row k of B, starting at column j.
                 // Since B is row-major, row k starts at index k*K.
-                uint16x8_t b_vec = vld1q_u16(&B(k,j));
+                uint16x8_t b_vec = vld1q_u16(B.row(k) + j);
                 // Accumulate: sum += a_vec * b_vec
                 sum = vmlaq_u16(sum, a_vec, b_vec);
             }
             // Store the computed 4 floats back into matrixC
-            vst1q_u16(&result(i, j), sum);
+            vst1q_u16(rowC + j, sum);
         }
         for(; j < K_dim; j+=1){
             uint16_t sum = 0;
-            for(int k = 0; k < N_dim; k++){
-                sum += A(i,k) * B(k, j);
+            for(uint32_t k = 0; k < N_dim; k++){
+                sum += rowA[k] * B.Data[static_cast<uint64_t>(k) * K_dim + j];
             }
-            result(i, j) = sum;
+            rowC[j] = sum;
         }
     }
     return result;
@@ -233,32 +240,56 @@ Tensor<uint8_t, 2> TensorMatmul::naivematmul2d(const Tensor<uint8_t, 2>& A, cons
     uint32_t N_dim = dimsA[1];
     uint32_t K_dim = dimsB[1];
     std::array<uint32_t, 2> dims = {M_dim, K_dim};
-    Tensor<uint8_t, 2> result(dims); 
-    for(int i = 0; i < M_dim; i++){
-        int j = 0;
+    Tensor<uint8_t, 2> result(dims, TensorUninitialized);
+    for(uint32_t i = 0; i < M_dim; i++){
+        const uint8_t* rowA = A.row(i);
+        uint8_t* rowC = result.row(i);
+        uint32_t j = 0;
         for(; j+15 < K_dim; j+=16){ 
             // Initialize sum vector for 4 elements of row i of C
             uint8x16_t sum = vdupq_n_u8(0);
-            for(int k = 0; k < N_dim; k++){
+            for(uint32_t k = 0; k < N_dim; k++){
                 // Load A(i,k) and broadcast it into a vector.
-                uint8_t a_val = A(i, k);
+                uint8_t a_val = rowA[k];
                 uint8x16_t a_vec = vdupq_n_u8(a_val);
                 // Load 4 contiguous floats from row k of B, starting at column j.
                 // Since B is row-major, row k starts at index k*K.
-                uint8x16_t b_vec = vld1q_u8(&B(k,j));
+                uint8x16_t b_vec = vld1q_u8(B.row(k) + j);
                 // Accumulate: sum += a_vec * b_vec
                 sum = vmlaq_u8(sum, a_vec, b_vec);
             }
             // Store the computed 4 floats back into matrixC
-            vst1q_u8(&result(i, j), sum);
+            vst1q_u8(rowC + j, sum);
         }
         for(; j < K_dim; j+=1){
             uint8_t sum = 0;
-            for(int k = 0; k < N_dim; k++){
-                sum += A(i,k) * B(k, j);
+            for(uint32_t k = 0; k < N_dim; k++){
+                sum += rowA[k] * B.Data[static_cast<uint64_t>(k) * K_dim + j];
             }
-            result(i, j) = sum;
+            rowC[j] = sum;
         }
     }
     return result;
-}
\ No newline at end of file
+}
+void TensorMatmul::Gemm::convertToHalf(const float* src, uint16_t* dst, uint64_t size){
+    uint64_t i = 0;
+    for (; i + 4 <= size; i += 4) {
+        vst1_u16(dst + i, vreinterpret_u16_f16(vcvt_f16_f32(vld1q_f32(src + i))));
+    }
+    for (; i < size; ++i) {
+        float16_t half = static_cast<float16_t>(src[i]);
+        std::memcpy(dst + i, &half, sizeof(half));
+    }
+}
+
+void TensorMatmul::Gemm::convertFromHalf(const uint16_t* src, float* dst, uint64_t size){
+    uint64_t i = 0;
+    for (; i + 4 <= size; i += 4) {
+        vst1q_f32(dst + i, vcvt_f32_f16(vreinterpret_f16_u16(vld1_u16(src + i))));
+    }
+    for (; i < size; ++i) {
+        float16_t half;
+        std::memcpy(&half, src + i, sizeof(half));
+        dst[i] = static_cast<float>(half);
+    }
+}
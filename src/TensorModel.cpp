@@ -0,0 +1,605 @@
+#include "Tensor/TensorModel.h"
+#include "Tensor/TensorNorm.h"
+#include "Tensor/TensorParallel.h"
+#include <algorithm>
+#include <arm_neon.h>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+
+namespace {
+    using TensorModel::LayerKind;
+    using TensorModel::Pool2DParams;
+    using TensorModel::Shape;
+
+    constexpr char Magic[4] = {'D', 'P', 'M', 'D'};
+    constexpr uint32_t Version = 1;
+
+    // Runs fn(begin, end) over rows of cols floats, split across threads only when the whole range is large
+    template <typename Fn>
+    void forRows(uint64_t rows, uint64_t cols, Fn&& fn){
+        if (rows * cols < TensorParallel::elementwiseThreshold()){
+            fn(uint64_t(0), rows);
+            return;
+        }
+        uint64_t minRows = std::max<uint64_t>(1, TensorParallel::ElementwiseChunk / std::max<uint64_t>(cols, 1));
+        TensorParallel::parallelFor(0, rows, minRows, fn);
+    }
+
+    // 2x2 window with stride 2 and no padding, each row pair is read as even and odd columns
+    void pool2x2(const float* x, float* y, uint32_t width, uint32_t outHeight, uint32_t outWidth, bool average){
+        for (uint32_t oh = 0; oh < outHeight; oh++){
+            const float* top = x + static_cast<uint64_t>(2 * oh) * width;
+            const float* bottom = top + width;
+            float* out = y + static_cast<uint64_t>(oh) * outWidth;
+            uint32_t ow = 0;
+            for (; ow + 4 <= outWidth; ow += 4){
+                float32x4x2_t a = vld2q_f32(top + 2 * ow);
+                float32x4x2_t b = vld2q_f32(bottom + 2 * ow);
+                float32x4_t value = average
+                    ? vmulq_f32(vaddq_f32(vaddq_f32(a.val[0], a.val[1]), vaddq_f32(b.val[0], b.val[1])), vdupq_n_f32(0.25f))
+                    : vmaxq_f32(vmaxq_f32(a.val[0], a.val[1]), vmaxq_f32(b.val[0], b.val[1]));
+                vst1q_f32(out + ow, value);
+            }
+            for (; ow < outWidth; ow++){
+                const float* a = top + 2 * ow;
+                const float* b = bottom + 2 * ow;
+                out[ow] = average ? 0.25f * (a[0] + a[1] + b[0] + b[1]) : std::max(std::max(a[0], a[1]), std::max(b[0], b[1]));
+            }
+        }
+    }
+
+    void pool2d(const float* src, float* dst, const Shape& in, const Shape& out, const Pool2DParams& p, bool average){
+        uint32_t height = in[2], width = in[3];
+        uint32_t outHeight = out[2], outWidth = out[3];
+        uint64_t planes = static_cast<uint64_t>(in[0]) * in[1];
+        uint64_t work = static_cast<uint64_t>(outHeight) * outWidth * p.kernelH * p.kernelW;
+        uint64_t minPlanes = std::max<uint64_t>(1, TensorMatmul::Gemm::ParallelWorkThreshold / std::max<uint64_t>(work, 1));
+        bool fast = p.kernelH == 2 && p.kernelW == 2 && p.strideH == 2 && p.strideW == 2 && p.padH == 0 && p.padW == 0;
+        // Windows never lie entirely in the padding, so a max pool always sees a real value
+        float inverseArea = 1.0f / static_cast<float>(p.kernelH * p.kernelW);
+        TensorParallel::parallelFor(0, planes, minPlanes, [&](uint64_t begin, uint64_t end) {
+            for (uint64_t plane = begin; plane < end; plane++){
+                const float* x = src + plane * height * width;
+                float* y = dst + plane * outHeight * outWidth;
+                if (fast){
+                    pool2x2(x, y, width, outHeight, outWidth, average);
+                    continue;
+                }
+                for (uint32_t oh = 0; oh < outHeight; oh++){
+                    int64_t h0 = static_cast<int64_t>(oh) * p.strideH - p.padH;
+                    int64_t hBegin = std::max<int64_t>(h0, 0);
+                    int64_t hEnd = std::min<int64_t>(h0 + p.kernelH, height);
+                    for (uint32_t ow = 0; ow < outWidth; ow++){
+                        int64_t w0 = static_cast<int64_t>(ow) * p.strideW - p.padW;
+                        int64_t wBegin = std::max<int64_t>(w0, 0);
+                        int64_t wEnd = std::min<int64_t>(w0 + p.kernelW, width);
+                        float value = average ? 0.0f : -std::numeric_limits<float>::infinity();
+                        for (int64_t h = hBegin; h < hEnd; h++){
+                            for (int64_t w = wBegin; w < wEnd; w++)
+                                value = average ? value + x[h * width + w] : std::max(value, x[h * width + w]);
+                        }
+                        y[static_cast<uint64_t>(oh) * outWidth + ow] = average ? value * inverseArea : value;
+                    }
+                }
+            }
+        });
+    }
+
+    void activate(const float* src, float* dst, uint64_t size, TensorMatmul::Activation activation){
+        TensorParallel::parallelElementwise(size, [&](uint64_t begin, uint64_t end) {
+            uint64_t i = begin;
+            for (; i + 4 <= end; i += 4)
+                vst1q_f32(dst + i, TensorMatmul::Gemm::activateVector<float>(vld1q_f32(src + i), activation));
+            for (; i < end; i++)
+                dst[i] = TensorMatmul::Gemm::activate(src[i], activation);
+        });
+    }
+
+    // dst = src * scale[c] + shift[c] for every channel c of axis 1
+    void scaleShift(const float* src, float* dst, const Shape& shape, const float* scale, const float* shift){
+        uint64_t channels = shape[1];
+        uint64_t rows = static_cast<uint64_t>(shape[0]) * channels;
+        uint64_t inner = TensorModel::Model::elementCount(shape) / std::max<uint64_t>(rows, 1);
+        forRows(rows, inner, [&](uint64_t begin, uint64_t end) {
+            for (uint64_t row = begin; row < end; row++){
+                const float* x = src + row * inner;
+                float* y = dst + row * inner;
+                float a = scale[row % channels];
+                float b = shift[row % channels];
+                float32x4_t av = vdupq_n_f32(a);
+                float32x4_t bv = vdupq_n_f32(b);
+                uint64_t i = 0;
+                for (; i + 4 <= inner; i += 4)
+                    vst1q_f32(y + i, vmlaq_f32(bv, vld1q_f32(x + i), av));
+                for (; i < inner; i++)
+                    y[i] = x[i] * a + b;
+            }
+        });
+    }
+
+    Shape pooledShape(const Shape& input, const Pool2DParams& p){
+        return {input[0], input[1], (input[2] + 2 * p.padH - p.kernelH) / p.strideH + 1, (input[3] + 2 * p.padW - p.kernelW) / p.strideW + 1};
+    }
+
+    bool poolFits(const Shape& input, const Pool2DParams& p){
+        return input.size() == 4 && p.kernelH > 0 && p.kernelW > 0 && p.strideH > 0 && p.strideW > 0 &&
+               p.padH < p.kernelH && p.padW < p.kernelW && input[2] + 2 * p.padH >= p.kernelH && input[3] + 2 * p.padW >= p.kernelW;
+    }
+
+    class Writer {
+    public:
+        explicit Writer(const std::string& path) : _file(path, std::ios::binary) {}
+
+        // Flushes first, so that a failed write shows up here
+        bool good() { return static_cast<bool>(_file.flush()); }
+
+        template <typename T>
+        void write(T value){
+            _file.write(reinterpret_cast<const char*>(&value), sizeof(T));
+        }
+
+        void writeFloats(const float* values, uint64_t count){
+            _file.write(reinterpret_cast<const char*>(values), static_cast<std::streamsize>(count * sizeof(float)));
+        }
+
+    private:
+        std::ofstream _file;
+    };
+
+    // Reads a model file and throws std::runtime_error as soon as it ends early
+    class Reader {
+    public:
+        explicit Reader(const std::string& path) : _file(path, std::ios::binary | std::ios::ate) {
+            if (!_file)
+                throw std::runtime_error("Cannot open model file " + path);
+            _remaining = static_cast<uint64_t>(_file.tellg());
+            _file.seekg(0);
+        }
+
+        template <typename T>
+        T read(){
+            T value;
+            take(&value, sizeof(T));
+            return value;
+        }
+
+        template <uint16_t N>
+        Tensor<float, N> readTensor(const std::array<uint32_t, N>& dims){
+            uint64_t count = 1;
+            for (uint32_t dim : dims)
+                count *= dim;
+            if (count > _remaining / sizeof(float))
+                throw std::runtime_error("Model file ends inside a parameter tensor");
+            Tensor<float, N> tensor(dims, TensorUninitialized);
+            take(tensor.Data.data(), count * sizeof(float));
+            return tensor;
+        }
+
+    private:
+        void take(void* dst, uint64_t bytes){
+            if (bytes > _remaining || !_file.read(static_cast<char*>(dst), static_cast<std::streamsize>(bytes)))
+                throw std::runtime_error("Model file ends unexpectedly");
+            _remaining -= bytes;
+        }
+
+        std::ifstream _file;
+        uint64_t _remaining = 0;
+    };
+
+    void expect(bool condition, const char* message){
+        if (!condition)
+            throw std::runtime_error(message);
+    }
+};
+
+namespace TensorModel {
+    Model::Model(const Shape& inputShape) : _inputShape(inputShape) {
+        assert((inputShape.size() == 2 || inputShape.size() == 4) && "Model input must be [batch, features] or NCHW");
+        assert(elementCount(inputShape) > 0 && "Model input must not be empty");
+    }
+
+    uint64_t Model::elementCount(const Shape& shape){
+        uint64_t count = 1;
+        for (uint32_t dim : shape)
+            count *= dim;
+        return count;
+    }
+
+    const char* Model::name(LayerKind kind){
+        switch (kind){
+            case LayerKind::Linear: return "Linear";
+            case LayerKind::Conv2D: return "Conv2D";
+            case LayerKind::MaxPool2D: return "MaxPool2D";
+            case LayerKind::AvgPool2D: return "AvgPool2D";
+            case LayerKind::Activation: return "Activation";
+            case LayerKind::BatchNorm: return "BatchNorm";
+            case LayerKind::LayerNorm: return "LayerNorm";
+            case LayerKind::Softmax: return "Softmax";
+        }
+        return "Unknown";
+    }
+
+    Layer& Model::addLayer(LayerKind kind, const Shape& outputShape){
+        Layer layer;
+        layer.kind = kind;
+        layer.inputShape = this->outputShape();
+        layer.outputShape = outputShape;
+        _layers.push_back(std::move(layer));
+        _timings.assign(_layers.size(), 0.0);
+
+        // Every output but the last one lives in the arena, the last is written straight to the caller's buffer
+        uint64_t half = 0;
+        for (uint64_t i = 0; i + 1 < _layers.size(); i++)
+            half = std::max(half, elementCount(_layers[i].outputShape));
+        _arena.resize(2 * half);
+        return _layers.back();
+    }
+
+    uint64_t Model::addParameters(const float* values, uint64_t count){
+        uint64_t offset = _parameters.size();
+        _parameters.insert(_parameters.end(), values, values + count);
+        return offset;
+    }
+
+    void Model::linear(const Tensor<float, 2>& weights, const Tensor<float, 1>* bias){
+        const Shape& input = outputShape();
+        const auto& dims = weights.getDimensions();
+        assert(elementCount(input) / input[0] == dims[1] && "Linear weights must be [outFeatures, inFeatures of the input]");
+        assert((!bias || bias->getDimensions()[0] == dims[0]) && "Linear bias must have one value per output feature");
+        Layer& layer = addLayer(LayerKind::Linear, {input[0], dims[0]});
+        layer.weightShape = {dims[0], dims[1]};
+        layer.weights = addParameters(weights.Data.data(), weights.Data.size());
+        if (bias)
+            layer.bias = addParameters(bias->Data.data(), dims[0]);
+        layer.packed = static_cast<uint32_t>(_packed.size());
+        _packed.emplace_back(weights, TensorMatmul::Transpose::Yes);
+    }
+
+    void Model::conv2d(const Tensor<float, 4>& weights, const Tensor<float, 1>* bias, const TensorConv::Conv2DParams& params){
+        const Shape& input = outputShape();
+        const auto& dims = weights.getDimensions();
+        assert(input.size() == 4 && "Conv2D needs an NCHW input");
+        assert(params.layout == TensorConv::Layout::NCHW && "Model activations are NCHW");
+        assert((!bias || bias->getDimensions()[0] == dims[0]) && "Conv2D bias must have one value per output channel");
+        auto out = TensorConv::outputShape({input[0], input[1], input[2], input[3]}, dims, params);
+        Layer& layer = addLayer(LayerKind::Conv2D, {out[0], out[1], out[2], out[3]});
+        layer.weightShape = {dims[0], dims[1], dims[2], dims[3]};
+        layer.conv = params;
+        layer.weights = addParameters(weights.Data.data(), weights.Data.size());
+        if (bias)
+            layer.bias = addParameters(bias->Data.data(), dims[0]);
+    }
+
+    void Model::maxPool2d(const Pool2DParams& params){
+        assert(poolFits(outputShape(), params) && "MaxPool2D needs an NCHW input at least as large as the window, padding smaller than the window");
+        Layer& layer = addLayer(LayerKind::MaxPool2D, pooledShape(outputShape(), params));
+        layer.pool = params;
+    }
+
+    void Model::avgPool2d(const Pool2DParams& params){
+        assert(poolFits(outputShape(), params) && "AvgPool2D needs an NCHW input at least as large as the window, padding smaller than the window");
+        Layer& layer = addLayer(LayerKind::AvgPool2D, pooledShape(outputShape(), params));
+        layer.pool = params;
+    }
+
+    void Model::activation(Activation activation){
+        Layer& layer = addLayer(LayerKind::Activation, outputShape());
+        layer.activation = activation;
+        // A Linear or Conv2D layer right before applies it while storing its output
+        if (_layers.size() >= 2){
+            Layer& previous = _layers[_layers.size() - 2];
+            if ((previous.kind == LayerKind::Linear || previous.kind == LayerKind::Conv2D) && previous.activation == Activation::None){
+                previous.activation = activation;
+                layer.fused = true;
+            }
+        }
+    }
+
+    void Model::batchNorm(const Tensor<float, 1>& gamma, const Tensor<float, 1>& beta, const Tensor<float, 1>& mean,
+                          const Tensor<float, 1>& variance, float epsilon){
+        uint32_t channels = outputShape()[1];
+        assert(gamma.Data.size() == channels && beta.Data.size() == channels && mean.Data.size() == channels &&
+               variance.Data.size() == channels && "BatchNorm parameters must have one value per channel of axis 1");
+        Layer& layer = addLayer(LayerKind::BatchNorm, outputShape());
+        layer.epsilon = epsilon;
+        layer.weights = addParameters(gamma.Data.data(), channels);
+        addParameters(beta.Data.data(), channels);
+        addParameters(mean.Data.data(), channels);
+        addParameters(variance.Data.data(), channels);
+        // gamma * (x - mean) / sqrt(var + eps) + beta = x * scale + shift
+        layer.folded = _parameters.size();
+        _parameters.resize(_parameters.size() + 2 * channels);
+        float* scale = _parameters.data() + layer.folded;
+        for (uint32_t c = 0; c < channels; c++){
+            scale[c] = gamma.Data[c] / std::sqrt(variance.Data[c] + epsilon);
+            scale[channels + c] = beta.Data[c] - mean.Data[c] * scale[c];
+        }
+    }
+
+    void Model::layerNorm(const Tensor<float, 1>& gamma, const Tensor<float, 1>& beta, float epsilon){
+        uint32_t cols = outputShape().back();
+        assert(gamma.Data.size() == cols && beta.Data.size() == cols && "LayerNorm parameters must match the last axis");
+        Layer& layer = addLayer(LayerKind::LayerNorm, outputShape());
+        layer.epsilon = epsilon;
+        layer.weights = addParameters(gamma.Data.data(), cols);
+        addParameters(beta.Data.data(), cols);
+    }
+
+    void Model::softmax(){
+        addLayer(LayerKind::Softmax, outputShape());
+    }
+
+    void Model::runLayer(const Layer& layer, const float* src, float* dst){
+        const float* weights = _parameters.data() + layer.weights;
+        const float* bias = layer.bias == UINT64_MAX ? nullptr : _parameters.data() + layer.bias;
+        const Shape& in = layer.inputShape;
+        switch (layer.kind){
+            case LayerKind::Linear: {
+                uint32_t rows = layer.outputShape[0];
+                uint32_t depth = layer.weightShape[1];
+                uint32_t cols = layer.weightShape[0];
+                const PackedMatrix<float>& packed = _packed[layer.packed];
+                TensorMatmul::GemmEpilogue<float> epilogue;
+                epilogue.bias = bias;
+                epilogue.activation = layer.activation;
+                TensorMatmul::gemmWithPacking<float>(rows, depth, cols,
+                    [=](uint64_t i0, uint64_t p0, uint32_t mc, uint32_t kc, float* buffer) {
+                        TensorMatmul::Gemm::packA(src, depth, TensorMatmul::Transpose::No, i0, p0, mc, kc, buffer);
+                    },
+                    [&packed](uint64_t p0, uint64_t j0, uint32_t kc, uint32_t nc, float* buffer) { return packed.block(p0, j0, kc, nc, buffer); },
+                    dst, cols, &epilogue);
+                break;
+            }
+            case LayerKind::Conv2D: {
+                const Shape& w = layer.weightShape;
+                TensorConv::conv2d<float>(src, {in[0], in[1], in[2], in[3]}, weights, {w[0], w[1], w[2], w[3]}, bias, dst,
+                                          layer.conv, layer.activation);
+                break;
+            }
+            case LayerKind::MaxPool2D:
+            case LayerKind::AvgPool2D:
+                pool2d(src, dst, in, layer.outputShape, layer.pool, layer.kind == LayerKind::AvgPool2D);
+                break;
+            case LayerKind::Activation:
+                activate(src, dst, elementCount(in), layer.activation);
+                break;
+            case LayerKind::BatchNorm: {
+                const float* scale = _parameters.data() + layer.folded;
+                scaleShift(src, dst, in, scale, scale + in[1]);
+                break;
+            }
+            case LayerKind::LayerNorm: {
+                uint64_t cols = in.back();
+                TensorNorm::layerNorm(src, dst, elementCount(in) / cols, cols, weights, weights + cols, layer.epsilon);
+                break;
+            }
+            case LayerKind::Softmax: {
+                uint64_t cols = in.back();
+                TensorNorm::softmax(src, dst, elementCount(in) / cols, cols);
+                break;
+            }
+        }
+    }
+
+    void Model::run(const float* input, float* output){
+        // Fused activations only ever follow the layer they are folded into, so the last layer that runs is found from the back
+        uint64_t last = _layers.size();
+        while (last > 0 && _layers[last - 1].fused)
+            last--;
+        if (last == 0){
+            std::memcpy(output, input, elementCount(_inputShape) * sizeof(float));
+            return;
+        }
+        TensorMatmul::Gemm::WorkspaceBinding<float> scratch(_workspace);
+        uint64_t half = _arena.size() / 2;
+        const float* src = input;
+        uint32_t step = 0;
+        for (uint64_t i = 0; i < _layers.size(); i++){
+            const Layer& layer = _layers[i];
+            if (layer.fused){
+                _timings[i] = 0.0;
+                continue;
+            }
+            float* dst = i + 1 == last ? output : _arena.data() + (step % 2) * half;
+            auto start = std::chrono::steady_clock::now();
+            runLayer(layer, src, dst);
+            _timings[i] = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            src = dst;
+            step++;
+        }
+    }
+
+    void Model::warmUp(){
+        std::vector<float> input(elementCount(_inputShape), 0.0f);
+        std::vector<float> output(elementCount(outputShape()));
+        run(input.data(), output.data());
+        TensorMatmul::Gemm::reserveLargestRequests(_workspace);
+    }
+
+    std::string Model::profile() const{
+        std::ostringstream text;
+        text << std::fixed << std::setprecision(3);
+        for (uint64_t i = 0; i < _layers.size(); i++){
+            const Layer& layer = _layers[i];
+            text << i << ' ' << name(layer.kind) << " [";
+            for (uint64_t d = 0; d < layer.outputShape.size(); d++)
+                text << (d ? ", " : "") << layer.outputShape[d];
+            text << "] ";
+            if (layer.fused)
+                text << "fused\n";
+            else
+                text << _timings[i] << " ms\n";
+        }
+        return text.str();
+    }
+
+    void Model::save(const std::string& path) const{
+        Writer writer(path);
+        expect(writer.good(), "Cannot open the model file for writing");
+        for (char c : Magic)
+            writer.write(c);
+        writer.write(Version);
+        writer.write(static_cast<uint32_t>(_inputShape.size()));
+        for (uint32_t dim : _inputShape)
+            writer.write(dim);
+        writer.write(static_cast<uint32_t>(_layers.size()));
+        for (const Layer& layer : _layers){
+            const float* weights = _parameters.data() + layer.weights;
+            writer.write(static_cast<uint32_t>(layer.kind));
+            switch (layer.kind){
+                case LayerKind::Linear:
+                case LayerKind::Conv2D: {
+                    writer.write(static_cast<uint32_t>(layer.weightShape.size()));
+                    for (uint32_t dim : layer.weightShape)
+                        writer.write(dim);
+                    if (layer.kind == LayerKind::Conv2D){
+                        const TensorConv::Conv2DParams& p = layer.conv;
+                        for (uint32_t value : {p.strideH, p.strideW, p.padH, p.padW, p.dilationH, p.dilationW, p.groups})
+                            writer.write(value);
+                        writer.write(static_cast<uint32_t>(p.algorithm));
+                    }
+                    writer.write(static_cast<uint32_t>(layer.bias != UINT64_MAX));
+                    writer.writeFloats(weights, elementCount(layer.weightShape));
+                    if (layer.bias != UINT64_MAX)
+                        writer.writeFloats(_parameters.data() + layer.bias, layer.weightShape[0]);
+                    break;
+                }
+                case LayerKind::MaxPool2D:
+                case LayerKind::AvgPool2D: {
+                    const Pool2DParams& p = layer.pool;
+                    for (uint32_t value : {p.kernelH, p.kernelW, p.strideH, p.strideW, p.padH, p.padW})
+                        writer.write(value);
+                    break;
+                }
+                case LayerKind::Activation:
+                    writer.write(static_cast<uint32_t>(layer.activation));
+                    break;
+                case LayerKind::BatchNorm:
+                    writer.write(layer.epsilon);
+                    writer.writeFloats(weights, 4ull * layer.inputShape[1]);
+                    break;
+                case LayerKind::LayerNorm:
+                    writer.write(layer.epsilon);
+                    writer.writeFloats(weights, 2ull * layer.inputShape.back());
+                    break;
+                case LayerKind::Softmax:
+                    break;
+            }
+        }
+        expect(writer.good(), "Writing the model file failed");
+    }
+
+    Model Model::load(const std::string& path){
+        Reader reader(path);
+        for (char c : Magic)
+            expect(reader.read<char>() == c, "Not a DeepPi model file");
+        expect(reader.read<uint32_t>() == Version, "Unsupported model file version");
+        uint32_t rank = reader.read<uint32_t>();
+        expect(rank == 2 || rank == 4, "Model input must be [batch, features] or NCHW");
+        Shape inputShape(rank);
+        for (uint32_t& dim : inputShape)
+            dim = reader.read<uint32_t>();
+        expect(elementCount(inputShape) > 0, "Model input must not be empty");
+
+        Model model(inputShape);
+        uint32_t count = reader.read<uint32_t>();
+        for (uint32_t i = 0; i < count; i++){
+            const Shape& input = model.outputShape();
+            uint32_t kind = reader.read<uint32_t>();
+            switch (static_cast<LayerKind>(kind)){
+                case LayerKind::Linear: {
+                    expect(reader.read<uint32_t>() == 2, "Linear weights must be 2-D");
+                    std::array<uint32_t, 2> dims = {reader.read<uint32_t>(), reader.read<uint32_t>()};
+                    expect(dims[0] > 0 && dims[1] == elementCount(input) / input[0], "Linear weights do not match the layer input");
+                    bool hasBias = reader.read<uint32_t>() != 0;
+                    Tensor<float, 2> weights = reader.readTensor<2>(dims);
+                    if (hasBias){
+                        Tensor<float, 1> bias = reader.readTensor<1>({dims[0]});
+                        model.linear(weights, &bias);
+                    } else {
+                        model.linear(weights);
+                    }
+                    break;
+                }
+                case LayerKind::Conv2D: {
+                    expect(reader.read<uint32_t>() == 4, "Conv2D weights must be 4-D");
+                    std::array<uint32_t, 4> dims;
+                    for (uint32_t& dim : dims)
+                        dim = reader.read<uint32_t>();
+                    TensorConv::Conv2DParams p;
+                    for (uint32_t* value : {&p.strideH, &p.strideW, &p.padH, &p.padW, &p.dilationH, &p.dilationW, &p.groups})
+                        *value = reader.read<uint32_t>();
+                    uint32_t algorithm = reader.read<uint32_t>();
+                    expect(algorithm <= static_cast<uint32_t>(TensorConv::Algorithm::Winograd), "Unknown convolution algorithm");
+                    p.algorithm = static_cast<TensorConv::Algorithm>(algorithm);
+                    expect(input.size() == 4, "Conv2D needs an NCHW input");
+                    expect(p.strideH > 0 && p.strideW > 0 && p.dilationH > 0 && p.dilationW > 0 && p.groups > 0 &&
+                           dims[0] > 0 && dims[2] > 0 && dims[3] > 0, "Conv2D strides, dilations, groups and sizes must be positive");
+                    expect(input[1] % p.groups == 0 && dims[0] % p.groups == 0 && dims[1] == input[1] / p.groups,
+                           "Conv2D weights do not match the channels of the layer input");
+                    expect(input[2] + 2 * p.padH >= p.dilationH * (dims[2] - 1) + 1 && input[3] + 2 * p.padW >= p.dilationW * (dims[3] - 1) + 1,
+                           "Conv2D kernel is larger than the padded input");
+                    bool hasBias = reader.read<uint32_t>() != 0;
+                    Tensor<float, 4> weights = reader.readTensor<4>(dims);
+                    if (hasBias){
+                        Tensor<float, 1> bias = reader.readTensor<1>({dims[0]});
+                        model.conv2d(weights, &bias, p);
+                    } else {
+                        model.conv2d(weights, nullptr, p);
+                    }
+                    break;
+                }
+                case LayerKind::MaxPool2D:
+                case LayerKind::AvgPool2D: {
+                    Pool2DParams p;
+                    for (uint32_t* value : {&p.kernelH, &p.kernelW, &p.strideH, &p.strideW, &p.padH, &p.padW})
+                        *value = reader.read<uint32_t>();
+                    expect(poolFits(input, p), "Pooling window does not fit the layer input");
+                    if (static_cast<LayerKind>(kind) == LayerKind::MaxPool2D)
+                        model.maxPool2d(p);
+                    else
+                        model.avgPool2d(p);
+                    break;
+                }
+                case LayerKind::Activation: {
+                    uint32_t activation = reader.read<uint32_t>();
+                    expect(activation <= static_cast<uint32_t>(Activation::Sigmoid), "Unknown activation");
+                    model.activation(static_cast<Activation>(activation));
+                    break;
+                }
+                case LayerKind::BatchNorm: {
+                    float epsilon = reader.read<float>();
+                    std::array<uint32_t, 1> dims = {input[1]};
+                    Tensor<float, 1> gamma = reader.readTensor<1>(dims);
+                    Tensor<float, 1> beta = reader.readTensor<1>(dims);
+                    Tensor<float, 1> mean = reader.readTensor<1>(dims);
+                    Tensor<float, 1> variance = reader.readTensor<1>(dims);
+                    model.batchNorm(gamma, beta, mean, variance, epsilon);
+                    break;
+                }
+                case LayerKind::LayerNorm: {
+                    float epsilon = reader.read<float>();
+                    std::array<uint32_t, 1> dims = {input.back()};
+                    Tensor<float, 1> gamma = reader.readTensor<1>(dims);
+                    Tensor<float, 1> beta = reader.readTensor<1>(dims);
+                    model.layerNorm(gamma, beta, epsilon);
+                    break;
+                }
+                case LayerKind::Softmax:
+                    model.softmax();
+                    break;
+                default:
+                    throw std::runtime_error("Unknown layer kind in model file");
+            }
+            expect(elementCount(model.outputShape()) > 0, "Layer output is empty");
+        }
+        model.warmUp();
+        return model;
+    }
+};
@@ -0,0 +1,165 @@
+#include "Tensor/TensorNorm.h"
+#include "Tensor/TensorMath.h"
+#include "Tensor/TensorParallel.h"
+#include <algorithm>
+#include <arm_neon.h>
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+
+namespace {
+    // Loads the last count < 4 elements of a row, the missing lanes are set to pad
+    inline float32x4_t loadPartial(const float* ptr, uint64_t count, float pad){
+        float lanes[4] = {pad, pad, pad, pad};
+        for (uint64_t i = 0; i < count; i++)
+            lanes[i] = ptr[i];
+        return vld1q_f32(lanes);
+    }
+
+    inline void storePartial(float* ptr, uint64_t count, float32x4_t value){
+        float lanes[4];
+        vst1q_f32(lanes, value);
+        for (uint64_t i = 0; i < count; i++)
+            ptr[i] = lanes[i];
+    }
+
+    // Runs fn(row) for every row, each worker gets at least ParallelChunk elements
+    template <typename Fn>
+    void forEachRow(uint64_t rows, uint64_t cols, Fn fn){
+        uint64_t minRows = std::max<uint64_t>(1, TensorNorm::ParallelChunk / std::max<uint64_t>(cols, 1));
+        TensorParallel::parallelFor(0, rows, minRows, [&](uint64_t rowBegin, uint64_t rowEnd) {
+            for (uint64_t r = rowBegin; r < rowEnd; r++)
+                fn(r);
+        });
+    }
+
+    /**
+     * @brief Max of a row and the sum of exp(x - max), from a single read of the row
+     * Every lane keeps its own running max and sum. A block of 16 values first raises the max,
+     * rescales the sum by exp(oldMax - newMax) once, and then adds its exponentials.
+     */
+    void rowMaxAndSum(const float* row, uint64_t cols, float& maxOut, float& sumOut){
+        float32x4_t max = vdupq_n_f32(-FLT_MAX);
+        float32x4_t sum = vdupq_n_f32(0.0f);
+        uint64_t c = 0;
+        for (; c + 16 <= cols; c += 16){
+            float32x4_t x0 = vld1q_f32(row + c);
+            float32x4_t x1 = vld1q_f32(row + c + 4);
+            float32x4_t x2 = vld1q_f32(row + c + 8);
+            float32x4_t x3 = vld1q_f32(row + c + 12);
+            float32x4_t newMax = vmaxq_f32(max, vmaxq_f32(vmaxq_f32(x0, x1), vmaxq_f32(x2, x3)));
+            sum = vmulq_f32(sum, TensorMath::vexp(vsubq_f32(max, newMax)));
+            max = newMax;
+            float32x4_t e01 = vaddq_f32(TensorMath::vexp(vsubq_f32(x0, max)), TensorMath::vexp(vsubq_f32(x1, max)));
+            float32x4_t e23 = vaddq_f32(TensorMath::vexp(vsubq_f32(x2, max)), TensorMath::vexp(vsubq_f32(x3, max)));
+            sum = vaddq_f32(sum, vaddq_f32(e01, e23));
+        }
+        for (; c < cols; c += 4){
+            // -inf padding contributes nothing to either the max or the sum
+            float32x4_t x = c + 4 <= cols ? vld1q_f32(row + c) : loadPartial(row + c, cols - c, -INFINITY);
+            float32x4_t newMax = vmaxq_f32(max, x);
+            sum = vmulq_f32(sum, TensorMath::vexp(vsubq_f32(max, newMax)));
+            max = newMax;
+            sum = vaddq_f32(sum, TensorMath::vexp(vsubq_f32(x, max)));
+        }
+        maxOut = TensorMath::horizontalMax(max);
+        sumOut = TensorMath::horizontalSum(vmulq_f32(sum, TensorMath::vexp(vsubq_f32(max, vdupq_n_f32(maxOut)))));
+    }
+
+    // Applies fn to every vector of a row and writes the results to dst
+    template <typename Fn>
+    void mapRow(const float* src, float* dst, uint64_t cols, Fn fn){
+        uint64_t c = 0;
+        for (; c + 4 <= cols; c += 4)
+            vst1q_f32(dst + c, fn(vld1q_f32(src + c), c));
+        if (c < cols)
+            storePartial(dst + c, cols - c, fn(loadPartial(src + c, cols - c, 0.0f), c));
+    }
+
+    // gamma[c..c+3] or 1 where gamma is missing, reading only the valid columns on the row tail
+    inline float32x4_t loadParameter(const float* parameter, uint64_t c, uint64_t cols, float fallback){
+        if (!parameter)
+            return vdupq_n_f32(fallback);
+        return c + 4 <= cols ? vld1q_f32(parameter + c) : loadPartial(parameter + c, cols - c, fallback);
+    }
+};
+
+namespace TensorNorm {
+    void softmax(const float* src, float* dst, uint64_t rows, uint64_t cols){
+        forEachRow(rows, cols, [&](uint64_t r) {
+            const float* row = src + r * cols;
+            float max, sum;
+            rowMaxAndSum(row, cols, max, sum);
+            float32x4_t maxV = vdupq_n_f32(max);
+            float32x4_t invSum = vdupq_n_f32(1.0f / sum);
+            mapRow(row, dst + r * cols, cols, [&](float32x4_t x, uint64_t) {
+                return vmulq_f32(TensorMath::vexp(vsubq_f32(x, maxV)), invSum);
+            });
+        });
+    }
+
+    void logSoftmax(const float* src, float* dst, uint64_t rows, uint64_t cols){
+        forEachRow(rows, cols, [&](uint64_t r) {
+            const float* row = src + r * cols;
+            float max, sum;
+            rowMaxAndSum(row, cols, max, sum);
+            float32x4_t shift = vdupq_n_f32(max + std::log(sum));
+            mapRow(row, dst + r * cols, cols, [&](float32x4_t x, uint64_t) {
+                return vsubq_f32(x, shift);
+            });
+        });
+    }
+
+    void layerNorm(const float* src, float* dst, uint64_t rows, uint64_t cols, const float* gamma, const float* beta, float epsilon){
+        forEachRow(rows, cols, [&](uint64_t r) {
+            const float* row = src + r * cols;
+            // Sums of x - row[0] instead of x keep the variance accurate when the mean is large compared to the spread
+            float32x4_t shift = vdupq_n_f32(row[0]);
+            float32x4_t sum = vdupq_n_f32(0.0f);
+            float32x4_t squares = vdupq_n_f32(0.0f);
+            uint64_t c = 0;
+            for (; c + 4 <= cols; c += 4){
+                float32x4_t d = vsubq_f32(vld1q_f32(row + c), shift);
+                sum = vaddq_f32(sum, d);
+                squares = vmlaq_f32(squares, d, d);
+            }
+            if (c < cols){
+                float32x4_t d = vsubq_f32(loadPartial(row + c, cols - c, row[0]), shift);
+                sum = vaddq_f32(sum, d);
+                squares = vmlaq_f32(squares, d, d);
+            }
+            float meanShifted = TensorMath::horizontalSum(sum) / static_cast<float>(cols);
+            float variance = std::max(TensorMath::horizontalSum(squares) / static_cast<float>(cols) - meanShifted * meanShifted, 0.0f);
+            float32x4_t mean = vdupq_n_f32(row[0] + meanShifted);
+            float32x4_t invStd = vdupq_n_f32(1.0f / std::sqrt(variance + epsilon));
+            mapRow(row, dst + r * cols, cols, [&](float32x4_t x, uint64_t col) {
+                float32x4_t scale = vmulq_f32(invStd, loadParameter(gamma, col, cols, 1.0f));
+                return vmlaq_f32(loadParameter(beta, col, cols, 0.0f), vsubq_f32(x, mean), scale);
+            });
+        });
+    }
+
+    void rmsNorm(const float* src, float* dst, uint64_t rows, uint64_t cols, const float* gamma, float epsilon){
+        forEachRow(rows, cols, [&](uint64_t r) {
+            const float* row = src + r * cols;
+            float32x4_t squares0 = vdupq_n_f32(0.0f);
+            float32x4_t squares1 = vdupq_n_f32(0.0f);
+            uint64_t c = 0;
+            for (; c + 8 <= cols; c += 8){
+                float32x4_t x0 = vld1q_f32(row + c);
+                float32x4_t x1 = vld1q_f32(row + c + 4);
+                squares0 = vmlaq_f32(squares0, x0, x0);
+                squares1 = vmlaq_f32(squares1, x1, x1);
+            }
+            for (; c < cols; c += 4){
+                float32x4_t x = c + 4 <= cols ? vld1q_f32(row + c) : loadPartial(row + c, cols - c, 0.0f);
+                squares0 = vmlaq_f32(squares0, x, x);
+            }
+            float meanSquare = TensorMath::horizontalSum(vaddq_f32(squares0, squares1)) / static_cast<float>(cols);
+            float32x4_t invRms = vdupq_n_f32(1.0f / std::sqrt(meanSquare + epsilon));
+            mapRow(row, dst + r * cols, cols, [&](float32x4_t x, uint64_t col) {
+                return vmulq_f32(vmulq_f32(x, invRms), loadParameter(gamma, col, cols, 1.0f));
+            });
+        });
+    }
+};
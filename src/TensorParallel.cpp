@@ -0,0 +1,184 @@
+#include "Tensor/TensorParallel.h"
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <vector>
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace {
+    std::mutex poolMutex;
+    std::unique_ptr<TensorParallel::ThreadPool> poolInstance;
+
+    bool readNumber(const std::string& path, uint64_t& value){
+        std::ifstream file(path);
+        return static_cast<bool>(file >> value);
+    }
+
+    // Parses a sysfs CPU list such as "0-3,6,8-9"
+    std::vector<unsigned> parseCpuList(const std::string& list){
+        std::vector<unsigned> cpus;
+        std::stringstream stream(list);
+        std::string range;
+        while (std::getline(stream, range, ',')){
+            if (range.empty() || range == "\n")
+                continue;
+            size_t dash = range.find('-');
+            unsigned first = static_cast<unsigned>(std::stoul(range.substr(0, dash)));
+            unsigned last = dash == std::string::npos ? first : static_cast<unsigned>(std::stoul(range.substr(dash + 1)));
+            for (unsigned cpu = first; cpu <= last; cpu++)
+                cpus.push_back(cpu);
+        }
+        return cpus;
+    }
+
+    /**
+     * @brief Number of tasks a parallel loop is cut into so that every core gets work in proportion to its capacity
+     * With tasks of equal size the slowest core should get one, so the count is the total capacity in units of the slowest core.
+     *
+     * @return 0 when all cores are equally fast
+     */
+    unsigned weightedGranularity(const std::vector<TensorParallel::CoreInfo>& cores){
+        if (cores.empty())
+            return 0;
+        uint64_t total = 0;
+        uint32_t slowest = UINT32_MAX;
+        uint32_t fastest = 0;
+        for (const auto& core : cores){
+            total += core.capacity;
+            slowest = std::min(slowest, core.capacity);
+            fastest = std::max(fastest, core.capacity);
+        }
+        if (slowest == fastest || slowest == 0)
+            return 0;
+        uint64_t tasks = (total + slowest - 1) / slowest;
+        // Beyond a few tasks per core the scheduling overhead outweighs the better balance
+        return static_cast<unsigned>(std::min<uint64_t>(tasks, 4 * cores.size()));
+    }
+
+    TensorParallel::ThreadPool& installPool(std::unique_ptr<TensorParallel::ThreadPool> pool, unsigned workers, unsigned granularity){
+        TensorParallel::detail::poolPointer.store(nullptr, std::memory_order_release);
+        poolInstance = std::move(pool);
+        TensorParallel::detail::taskGranularity.store(granularity, std::memory_order_relaxed);
+        TensorParallel::detail::configuredWorkers.store(workers, std::memory_order_relaxed);
+        TensorParallel::detail::poolPointer.store(poolInstance.get(), std::memory_order_release);
+        return *poolInstance;
+    }
+};
+
+namespace TensorParallel {
+    std::vector<CoreInfo> detectCores(const std::string& sysfsRoot){
+        std::vector<unsigned> ids;
+        std::ifstream online(sysfsRoot + "/online");
+        std::string list;
+        if (online && std::getline(online, list))
+            ids = parseCpuList(list);
+        if (ids.empty()){
+            unsigned count = std::thread::hardware_concurrency();
+            for (unsigned id = 0; id < std::max(count, 1u); id++)
+                ids.push_back(id);
+        }
+
+        std::vector<uint64_t> capacities(ids.size(), 0);
+        std::vector<uint64_t> frequencies(ids.size(), 0);
+        bool haveCapacity = true;
+        bool haveFrequency = true;
+        for (size_t i = 0; i < ids.size(); i++){
+            std::string cpu = sysfsRoot + "/cpu" + std::to_string(ids[i]);
+            haveCapacity = readNumber(cpu + "/cpu_capacity", capacities[i]) && haveCapacity;
+            haveFrequency = readNumber(cpu + "/cpufreq/cpuinfo_max_freq", frequencies[i]) && haveFrequency;
+        }
+
+        std::vector<CoreInfo> cores(ids.size());
+        uint64_t maxFrequency = haveFrequency ? *std::max_element(frequencies.begin(), frequencies.end()) : 0;
+        for (size_t i = 0; i < ids.size(); i++){
+            cores[i].id = ids[i];
+            if (haveCapacity)
+                cores[i].capacity = static_cast<uint32_t>(capacities[i]);
+            else if (maxFrequency > 0)
+                cores[i].capacity = static_cast<uint32_t>(frequencies[i] * 1024 / maxFrequency);
+            else
+                cores[i].capacity = 1024;
+        }
+
+        // Clusters numbered from the fastest capacity down
+        std::vector<uint32_t> levels;
+        for (const auto& core : cores)
+            levels.push_back(core.capacity);
+        std::sort(levels.begin(), levels.end(), std::greater<uint32_t>());
+        levels.erase(std::unique(levels.begin(), levels.end()), levels.end());
+        for (auto& core : cores)
+            core.cluster = static_cast<uint32_t>(std::find(levels.begin(), levels.end(), core.capacity) - levels.begin());
+        return cores;
+    }
+
+    bool pinCurrentThread(unsigned core){
+#if defined(__linux__)
+        if (core >= CPU_SETSIZE)
+            return false;
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(core, &set);
+        return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+        (void)core;
+        return false;
+#endif
+    }
+
+    void configure(const ThreadConfig& config){
+        std::vector<CoreInfo> detected = detectCores();
+        std::vector<CoreInfo> cores;
+        if (config.cores.empty()){
+            cores = detected;
+        } else {
+            for (unsigned id : config.cores){
+                auto found = std::find_if(detected.begin(), detected.end(), [id](const CoreInfo& core) { return core.id == id; });
+                cores.push_back(found != detected.end() ? *found : CoreInfo{id, 1024, 0});
+            }
+        }
+        unsigned workers = static_cast<unsigned>(std::max<size_t>(cores.size(), 1));
+
+        // The calling thread takes the first core, every worker one of the others
+        std::vector<unsigned> pinned;
+        if (config.pinWorkers){
+            for (size_t i = 1; i < cores.size(); i++)
+                pinned.push_back(cores[i].id);
+        }
+        if (config.pinCaller && !cores.empty())
+            pinCurrentThread(cores[0].id);
+
+        std::lock_guard<std::mutex> lock(poolMutex);
+        auto pool = std::make_unique<ThreadPool>(workers - 1, pinned);
+        installPool(std::move(pool), workers, config.weightByCapacity ? weightedGranularity(cores) : 0);
+    }
+
+    void resetConfiguration(){
+        std::lock_guard<std::mutex> lock(poolMutex);
+        detail::poolPointer.store(nullptr, std::memory_order_release);
+        poolInstance.reset();
+        detail::taskGranularity.store(0, std::memory_order_relaxed);
+        detail::configuredWorkers.store(0, std::memory_order_relaxed);
+    }
+
+    namespace detail {
+        ThreadPool& createPool(){
+            std::lock_guard<std::mutex> lock(poolMutex);
+            if (ThreadPool* existing = poolPointer.load(std::memory_order_acquire))
+                return *existing;
+            unsigned workers = workerCount();
+            std::vector<CoreInfo> cores = detectCores();
+            // Unpinned, but loops are still cut by capacity on heterogeneous boards
+            unsigned granularity = cores.size() == workers ? weightedGranularity(cores) : 0;
+            auto pool = std::make_unique<ThreadPool>(workers - 1);
+            return installPool(std::move(pool), configuredWorkers.load(std::memory_order_relaxed), granularity);
+        }
+    };
+};
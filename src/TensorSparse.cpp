@@ -0,0 +1,197 @@
+#include "Tensor/SparseTensor.h"
+#include "Tensor/TensorMath.h"
+#include <algorithm>
+#include <arm_neon.h>
+#include <cstdint>
+
+namespace {
+    // y = A x for the CSR rows [rowBegin, rowEnd), four stored values per step with the x values gathered into one register
+    void spmvCsr(const SparseTensor<float>& A, const float* x, float* y, uint32_t rowBegin, uint32_t rowEnd){
+        const float* values = A.Values.data();
+        const uint32_t* columns = A.ColumnIndices.data();
+        for (uint32_t i = rowBegin; i < rowEnd; i++){
+            uint64_t k = A.RowPointers[i];
+            uint64_t end = A.RowPointers[i + 1];
+            float32x4_t acc = vdupq_n_f32(0.0f);
+            for (; k + 4 <= end; k += 4){
+                float gathered[4] = { x[columns[k]], x[columns[k + 1]], x[columns[k + 2]], x[columns[k + 3]] };
+                acc = vmlaq_f32(acc, vld1q_f32(values + k), vld1q_f32(gathered));
+            }
+            float sum = TensorMath::horizontalSum(acc);
+            for (; k < end; k++)
+                sum += values[k] * x[columns[k]];
+            y[i] = sum;
+        }
+    }
+
+    // 1x4 blocks hold four neighbouring values of one row, multiplied with four contiguous values of x
+    void spmvRow1x4(const SparseTensor<float>& A, const float* x, float* y, uint32_t rowBegin, uint32_t rowEnd){
+        uint32_t cols = A.getDimensions()[1];
+        for (uint32_t i = rowBegin; i < rowEnd; i++){
+            float32x4_t acc = vdupq_n_f32(0.0f);
+            float tail = 0.0f;
+            for (uint64_t block = A.RowPointers[i]; block < A.RowPointers[i + 1]; block++){
+                const float* values = A.Values.data() + block * 4;
+                uint32_t j0 = A.ColumnIndices[block] * 4;
+                if (j0 + 4 <= cols){
+                    acc = vmlaq_f32(acc, vld1q_f32(values), vld1q_f32(x + j0));
+                } else {
+                    for (uint32_t j = j0; j < cols; j++)
+                        tail += values[j - j0] * x[j];
+                }
+            }
+            y[i] = TensorMath::horizontalSum(acc) + tail;
+        }
+    }
+
+    // 4x1 blocks hold four values of one column, every block adds one scaled value of x to four rows of y
+    void spmvBlock4x1(const SparseTensor<float>& A, const float* x, float* y, uint32_t rowBegin, uint32_t rowEnd){
+        uint32_t rows = A.getDimensions()[0];
+        for (uint32_t blockRow = rowBegin; blockRow < rowEnd; blockRow++){
+            uint32_t i0 = blockRow * 4;
+            if (i0 + 4 > rows){
+                TensorSparse::spmvRows(A, x, y, blockRow, blockRow + 1);
+                continue;
+            }
+            float32x4_t acc = vdupq_n_f32(0.0f);
+            for (uint64_t block = A.RowPointers[blockRow]; block < A.RowPointers[blockRow + 1]; block++)
+                acc = vmlaq_n_f32(acc, vld1q_f32(A.Values.data() + block * 4), x[A.ColumnIndices[block]]);
+            vst1q_f32(y + i0, acc);
+        }
+    }
+
+    /**
+     * @brief C = A B for the rows [rowBegin, rowEnd) of a matrix with 1 x blockCols blocks
+     * The columns of C are done in strips of up to 16 held in registers while all stored values of the row are applied.
+     */
+    void spmmSingleRowBlocks(const SparseTensor<float>& A, const float* B, uint32_t K, uint64_t ldb, float* C, uint64_t ldc,
+                             uint32_t rowBegin, uint32_t rowEnd){
+        uint32_t bc = A.blockCols();
+        uint32_t cols = A.getDimensions()[1];
+        for (uint32_t i = rowBegin; i < rowEnd; i++){
+            uint64_t blockBegin = A.RowPointers[i];
+            uint64_t blockEnd = A.RowPointers[i + 1];
+            float* row = C + i * ldc;
+            uint32_t k = 0;
+            for (; k + 16 <= K; k += 16){
+                float32x4_t acc0 = vdupq_n_f32(0.0f), acc1 = vdupq_n_f32(0.0f), acc2 = vdupq_n_f32(0.0f), acc3 = vdupq_n_f32(0.0f);
+                for (uint64_t block = blockBegin; block < blockEnd; block++){
+                    const float* values = A.Values.data() + block * bc;
+                    uint32_t j0 = A.ColumnIndices[block] * bc;
+                    uint32_t width = std::min(bc, cols - j0);
+                    for (uint32_t j = 0; j < width; j++){
+                        const float* rowB = B + (j0 + j) * ldb + k;
+                        float a = values[j];
+                        acc0 = vmlaq_n_f32(acc0, vld1q_f32(rowB), a);
+                        acc1 = vmlaq_n_f32(acc1, vld1q_f32(rowB + 4), a);
+                        acc2 = vmlaq_n_f32(acc2, vld1q_f32(rowB + 8), a);
+                        acc3 = vmlaq_n_f32(acc3, vld1q_f32(rowB + 12), a);
+                    }
+                }
+                vst1q_f32(row + k, acc0);
+                vst1q_f32(row + k + 4, acc1);
+                vst1q_f32(row + k + 8, acc2);
+                vst1q_f32(row + k + 12, acc3);
+            }
+            for (; k + 4 <= K; k += 4){
+                float32x4_t acc = vdupq_n_f32(0.0f);
+                for (uint64_t block = blockBegin; block < blockEnd; block++){
+                    const float* values = A.Values.data() + block * bc;
+                    uint32_t j0 = A.ColumnIndices[block] * bc;
+                    uint32_t width = std::min(bc, cols - j0);
+                    for (uint32_t j = 0; j < width; j++)
+                        acc = vmlaq_n_f32(acc, vld1q_f32(B + (j0 + j) * ldb + k), values[j]);
+                }
+                vst1q_f32(row + k, acc);
+            }
+            for (; k < K; k++){
+                float sum = 0.0f;
+                for (uint64_t block = blockBegin; block < blockEnd; block++){
+                    const float* values = A.Values.data() + block * bc;
+                    uint32_t j0 = A.ColumnIndices[block] * bc;
+                    uint32_t width = std::min(bc, cols - j0);
+                    for (uint32_t j = 0; j < width; j++)
+                        sum += values[j] * B[(j0 + j) * ldb + k];
+                }
+                row[k] = sum;
+            }
+        }
+    }
+
+    // 4x1 blocks: each loaded strip of a B row is multiplied into four rows of C
+    void spmmBlock4x1(const SparseTensor<float>& A, const float* B, uint32_t K, uint64_t ldb, float* C, uint64_t ldc,
+                      uint32_t rowBegin, uint32_t rowEnd){
+        uint32_t rows = A.getDimensions()[0];
+        for (uint32_t blockRow = rowBegin; blockRow < rowEnd; blockRow++){
+            uint32_t i0 = blockRow * 4;
+            if (i0 + 4 > rows){
+                TensorSparse::spmmRows(A, B, K, ldb, C, ldc, blockRow, blockRow + 1);
+                continue;
+            }
+            uint64_t blockBegin = A.RowPointers[blockRow];
+            uint64_t blockEnd = A.RowPointers[blockRow + 1];
+            float* row0 = C + i0 * ldc;
+            uint32_t k = 0;
+            for (; k + 8 <= K; k += 8){
+                float32x4_t acc[4][2];
+                for (int r = 0; r < 4; r++)
+                    acc[r][0] = acc[r][1] = vdupq_n_f32(0.0f);
+                for (uint64_t block = blockBegin; block < blockEnd; block++){
+                    const float* values = A.Values.data() + block * 4;
+                    const float* rowB = B + A.ColumnIndices[block] * ldb + k;
+                    float32x4_t b0 = vld1q_f32(rowB);
+                    float32x4_t b1 = vld1q_f32(rowB + 4);
+                    for (int r = 0; r < 4; r++){
+                        acc[r][0] = vmlaq_n_f32(acc[r][0], b0, values[r]);
+                        acc[r][1] = vmlaq_n_f32(acc[r][1], b1, values[r]);
+                    }
+                }
+                for (int r = 0; r < 4; r++){
+                    vst1q_f32(row0 + r * ldc + k, acc[r][0]);
+                    vst1q_f32(row0 + r * ldc + k + 4, acc[r][1]);
+                }
+            }
+            for (; k < K; k++){
+                float sums[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+                for (uint64_t block = blockBegin; block < blockEnd; block++){
+                    const float* values = A.Values.data() + block * 4;
+                    float b = B[A.ColumnIndices[block] * ldb + k];
+                    for (int r = 0; r < 4; r++)
+                        sums[r] += values[r] * b;
+                }
+                for (int r = 0; r < 4; r++)
+                    row0[r * ldc + k] = sums[r];
+            }
+        }
+    }
+};
+
+namespace TensorSparse {
+    void spmv(const SparseTensor<float>& A, const float* x, float* y){
+        uint32_t br = A.blockRows();
+        uint32_t bc = A.blockCols();
+        forBlockRowRanges(A, 1, [&](uint32_t rowBegin, uint32_t rowEnd) {
+            if (br == 1 && bc == 1)
+                spmvCsr(A, x, y, rowBegin, rowEnd);
+            else if (br == 1 && bc == 4)
+                spmvRow1x4(A, x, y, rowBegin, rowEnd);
+            else if (br == 4 && bc == 1)
+                spmvBlock4x1(A, x, y, rowBegin, rowEnd);
+            else
+                spmvRows(A, x, y, rowBegin, rowEnd);
+        });
+    }
+
+    void spmm(const SparseTensor<float>& A, const float* B, uint32_t K, uint64_t ldb, float* C, uint64_t ldc){
+        uint32_t br = A.blockRows();
+        uint32_t bc = A.blockCols();
+        forBlockRowRanges(A, K, [&](uint32_t rowBegin, uint32_t rowEnd) {
+            if (br == 1)
+                spmmSingleRowBlocks(A, B, K, ldb, C, ldc, rowBegin, rowEnd);
+            else if (br == 4 && bc == 1)
+                spmmBlock4x1(A, B, K, ldb, C, ldc, rowBegin, rowEnd);
+            else
+                spmmRows(A, B, K, ldb, C, ldc, rowBegin, rowEnd);
+        });
+    }
+};
@@ -0,0 +1,85 @@
+#include "Tensor/TensorTranspose.h"
+#include <arm_neon.h>
+#include <cstdint>
+
+namespace {
+    // Transposes one 4x4 tile of floats held in four q registers
+    inline void transposeTile4x4(const float* src, uint64_t srcStride, float* dst, uint64_t dstStride){
+        float32x4_t r0 = vld1q_f32(src);
+        float32x4_t r1 = vld1q_f32(src + srcStride);
+        float32x4_t r2 = vld1q_f32(src + 2 * srcStride);
+        float32x4_t r3 = vld1q_f32(src + 3 * srcStride);
+        // Interleave pairs of rows: t01.val[0] = r0[0] r1[0] r0[2] r1[2], t01.val[1] = r0[1] r1[1] r0[3] r1[3]
+        float32x4x2_t t01 = vtrnq_f32(r0, r1);
+        float32x4x2_t t23 = vtrnq_f32(r2, r3);
+        // Combine the 64-bit halves into full columns
+        vst1q_f32(dst,                 vcombine_f32(vget_low_f32(t01.val[0]), vget_low_f32(t23.val[0])));
+        vst1q_f32(dst + dstStride,     vcombine_f32(vget_low_f32(t01.val[1]), vget_low_f32(t23.val[1])));
+        vst1q_f32(dst + 2 * dstStride, vcombine_f32(vget_high_f32(t01.val[0]), vget_high_f32(t23.val[0])));
+        vst1q_f32(dst + 3 * dstStride, vcombine_f32(vget_high_f32(t01.val[1]), vget_high_f32(t23.val[1])));
+    }
+
+    // Transposes one 4x4 tile of 32-bit integers held in four q registers
+    inline void transposeTile4x4(const uint32_t* src, uint64_t srcStride, uint32_t* dst, uint64_t dstStride){
+        uint32x4_t r0 = vld1q_u32(src);
+        uint32x4_t r1 = vld1q_u32(src + srcStride);
+        uint32x4_t r2 = vld1q_u32(src + 2 * srcStride);
+        uint32x4_t r3 = vld1q_u32(src + 3 * srcStride);
+        uint32x4x2_t t01 = vtrnq_u32(r0, r1);
+        uint32x4x2_t t23 = vtrnq_u32(r2, r3);
+        vst1q_u32(dst,                 vcombine_u32(vget_low_u32(t01.val[0]), vget_low_u32(t23.val[0])));
+        vst1q_u32(dst + dstStride,     vcombine_u32(vget_low_u32(t01.val[1]), vget_low_u32(t23.val[1])));
+        vst1q_u32(dst + 2 * dstStride, vcombine_u32(vget_high_u32(t01.val[0]), vget_high_u32(t23.val[0])));
+        vst1q_u32(dst + 3 * dstStride, vcombine_u32(vget_high_u32(t01.val[1]), vget_high_u32(t23.val[1])));
+    }
+
+    // Transposes one 8x8 tile of 16-bit integers: 16-bit, then 32-bit interleaves, then 64-bit half swaps
+    inline void transposeTile8x8(const uint16_t* src, uint64_t srcStride, uint16_t* dst, uint64_t dstStride){
+        uint16x8x2_t a0 = vtrnq_u16(vld1q_u16(src),                 vld1q_u16(src + srcStride));
+        uint16x8x2_t a1 = vtrnq_u16(vld1q_u16(src + 2 * srcStride), vld1q_u16(src + 3 * srcStride));
+        uint16x8x2_t a2 = vtrnq_u16(vld1q_u16(src + 4 * srcStride), vld1q_u16(src + 5 * srcStride));
+        uint16x8x2_t a3 = vtrnq_u16(vld1q_u16(src + 6 * srcStride), vld1q_u16(src + 7 * srcStride));
+        // b0/b2 hold columns 0,4 and 2,6 of rows 0-3 and 4-7, b1/b3 hold columns 1,5 and 3,7
+        uint32x4x2_t b0 = vtrnq_u32(vreinterpretq_u32_u16(a0.val[0]), vreinterpretq_u32_u16(a1.val[0]));
+        uint32x4x2_t b1 = vtrnq_u32(vreinterpretq_u32_u16(a0.val[1]), vreinterpretq_u32_u16(a1.val[1]));
+        uint32x4x2_t b2 = vtrnq_u32(vreinterpretq_u32_u16(a2.val[0]), vreinterpretq_u32_u16(a3.val[0]));
+        uint32x4x2_t b3 = vtrnq_u32(vreinterpretq_u32_u16(a2.val[1]), vreinterpretq_u32_u16(a3.val[1]));
+        vst1q_u16(dst,                 vreinterpretq_u16_u32(vcombine_u32(vget_low_u32(b0.val[0]), vget_low_u32(b2.val[0]))));
+        vst1q_u16(dst + dstStride,     vreinterpretq_u16_u32(vcombine_u32(vget_low_u32(b1.val[0]), vget_low_u32(b3.val[0]))));
+        vst1q_u16(dst + 2 * dstStride, vreinterpretq_u16_u32(vcombine_u32(vget_low_u32(b0.val[1]), vget_low_u32(b2.val[1]))));
+        vst1q_u16(dst + 3 * dstStride, vreinterpretq_u16_u32(vcombine_u32(vget_low_u32(b1.val[1]), vget_low_u32(b3.val[1]))));
+        vst1q_u16(dst + 4 * dstStride, vreinterpretq_u16_u32(vcombine_u32(vget_high_u32(b0.val[0]), vget_high_u32(b2.val[0]))));
+        vst1q_u16(dst + 5 * dstStride, vreinterpretq_u16_u32(vcombine_u32(vget_high_u32(b1.val[0]), vget_high_u32(b3.val[0]))));
+        vst1q_u16(dst + 6 * dstStride, vreinterpretq_u16_u32(vcombine_u32(vget_high_u32(b0.val[1]), vget_high_u32(b2.val[1]))));
+        vst1q_u16(dst + 7 * dstStride, vreinterpretq_u16_u32(vcombine_u32(vget_high_u32(b1.val[1]), vget_high_u32(b3.val[1]))));
+    }
+
+    // 8x8 byte tile; the fixed trip counts let the compiler unroll it completely
+    inline void transposeTile8x8(const uint8_t* src, uint64_t srcStride, uint8_t* dst, uint64_t dstStride){
+        for (int i = 0; i < 8; i++){
+            for (int j = 0; j < 8; j++){
+                dst[j * dstStride + i] = src[i * srcStride + j];
+            }
+        }
+    }
+}
+
+void TensorTranspose::transpose(const float* src, uint64_t rows, uint64_t cols, uint64_t srcStride, float* dst, uint64_t dstStride){
+    transposeBlocked<4>(src, rows, cols, srcStride, dst, dstStride,
+        [](const float* s, uint64_t ss, float* d, uint64_t ds) { transposeTile4x4(s, ss, d, ds); });
+}
+
+void TensorTranspose::transpose(const uint32_t* src, uint64_t rows, uint64_t cols, uint64_t srcStride, uint32_t* dst, uint64_t dstStride){
+    transposeBlocked<4>(src, rows, cols, srcStride, dst, dstStride,
+        [](const uint32_t* s, uint64_t ss, uint32_t* d, uint64_t ds) { transposeTile4x4(s, ss, d, ds); });
+}
+
+void TensorTranspose::transpose(const uint16_t* src, uint64_t rows, uint64_t cols, uint64_t srcStride, uint16_t* dst, uint64_t dstStride){
+    transposeBlocked<8>(src, rows, cols, srcStride, dst, dstStride,
+        [](const uint16_t* s, uint64_t ss, uint16_t* d, uint64_t ds) { transposeTile8x8(s, ss, d, ds); });
+}
+
+void TensorTranspose::transpose(const uint8_t* src, uint64_t rows, uint64_t cols, uint64_t srcStride, uint8_t* dst, uint64_t dstStride){
+    transposeBlocked<8>(src, rows, cols, srcStride, dst, dstStride,
+        [](const uint8_t* s, uint64_t ss, uint8_t* d, uint64_t ds) { transposeTile8x8(s, ss, d, ds); });
+}
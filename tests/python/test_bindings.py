@@ -0,0 +1,149 @@
+import array
+import threading
+import unittest
+
+import deeppi
+
+try:
+    import numpy
+except ImportError:
+    numpy = None
+
+
+def filled(shape, typecode, values):
+    """Python array with the given values viewed as a C-contiguous buffer of the given shape."""
+    return memoryview(array.array(typecode, values)).cast("B").cast(typecode, shape)
+
+
+class BindingTests(unittest.TestCase):
+    def test_tensor_shares_memory(self):
+        tensor = deeppi.Tensor((2, 3))
+        self.assertEqual(tensor.shape, (2, 3))
+        self.assertEqual(tensor.dtype, "float32")
+        view = memoryview(tensor)
+        self.assertEqual(view.format, "f")
+        self.assertEqual(view.shape, (2, 3))
+        view[1, 2] = 5.0
+        # A second view sees the write, both point into the same DeepPi storage
+        self.assertEqual(memoryview(tensor)[1, 2], 5.0)
+        self.assertEqual(memoryview(tensor).tolist(), [[0.0, 0.0, 0.0], [0.0, 0.0, 5.0]])
+
+    def test_matmul_reads_foreign_buffers(self):
+        a = filled((2, 3), "f", [1, 2, 3, 4, 5, 6])
+        b = filled((3, 2), "f", [7, 8, 9, 10, 11, 12])
+        c = deeppi.matmul(a, b)
+        self.assertIsInstance(c, deeppi.Tensor)
+        self.assertEqual(memoryview(c).tolist(), [[58.0, 64.0], [139.0, 154.0]])
+
+        # Results can go straight into a caller's buffer
+        storage = array.array("f", [0.0] * 4)
+        out = memoryview(storage).cast("B").cast("f", (2, 2))
+        self.assertIs(deeppi.matmul(a, b, out=out), out)
+        self.assertEqual(storage.tolist(), [58.0, 64.0, 139.0, 154.0])
+
+        # A tensor result is again a valid operand
+        self.assertEqual(memoryview(deeppi.matmul(c, filled((2, 1), "f", [1, 1]))).tolist(), [[122.0], [293.0]])
+
+    def test_integer_types(self):
+        for typecode, dtype in (("B", "uint8"), ("H", "uint16"), ("I", "uint32")):
+            a = filled((4,), typecode, [1, 2, 3, 4])
+            b = filled((4,), typecode, [4, 3, 2, 1])
+            self.assertEqual(deeppi.add(a, b).dtype, dtype)
+            self.assertEqual(memoryview(deeppi.add(a, b)).tolist(), [5, 5, 5, 5])
+            self.assertEqual(memoryview(deeppi.subtract(a, filled((4,), typecode, [1, 1, 1, 1]))).tolist(), [0, 1, 2, 3])
+            self.assertEqual(memoryview(deeppi.multiply(a, b)).tolist(), [4, 6, 6, 4])
+        product = deeppi.matmul(filled((1, 2), "I", [2, 3]), filled((2, 1), "I", [4, 5]))
+        self.assertEqual(memoryview(product).tolist(), [[23]])
+
+    def test_errors(self):
+        with self.assertRaises(ValueError):
+            deeppi.matmul(filled((2, 3), "f", [0] * 6), filled((2, 3), "f", [0] * 6))
+        with self.assertRaises(TypeError):
+            deeppi.add(filled((2,), "f", [0, 0]), filled((2,), "H", [0, 0]))
+        with self.assertRaises(TypeError):
+            deeppi.add(filled((2,), "b", [0, 0]), filled((2,), "b", [0, 0]))
+        with self.assertRaises(ValueError):
+            deeppi.Tensor((2,), dtype="int64")
+        # The element count is checked before it can overflow
+        with self.assertRaises(ValueError):
+            deeppi.Tensor((2**32 - 1, 2**32 - 1))
+        with self.assertRaises(ValueError):
+            deeppi.add(filled((2,), "f", [0, 0]), filled((2,), "f", [0, 0]), out=deeppi.Tensor((3,)))
+
+    def test_matmul_rejects_overlapping_out(self):
+        storage = array.array("f", [1.0] * 8)
+        a = memoryview(storage).cast("B")[:16].cast("f", (2, 2))
+        b = filled((2, 2), "f", [1, 2, 3, 4])
+        with self.assertRaises(ValueError):
+            deeppi.matmul(a, b, out=a)
+        with self.assertRaises(ValueError):
+            deeppi.matmul(b, a, out=a)
+        # Sharing part of the storage is rejected as well, the inputs stay untouched
+        shifted = memoryview(storage).cast("B")[8:24].cast("f", (2, 2))
+        with self.assertRaises(ValueError):
+            deeppi.matmul(a, b, out=shifted)
+        self.assertEqual(storage.tolist(), [1.0] * 8)
+        tail = memoryview(storage).cast("B")[16:].cast("f", (2, 2))
+        deeppi.matmul(a, b, out=tail)
+        self.assertEqual(storage.tolist(), [1.0] * 4 + [4.0, 6.0, 4.0, 6.0])
+
+    def test_threads_run_matmuls(self):
+        size = 96
+        a = deeppi.Tensor((size, size))
+        b = deeppi.Tensor((size, size))
+        view_a = memoryview(a)
+        view_b = memoryview(b)
+        for i in range(size):
+            view_a[i, i] = 2.0
+            view_b[i, (i + 1) % size] = 1.0
+        results = [None] * 4
+
+        def work(index):
+            results[index] = deeppi.matmul(a, b)
+
+        threads = [threading.Thread(target=work, args=(index,)) for index in range(4)]
+        for thread in threads:
+            thread.start()
+        for thread in threads:
+            thread.join()
+        for result in results:
+            view = memoryview(result)
+            self.assertEqual(view[3, 4], 2.0)
+            self.assertEqual(view[3, 3], 0.0)
+
+
+@unittest.skipIf(numpy is None, "numpy is not installed")
+class NumpyTests(unittest.TestCase):
+    def test_asarray_shares_memory(self):
+        tensor = deeppi.Tensor((3, 4))
+        array_view = numpy.asarray(tensor)
+        self.assertEqual(array_view.dtype, numpy.float32)
+        self.assertEqual(array_view.shape, (3, 4))
+        array_view[1, 2] = 7.0
+        self.assertEqual(memoryview(tensor)[1, 2], 7.0)
+        self.assertTrue(numpy.shares_memory(array_view, numpy.asarray(tensor)))
+
+    def test_matmul_reads_ndarrays(self):
+        generator = numpy.random.default_rng(0)
+        a = generator.random((33, 17), dtype=numpy.float32)
+        b = generator.random((17, 9), dtype=numpy.float32)
+        numpy.testing.assert_allclose(numpy.asarray(deeppi.matmul(a, b)), a @ b, rtol=1e-5)
+        out = numpy.zeros((33, 9), dtype=numpy.float32)
+        self.assertIs(deeppi.matmul(a, b, out=out), out)
+        numpy.testing.assert_allclose(out, a @ b, rtol=1e-5)
+
+    def test_matmul_rejects_unsupported_ndarrays(self):
+        a = numpy.ones((8, 8), dtype=numpy.float32)
+        with self.assertRaises(TypeError):
+            deeppi.matmul(a.T, a)
+        with self.assertRaises(TypeError):
+            deeppi.matmul(a[:, ::2], a[:4])
+        with self.assertRaises(TypeError):
+            deeppi.matmul(a, a, out=numpy.zeros((8, 8), dtype=numpy.float32).T)
+        # Axes that do not fit 32 bits are refused rather than truncated
+        with self.assertRaises(ValueError):
+            deeppi.matmul(numpy.zeros((0, 2**32), dtype=numpy.float32), numpy.zeros((2**32, 0), dtype=numpy.float32))
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -1,5 +1,7 @@
 #include <gtest/gtest.h>
+#include <vector>
 #include "Tensor/Tensor.h" 
+#include "Tensor/TensorView.h"
 
 // Test that valid access works correctly.
 TEST(TensorAccessTest, ValidAccess) {
@@ -40,6 +42,73 @@ TEST(TensorAccessTest, OutOfBoundsAccess) {
     }, "Index out of bounds");
 }
 
+TEST(TensorAccessTest, RowsAndFlatSpan) {
+    Tensor<float, 3> tensor({2, 3, 4});
+    float value = 0.0f;
+    for (float& element : tensor.flat()) element = value++;
+    // row() takes every index but the last and points at contiguous elements of the innermost axis
+    const float* line = tensor.row(1, 2);
+    for (uint32_t k = 0; k < 4; k++) EXPECT_FLOAT_EQ(line[k], tensor(1, 2, k));
+    EXPECT_EQ(tensor.getStrides()[0], 12u);
+
+    const Tensor<float, 3>& constant = tensor;
+    EXPECT_EQ(constant.flat().size(), 24u);
+    EXPECT_EQ(constant.row(0, 1), tensor.Data.data() + 4);
+    EXPECT_DEATH({ (void)tensor.row(2, 0); }, "Index out of bounds");
+}
+
+TEST(TensorAccessTest, IndexCarriesIntoOuterAxes) {
+    Tensor<float, 3> tensor({2, 3, 4});
+    TensorIndex<3> index(tensor.getDimensions(), tensor.getStrides());
+    uint64_t visited = 0;
+    for (; !index.done(); index.next()) {
+        const auto& idx = index.index();
+        ASSERT_EQ(&tensor(idx[0], idx[1], idx[2]), tensor.Data.data() + index.offset());
+        ASSERT_EQ(index.offset(), visited);
+        visited++;
+    }
+    EXPECT_EQ(visited, 24u);
+
+    // Transposed strides visit the elements of the transpose in row-major order
+    std::array<uint32_t, 2> dims = {4, 3};
+    std::array<uint64_t, 2> strides = {1, 4};
+    std::vector<uint64_t> offsets;
+    for (TensorIndex<2> transposed(dims, strides); !transposed.done(); transposed.next()) offsets.push_back(transposed.offset());
+    EXPECT_EQ(offsets, (std::vector<uint64_t>{0, 4, 8, 1, 5, 9, 2, 6, 10, 3, 7, 11}));
+
+    TensorIndex<2> empty(std::array<uint32_t, 2>{3, 0});
+    EXPECT_TRUE(empty.done());
+}
+
+TEST(TensorAccessTest, BlockCopies) {
+    Tensor<double, 2> A({5, 7});
+    for (uint64_t i = 0; i < A.Data.size(); i++) A.Data[i] = static_cast<double>(i);
+    Tensor<double, 2> extended = A.ExtendToDivisibleBy2();
+    ASSERT_EQ(extended.getDimensions()[0], 6u);
+    ASSERT_EQ(extended.getDimensions()[1], 8u);
+    for (uint32_t i = 0; i < 6; i++) {
+        for (uint32_t j = 0; j < 8; j++) EXPECT_EQ(extended(i, j), i < 5 && j < 7 ? A(i, j) : 0.0);
+    }
+    Tensor<double, 2> corner = extended.RightBottomPart();
+    EXPECT_EQ(corner(0, 0), A(3, 4));
+    Tensor<double, 2> cut = extended.CutToDimensions(5, 7);
+    EXPECT_EQ(cut.Data, A.Data);
+}
+
+TEST(TensorAccessTest, StridesBeyond32Bits) {
+    // A view computes its strides without touching memory, so shapes beyond 2^32 elements need no allocation
+    std::array<uint32_t, 3> dims = {3, 70000, 70000};
+    TensorView<const uint8_t, 3> view(nullptr, dims);
+    EXPECT_EQ(view.size(), 3ull * 70000 * 70000);
+    EXPECT_EQ(view.getStrides()[0], 4900000000ull);
+
+    TensorIndex<3> index(dims, view.getStrides());
+    index.seek(view.size() - 1);
+    EXPECT_EQ(index.offset(), view.size() - 1);
+    EXPECT_EQ(index.index()[0], 2u);
+    EXPECT_FALSE(index.next());
+}
+
 // Optional: Provide a main() if you don't use gtest_main.
 // If you link against gtest_main in your CMakeLists, you don't need this.
 int main(int argc, char** argv) {
@@ -0,0 +1,117 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <coroutine>
+#include <future>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include "Tensor/Tensor.h"
+#include "Tensor/TensorAsync.h"
+
+TEST(AsyncTests, OperationsRunInOrder) {
+    TensorAsync::Stream stream;
+    std::vector<int> order;
+    std::vector<std::future<int>> results;
+    for (int i = 0; i < 50; i++) {
+        results.push_back(stream.submit([&order, i]() {
+            order.push_back(i);
+            return i * i;
+        }));
+    }
+    stream.synchronize();
+    EXPECT_EQ(stream.pending(), 0u);
+    ASSERT_EQ(order.size(), 50u);
+    for (int i = 0; i < 50; i++) {
+        EXPECT_EQ(order[i], i);
+        EXPECT_EQ(results[i].get(), i * i);
+    }
+}
+
+TEST(AsyncTests, TensorOperations) {
+    TensorAsync::Stream stream;
+    Tensor<float, 2> A({40, 30});
+    Tensor<float, 2> B({30, 20});
+    A.fillWithValues(0.5f);
+    B.fillWithValues(2.0f);
+    auto product = stream.matmul(A, B);
+    auto sum = stream.add(A, A);
+    auto difference = stream.subtract(std::move(B), Tensor<float, 2>({30, 20}));
+
+    Tensor<float, 2> C = product.get();
+    ASSERT_EQ(C.getDimensions()[0], 40u);
+    ASSERT_EQ(C.getDimensions()[1], 20u);
+    for (float value : C.Data) ASSERT_FLOAT_EQ(value, 30.0f);
+    for (float value : sum.get().Data) ASSERT_FLOAT_EQ(value, 1.0f);
+    for (float value : difference.get().Data) ASSERT_FLOAT_EQ(value, 2.0f);
+}
+
+TEST(AsyncTests, StreamsRunConcurrently) {
+    // The first stream waits for work that was queued later on the second one, which only finishes if both run at once
+    TensorAsync::Stream first;
+    TensorAsync::Stream second;
+    std::promise<int> signal;
+    auto waiting = first.submit([future = signal.get_future()]() mutable { return future.get() + 1; });
+    auto signalling = second.submit([&signal]() { signal.set_value(41); });
+    ASSERT_EQ(waiting.wait_for(std::chrono::seconds(10)), std::future_status::ready);
+    EXPECT_EQ(waiting.get(), 42);
+    signalling.get();
+}
+
+TEST(AsyncTests, ExceptionsReachTheFuture) {
+    TensorAsync::Stream stream;
+    auto failed = stream.submit([]() -> int { throw std::runtime_error("failed"); });
+    auto next = stream.submit([]() { return 7; });
+    EXPECT_THROW(failed.get(), std::runtime_error);
+    EXPECT_EQ(next.get(), 7);
+}
+
+// Coroutine that starts right away and sets a promise when it returns
+struct Detached {
+    struct promise_type {
+        Detached get_return_object() { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+    };
+};
+
+static Detached pipeline(TensorAsync::Stream& stream, std::promise<float>& done, std::thread::id& resumedOn) {
+    Tensor<float, 2> A({8, 8});
+    A.fillWithValues(1.0f);
+    Tensor<float, 2> squared = co_await stream.operation([&A]() { return TensorOps::matmul(A, A); });
+    resumedOn = std::this_thread::get_id();
+    Tensor<float, 2> doubled = co_await stream.operation([&squared]() { return squared + squared; });
+    done.set_value(doubled.Data[0]);
+}
+
+TEST(AsyncTests, CoroutineAwaitsOperations) {
+    TensorAsync::Stream stream;
+    std::promise<float> done;
+    auto result = done.get_future();
+    std::thread::id resumedOn;
+    pipeline(stream, done, resumedOn);
+    EXPECT_EQ(result.get(), 16.0f);
+    stream.synchronize();
+    EXPECT_NE(resumedOn, std::this_thread::get_id());
+    // Coroutines are resumed off the stream's queue
+    EXPECT_NE(resumedOn, stream.submit([]() { return std::this_thread::get_id(); }).get());
+}
+
+// After the co_await the coroutine blocks on its own stream, which only finishes if it was resumed outside the queue
+static Detached blocking(TensorAsync::Stream& stream, std::promise<int>& done) {
+    int first = co_await stream.operation([]() { return 20; });
+    int second = stream.submit([]() { return 21; }).get();
+    stream.synchronize();
+    int third = co_await stream.operation([]() { return 1; });
+    done.set_value(first + second + third);
+}
+
+TEST(AsyncTests, CoroutineBlocksOnItsStream) {
+    TensorAsync::Stream stream;
+    std::promise<int> done;
+    auto result = done.get_future();
+    blocking(stream, done);
+    ASSERT_EQ(result.wait_for(std::chrono::seconds(10)), std::future_status::ready);
+    EXPECT_EQ(result.get(), 42);
+}
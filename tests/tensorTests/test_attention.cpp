@@ -0,0 +1,110 @@
+#include <gtest/gtest.h>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+#include "Tensor/TensorOps.h"
+#include "test_patterns.h"
+
+using TensorAttention::AttentionParams;
+
+// softmax(scale * Q K^T) V computed row by row in double precision, inputs viewed as batch x seq x dim
+static std::vector<double> referenceAttention(const float* Q, const float* K, const float* V,
+                                              uint64_t batch, uint32_t seqQ, uint32_t seqK, uint32_t dim, uint32_t dimV, bool causal) {
+    std::vector<double> out(batch * seqQ * dimV, 0.0);
+    double scale = 1.0 / std::sqrt(static_cast<double>(dim));
+    int64_t offset = static_cast<int64_t>(seqK) - seqQ;
+    for (uint64_t b = 0; b < batch; b++) {
+        for (uint32_t i = 0; i < seqQ; i++) {
+            std::vector<double> scores(seqK, -INFINITY);
+            double max = -INFINITY;
+            for (uint32_t j = 0; j < seqK; j++) {
+                if (causal && static_cast<int64_t>(j) > static_cast<int64_t>(i) + offset) continue;
+                double s = 0;
+                for (uint32_t d = 0; d < dim; d++) s += static_cast<double>(Q[(b * seqQ + i) * dim + d]) * K[(b * seqK + j) * dim + d];
+                scores[j] = s * scale;
+                max = std::max(max, scores[j]);
+            }
+            double sum = 0;
+            for (uint32_t j = 0; j < seqK; j++) {
+                scores[j] = std::isinf(scores[j]) ? 0.0 : std::exp(scores[j] - max);
+                sum += scores[j];
+            }
+            for (uint32_t j = 0; j < seqK; j++) {
+                for (uint32_t d = 0; d < dimV; d++) {
+                    out[(b * seqQ + i) * dimV + d] += sum > 0 ? scores[j] / sum * V[(b * seqK + j) * dimV + d] : 0.0;
+                }
+            }
+        }
+    }
+    return out;
+}
+
+template <uint16_t N>
+static void expectAttentionMatches(const std::array<uint32_t, N>& dimsQ, uint32_t seqK, uint32_t dimV, bool causal) {
+    std::array<uint32_t, N> dimsK = dimsQ;
+    dimsK[N - 2] = seqK;
+    std::array<uint32_t, N> dimsV = dimsK;
+    dimsV[N - 1] = dimV;
+    auto Q = TestPatterns::tensor<N>(dimsQ, 1);
+    auto K = TestPatterns::tensor<N>(dimsK, 2);
+    auto V = TestPatterns::tensor<N>(dimsV, 3);
+    AttentionParams params;
+    params.causal = causal;
+    auto output = TensorOps::attention(Q, K, V, params);
+    uint64_t batch = Q.Data.size() / (static_cast<uint64_t>(dimsQ[N - 2]) * dimsQ[N - 1]);
+    auto expected = referenceAttention(Q.Data.data(), K.Data.data(), V.Data.data(), batch, dimsQ[N - 2], seqK, dimsQ[N - 1], dimV, causal);
+    auto dimsO = output.getDimensions();
+    EXPECT_EQ(dimsO[N - 1], dimV);
+    EXPECT_EQ(dimsO[N - 2], dimsQ[N - 2]);
+    ASSERT_EQ(output.Data.size(), expected.size());
+    for (uint64_t i = 0; i < expected.size(); i++) {
+        ASSERT_NEAR(output.Data[i], expected[i], 1e-4) << "at " << i;
+    }
+}
+
+TEST(AttentionTests, SelfAttention3D) {
+    // Sequence lengths that leave partial query and key blocks
+    expectAttentionMatches<3>({2, 70, 16}, 70, 16, false);
+    expectAttentionMatches<3>({1, 5, 8}, 5, 8, false);
+}
+
+TEST(AttentionTests, CausalSelfAttention4D) {
+    expectAttentionMatches<4>({2, 3, 130, 12}, 130, 12, true);
+}
+
+TEST(AttentionTests, CrossAttentionDifferentLengthsAndValueDim) {
+    expectAttentionMatches<4>({1, 2, 33, 20}, 150, 7, false);
+    // More queries than keys: the first queries see no key under the causal mask and give zeros
+    expectAttentionMatches<3>({2, 90, 8}, 40, 5, true);
+}
+
+TEST(AttentionTests, CustomScale) {
+    std::array<uint32_t, 3> dims = {1, 4, 4};
+    auto Q = TestPatterns::tensor<3>(dims, 1);
+    auto K = TestPatterns::tensor<3>(dims, 2);
+    auto V = TestPatterns::tensor<3>(dims, 3);
+    // A zero scale makes every score equal, so each output row is the mean of the value rows
+    AttentionParams params;
+    params.scale = 1e-30f;
+    auto output = TensorOps::attention(Q, K, V, params);
+    for (uint32_t d = 0; d < 4; d++) {
+        float mean = (V(0, 0, d) + V(0, 1, d) + V(0, 2, d) + V(0, 3, d)) / 4.0f;
+        for (uint32_t i = 0; i < 4; i++) {
+            EXPECT_NEAR(output(0, i, d), mean, 1e-6f);
+        }
+    }
+}
+
+TEST(AttentionTests, WrongShapes) {
+    auto Q = TestPatterns::tensor<3>({2, 8, 4}, 1);
+    auto K = TestPatterns::tensor<3>({2, 8, 5}, 2);
+    auto V = TestPatterns::tensor<3>({2, 8, 4}, 3);
+    EXPECT_DEATH({
+        TensorOps::attention(Q, K, V);
+    }, "Q and K must have the same head dimension");
+    auto shortV = TestPatterns::tensor<3>({2, 7, 4}, 3);
+    EXPECT_DEATH({
+        TensorOps::attention(Q, Q, shortV);
+    }, "K and V must have the same sequence length");
+}
@@ -0,0 +1,127 @@
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <vector>
+#include "Tensor/TensorBatched.h"
+#include "Tensor/TensorOps.h"
+#include "test_patterns.h"
+
+using TensorMatmul::Transpose;
+
+// Reference product of one stored problem, with the same conventions as gemm()
+static void referenceProduct(uint32_t M, uint32_t N, uint32_t K, const float* A, uint64_t lda, Transpose transA,
+                             const float* B, uint64_t ldb, Transpose transB, float* C, uint64_t ldc) {
+    for (uint32_t i = 0; i < M; i++) {
+        for (uint32_t j = 0; j < K; j++) {
+            float sum = 0.0f;
+            for (uint32_t p = 0; p < N; p++) {
+                float a = transA == Transpose::No ? A[i * lda + p] : A[p * lda + i];
+                float b = transB == Transpose::No ? B[p * ldb + j] : B[j * ldb + p];
+                sum += a * b;
+            }
+            C[i * ldc + j] = sum;
+        }
+    }
+}
+
+static void expectStridedBatched(uint32_t M, uint32_t N, uint32_t K, uint64_t batch, Transpose transA, Transpose transB, bool shareB = false) {
+    uint64_t lda = (transA == Transpose::No ? N : M) + 1;
+    uint64_t ldb = (transB == Transpose::No ? K : N) + 2;
+    uint64_t ldc = K + 3;
+    uint64_t strideA = lda * (transA == Transpose::No ? M : N);
+    uint64_t strideB = shareB ? 0 : ldb * (transB == Transpose::No ? N : K);
+    uint64_t strideC = ldc * M;
+    auto A = TestPatterns::values(strideA * batch, 1);
+    auto B = TestPatterns::values(shareB ? ldb * (transB == Transpose::No ? N : K) : strideB * batch, 2);
+    std::vector<float> C(strideC * batch, -7.0f);
+    std::vector<float> expected(strideC * batch, -7.0f);
+    TensorMatmul::gemmStridedBatched<float>(M, N, K, A.data(), lda, strideA, transA, B.data(), ldb, strideB, transB,
+                                            C.data(), ldc, strideC, batch);
+    for (uint64_t p = 0; p < batch; p++) {
+        referenceProduct(M, N, K, A.data() + p * strideA, lda, transA, B.data() + p * strideB, ldb, transB,
+                         expected.data() + p * strideC, ldc);
+    }
+    for (uint64_t i = 0; i < C.size(); i++) {
+        ASSERT_NEAR(C[i], expected[i], 1e-4f) << M << "x" << N << "x" << K << " batch " << batch << " at " << i;
+    }
+}
+
+TEST(BatchedGemmTests, SmallShapesAllLaneCounts) {
+    for (uint64_t batch : {1, 2, 3, 4, 5, 11}) {
+        expectStridedBatched(8, 8, 8, batch, Transpose::No, Transpose::No);
+    }
+    expectStridedBatched(3, 3, 3, 7, Transpose::No, Transpose::No);
+    expectStridedBatched(6, 5, 7, 9, Transpose::No, Transpose::No);
+    expectStridedBatched(1, 1, 1, 6, Transpose::No, Transpose::No);
+    expectStridedBatched(64, 64, 64, 6, Transpose::No, Transpose::No);
+}
+
+TEST(BatchedGemmTests, TransposedAndSharedOperands) {
+    expectStridedBatched(9, 7, 5, 6, Transpose::Yes, Transpose::No);
+    expectStridedBatched(9, 7, 5, 6, Transpose::No, Transpose::Yes);
+    expectStridedBatched(16, 12, 10, 5, Transpose::Yes, Transpose::Yes);
+    expectStridedBatched(16, 16, 16, 10, Transpose::No, Transpose::No, true);
+}
+
+TEST(BatchedGemmTests, LargeShapesUsePackedGemm) {
+    expectStridedBatched(65, 40, 70, 3, Transpose::No, Transpose::No);
+    expectStridedBatched(100, 80, 30, 2, Transpose::Yes, Transpose::No);
+}
+
+TEST(BatchedGemmTests, PointerArrays) {
+    constexpr uint32_t M = 5, N = 4, K = 6;
+    constexpr uint64_t batch = 6;
+    std::vector<std::vector<float>> As, Bs, Cs;
+    std::vector<const float*> a, b;
+    std::vector<float*> c;
+    for (uint64_t p = 0; p < batch; p++) {
+        As.push_back(TestPatterns::values(M * N, p));
+        Bs.push_back(TestPatterns::values(N * K, p + 10));
+        Cs.emplace_back(M * K);
+    }
+    // Problems in any order, one of them listed twice
+    for (uint64_t p = 0; p < batch; p++) {
+        a.push_back(As[(p * 5) % batch].data());
+        b.push_back(Bs[p == 3 ? 0 : p].data());
+        c.push_back(Cs[p].data());
+    }
+    TensorMatmul::gemmBatched<float>(M, N, K, a.data(), N, Transpose::No, b.data(), K, Transpose::No, c.data(), K, batch);
+    std::vector<float> expected(M * K);
+    for (uint64_t p = 0; p < batch; p++) {
+        referenceProduct(M, N, K, a[p], N, Transpose::No, b[p], K, Transpose::No, expected.data(), K);
+        for (uint32_t i = 0; i < M * K; i++) ASSERT_NEAR(Cs[p][i], expected[i], 1e-5f) << p << " " << i;
+    }
+}
+
+TEST(BatchedGemmTests, TensorMatmul) {
+    Tensor<float, 3> A({7, 8, 12});
+    Tensor<float, 3> B({7, 12, 4});
+    auto valuesA = TestPatterns::values(A.Data.size(), 1);
+    auto valuesB = TestPatterns::values(B.Data.size(), 2);
+    std::copy(valuesA.begin(), valuesA.end(), A.Data.begin());
+    std::copy(valuesB.begin(), valuesB.end(), B.Data.begin());
+    auto C = TensorOps::matmul(A, B);
+    ASSERT_EQ(C.getDimensions(), (std::array<uint32_t, 3>{7, 8, 4}));
+    for (uint32_t p = 0; p < 7; p++)
+        for (uint32_t i = 0; i < 8; i++)
+            for (uint32_t j = 0; j < 4; j++) {
+                float sum = 0.0f;
+                for (uint32_t k = 0; k < 12; k++) sum += A(p, i, k) * B(p, k, j);
+                ASSERT_NEAR(C(p, i, j), sum, 1e-4f);
+            }
+
+    Tensor<uint32_t, 3> U({5, 3, 3});
+    Tensor<uint32_t, 3> V({5, 3, 3});
+    for (uint64_t i = 0; i < U.Data.size(); i++) {
+        U.Data[i] = static_cast<uint32_t>(i % 7);
+        V.Data[i] = static_cast<uint32_t>(i % 5);
+    }
+    auto W = TensorOps::matmul(U, V);
+    uint32_t sum = 0;
+    for (uint32_t k = 0; k < 3; k++) sum += U(4, 2, k) * V(4, k, 1);
+    EXPECT_EQ(W(4, 2, 1), sum);
+
+    Tensor<float, 3> wrongBatch({6, 12, 4});
+    EXPECT_DEATH({
+        TensorOps::matmul(A, wrongBatch);
+    }, "Batched matmul needs the same number of matrices on both sides");
+}
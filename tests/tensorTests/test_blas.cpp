@@ -0,0 +1,147 @@
+#include <gtest/gtest.h>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
+#include "Tensor/TensorBlas.h"
+#include "Tensor/TensorParallel.h"
+#include "test_patterns.h"
+
+// Element (i, j) of a matrix with the given storage order and leading dimension
+static float blasAt(const std::vector<float>& matrix, CBLAS_ORDER order, int ld, int i, int j) {
+    return order == CblasRowMajor ? matrix[i * ld + j] : matrix[j * ld + i];
+}
+
+TEST(BlasTests, SgemmMatchesReference) {
+    const int M = 37, N = 29, K = 300;
+    const float alpha = 1.5f, beta = -0.5f;
+    for (CBLAS_ORDER order : {CblasRowMajor, CblasColMajor}) {
+        for (CBLAS_TRANSPOSE transA : {CblasNoTrans, CblasTrans}) {
+            for (CBLAS_TRANSPOSE transB : {CblasNoTrans, CblasTrans}) {
+                // Stored shapes, with leading dimensions wider than a stored row or column
+                bool rowsA = (order == CblasRowMajor) == (transA == CblasNoTrans);
+                bool rowsB = (order == CblasRowMajor) == (transB == CblasNoTrans);
+                int lda = (rowsA ? K : M) + 3;
+                int ldb = (rowsB ? N : K) + 5;
+                int ldc = (order == CblasRowMajor ? N : M) + 2;
+                auto A = TestPatterns::values(static_cast<uint64_t>(lda) * (rowsA ? M : K), 7);
+                auto B = TestPatterns::values(static_cast<uint64_t>(ldb) * (rowsB ? K : N), 5);
+                auto C = TestPatterns::values(static_cast<uint64_t>(ldc) * (order == CblasRowMajor ? M : N), 3);
+                auto expected = C;
+                for (int i = 0; i < M; i++) {
+                    for (int j = 0; j < N; j++) {
+                        float sum = 0.0f;
+                        for (int k = 0; k < K; k++) {
+                            float a = transA == CblasNoTrans ? blasAt(A, order, lda, i, k) : blasAt(A, order, lda, k, i);
+                            float b = transB == CblasNoTrans ? blasAt(B, order, ldb, k, j) : blasAt(B, order, ldb, j, k);
+                            sum += a * b;
+                        }
+                        float& c = order == CblasRowMajor ? expected[i * ldc + j] : expected[j * ldc + i];
+                        c = alpha * sum + beta * c;
+                    }
+                }
+                cblas_sgemm(order, transA, transB, M, N, K, alpha, A.data(), lda, B.data(), ldb, beta, C.data(), ldc);
+                for (uint64_t i = 0; i < C.size(); i++)
+                    ASSERT_NEAR(C[i], expected[i], 1e-3f) << "order " << order << " transA " << transA << " transB " << transB;
+            }
+        }
+    }
+}
+
+TEST(BlasTests, SgemmBetaZeroIgnoresC) {
+    const int M = 9, N = 11, K = 4;
+    auto A = TestPatterns::values(M * K, 7);
+    auto B = TestPatterns::values(K * N, 5);
+    std::vector<float> C(M * N, std::numeric_limits<float>::quiet_NaN());
+    cblas_sgemm(CblasRowMajor, CblasNoTrans, CblasNoTrans, M, N, K, 2.0f, A.data(), K, B.data(), N, 0.0f, C.data(), N);
+    for (int i = 0; i < M; i++) {
+        for (int j = 0; j < N; j++) {
+            float sum = 0.0f;
+            for (int k = 0; k < K; k++) sum += A[i * K + k] * B[k * N + j];
+            ASSERT_NEAR(C[i * N + j], 2.0f * sum, 1e-5f);
+        }
+    }
+    // alpha = 0 only scales C
+    std::vector<float> D(M * N, 4.0f);
+    cblas_sgemm(CblasRowMajor, CblasNoTrans, CblasNoTrans, M, N, K, 0.0f, A.data(), K, B.data(), N, 0.25f, D.data(), N);
+    for (float value : D) ASSERT_EQ(value, 1.0f);
+}
+
+TEST(BlasTests, SgemvStridedVectors) {
+    const int M = 45, N = 70, lda = 73;
+    auto A = TestPatterns::values(static_cast<uint64_t>(M) * lda, 7);
+    for (CBLAS_TRANSPOSE trans : {CblasNoTrans, CblasTrans}) {
+        int lengthX = trans == CblasNoTrans ? N : M;
+        int lengthY = trans == CblasNoTrans ? M : N;
+        auto X = TestPatterns::values(2 * lengthX, 5);
+        auto Y = TestPatterns::values(lengthY, 3);
+        // Row-major with incX = 2 and incY = -1, which walks y from its last element
+        auto expected = Y;
+        for (int i = 0; i < lengthY; i++) {
+            float sum = 0.0f;
+            for (int k = 0; k < lengthX; k++) sum += (trans == CblasNoTrans ? A[i * lda + k] : A[k * lda + i]) * X[2 * k];
+            expected[lengthY - 1 - i] = 0.5f * sum + 2.0f * Y[lengthY - 1 - i];
+        }
+        cblas_sgemv(CblasRowMajor, trans, M, N, 0.5f, A.data(), lda, X.data(), 2, 2.0f, Y.data(), -1);
+        for (int i = 0; i < lengthY; i++) ASSERT_NEAR(Y[i], expected[i], 1e-4f) << "trans " << trans;
+
+        // The same storage read as column-major is the N x M transpose
+        std::vector<float> Z(lengthY, 0.0f);
+        CBLAS_TRANSPOSE flipped = trans == CblasNoTrans ? CblasTrans : CblasNoTrans;
+        std::vector<float> W(lengthY, 0.0f);
+        cblas_sgemv(CblasRowMajor, trans, M, N, 1.0f, A.data(), lda, X.data(), 2, 0.0f, Z.data(), 1);
+        cblas_sgemv(CblasColMajor, flipped, N, M, 1.0f, A.data(), lda, X.data(), 2, 0.0f, W.data(), 1);
+        for (int i = 0; i < lengthY; i++) ASSERT_FLOAT_EQ(W[i], Z[i]);
+    }
+}
+
+TEST(BlasTests, LevelOneRoutines) {
+    uint64_t saved = TensorParallel::elementwiseThreshold();
+    TensorParallel::setElementwiseThreshold(1 << 10);
+    const int N = 100003;
+    auto X = TestPatterns::values(N, 7);
+    auto Y = TestPatterns::values(N, 5);
+    double expected = 0.0;
+    for (int i = 0; i < N; i++) expected += static_cast<double>(X[i]) * Y[i];
+    EXPECT_NEAR(cblas_sdot(N, X.data(), 1, Y.data(), 1), expected, 1e-2);
+
+    auto Z = Y;
+    cblas_saxpy(N, -2.0f, X.data(), 1, Z.data(), 1);
+    for (int i = 0; i < N; i++) ASSERT_FLOAT_EQ(Z[i], Y[i] - 2.0f * X[i]);
+    cblas_sscal(N, 0.5f, Z.data(), 1);
+    for (int i = 0; i < N; i++) ASSERT_FLOAT_EQ(Z[i], 0.5f * (Y[i] - 2.0f * X[i]));
+    TensorParallel::setElementwiseThreshold(saved);
+
+    // Strided and reversed vectors
+    std::vector<float> a = {1, 0, 2, 0, 3};
+    std::vector<float> b = {4, 5, 6};
+    EXPECT_FLOAT_EQ(cblas_sdot(3, a.data(), 2, b.data(), -1), 1 * 6 + 2 * 5 + 3 * 4);
+    cblas_saxpy(3, 1.0f, b.data(), 1, a.data(), 2);
+    EXPECT_EQ(a, (std::vector<float>{5, 0, 7, 0, 9}));
+    cblas_sscal(2, 3.0f, a.data(), 4);
+    EXPECT_EQ(a, (std::vector<float>{15, 0, 7, 0, 27}));
+}
+
+TEST(BlasTests, ScalByZeroKeepsNaN) {
+    // sscal multiplies like reference BLAS, only the beta of gemm and gemv clears, so every increment gives alpha * x
+    uint64_t saved = TensorParallel::elementwiseThreshold();
+    TensorParallel::setElementwiseThreshold(1 << 10);
+    auto original = TestPatterns::values(100003, 3);
+    original[0] = std::numeric_limits<float>::quiet_NaN();
+    original[6] = std::numeric_limits<float>::infinity();
+    original[4097] = -std::numeric_limits<float>::infinity();
+    original[50000] = std::numeric_limits<float>::quiet_NaN();
+    for (int inc : {1, 2, 3}) {
+        auto x = original;
+        cblas_sscal(static_cast<int>((x.size() + inc - 1) / inc), 0.0f, x.data(), inc);
+        for (uint64_t i = 0; i < x.size(); i++) {
+            float expected = i % inc == 0 ? 0.0f * original[i] : original[i];
+            if (std::isnan(expected))
+                ASSERT_TRUE(std::isnan(x[i])) << "at " << i << " with increment " << inc;
+            else
+                ASSERT_EQ(x[i], expected) << "at " << i << " with increment " << inc;
+        }
+    }
+    TensorParallel::setElementwiseThreshold(saved);
+}
+
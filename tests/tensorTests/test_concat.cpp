@@ -0,0 +1,84 @@
+#include <gtest/gtest.h>
+#include <array>
+#include <cstdint>
+#include <vector>
+#include "Tensor/TensorOps.h"
+#include "Tensor/TensorParallel.h"
+
+template <typename T, uint16_t N>
+static Tensor<T, N> iota(const std::array<uint32_t, N>& dims, uint64_t start) {
+    Tensor<T, N> tensor(dims, TensorUninitialized);
+    for (uint64_t i = 0; i < tensor.Data.size(); i++) tensor.Data[i] = static_cast<T>(start + i);
+    return tensor;
+}
+
+TEST(ConcatTests, ConcatInnerAxis) {
+    auto A = iota<float, 3>({2, 3, 4}, 0);
+    auto B = iota<float, 3>({2, 5, 4}, 100);
+    auto C = TensorOps::concat(A, B, 1);
+    ASSERT_EQ(C.getDimensions(), (std::array<uint32_t, 3>{2, 8, 4}));
+    for (uint32_t i = 0; i < 2; i++) {
+        for (uint32_t j = 0; j < 8; j++) {
+            for (uint32_t k = 0; k < 4; k++) ASSERT_EQ(C(i, j, k), j < 3 ? A(i, j, k) : B(i, j - 3, k));
+        }
+    }
+    // Along the last axis every run is a single row
+    auto D = TensorOps::concat<float, 3>({A, A, A}, 2);
+    ASSERT_EQ(D.getDimensions()[2], 12u);
+    EXPECT_EQ(D(1, 2, 9), A(1, 2, 1));
+}
+
+TEST(ConcatTests, StackAndSplitRoundTrip) {
+    std::vector<Tensor<uint16_t, 2>> frames;
+    std::vector<TensorView<const uint16_t, 2>> views;
+    for (uint32_t f = 0; f < 5; f++) frames.push_back(iota<uint16_t, 2>({3, 7}, f * 21));
+    for (const auto& frame : frames) views.emplace_back(frame);
+
+    auto batch = TensorOps::stack(views);
+    ASSERT_EQ(batch.getDimensions(), (std::array<uint32_t, 3>{5, 3, 7}));
+    for (uint64_t i = 0; i < batch.Data.size(); i++) ASSERT_EQ(batch.Data[i], i);
+
+    auto interleaved = TensorOps::stack(views, 2);
+    ASSERT_EQ(interleaved.getDimensions(), (std::array<uint32_t, 3>{3, 7, 5}));
+    EXPECT_EQ(interleaved(2, 6, 4), frames[4](2, 6));
+
+    auto parts = TensorOps::split(interleaved, 2, {2, 3});
+    ASSERT_EQ(parts.size(), 2u);
+    EXPECT_EQ(parts[1].getDimensions(), (std::array<uint32_t, 3>{3, 7, 3}));
+    EXPECT_EQ(parts[1](1, 5, 0), frames[2](1, 5));
+    EXPECT_EQ(TensorOps::concat(parts[0], parts[1], 2).Data, interleaved.Data);
+}
+
+TEST(ConcatTests, SplitViewsShareStorage) {
+    auto A = iota<float, 3>({1, 6, 4}, 0);
+    auto heads = TensorOps::splitViews(A, 1, {2, 4});
+    ASSERT_EQ(heads.size(), 2u);
+    EXPECT_EQ(heads[0].data(), A.Data.data());
+    EXPECT_EQ(heads[1].data(), A.Data.data() + 8);
+    heads[1](0, 3, 3) = -1.0f;
+    EXPECT_EQ(A(0, 5, 3), -1.0f);
+
+    const Tensor<float, 3>& constant = A;
+    auto readOnly = TensorOps::splitViews(constant, 0, {1});
+    EXPECT_EQ(readOnly[0].size(), 24u);
+
+    EXPECT_DEATH({ TensorOps::splitViews(A, 2, {2, 2}); }, "Views need the split axis to be the outermost one");
+    EXPECT_DEATH({ TensorOps::split(A, 1, {2, 2}); }, "Split sizes must add up");
+}
+
+TEST(ConcatTests, LargeConcatAcrossThreads) {
+    uint64_t saved = TensorParallel::elementwiseThreshold();
+    TensorParallel::setElementwiseThreshold(1 << 10);
+    auto A = iota<uint32_t, 2>({3, 40000}, 0);
+    auto B = iota<uint32_t, 2>({2, 40000}, 1000000);
+    auto C = TensorOps::concat(A, B, 0);
+    auto wide = TensorOps::concat(A, A, 1);
+    TensorParallel::setElementwiseThreshold(saved);
+    for (uint64_t i = 0; i < A.Data.size(); i++) ASSERT_EQ(C.Data[i], A.Data[i]);
+    for (uint64_t i = 0; i < B.Data.size(); i++) ASSERT_EQ(C.Data[A.Data.size() + i], B.Data[i]);
+    for (uint32_t i = 0; i < 3; i++) {
+        for (uint32_t j = 0; j < 80000; j += 997) ASSERT_EQ(wide(i, j), A(i, j % 40000));
+    }
+
+    EXPECT_DEATH({ TensorOps::concat(A, iota<uint32_t, 2>({3, 5}, 0), 0); }, "Tensors must match in every axis");
+}
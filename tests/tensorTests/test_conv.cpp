@@ -0,0 +1,146 @@
+#include <cstdint>
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <array>
+#include "Tensor/TensorOps.h"
+
+using TensorConv::Algorithm;
+using TensorConv::Conv2DParams;
+using TensorConv::Layout;
+
+template <typename T>
+static Tensor<T, 4> patternTensor4(const std::array<uint32_t, 4>& dims, uint32_t modulo, float scale) {
+    Tensor<T, 4> tensor(dims);
+    for (uint64_t i = 0; i < tensor.Data.size(); i++) {
+        tensor.Data[i] = static_cast<T>(static_cast<float>((i * 13 + 5) % modulo) * scale);
+    }
+    return tensor;
+}
+
+// Direct convolution straight from the definition, input and output in params.layout
+template <typename T>
+static Tensor<T, 4> referenceConv(const Tensor<T, 4>& input, const Tensor<T, 4>& weights, const Conv2DParams& params, const Tensor<T, 1>* bias, bool relu) {
+    auto g = TensorConv::geometry(input.getDimensions(), weights.getDimensions(), params);
+    Tensor<T, 4> output(TensorConv::outputShape(input.getDimensions(), weights.getDimensions(), params));
+    uint32_t groupChannels = g.channels / params.groups;
+    uint32_t groupOutChannels = g.outChannels / params.groups;
+    for (uint32_t n = 0; n < g.batch; n++) {
+        for (uint32_t oc = 0; oc < g.outChannels; oc++) {
+            uint32_t group = oc / groupOutChannels;
+            for (uint32_t oy = 0; oy < g.outHeight; oy++) {
+                for (uint32_t ox = 0; ox < g.outWidth; ox++) {
+                    T sum = bias ? (*bias)(oc) : T(0);
+                    for (uint32_t c = 0; c < groupChannels; c++) {
+                        for (uint32_t ky = 0; ky < g.kernelH; ky++) {
+                            for (uint32_t kx = 0; kx < g.kernelW; kx++) {
+                                int64_t iy = static_cast<int64_t>(oy) * params.strideH - params.padH + ky * params.dilationH;
+                                int64_t ix = static_cast<int64_t>(ox) * params.strideW - params.padW + kx * params.dilationW;
+                                if (iy < 0 || iy >= g.height || ix < 0 || ix >= g.width)
+                                    continue;
+                                uint32_t ic = group * groupChannels + c;
+                                T value = params.layout == Layout::NCHW ? input(n, ic, iy, ix) : input(n, iy, ix, ic);
+                                sum += value * weights(oc, c, ky, kx);
+                            }
+                        }
+                    }
+                    if (relu)
+                        sum = std::max(sum, T(0));
+                    if (params.layout == Layout::NCHW)
+                        output(n, oc, oy, ox) = sum;
+                    else
+                        output(n, oy, ox, oc) = sum;
+                }
+            }
+        }
+    }
+    return output;
+}
+
+static void expectConvMatches(const std::array<uint32_t, 4>& inputDims, const std::array<uint32_t, 4>& weightDims,
+                              const Conv2DParams& params, bool withBias, bool relu, float tolerance) {
+    auto input = patternTensor4<float>(inputDims, 17, 0.25f);
+    auto weights = patternTensor4<float>(weightDims, 7, 0.5f);
+    for (float& w : weights.Data) w -= 1.25f;
+    std::array<uint32_t, 1> biasDims = {weightDims[0]};
+    Tensor<float, 1> bias(biasDims);
+    for (uint32_t i = 0; i < weightDims[0]; i++) bias(i) = 0.5f * static_cast<float>(i) - 1.0f;
+    const Tensor<float, 1>* biasPtr = withBias ? &bias : nullptr;
+    auto activation = relu ? TensorMatmul::Activation::ReLU : TensorMatmul::Activation::None;
+
+    auto output = TensorOps::conv2d(input, weights, params, biasPtr, activation);
+    auto expected = referenceConv(input, weights, params, biasPtr, relu);
+    ASSERT_EQ(output.getDimensions(), expected.getDimensions());
+    for (uint64_t i = 0; i < output.Data.size(); i++) {
+        ASSERT_NEAR(output.Data[i], expected.Data[i], tolerance) << "at " << i;
+    }
+}
+
+TEST(ConvTests, Im2colStridePaddingDilationGroups) {
+    Conv2DParams params;
+    params.strideH = 2; params.strideW = 1;
+    params.padH = 1; params.padW = 2;
+    params.dilationH = 2; params.dilationW = 1;
+    params.groups = 2;
+    params.algorithm = Algorithm::Im2colGemm;
+    expectConvMatches({2, 6, 11, 13}, {10, 3, 3, 2}, params, true, false, 1e-3f);
+    params.layout = Layout::NHWC;
+    expectConvMatches({2, 11, 13, 6}, {10, 3, 3, 2}, params, true, true, 1e-3f);
+}
+
+TEST(ConvTests, Im2colManyPixelsOneByOne) {
+    // More pixels than one task and a 1x1 kernel
+    Conv2DParams params;
+    expectConvMatches({1, 5, 23, 29}, {9, 5, 1, 1}, params, false, false, 1e-3f);
+    params.layout = Layout::NHWC;
+    expectConvMatches({1, 23, 29, 5}, {9, 5, 1, 1}, params, false, false, 1e-3f);
+}
+
+TEST(ConvTests, Depthwise3x3BothStrides) {
+    for (uint32_t stride = 1; stride <= 2; stride++) {
+        Conv2DParams params;
+        params.strideH = stride; params.strideW = stride;
+        params.padH = 1; params.padW = 1;
+        params.groups = 6;
+        ASSERT_EQ(TensorConv::selectAlgorithm<float>(TensorConv::geometry({1, 6, 19, 21}, {6, 1, 3, 3}, params), params), Algorithm::Depthwise3x3);
+        expectConvMatches({2, 6, 19, 21}, {6, 1, 3, 3}, params, true, true, 1e-3f);
+        params.layout = Layout::NHWC;
+        expectConvMatches({2, 19, 21, 6}, {6, 1, 3, 3}, params, true, false, 1e-3f);
+    }
+}
+
+TEST(ConvTests, WinogradMatchesDirect) {
+    Conv2DParams params;
+    params.padH = 1; params.padW = 1;
+    ASSERT_EQ(TensorConv::selectAlgorithm<float>(TensorConv::geometry({1, 8, 15, 17}, {12, 8, 3, 3}, params), params), Algorithm::Winograd);
+    expectConvMatches({2, 8, 15, 17}, {12, 8, 3, 3}, params, true, true, 1e-2f);
+    params.padH = 0; params.padW = 0;
+    params.layout = Layout::NHWC;
+    params.algorithm = Algorithm::Winograd;
+    expectConvMatches({1, 10, 9, 3}, {5, 3, 3, 3}, params, false, false, 1e-2f);
+}
+
+TEST(ConvTests, IntegerConvolution) {
+    Conv2DParams params;
+    params.padH = 1; params.padW = 1;
+    params.strideH = 2; params.strideW = 2;
+    auto input = patternTensor4<uint32_t>({1, 3, 9, 8}, 9, 1.0f);
+    auto weights = patternTensor4<uint32_t>({4, 3, 3, 3}, 5, 1.0f);
+    auto output = TensorOps::conv2d(input, weights, params);
+    auto expected = referenceConv<uint32_t>(input, weights, params, nullptr, false);
+    EXPECT_EQ(output.Data, expected.Data);
+}
+
+TEST(ConvTests, ConvWrongShapes) {
+    auto input = patternTensor4<float>({1, 4, 8, 8}, 5, 1.0f);
+    auto weights = patternTensor4<float>({2, 3, 3, 3}, 5, 1.0f);
+    EXPECT_DEATH({
+        TensorOps::conv2d(input, weights);
+    }, "Weights must have shape");
+    Conv2DParams params;
+    params.strideH = 2; params.strideW = 2;
+    params.algorithm = Algorithm::Winograd;
+    auto goodWeights = patternTensor4<float>({2, 4, 3, 3}, 5, 1.0f);
+    EXPECT_DEATH({
+        TensorOps::conv2d(input, goodWeights, params);
+    }, "Winograd needs");
+}
@@ -0,0 +1,154 @@
+#include <gtest/gtest.h>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include "Tensor/TensorGraph.h"
+#include "Tensor/TensorOps.h"
+#include "test_patterns.h"
+
+using TensorGraph::CompiledGraph;
+using TensorGraph::Graph;
+using TensorMatmul::Activation;
+
+static float geluTanh(float x) {
+    return 0.5f * x * (1.0f + std::tanh(0.7978845608f * (x + 0.044715f * x * x * x)));
+}
+
+TEST(GraphTests, MlpFusesIntoGemmEpilogues) {
+    auto x = TestPatterns::tensor<2>({9, 16}, 1);
+    auto w1 = TestPatterns::tensor<2>({16, 32}, 2);
+    auto b1 = TestPatterns::tensor<1>({32}, 3);
+    auto w2 = TestPatterns::tensor<2>({32, 10}, 4);
+    auto b2 = TestPatterns::tensor<1>({10}, 5);
+
+    Graph graph;
+    auto input = graph.input<2>(x.getDimensions());
+    auto hidden = graph.activation(graph.add(graph.matmul(input, graph.constant(w1)), graph.constant(b1)), Activation::GELU);
+    auto logits = graph.add(graph.matmul(hidden, graph.constant(w2)), graph.constant(b2));
+    graph.output(graph.softmax(logits));
+    CompiledGraph compiled = graph.compile();
+    // Two GEMMs with bias and activation in their epilogues and one softmax
+    ASSERT_EQ(compiled.stepCount(), 3u);
+
+    Tensor<float, 2> output({9, 10});
+    compiled.bindInput(0, x);
+    compiled.bindOutput(0, output);
+    compiled.run();
+
+    auto h = TensorOps::matmul(x, w1);
+    for (uint32_t r = 0; r < 9; r++)
+        for (uint32_t c = 0; c < 32; c++) h(r, c) = geluTanh(h(r, c) + b1(c));
+    auto l = TensorOps::matmul(h, w2);
+    for (uint32_t r = 0; r < 9; r++)
+        for (uint32_t c = 0; c < 10; c++) l(r, c) += b2(c);
+    auto expected = TensorOps::softmax(l);
+    for (uint64_t i = 0; i < expected.Data.size(); i++) {
+        ASSERT_NEAR(output.Data[i], expected.Data[i], 1e-5f) << "at " << i;
+    }
+}
+
+TEST(GraphTests, ElementwiseChainIsOneKernel) {
+    std::array<uint32_t, 2> dims = {37, 29};
+    auto a = TestPatterns::tensor<2>(dims, 1);
+    auto b = TestPatterns::tensor<2>(dims, 2);
+    auto c = TestPatterns::tensor<2>(dims, 3);
+    auto bias = TestPatterns::tensor<1>({29}, 4);
+
+    Graph graph;
+    auto ia = graph.input<2>(dims);
+    auto ib = graph.input<2>(dims);
+    auto ic = graph.input<2>(dims);
+    // c - tanh((a * b) * 0.5 + bias) continues the chain through the second operand of sub
+    auto chain = graph.tanh(graph.add(graph.scale(graph.mul(ia, ib), 0.5f), graph.constant(bias)));
+    graph.output(graph.sub(ic, chain));
+    CompiledGraph compiled = graph.compile();
+    ASSERT_EQ(compiled.stepCount(), 1u);
+    EXPECT_EQ(compiled.arenaSize(), 0u);
+
+    Tensor<float, 2> output(dims);
+    compiled.bindInput(0, a);
+    compiled.bindInput(1, b);
+    compiled.bindInput(2, c);
+    compiled.bindOutput(0, output);
+    compiled.run();
+    for (uint32_t r = 0; r < dims[0]; r++) {
+        for (uint32_t col = 0; col < dims[1]; col++) {
+            float expected = c(r, col) - std::tanh(a(r, col) * b(r, col) * 0.5f + bias(col));
+            ASSERT_NEAR(output(r, col), expected, 1e-6f) << r << " " << col;
+        }
+    }
+}
+
+TEST(GraphTests, ResidualFusesIntoGemm) {
+    std::array<uint32_t, 2> dims = {20, 20};
+    auto x = TestPatterns::tensor<2>(dims, 1);
+    auto w = TestPatterns::tensor<2>(dims, 2);
+    Graph graph;
+    auto input = graph.input<2>(dims);
+    graph.output(graph.activation(graph.add(input, graph.scale(graph.matmul(input, graph.constant(w)), 2.0f)), Activation::ReLU));
+    CompiledGraph compiled = graph.compile();
+    ASSERT_EQ(compiled.stepCount(), 1u);
+    EXPECT_EQ(compiled.steps()[0].scale, 2.0f);
+
+    Tensor<float, 2> output(dims);
+    compiled.bindInput(0, x);
+    compiled.bindOutput(0, output);
+    compiled.run();
+    auto product = TensorOps::matmul(x, w);
+    for (uint64_t i = 0; i < output.Data.size(); i++) {
+        ASSERT_NEAR(output.Data[i], std::max(0.0f, 2.0f * product.Data[i] + x.Data[i]), 1e-5f) << "at " << i;
+    }
+}
+
+TEST(GraphTests, ArenaReusesDeadIntermediates) {
+    std::array<uint32_t, 2> dims = {64, 64};
+    auto w = TestPatterns::tensor<2>(dims, 2);
+    Graph graph;
+    auto input = graph.input<2>(dims);
+    auto weights = graph.constant(w);
+    auto h1 = graph.activation(graph.matmul(input, weights), Activation::ReLU);
+    auto h2 = graph.activation(graph.matmul(h1, weights), Activation::ReLU);
+    auto h3 = graph.activation(graph.matmul(h2, weights), Activation::ReLU);
+    // Not needed by the output, dropped by compile
+    graph.exp(h3);
+    graph.output(graph.matmul(h3, weights));
+    CompiledGraph compiled = graph.compile();
+    EXPECT_EQ(compiled.stepCount(), 4u);
+    // h1 and h3 are never alive at the same time and share their space
+    EXPECT_EQ(compiled.arenaSize(), 2u * 64 * 64);
+
+    Tensor<float, 2> output(dims);
+    compiled.bindOutput(0, output);
+    // The same plan runs again on new input data
+    for (uint32_t seed = 1; seed <= 2; seed++) {
+        auto x = TestPatterns::tensor<2>(dims, seed);
+        compiled.bindInput(0, x);
+        compiled.run();
+        auto e = x;
+        for (int layer = 0; layer < 3; layer++) {
+            e = TensorOps::matmul(e, w);
+            for (float& value : e.Data) value = std::max(value, 0.0f);
+        }
+        e = TensorOps::matmul(e, w);
+        for (uint64_t i = 0; i < e.Data.size(); i++) {
+            ASSERT_NEAR(output.Data[i], e.Data[i], 1e-4f * std::max(1.0f, std::fabs(e.Data[i]))) << "at " << i;
+        }
+    }
+}
+
+TEST(GraphTests, GraphErrors) {
+    Graph graph;
+    auto a = graph.input<2>({4, 5});
+    auto b = graph.input<2>({4, 6});
+    EXPECT_DEATH({
+        graph.add(a, b);
+    }, "Operands must have the same shape or the second must be a vector over the last axis");
+    EXPECT_DEATH({
+        graph.matmul(a, b);
+    }, "need to have shapes M\\*N and N\\*K");
+    graph.output(graph.exp(a));
+    CompiledGraph compiled = graph.compile();
+    EXPECT_DEATH({
+        compiled.run();
+    }, "Every input must be bound before run");
+}
@@ -0,0 +1,108 @@
+#include <gtest/gtest.h>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include "Tensor/TensorOps.h"
+
+// Distance between two floats in units in the last place of the expected value
+static double ulpDistance(float value, double expected) {
+    double magnitude = std::max(std::fabs(expected), static_cast<double>(std::numeric_limits<float>::min()));
+    int exponent;
+    std::frexp(magnitude, &exponent);
+    return std::fabs(static_cast<double>(value) - expected) / std::ldexp(1.0, exponent - 24);
+}
+
+static Tensor<float, 1> rangeTensor(uint32_t size, float from, float to) {
+    std::array<uint32_t, 1> dims = {size};
+    Tensor<float, 1> tensor(dims);
+    for (uint32_t i = 0; i < size; i++) {
+        tensor(i) = from + (to - from) * static_cast<float>(i) / static_cast<float>(size - 1);
+    }
+    return tensor;
+}
+
+template <typename Op, typename Reference>
+static void expectWithinUlp(Op op, Reference reference, float from, float to, double maxUlp) {
+    // Odd size so the scalar tail is covered too
+    auto input = rangeTensor(10007, from, to);
+    auto output = op(input);
+    for (uint64_t i = 0; i < input.Data.size(); i++) {
+        double expected = reference(static_cast<double>(input.Data[i]));
+        ASSERT_LE(ulpDistance(output.Data[i], expected), maxUlp) << "at x = " << input.Data[i];
+    }
+}
+
+TEST(MathTests, ExpLog) {
+    expectWithinUlp([](const auto& t) { return TensorOps::exp(t); }, [](double x) { return std::exp(x); }, -87.0f, 88.0f, 1.5);
+    expectWithinUlp([](const auto& t) { return TensorOps::log(t); }, [](double x) { return std::log(x); }, 1e-30f, 1e30f, 1.0);
+    expectWithinUlp([](const auto& t) { return TensorOps::log(t); }, [](double x) { return std::log(x); }, 0.5f, 2.0f, 1.0);
+}
+
+TEST(MathTests, Activations) {
+    expectWithinUlp([](const auto& t) { return TensorOps::tanh(t); }, [](double x) { return std::tanh(x); }, -12.0f, 12.0f, 2.0);
+    expectWithinUlp([](const auto& t) { return TensorOps::sigmoid(t); }, [](double x) { return 1.0 / (1.0 + std::exp(-x)); }, -80.0f, 30.0f, 4.0);
+    expectWithinUlp([](const auto& t) { return TensorOps::erf(t); }, [](double x) { return std::erf(x); }, -5.0f, 5.0f, 3.0);
+    expectWithinUlp([](const auto& t) { return TensorOps::gelu(t); }, [](double x) { return 0.5 * x * std::erfc(-x / std::sqrt(2.0)); }, -10.0f, 10.0f, 16.0);
+}
+
+TEST(MathTests, SqrtRsqrt) {
+    expectWithinUlp([](const auto& t) { return TensorOps::sqrt(t); }, [](double x) { return std::sqrt(x); }, 0.0f, 1e6f, 1.0);
+    expectWithinUlp([](const auto& t) { return TensorOps::rsqrt(t); }, [](double x) { return 1.0 / std::sqrt(x); }, 1e-6f, 1e6f, 2.0);
+}
+
+TEST(MathTests, SpecialValues) {
+    const float inf = std::numeric_limits<float>::infinity();
+    std::array<uint32_t, 1> dims = {6};
+    Tensor<float, 1> input(dims);
+    input.Data = {0.0f, -1.0f, inf, -200.0f, 200.0f, 1e-40f};
+    auto logs = TensorOps::log(input);
+    EXPECT_EQ(logs(0), -inf);
+    EXPECT_TRUE(std::isnan(logs(1)));
+    EXPECT_EQ(logs(2), inf);
+    EXPECT_NEAR(logs(5), std::log(1e-40), 1e-5);
+    auto exps = TensorOps::exp(input);
+    EXPECT_EQ(exps(0), 1.0f);
+    EXPECT_EQ(exps(3), 0.0f);
+    EXPECT_EQ(exps(4), inf);
+    auto tanhs = TensorOps::tanh(input);
+    EXPECT_EQ(tanhs(2), 1.0f);
+    EXPECT_EQ(tanhs(3), -1.0f);
+    auto sigmoids = TensorOps::sigmoid(input);
+    EXPECT_EQ(sigmoids(3), 0.0f);
+    EXPECT_EQ(sigmoids(4), 1.0f);
+    auto rsqrts = TensorOps::rsqrt(input);
+    EXPECT_EQ(rsqrts(0), inf);
+    EXPECT_EQ(rsqrts(2), 0.0f);
+}
+
+TEST(MathTests, InPlaceAndIntoDestination) {
+    auto input = rangeTensor(37, -3.0f, 3.0f);
+    auto expected = TensorOps::tanh(input);
+    Tensor<float, 1> destination(input.getDimensions(), TensorUninitialized);
+    TensorOps::tanh(input, destination);
+    EXPECT_EQ(destination.Data, expected.Data);
+    TensorOps::tanh(input, input);
+    EXPECT_EQ(input.Data, expected.Data);
+}
+
+TEST(MathTests, LargeTensorSplitsAcrossThreads) {
+    std::array<uint32_t, 2> dims = {300, 1001};
+    Tensor<float, 2> input(dims);
+    for (uint64_t i = 0; i < input.Data.size(); i++) {
+        input.Data[i] = static_cast<float>(i % 200) * 0.05f - 5.0f;
+    }
+    auto output = TensorOps::sigmoid(input);
+    for (uint64_t i = 0; i < input.Data.size(); i += 97) {
+        ASSERT_NEAR(output.Data[i], 1.0 / (1.0 + std::exp(-static_cast<double>(input.Data[i]))), 1e-6) << "at " << i;
+    }
+}
+
+TEST(MathTests, WrongDestination) {
+    auto input = rangeTensor(8, 0.0f, 1.0f);
+    std::array<uint32_t, 1> dims = {7};
+    Tensor<float, 1> destination(dims);
+    EXPECT_DEATH({
+        TensorOps::exp(input, destination);
+    }, "Result must have the same dimensions");
+}
@@ -1,3 +1,5 @@
+#include <algorithm>
+#include <cmath>
 #include <chrono>
 #include <cstdint>
 #include <gtest/gtest.h>
@@ -5,6 +7,7 @@
 #include <iostream>
 #include <sys/types.h>
 #include <vector>
+#include <span>
 #include <stdexcept>
 #include "Tensor/TensorOps.h"
 
@@ -334,4 +337,270 @@ TEST(TensorSumTest, TestMatmulAlgorithmEvenUint8) {
     EXPECT_EQ(C(0, 0), 123);
     EXPECT_EQ(C(10, 10), 123);
     EXPECT_EQ(C(30, 110), 123);
-}
\ No newline at end of file
+}
+
+TEST(MatmulTests, EpilogueBiasReLUFloat){
+    // 21 x 37 output covers full and border tiles
+    std::array<uint32_t, 2> dimsA = {21, 300};
+    std::array<uint32_t, 2> dimsB = {300, 37};
+    Tensor<float, 2> A(dimsA);
+    Tensor<float, 2> B(dimsB);
+    for (uint64_t i = 0; i < A.Data.size(); i++) A.Data[i] = static_cast<float>(i % 7) - 3.0f;
+    for (uint64_t i = 0; i < B.Data.size(); i++) B.Data[i] = static_cast<float>(i % 5) - 2.0f;
+    std::array<uint32_t, 1> dimsBias = {37};
+    Tensor<float, 1> bias(dimsBias);
+    for (uint32_t j = 0; j < 37; j++) bias(j) = static_cast<float>(j) - 18.0f;
+
+    TensorMatmul::Epilogue<float> epilogue;
+    epilogue.bias = &bias;
+    epilogue.activation = TensorMatmul::Activation::ReLU;
+    auto C = TensorOps::matmul(A, B, epilogue);
+    auto plain = TensorMatmul::naivematmul2d(A, B);
+    for (uint32_t i = 0; i < 21; i++) {
+        for (uint32_t j = 0; j < 37; j++) {
+            ASSERT_FLOAT_EQ(C(i, j), std::max(plain(i, j) + bias(j), 0.0f));
+        }
+    }
+}
+
+TEST(MatmulTests, EpilogueScaleResidualGELUFloat){
+    std::array<uint32_t, 2> dimsA = {9, 16};
+    std::array<uint32_t, 2> dimsBt = {12, 16};
+    std::array<uint32_t, 2> dimsC = {9, 12};
+    Tensor<float, 2> A(dimsA);
+    Tensor<float, 2> Bt(dimsBt);
+    Tensor<float, 2> residual(dimsC);
+    for (uint64_t i = 0; i < A.Data.size(); i++) A.Data[i] = 0.01f * static_cast<float>(i % 11);
+    for (uint64_t i = 0; i < Bt.Data.size(); i++) Bt.Data[i] = 0.02f * static_cast<float>(i % 13) - 0.1f;
+    for (uint64_t i = 0; i < residual.Data.size(); i++) residual.Data[i] = 0.1f * static_cast<float>(i % 9) - 0.4f;
+
+    TensorMatmul::Epilogue<float> epilogue;
+    epilogue.scale = 0.5f;
+    epilogue.residual = &residual;
+    epilogue.activation = TensorMatmul::Activation::GELU;
+    auto C = TensorMatmul::matmul2d(A, Bt, TensorMatmul::Transpose::No, TensorMatmul::Transpose::Yes, epilogue);
+    for (uint32_t i = 0; i < 9; i++) {
+        for (uint32_t j = 0; j < 12; j++) {
+            float acc = 0.0f;
+            for (uint32_t k = 0; k < 16; k++) acc += A(i, k) * Bt(j, k);
+            float x = 0.5f * acc + residual(i, j);
+            float expected = 0.5f * x * (1.0f + std::tanh(0.7978845608f * (x + 0.044715f * x * x * x)));
+            ASSERT_NEAR(C(i, j), expected, 1e-5f);
+        }
+    }
+}
+
+TEST(MatmulTests, EpilogueIntegerPaths){
+    std::array<uint32_t, 2> dimsA = {10, 4};
+    std::array<uint32_t, 2> dimsB = {4, 40};
+    auto A = TensorOps::full<uint32_t, 2>(dimsA, 1);
+    auto B = TensorOps::full<uint32_t, 2>(dimsB, 1);
+    TensorMatmul::Epilogue<uint32_t> clamp;
+    clamp.scale = 3;
+    clamp.activation = TensorMatmul::Activation::ReLU6;
+    auto C = TensorOps::matmul(A, B, clamp);
+    for (uint32_t value : C.Data) {
+        ASSERT_EQ(value, 6);
+    }
+
+    auto A8 = TensorOps::zeroes<uint8_t, 2>(dimsA);
+    auto B8 = TensorOps::zeroes<uint8_t, 2>(dimsB);
+    std::array<uint32_t, 1> dimsBias = {40};
+    Tensor<uint8_t, 1> bias(dimsBias);
+    for (uint32_t j = 0; j < 40; j++) bias(j) = static_cast<uint8_t>(j);
+    TensorMatmul::Epilogue<uint8_t> sigmoid;
+    sigmoid.bias = &bias;
+    sigmoid.activation = TensorMatmul::Activation::Sigmoid;
+    auto C8 = TensorOps::matmul(A8, B8, sigmoid);
+    for (uint32_t i = 0; i < 10; i++) {
+        EXPECT_EQ(C8(i, 0), 0);   // sigmoid(0) = 0.5 rounds to even
+        EXPECT_EQ(C8(i, 39), 1);
+    }
+}
+
+TEST(MatmulTests, EpilogueWrongBiasSize){
+    std::array<uint32_t, 2> dims = {4, 4};
+    auto A = TensorOps::ones<float, 2>(dims);
+    std::array<uint32_t, 1> dimsBias = {3};
+    Tensor<float, 1> bias(dimsBias);
+    TensorMatmul::Epilogue<float> epilogue;
+    epilogue.bias = &bias;
+    EXPECT_DEATH({
+        TensorOps::matmul(A, A, epilogue);
+    }, "one value per output column");
+}
+
+TEST(MatmulTests, GenericNaiveMatmulDouble){
+    std::array<uint32_t, 2> dimsA = {7, 13};
+    std::array<uint32_t, 2> dimsB = {13, 9};
+    Tensor<double, 2> A(dimsA);
+    Tensor<double, 2> B(dimsB);
+    for (uint64_t i = 0; i < A.Data.size(); i++) A.Data[i] = static_cast<double>(i % 11) * 0.25 - 1.0;
+    for (uint64_t i = 0; i < B.Data.size(); i++) B.Data[i] = static_cast<double>(i % 6) + 0.5;
+    auto C = TensorMatmul::naivematmul2d(A, B);
+    for (uint32_t i = 0; i < 7; i++) {
+        for (uint32_t j = 0; j < 9; j++) {
+            double expected = 0.0;
+            for (uint32_t k = 0; k < 13; k++) expected += A(i, k) * B(k, j);
+            ASSERT_DOUBLE_EQ(C(i, j), expected);
+        }
+    }
+}
+
+TEST(MatmulTests, PackedWeightsMatchPlainGemm){
+    // Deeper than one KC block and wider than one NC block
+    std::array<uint32_t, 2> dimsA = {37, 300};
+    std::array<uint32_t, 2> dimsW = {300, 530};
+    Tensor<float, 2> A(dimsA);
+    Tensor<float, 2> W(dimsW);
+    for (uint64_t i = 0; i < A.Data.size(); i++) A.Data[i] = static_cast<float>(i % 9) * 0.25f - 1.0f;
+    for (uint64_t i = 0; i < W.Data.size(); i++) W.Data[i] = static_cast<float>(i % 13) * 0.125f - 0.75f;
+    std::array<uint32_t, 1> dimsBias = {530};
+    Tensor<float, 1> bias(dimsBias);
+    bias.fillWithValues(0.5f);
+    TensorMatmul::Epilogue<float> epilogue;
+    epilogue.bias = &bias;
+    epilogue.activation = TensorMatmul::Activation::ReLU;
+
+    PackedMatrix<float> packed(W);
+    EXPECT_EQ(packed.rows(), 300u);
+    EXPECT_EQ(packed.cols(), 530u);
+    auto expected = TensorOps::matmul(A, W, epilogue);
+    auto C = TensorOps::matmul(A, packed, epilogue);
+    for (uint64_t i = 0; i < C.Data.size(); i++) ASSERT_FLOAT_EQ(C.Data[i], expected.Data[i]) << "at " << i;
+    // Calls reuse the packing
+    auto again = TensorOps::matmul(A, packed, epilogue);
+    EXPECT_EQ(again.Data, C.Data);
+
+    // Weights stored as out x in, as linear layers keep them
+    auto Wt = TensorOps::transpose(W);
+    PackedMatrix<float> packedT(Wt, TensorMatmul::Transpose::Yes);
+    auto Ct = TensorOps::matmul(A, packedT);
+    auto plain = TensorOps::matmul(A, W, TensorMatmul::Transpose::No, TensorMatmul::Transpose::No);
+    for (uint64_t i = 0; i < Ct.Data.size(); i++) ASSERT_NEAR(Ct.Data[i], plain.Data[i], 1e-3f) << "at " << i;
+}
+
+TEST(MatmulTests, PackedWeightsHalfAndIntegers){
+    std::array<uint32_t, 2> dimsA = {10, 24};
+    std::array<uint32_t, 2> dimsW = {24, 19};
+    Tensor<float, 2> A(dimsA);
+    Tensor<float, 2> W(dimsW);
+    for (uint64_t i = 0; i < A.Data.size(); i++) A.Data[i] = static_cast<float>(i % 5) - 2.0f;
+    // Multiples of 1/8 below 8 are exact in half precision
+    for (uint64_t i = 0; i < W.Data.size(); i++) W.Data[i] = static_cast<float>(i % 17) * 0.125f;
+    PackedMatrix<float> native(W);
+    PackedMatrix<float> half(W, TensorMatmul::Transpose::No, TensorMatmul::PackedStorage::Half);
+    EXPECT_EQ(half.bytes() * 2, native.bytes());
+    EXPECT_EQ(TensorOps::matmul(A, half).Data, TensorOps::matmul(A, native).Data);
+
+    Tensor<uint16_t, 2> U(dimsA);
+    Tensor<uint16_t, 2> V(dimsW);
+    for (uint64_t i = 0; i < U.Data.size(); i++) U.Data[i] = static_cast<uint16_t>(i % 7);
+    for (uint64_t i = 0; i < V.Data.size(); i++) V.Data[i] = static_cast<uint16_t>(i % 11);
+    EXPECT_EQ(TensorOps::matmul(U, PackedMatrix<uint16_t>(V)).Data, TensorMatmul::naivematmul2d(U, V).Data);
+
+    std::array<uint32_t, 2> dimsWrong = {23, 10};
+    Tensor<float, 2> wrong(dimsWrong);
+    EXPECT_DEATH({ TensorOps::matmul(wrong, native); }, "matrices need to have shapes");
+}
+
+TEST(MatmulTests, StrassenPeelsOddDimensions){
+    // Every combination of odd and even M, N and K, two recursion levels deep, exact in integers
+    for (uint32_t mask = 0; mask < 8; mask++) {
+        uint32_t M = 40 + (mask & 1);
+        uint32_t N = 36 + ((mask >> 1) & 1);
+        uint32_t K = 44 + ((mask >> 2) & 1);
+        std::array<uint32_t, 2> dimsA = {M, N};
+        std::array<uint32_t, 2> dimsB = {N, K};
+        Tensor<uint32_t, 2> A(dimsA);
+        Tensor<uint32_t, 2> B(dimsB);
+        for (uint64_t i = 0; i < A.Data.size(); i++) A.Data[i] = static_cast<uint32_t>((i * 7) % 23);
+        for (uint64_t i = 0; i < B.Data.size(); i++) B.Data[i] = static_cast<uint32_t>((i * 5) % 19);
+        auto C = TensorMatmul::matmul2dStrassen(A, B, 0);
+        ASSERT_EQ(C.getDimensions()[0], M);
+        ASSERT_EQ(C.getDimensions()[1], K);
+        EXPECT_EQ(C.Data, TensorMatmul::naivematmul2d(A, B).Data) << "M " << M << " N " << N << " K " << K;
+    }
+}
+
+TEST(MatmulTests, StrassenIntoFixedWorkspace){
+    // A small leaf forces several levels, odd sizes exercise the peeling at each of them
+    uint32_t M = 45, N = 38, K = 51, leaf = 4;
+    std::array<uint32_t, 2> dimsA = {M, N};
+    std::array<uint32_t, 2> dimsB = {N, K};
+    std::array<uint32_t, 2> dimsC = {M, K};
+    Tensor<uint32_t, 2> A(dimsA);
+    Tensor<uint32_t, 2> B(dimsB);
+    for (uint64_t i = 0; i < A.Data.size(); i++) A.Data[i] = static_cast<uint32_t>((i * 7) % 23);
+    for (uint64_t i = 0; i < B.Data.size(); i++) B.Data[i] = static_cast<uint32_t>((i * 5) % 19);
+
+    uint64_t size = TensorMatmul::strassenWorkspaceSize(M, N, K, leaf);
+    EXPECT_LE(size, (static_cast<uint64_t>(M) * N + static_cast<uint64_t>(N) * K + static_cast<uint64_t>(M) * K) / 3);
+    std::vector<uint32_t> workspace(size + 16, 12345u);
+    Tensor<uint32_t, 2> C(dimsC, TensorUninitialized);
+    TensorMatmul::matmul2dStrassen(A, B, C, std::span<uint32_t>(workspace.data(), size), leaf);
+    EXPECT_EQ(C.Data, TensorMatmul::naivematmul2d(A, B).Data);
+    for (uint64_t i = size; i < workspace.size(); i++) ASSERT_EQ(workspace[i], 12345u);
+
+    // Square operands never need more than one operand worth of workspace
+    EXPECT_LE(TensorMatmul::strassenWorkspaceSize(4096, 4096, 4096), 4096ull * 4096);
+    EXPECT_EQ(TensorMatmul::strassenWorkspaceSize(200, 200, 200), 0u);
+
+    std::span<uint32_t> tooSmall(workspace.data(), size - 1);
+    EXPECT_DEATH({ TensorMatmul::matmul2dStrassen(A, B, C, tooSmall, leaf); }, "Workspace is smaller");
+}
+
+TEST(MatmulTests, StrassenIntoAcrossThreads){
+    uint64_t saved = TensorParallel::elementwiseThreshold();
+    TensorParallel::setElementwiseThreshold(1 << 8);
+    std::array<uint32_t, 2> dims = {161, 161};
+    Tensor<float, 2> A(dims);
+    Tensor<float, 2> B(dims);
+    for (uint64_t i = 0; i < A.Data.size(); i++) A.Data[i] = static_cast<float>(i % 13) / 13.0f;
+    for (uint64_t i = 0; i < B.Data.size(); i++) B.Data[i] = static_cast<float>(i % 17) / 17.0f - 0.5f;
+    Tensor<float, 2> C(dims, TensorUninitialized);
+    TensorMatmul::matmul2dStrassen(A, B, C, 32);
+    TensorParallel::setElementwiseThreshold(saved);
+    auto expected = TensorMatmul::naivematmul2d(A, B);
+    for (uint64_t i = 0; i < C.Data.size(); i++) ASSERT_NEAR(C.Data[i], expected.Data[i], 1e-3f);
+}
+
+TEST(MatmulTests, MortonLayoutRoundTrip){
+    std::array<uint32_t, 2> dims = {37, 70};
+    Tensor<uint16_t, 2> A(dims);
+    for (uint64_t i = 0; i < A.Data.size(); i++) A.Data[i] = static_cast<uint16_t>(i);
+    MortonMatrix<uint16_t> morton(A, 16);
+    EXPECT_EQ(morton.levels(), 3u);
+    EXPECT_EQ(morton.side(), 8u);
+    EXPECT_EQ(morton(36, 69), A(36, 69));
+    // Tile (1, 2) is the sixth tile in Z order, its rows follow each other
+    EXPECT_EQ(MortonMatrix<uint16_t>::index(1, 2), 6u);
+    EXPECT_EQ(morton.data()[6 * 256 + 17], A(17, 33));
+    EXPECT_EQ(morton.toTensor().Data, A.Data);
+    EXPECT_DEATH({ MortonMatrix<uint16_t>(A, 16, 2); }, "does not cover the matrix");
+}
+
+TEST(MatmulTests, MortonMatmulBothAlgorithms){
+    uint32_t M = 50, N = 61, K = 29, tile = 8;
+    std::array<uint32_t, 2> dimsA = {M, N};
+    std::array<uint32_t, 2> dimsB = {N, K};
+    Tensor<uint32_t, 2> A(dimsA);
+    Tensor<uint32_t, 2> B(dimsB);
+    for (uint64_t i = 0; i < A.Data.size(); i++) A.Data[i] = static_cast<uint32_t>((i * 7) % 23);
+    for (uint64_t i = 0; i < B.Data.size(); i++) B.Data[i] = static_cast<uint32_t>((i * 5) % 19);
+    uint32_t levels = MortonMatrix<uint32_t>::levelsFor(std::max({M, N, K}), tile);
+    MortonMatrix<uint32_t> mortonA(A, tile, levels);
+    MortonMatrix<uint32_t> mortonB(B, tile, levels);
+    auto expected = TensorMatmul::naivematmul2d(A, B).Data;
+
+    auto recursive = TensorOps::matmul(mortonA, mortonB);
+    auto strassen = TensorOps::matmul(mortonA, mortonB, TensorMatmul::MortonAlgorithm::Strassen);
+    EXPECT_EQ(recursive.rows(), M);
+    EXPECT_EQ(recursive.cols(), K);
+    EXPECT_EQ(recursive.toTensor().Data, expected);
+    EXPECT_EQ(strassen.toTensor().Data, expected);
+    EXPECT_EQ(TensorMatmul::strassenWorkspaceSize(mortonA), 63u * 64);
+
+    MortonMatrix<uint32_t> coarse(B, 16);
+    EXPECT_DEATH({ TensorOps::matmul(mortonA, coarse); }, "must share the tile size");
+}
@@ -0,0 +1,204 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "Tensor/TensorModel.h"
+#include "Tensor/TensorOps.h"
+#include "test_patterns.h"
+
+using TensorMatmul::Activation;
+using TensorModel::Model;
+using TensorModel::Pool2DParams;
+
+static std::string modelPath(const char* name) {
+    return (std::filesystem::temp_directory_path() / name).string();
+}
+
+// y = x W^T + b for x [rows, in] and W [out, in]
+static Tensor<float, 2> linearReference(const Tensor<float, 2>& x, const Tensor<float, 2>& w, const Tensor<float, 1>& b) {
+    uint32_t rows = x.getDimensions()[0], in = x.getDimensions()[1], out = w.getDimensions()[0];
+    Tensor<float, 2> y({rows, out});
+    for (uint32_t r = 0; r < rows; r++) {
+        for (uint32_t o = 0; o < out; o++) {
+            float sum = b(o);
+            for (uint32_t k = 0; k < in; k++) sum += x(r, k) * w(o, k);
+            y(r, o) = sum;
+        }
+    }
+    return y;
+}
+
+// Max or average pool of an NCHW tensor, the average divides by the whole window
+static Tensor<float, 4> poolReference(const Tensor<float, 4>& x, const Pool2DParams& p, bool average) {
+    auto dims = x.getDimensions();
+    uint32_t outH = (dims[2] + 2 * p.padH - p.kernelH) / p.strideH + 1;
+    uint32_t outW = (dims[3] + 2 * p.padW - p.kernelW) / p.strideW + 1;
+    Tensor<float, 4> y({dims[0], dims[1], outH, outW});
+    for (uint32_t n = 0; n < dims[0]; n++) {
+        for (uint32_t c = 0; c < dims[1]; c++) {
+            for (uint32_t oh = 0; oh < outH; oh++) {
+                for (uint32_t ow = 0; ow < outW; ow++) {
+                    float value = average ? 0.0f : -std::numeric_limits<float>::infinity();
+                    for (uint32_t kh = 0; kh < p.kernelH; kh++) {
+                        for (uint32_t kw = 0; kw < p.kernelW; kw++) {
+                            int64_t h = static_cast<int64_t>(oh * p.strideH + kh) - p.padH;
+                            int64_t w = static_cast<int64_t>(ow * p.strideW + kw) - p.padW;
+                            if (h < 0 || w < 0 || h >= dims[2] || w >= dims[3]) continue;
+                            float v = x(n, c, static_cast<uint32_t>(h), static_cast<uint32_t>(w));
+                            value = average ? value + v : std::max(value, v);
+                        }
+                    }
+                    y(n, c, oh, ow) = average ? value / static_cast<float>(p.kernelH * p.kernelW) : value;
+                }
+            }
+        }
+    }
+    return y;
+}
+
+TEST(ModelTests, MlpMatchesReference) {
+    auto x = TestPatterns::tensor<2>({5, 24}, 1);
+    auto w1 = TestPatterns::tensor<2>({40, 24}, 2);
+    auto b1 = TestPatterns::tensor<1>({40}, 3);
+    auto gamma = TestPatterns::tensor<1>({40}, 4);
+    auto beta = TestPatterns::tensor<1>({40}, 5);
+    auto w2 = TestPatterns::tensor<2>({10, 40}, 6);
+    auto b2 = TestPatterns::tensor<1>({10}, 7);
+
+    Model model({5, 24});
+    model.linear(w1, &b1);
+    model.activation(Activation::ReLU);
+    model.layerNorm(gamma, beta);
+    model.linear(w2, &b2);
+    model.softmax();
+    ASSERT_EQ(model.layers().size(), 5u);
+    EXPECT_TRUE(model.layers()[1].fused);
+    EXPECT_EQ(model.layers()[0].activation, Activation::ReLU);
+    EXPECT_EQ(model.outputShape(), (TensorModel::Shape{5, 10}));
+    // Outputs of the first four layers share two halves of 5 x 40 floats
+    EXPECT_EQ(model.arenaSize(), 2u * 5 * 40);
+
+    Tensor<float, 2> output({5, 10});
+    model.run(x, output);
+
+    auto h = linearReference(x, w1, b1);
+    for (float& value : h.Data) value = std::max(value, 0.0f);
+    auto expected = TensorOps::softmax(linearReference(TensorOps::layerNorm(h, &gamma, &beta), w2, b2));
+    for (uint64_t i = 0; i < expected.Data.size(); i++) ASSERT_NEAR(output.Data[i], expected.Data[i], 1e-5f) << "at " << i;
+
+    ASSERT_EQ(model.timings().size(), 5u);
+    EXPECT_EQ(model.timings()[1], 0.0);
+    for (double ms : model.timings()) EXPECT_GE(ms, 0.0);
+    EXPECT_NE(model.profile().find("fused"), std::string::npos);
+}
+
+TEST(ModelTests, ConvNetSaveLoadRoundTrip) {
+    auto x = TestPatterns::tensor<4>({2, 3, 15, 16}, 1);
+    auto w1 = TestPatterns::tensor<4>({8, 3, 3, 3}, 2);
+    auto b1 = TestPatterns::tensor<1>({8}, 3);
+    auto gamma = TestPatterns::tensor<1>({8}, 4);
+    auto beta = TestPatterns::tensor<1>({8}, 5);
+    auto mean = TestPatterns::tensor<1>({8}, 6);
+    auto variance = TestPatterns::tensor<1>({8}, 7);
+    for (float& value : variance.Data) value = value * value + 0.5f;
+    auto w2 = TestPatterns::tensor<4>({6, 4, 3, 3}, 8);
+    auto w3 = TestPatterns::tensor<2>({4, 6 * 2 * 2}, 9);
+    auto b3 = TestPatterns::tensor<1>({4}, 10);
+
+    TensorConv::Conv2DParams same;
+    same.padH = same.padW = 1;
+    TensorConv::Conv2DParams grouped;
+    grouped.strideH = grouped.strideW = 2;
+    grouped.groups = 2;
+    Pool2DParams average{3, 3, 2, 2, 1, 1};
+
+    Model model({2, 3, 15, 16});
+    model.conv2d(w1, &b1, same);
+    model.batchNorm(gamma, beta, mean, variance);
+    model.activation(Activation::ReLU6);
+    model.maxPool2d();
+    model.conv2d(w2, nullptr, grouped);
+    model.avgPool2d(average);
+    model.linear(w3, &b3);
+    model.activation(Activation::Sigmoid);
+    // The activation after a batch norm runs on its own, the one after the last linear is fused
+    EXPECT_FALSE(model.layers()[2].fused);
+    EXPECT_TRUE(model.layers()[7].fused);
+    EXPECT_EQ(model.layers()[3].outputShape, (TensorModel::Shape{2, 8, 7, 8}));
+    EXPECT_EQ(model.layers()[4].outputShape, (TensorModel::Shape{2, 6, 3, 3}));
+    EXPECT_EQ(model.layers()[5].outputShape, (TensorModel::Shape{2, 6, 2, 2}));
+    ASSERT_EQ(model.outputShape(), (TensorModel::Shape{2, 4}));
+
+    Tensor<float, 2> output({2, 4});
+    model.run(x, output);
+
+    auto y = TensorOps::conv2d(x, w1, same, &b1);
+    auto dims = y.getDimensions();
+    for (uint32_t n = 0; n < dims[0]; n++)
+        for (uint32_t c = 0; c < dims[1]; c++)
+            for (uint32_t h = 0; h < dims[2]; h++)
+                for (uint32_t w = 0; w < dims[3]; w++) {
+                    float v = gamma(c) * (y(n, c, h, w) - mean(c)) / std::sqrt(variance(c) + 1e-5f) + beta(c);
+                    y(n, c, h, w) = std::min(std::max(v, 0.0f), 6.0f);
+                }
+    auto pooled = poolReference(TensorOps::conv2d(poolReference(y, Pool2DParams{}, false), w2, grouped), average, true);
+    Tensor<float, 2> flat({2, 24});
+    std::copy(pooled.Data.begin(), pooled.Data.end(), flat.Data.begin());
+    auto expected = linearReference(flat, w3, b3);
+    for (uint64_t i = 0; i < expected.Data.size(); i++) {
+        float sigmoid = 1.0f / (1.0f + std::exp(-expected.Data[i]));
+        ASSERT_NEAR(output.Data[i], sigmoid, 1e-4f) << "at " << i;
+    }
+
+    std::string path = modelPath("deeppi_test_convnet.dpmd");
+    model.save(path);
+    Model loaded = Model::load(path);
+    std::filesystem::remove(path);
+    ASSERT_EQ(loaded.layers().size(), model.layers().size());
+    for (uint64_t i = 0; i < model.layers().size(); i++) {
+        EXPECT_EQ(loaded.layers()[i].kind, model.layers()[i].kind);
+        EXPECT_EQ(loaded.layers()[i].outputShape, model.layers()[i].outputShape);
+        EXPECT_EQ(loaded.layers()[i].fused, model.layers()[i].fused);
+    }
+    Tensor<float, 2> reloaded({2, 4});
+    loaded.run(x, reloaded);
+    EXPECT_EQ(reloaded.Data, output.Data);
+}
+
+TEST(ModelTests, LoadRejectsMalformedFiles) {
+    std::string path = modelPath("deeppi_test_malformed.dpmd");
+    EXPECT_THROW(Model::load(path + ".missing"), std::runtime_error);
+
+    {
+        std::ofstream file(path, std::ios::binary);
+        file << "NOPE";
+    }
+    EXPECT_THROW(Model::load(path), std::runtime_error);
+
+    // A valid model cut inside its weights
+    Model model({3, 8});
+    model.linear(TestPatterns::tensor<2>({6, 8}, 1));
+    model.save(path);
+    std::filesystem::resize_file(path, std::filesystem::file_size(path) - 4);
+    EXPECT_THROW(Model::load(path), std::runtime_error);
+
+    // Weights that do not fit the input declared in the file
+    Model other({3, 5});
+    other.linear(TestPatterns::tensor<2>({6, 5}, 1));
+    other.save(path);
+    {
+        std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+        uint32_t features = 8;
+        file.seekp(4 + 4 + 4 + 4);
+        file.write(reinterpret_cast<const char*>(&features), sizeof(features));
+    }
+    EXPECT_THROW(Model::load(path), std::runtime_error);
+    std::filesystem::remove(path);
+}
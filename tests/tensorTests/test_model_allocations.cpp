@@ -0,0 +1,124 @@
+#include <gtest/gtest.h>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Tensor/TensorModel.h"
+#include "Tensor/TensorParallel.h"
+#include "test_patterns.h"
+
+// Built as its own executable, the operator new below replaces the allocator of this binary only
+namespace {
+    std::atomic<bool> countingAllocations{false};
+    std::atomic<uint64_t> allocations{0};
+
+    // Counts the allocations of every thread while alive
+    struct AllocationCounter {
+        AllocationCounter() {
+            allocations.store(0);
+            countingAllocations.store(true);
+        }
+        ~AllocationCounter() { countingAllocations.store(false); }
+        uint64_t count() const { return allocations.load(); }
+    };
+};
+
+// Not inlined, so that the compiler does not pair the malloc inside with the library's sized delete
+[[gnu::noinline]] void* operator new(std::size_t size) {
+    if (countingAllocations.load(std::memory_order_relaxed)) allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size == 0 ? 1 : size)) return p;
+    throw std::bad_alloc();
+}
+
+[[gnu::noinline]] void operator delete(void* p) noexcept { std::free(p); }
+[[gnu::noinline]] void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+TEST(ModelTests, RunDoesNotAllocate) {
+    using TensorModel::Model;
+    auto w1 = TestPatterns::tensor<4>({4, 2, 3, 3}, 1);
+    auto w2 = TestPatterns::tensor<2>({12, 4 * 4 * 4}, 2);
+    auto b2 = TestPatterns::tensor<1>({12}, 3);
+    auto gamma = TestPatterns::tensor<1>({12}, 4);
+    auto beta = TestPatterns::tensor<1>({12}, 5);
+    Model built({1, 2, 10, 10});
+    built.conv2d(w1);
+    built.activation(TensorMatmul::Activation::GELU);
+    built.maxPool2d();
+    built.linear(w2, &b2);
+    built.layerNorm(gamma, beta);
+    built.activation(TensorMatmul::Activation::ReLU);
+    built.softmax();
+
+    std::string path = (std::filesystem::temp_directory_path() / "deeppi_test_allocations.dpmd").string();
+    built.save(path);
+    Model model = Model::load(path);
+    std::filesystem::remove(path);
+
+    auto x = TestPatterns::tensor<4>({1, 2, 10, 10}, 6);
+    Tensor<float, 2> output({1, 12});
+    {
+        AllocationCounter counter;
+        for (int i = 0; i < 3; i++) model.run(x, output);
+        EXPECT_EQ(counter.count(), 0u);
+    }
+
+    float sum = 0.0f;
+    for (float value : output.Data) sum += value;
+    EXPECT_NEAR(sum, 1.0f, 1e-5f);
+}
+
+TEST(ModelTests, ParallelRunDoesNotAllocate) {
+    using TensorModel::Model;
+    // Four workers and no elementwise threshold send every kernel down its parallel path, whatever the host
+    TensorParallel::ThreadConfig config;
+    config.cores = {0, 0, 0, 0};
+    config.pinWorkers = false;
+    TensorParallel::configure(config);
+    uint64_t savedThreshold = TensorParallel::elementwiseThreshold();
+    TensorParallel::setElementwiseThreshold(0);
+
+    // About 37M multiply-adds in the convolution and 33M in the linear layer, far above Gemm::ParallelWorkThreshold
+    auto w1 = TestPatterns::tensor<4>({32, 16, 3, 3}, 1);
+    auto b1 = TestPatterns::tensor<1>({32}, 2);
+    auto w2 = TestPatterns::tensor<2>({512, 32 * 16 * 16}, 3);
+    auto gamma = TestPatterns::tensor<1>({512}, 4);
+    auto beta = TestPatterns::tensor<1>({512}, 5);
+    TensorConv::Conv2DParams same;
+    same.padH = same.padW = 1;
+    Model model({8, 16, 32, 32});
+    model.conv2d(w1, &b1, same);
+    model.activation(TensorMatmul::Activation::ReLU);
+    model.maxPool2d();
+    model.linear(w2);
+    model.layerNorm(gamma, beta);
+    model.softmax();
+    model.warmUp();
+
+    auto x = TestPatterns::tensor<4>({8, 16, 32, 32}, 6);
+    Tensor<float, 2> output({8, 512});
+    Tensor<float, 2> otherOutput({8, 512});
+    // Started before counting, creating a thread allocates
+    std::atomic<int> phase{0};
+    std::thread other([&]() {
+        while (phase.load() != 1) std::this_thread::yield();
+        model.run(x, otherOutput);
+        phase.store(2);
+    });
+    {
+        AllocationCounter counter;
+        for (int i = 0; i < 2; i++) model.run(x, output);
+        // A thread that never ran the model uses the model's scratch, not buffers of its own
+        phase.store(1);
+        while (phase.load() != 2) std::this_thread::yield();
+        EXPECT_EQ(counter.count(), 0u);
+    }
+    other.join();
+    EXPECT_EQ(otherOutput.Data, output.Data);
+    TensorParallel::setElementwiseThreshold(savedThreshold);
+    TensorParallel::resetConfiguration();
+}
@@ -0,0 +1,130 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+#include "Tensor/TensorOps.h"
+
+static Tensor<float, 2> patternRows(uint32_t rows, uint32_t cols, float offset, float scale) {
+    std::array<uint32_t, 2> dims = {rows, cols};
+    Tensor<float, 2> tensor(dims);
+    for (uint64_t i = 0; i < tensor.Data.size(); i++) {
+        tensor.Data[i] = offset + scale * static_cast<float>((i * 37 + 11) % 23) - scale * 11.0f;
+    }
+    return tensor;
+}
+
+static std::vector<double> referenceSoftmax(const float* row, uint32_t cols, bool log) {
+    double max = *std::max_element(row, row + cols);
+    double sum = 0;
+    for (uint32_t c = 0; c < cols; c++) sum += std::exp(row[c] - max);
+    std::vector<double> out(cols);
+    for (uint32_t c = 0; c < cols; c++) out[c] = log ? row[c] - max - std::log(sum) : std::exp(row[c] - max) / sum;
+    return out;
+}
+
+TEST(NormTests, SoftmaxMatchesReference) {
+    // Row lengths below one vector, with a tail, and long enough for the 16 wide blocks
+    for (uint32_t cols : {1u, 3u, 16u, 37u, 100u}) {
+        auto input = patternRows(5, cols, 1000.0f, 0.75f);
+        auto soft = TensorOps::softmax(input);
+        auto logSoft = TensorOps::logSoftmax(input);
+        for (uint32_t r = 0; r < 5; r++) {
+            auto expected = referenceSoftmax(&input(r, 0), cols, false);
+            auto expectedLog = referenceSoftmax(&input(r, 0), cols, true);
+            double total = 0;
+            for (uint32_t c = 0; c < cols; c++) {
+                ASSERT_NEAR(soft(r, c), expected[c], 1e-6) << cols << " " << r << " " << c;
+                ASSERT_NEAR(logSoft(r, c), expectedLog[c], 1e-4) << cols << " " << r << " " << c;
+                total += soft(r, c);
+            }
+            EXPECT_NEAR(total, 1.0, 1e-5);
+        }
+    }
+}
+
+TEST(NormTests, SoftmaxIncreasingRowRescalesSum) {
+    // The max grows in every block, so the running sum is rescaled many times
+    std::array<uint32_t, 2> dims = {1, 200};
+    Tensor<float, 2> input(dims);
+    for (uint32_t c = 0; c < 200; c++) input(0, c) = 0.5f * static_cast<float>(c);
+    auto soft = TensorOps::softmax(input);
+    auto expected = referenceSoftmax(&input(0, 0), 200, false);
+    for (uint32_t c = 0; c < 200; c++) {
+        ASSERT_NEAR(soft(0, c), expected[c], 1e-6) << c;
+    }
+}
+
+TEST(NormTests, LayerNormWithLargeMean) {
+    uint32_t cols = 45;
+    auto input = patternRows(7, cols, 5000.0f, 0.5f);
+    std::array<uint32_t, 1> paramDims = {cols};
+    Tensor<float, 1> gamma(paramDims), beta(paramDims);
+    for (uint32_t c = 0; c < cols; c++) {
+        gamma(c) = 0.5f + 0.1f * static_cast<float>(c % 5);
+        beta(c) = static_cast<float>(c % 3) - 1.0f;
+    }
+    auto output = TensorOps::layerNorm(input, &gamma, &beta);
+    for (uint32_t r = 0; r < 7; r++) {
+        double mean = 0, var = 0;
+        for (uint32_t c = 0; c < cols; c++) mean += input(r, c);
+        mean /= cols;
+        for (uint32_t c = 0; c < cols; c++) var += (input(r, c) - mean) * (input(r, c) - mean);
+        var /= cols;
+        for (uint32_t c = 0; c < cols; c++) {
+            double expected = (input(r, c) - mean) / std::sqrt(var + 1e-5) * gamma(c) + beta(c);
+            ASSERT_NEAR(output(r, c), expected, 1e-4) << r << " " << c;
+        }
+    }
+}
+
+TEST(NormTests, RmsNorm) {
+    uint32_t cols = 29;
+    auto input = patternRows(4, cols, 0.0f, 0.3f);
+    std::array<uint32_t, 1> paramDims = {cols};
+    Tensor<float, 1> gamma(paramDims);
+    for (uint32_t c = 0; c < cols; c++) gamma(c) = 1.0f + 0.05f * static_cast<float>(c);
+    auto output = TensorOps::rmsNorm(input, &gamma);
+    auto unscaled = TensorOps::rmsNorm(input);
+    for (uint32_t r = 0; r < 4; r++) {
+        double squares = 0;
+        for (uint32_t c = 0; c < cols; c++) squares += static_cast<double>(input(r, c)) * input(r, c);
+        double invRms = 1.0 / std::sqrt(squares / cols + 1e-6);
+        for (uint32_t c = 0; c < cols; c++) {
+            ASSERT_NEAR(output(r, c), input(r, c) * invRms * gamma(c), 1e-5) << r << " " << c;
+            ASSERT_NEAR(unscaled(r, c), input(r, c) * invRms, 1e-5) << r << " " << c;
+        }
+    }
+}
+
+TEST(NormTests, LastAxisOfHigherRankInPlace) {
+    std::array<uint32_t, 3> dims = {3, 4, 10};
+    Tensor<float, 3> input(dims);
+    for (uint64_t i = 0; i < input.Data.size(); i++) input.Data[i] = static_cast<float>(i % 13) * 0.25f;
+    auto expected = TensorOps::softmax(input);
+    TensorOps::softmax(input, input);
+    EXPECT_EQ(input.Data, expected.Data);
+    float total = 0;
+    for (uint32_t c = 0; c < 10; c++) total += input(2, 1, c);
+    EXPECT_NEAR(total, 1.0f, 1e-5f);
+}
+
+TEST(NormTests, ManyRowsSplitAcrossThreads) {
+    auto input = patternRows(2000, 64, 0.0f, 1.0f);
+    auto output = TensorOps::layerNorm(input);
+    for (uint32_t r = 0; r < 2000; r += 199) {
+        double mean = 0;
+        for (uint32_t c = 0; c < 64; c++) mean += output(r, c);
+        EXPECT_NEAR(mean / 64, 0.0, 1e-5);
+    }
+}
+
+TEST(NormTests, WrongGammaSize) {
+    auto input = patternRows(2, 8, 0.0f, 1.0f);
+    std::array<uint32_t, 1> paramDims = {7};
+    Tensor<float, 1> gamma(paramDims);
+    EXPECT_DEATH({
+        TensorOps::rmsNorm(input, &gamma);
+    }, "Gamma must have one value per element of the last axis");
+}
@@ -0,0 +1,237 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <pthread.h>
+#include <sched.h>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Tensor/Tensor.h"
+#include "Tensor/TensorMatmul.h"
+#include "Tensor/TensorParallel.h"
+
+// Restores the default elementwise threshold when a test ends
+struct ThresholdGuard {
+    uint64_t saved = TensorParallel::elementwiseThreshold();
+    ~ThresholdGuard() { TensorParallel::setElementwiseThreshold(saved); }
+};
+
+TEST(ParallelTests, ParallelForCoversRangeOnce) {
+    std::vector<std::atomic<int>> hits(100003);
+    TensorParallel::parallelFor(3, hits.size(), 1000, [&](uint64_t begin, uint64_t end) {
+        for (uint64_t i = begin; i < end; i++) hits[i]++;
+    });
+    for (uint64_t i = 0; i < hits.size(); i++) ASSERT_EQ(hits[i].load(), i < 3 ? 0 : 1) << "at " << i;
+}
+
+TEST(ParallelTests, NestedAndConcurrentLoops) {
+    // Loops started inside a task run inline, loops from other threads run on their own thread while the pool is busy
+    std::atomic<uint64_t> total{0};
+    auto work = [&]() {
+        TensorParallel::parallelFor(0, 64, 1, [&](uint64_t begin, uint64_t end) {
+            for (uint64_t i = begin; i < end; i++) {
+                TensorParallel::parallelFor(0, 1000, 10, [&](uint64_t innerBegin, uint64_t innerEnd) {
+                    total += innerEnd - innerBegin;
+                });
+            }
+        });
+    };
+    std::thread other(work);
+    work();
+    other.join();
+    EXPECT_EQ(total.load(), 2u * 64 * 1000);
+}
+
+TEST(ParallelTests, TaskExceptionReachesCaller) {
+    TensorParallel::ThreadPool workers(3);
+    std::atomic<int> started{0};
+    auto failing = [&](uint64_t index) {
+        started++;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        if (index == 5) throw std::runtime_error("task failed");
+    };
+    EXPECT_THROW(workers.run(64, failing), std::runtime_error);
+    // Tasks claimed after the failure are skipped
+    EXPECT_LT(started.load(), 64);
+
+    // The pool is released, so the next loop from the same thread is handed out to the workers again
+    std::mutex mutex;
+    std::set<std::thread::id> threads;
+    std::atomic<int> done{0};
+    auto counting = [&](uint64_t) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            threads.insert(std::this_thread::get_id());
+        }
+        done++;
+    };
+    workers.run(64, counting);
+    EXPECT_EQ(done.load(), 64);
+    EXPECT_GT(threads.size(), 1u);
+}
+
+TEST(ParallelTests, BroadcastRunsOnEveryThread) {
+    TensorParallel::ThreadPool workers(3);
+    std::mutex mutex;
+    std::vector<std::thread::id> threads;
+    auto record = [&]() {
+        std::lock_guard<std::mutex> lock(mutex);
+        threads.push_back(std::this_thread::get_id());
+    };
+    workers.broadcast(record);
+    // Three workers and the calling thread, each exactly once
+    std::set<std::thread::id> distinct(threads.begin(), threads.end());
+    EXPECT_EQ(threads.size(), 4u);
+    EXPECT_EQ(distinct.size(), 4u);
+    EXPECT_EQ(distinct.count(std::this_thread::get_id()), 1u);
+}
+
+TEST(ParallelTests, ElementwiseThreshold) {
+    ThresholdGuard guard;
+    std::thread::id caller = std::this_thread::get_id();
+    std::atomic<bool> offCaller{false};
+    auto record = [&](uint64_t, uint64_t) {
+        if (std::this_thread::get_id() != caller) offCaller = true;
+    };
+    // Below the threshold everything runs on the calling thread, in a single call
+    TensorParallel::setElementwiseThreshold(1 << 30);
+    std::atomic<int> calls{0};
+    TensorParallel::parallelElementwise(1 << 20, [&](uint64_t begin, uint64_t end) {
+        calls++;
+        record(begin, end);
+        EXPECT_EQ(begin, 0u);
+        EXPECT_EQ(end, 1u << 20);
+    });
+    EXPECT_EQ(calls.load(), 1);
+    EXPECT_FALSE(offCaller.load());
+
+    // Above it the range is cut into cache-sized chunks
+    TensorParallel::setElementwiseThreshold(0);
+    calls = 0;
+    uint64_t size = 5 * TensorParallel::ElementwiseChunk + 17;
+    std::vector<std::atomic<int>> hits(size);
+    TensorParallel::parallelElementwise(size, [&](uint64_t begin, uint64_t end) {
+        calls++;
+        EXPECT_LE(end - begin, TensorParallel::ElementwiseChunk);
+        for (uint64_t i = begin; i < end; i++) hits[i]++;
+    });
+    EXPECT_EQ(calls.load(), 6);
+    for (uint64_t i = 0; i < size; i++) ASSERT_EQ(hits[i].load(), 1) << "at " << i;
+}
+
+TEST(ParallelTests, LargeElementwiseOperators) {
+    ThresholdGuard guard;
+    TensorParallel::setElementwiseThreshold(1 << 16);
+    std::array<uint32_t, 2> dims = {513, 1031};
+    Tensor<float, 2> A(dims, TensorUninitialized);
+    Tensor<float, 2> B(dims, TensorUninitialized);
+    Tensor<uint8_t, 2> U(dims, TensorUninitialized);
+    Tensor<uint8_t, 2> V(dims, TensorUninitialized);
+    for (uint64_t i = 0; i < A.Data.size(); i++) {
+        A.Data[i] = static_cast<float>(i % 1000);
+        B.Data[i] = static_cast<float>(i % 7) * 0.5f;
+        U.Data[i] = static_cast<uint8_t>(i * 3);
+        V.Data[i] = static_cast<uint8_t>(i);
+    }
+    auto sum = A + B;
+    auto difference = A - B;
+    auto wrapped = U - V;
+    for (uint64_t i = 0; i < A.Data.size(); i++) {
+        ASSERT_EQ(sum.Data[i], A.Data[i] + B.Data[i]) << "at " << i;
+        ASSERT_EQ(difference.Data[i], A.Data[i] - B.Data[i]) << "at " << i;
+        ASSERT_EQ(wrapped.Data[i], static_cast<uint8_t>(U.Data[i] - V.Data[i])) << "at " << i;
+    }
+    // Above the threshold the zeroing constructor clears the storage chunk by chunk across the pool
+    Tensor<float, 2> zeros(dims);
+    Tensor<double, 2> doubleZeros(dims);
+    for (float value : zeros.Data) ASSERT_EQ(value, 0.0f);
+    for (double value : doubleZeros.Data) ASSERT_EQ(value, 0.0);
+    Tensor<uint16_t, 2> filled(dims, TensorUninitialized);
+    filled.fillWithValues(static_cast<uint16_t>(77));
+    for (uint16_t value : filled.Data) ASSERT_EQ(value, 77);
+}
+
+// Writes a fake sysfs cpu directory describing a board with four big and four LITTLE cores
+static std::string fakeSysfs(bool withCapacity) {
+    std::string root = std::filesystem::temp_directory_path() / ("deeppi_sysfs_" + std::to_string(withCapacity));
+    std::filesystem::remove_all(root);
+    for (unsigned cpu = 0; cpu < 8; cpu++) {
+        std::string dir = root + "/cpu" + std::to_string(cpu);
+        std::filesystem::create_directories(dir + "/cpufreq");
+        bool big = cpu >= 4;
+        if (withCapacity) std::ofstream(dir + "/cpu_capacity") << (big ? 1024 : 414) << "\n";
+        std::ofstream(dir + "/cpufreq/cpuinfo_max_freq") << (big ? 2400000 : 1800000) << "\n";
+    }
+    std::ofstream(root + "/online") << "0-3,4-7\n";
+    return root;
+}
+
+TEST(ParallelTests, DetectsBigLittleClusters) {
+    std::string withCapacity = fakeSysfs(true);
+    std::string withFrequencies = fakeSysfs(false);
+    auto cores = TensorParallel::detectCores(withCapacity);
+    ASSERT_EQ(cores.size(), 8u);
+    for (unsigned cpu = 0; cpu < 8; cpu++) {
+        EXPECT_EQ(cores[cpu].id, cpu);
+        EXPECT_EQ(cores[cpu].capacity, cpu >= 4 ? 1024u : 414u);
+        EXPECT_EQ(cores[cpu].cluster, cpu >= 4 ? 0u : 1u);
+    }
+    // Without cpu_capacity the maximum frequencies give the ratio
+    cores = TensorParallel::detectCores(withFrequencies);
+    EXPECT_EQ(cores[0].capacity, 768u);
+    EXPECT_EQ(cores[7].capacity, 1024u);
+    EXPECT_EQ(cores[0].cluster, 1u);
+    std::filesystem::remove_all(withCapacity);
+    std::filesystem::remove_all(withFrequencies);
+}
+
+// Restores the affinity the calling thread had when a test started
+struct AffinityGuard {
+    cpu_set_t saved;
+    AffinityGuard() { pthread_getaffinity_np(pthread_self(), sizeof(saved), &saved); }
+    ~AffinityGuard() { pthread_setaffinity_np(pthread_self(), sizeof(saved), &saved); }
+
+    // First core the thread may run on, which is not necessarily core 0 in a restricted cpuset
+    unsigned firstCore() const {
+        for (unsigned core = 0; core < CPU_SETSIZE; core++)
+            if (CPU_ISSET(core, &saved)) return core;
+        return 0;
+    }
+};
+
+TEST(ParallelTests, ConfiguredCores) {
+    AffinityGuard affinity;
+    unsigned core = affinity.firstCore();
+    EXPECT_TRUE(TensorParallel::pinCurrentThread(core));
+    // Cores that are not in sysfs count as full-speed cores, pinning to them just fails
+    TensorParallel::ThreadConfig config;
+    config.cores = {core, core, core};
+    TensorParallel::configure(config);
+    EXPECT_EQ(TensorParallel::workerCount(), 3u);
+    EXPECT_EQ(TensorParallel::pool().size(), 2u);
+    std::vector<std::atomic<int>> hits(30000);
+    TensorParallel::parallelFor(0, hits.size(), 1000, [&](uint64_t begin, uint64_t end) {
+        for (uint64_t i = begin; i < end; i++) hits[i]++;
+    });
+    for (uint64_t i = 0; i < hits.size(); i++) ASSERT_EQ(hits[i].load(), 1) << "at " << i;
+
+    Tensor<float, 2> A({70, 90});
+    Tensor<float, 2> B({90, 50});
+    A.fillWithValues(0.5f);
+    B.fillWithValues(2.0f);
+    auto C = TensorMatmul::matmul2dStrassen(A, B, 0);
+    for (float value : C.Data) ASSERT_FLOAT_EQ(value, 90.0f);
+
+    // Later tests run on the default pool again
+    TensorParallel::resetConfiguration();
+    unsigned hardware = std::thread::hardware_concurrency();
+    EXPECT_EQ(TensorParallel::workerCount(), hardware == 0 ? 1u : hardware);
+    EXPECT_EQ(TensorParallel::pool().size(), TensorParallel::workerCount() - 1);
+}
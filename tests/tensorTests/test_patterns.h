@@ -0,0 +1,27 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <vector>
+#include "Tensor/Tensor.h"
+
+// Deterministic test inputs shared by the test files, different seeds give differently shifted sequences
+namespace TestPatterns {
+    // Element i of a pattern, multiples of 1/16 in [-0.5, 0.5]
+    inline float value(uint64_t i, uint32_t seed) {
+        return static_cast<float>((i * 13 + seed * 7 + 3) % 17) * 0.0625f - 0.5f;
+    }
+
+    inline std::vector<float> values(uint64_t size, uint32_t seed) {
+        std::vector<float> result(size);
+        for (uint64_t i = 0; i < size; i++) result[i] = value(i, seed);
+        return result;
+    }
+
+    template <uint16_t N>
+    Tensor<float, N> tensor(const std::array<uint32_t, N>& dims, uint32_t seed) {
+        Tensor<float, N> result(dims, TensorUninitialized);
+        for (uint64_t i = 0; i < result.Data.size(); i++) result.Data[i] = value(i, seed);
+        return result;
+    }
+};
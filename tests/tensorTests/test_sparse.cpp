@@ -0,0 +1,144 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include "Tensor/SparseTensor.h"
+#include "Tensor/TensorParallel.h"
+#include "Tensor/TensorOps.h"
+#include "test_patterns.h"
+
+// Dense matrix where roughly one element in density is nonzero, the rest are small values below the pruning threshold
+static Tensor<float, 2> prunedPattern(uint32_t rows, uint32_t cols, uint32_t density, uint32_t seed) {
+    Tensor<float, 2> dense({rows, cols});
+    for (uint64_t i = 0; i < dense.Data.size(); i++) {
+        uint64_t h = (i * 2654435761u + seed * 40503u) % 1009;
+        dense.Data[i] = h % density == 0 ? static_cast<float>(h % 23) * 0.25f - 2.75f : 1e-4f;
+    }
+    return dense;
+}
+
+// Pruned copy of dense, the reference the sparse kernels must reproduce
+static Tensor<float, 2> pruned(const Tensor<float, 2>& dense, float threshold) {
+    Tensor<float, 2> result = dense;
+    for (float& value : result.Data) {
+        if (std::fabs(value) <= threshold) value = 0.0f;
+    }
+    return result;
+}
+
+static void expectSparseProducts(uint32_t rows, uint32_t cols, uint32_t blockRows, uint32_t blockCols, uint32_t density) {
+    auto dense = prunedPattern(rows, cols, density, rows + cols);
+    auto reference = pruned(dense, 1e-3f);
+    auto sparse = SparseTensor<float>::fromDense(dense, 1e-3f, blockRows, blockCols);
+    ASSERT_EQ(sparse.toDense().Data, reference.Data) << blockRows << "x" << blockCols;
+
+    Tensor<float, 1> x({cols});
+    for (uint32_t j = 0; j < cols; j++) x(j) = static_cast<float>(j % 9) * 0.5f - 2.0f;
+    auto y = TensorOps::matmul(sparse, x);
+    for (uint32_t i = 0; i < rows; i++) {
+        float expected = 0.0f;
+        for (uint32_t j = 0; j < cols; j++) expected += reference(i, j) * x(j);
+        ASSERT_NEAR(y(i), expected, 1e-3f) << blockRows << "x" << blockCols << " row " << i;
+    }
+
+    for (uint32_t K : {1u, 7u, 24u}) {
+        auto B = TestPatterns::tensor<2>({cols, K}, K);
+        auto C = TensorOps::matmul(sparse, B);
+        auto expected = TensorOps::matmul(reference, B);
+        ASSERT_EQ(C.getDimensions(), expected.getDimensions());
+        for (uint64_t i = 0; i < C.Data.size(); i++) {
+            ASSERT_NEAR(C.Data[i], expected.Data[i], 1e-3f) << blockRows << "x" << blockCols << " K " << K << " at " << i;
+        }
+    }
+}
+
+TEST(SparseTests, FromDenseKeepsValuesAboveThreshold) {
+    Tensor<float, 2> dense({3, 5});
+    dense(0, 1) = 2.0f;
+    dense(1, 4) = -3.0f;
+    dense(2, 0) = 0.01f;
+    dense(2, 2) = 1.0f;
+    auto csr = SparseTensor<float>::fromDense(dense, 0.1f);
+    EXPECT_EQ(csr.RowPointers, (std::vector<uint64_t>{0, 1, 2, 3}));
+    EXPECT_EQ(csr.ColumnIndices, (std::vector<uint32_t>{1, 4, 2}));
+    EXPECT_EQ(csr.Values, (std::vector<float>{2.0f, -3.0f, 1.0f}));
+
+    // 1x4 blocks over 5 columns, the block reaching past the last column is padded with zeros
+    auto bsr = SparseTensor<float>::fromDense(dense, 0.1f, 1, 4);
+    EXPECT_EQ(bsr.blockColCount(), 2u);
+    EXPECT_EQ(bsr.ColumnIndices, (std::vector<uint32_t>{0, 1, 0}));
+    EXPECT_EQ(bsr.Values, (std::vector<float>{0, 2, 0, 0, -3, 0, 0, 0, 0, 0, 1, 0}));
+    EXPECT_EQ(bsr.storedValues(), 12u);
+}
+
+TEST(SparseTests, CsrArrays) {
+    // Laplacian of a path graph with 4 nodes
+    SparseTensor<float> laplacian({4, 4}, {0, 2, 5, 8, 10}, {0, 1, 0, 1, 2, 1, 2, 3, 2, 3},
+                                  {1, -1, -1, 2, -1, -1, 2, -1, -1, 1});
+    Tensor<float, 1> x({4});
+    x.fillWithValues(3.0f);
+    auto y = TensorOps::matmul(laplacian, x);
+    for (uint32_t i = 0; i < 4; i++) EXPECT_EQ(y(i), 0.0f);
+    x(3) = 5.0f;
+    y = TensorOps::matmul(laplacian, x);
+    EXPECT_EQ(y(2), -2.0f);
+    EXPECT_EQ(y(3), 2.0f);
+
+    using Sparse = SparseTensor<float>;
+    EXPECT_DEATH({
+        Sparse bad({4, 4}, {0, 1, 2, 3}, {0, 1, 2}, {1, 1, 1});
+    }, "Sparse tensor needs one row pointer per block row plus one");
+    EXPECT_DEATH({
+        Sparse bad({2, 2}, {0, 1, 2}, {0, 2}, {1, 1});
+    }, "Sparse column index out of bounds");
+}
+
+TEST(SparseTests, ProductsForEveryBlockShape) {
+    for (auto [blockRows, blockCols] : std::vector<std::pair<uint32_t, uint32_t>>{{1, 1}, {1, 4}, {4, 1}, {2, 3}}) {
+        expectSparseProducts(37, 45, blockRows, blockCols, 7);
+        expectSparseProducts(16, 16, blockRows, blockCols, 3);
+    }
+    // Rows without any stored value
+    expectSparseProducts(30, 10, 1, 1, 40);
+}
+
+TEST(SparseTests, LargeProductsRunInParallel) {
+    expectSparseProducts(700, 600, 1, 1, 5);
+    expectSparseProducts(700, 600, 4, 1, 5);
+}
+
+TEST(SparseTests, WideProductsRunInParallel) {
+    // Too few stored values to split a SpMV, but times 1024 dense columns enough work for every worker
+    TensorParallel::ThreadConfig config;
+    config.cores = {0, 0, 0, 0};
+    config.pinWorkers = false;
+    TensorParallel::configure(config);
+    auto dense = prunedPattern(256, 160, 5, 1);
+    auto sparse = SparseTensor<float>::fromDense(dense, 1e-3f, 4, 1);
+    ASSERT_LT(sparse.storedValues(), TensorSparse::ParallelValues);
+    std::atomic<int> ranges{0};
+    auto count = [&](uint32_t, uint32_t) { ranges++; };
+    TensorSparse::forBlockRowRanges(sparse, 1, count);
+    EXPECT_EQ(ranges.load(), 1);
+    ranges = 0;
+    TensorSparse::forBlockRowRanges(sparse, 1024, count);
+    EXPECT_GT(ranges.load(), 1);
+
+    auto B = TestPatterns::tensor<2>({160, 1024}, 2);
+    auto C = TensorOps::matmul(sparse, B);
+    auto expected = TensorOps::matmul(pruned(dense, 1e-3f), B);
+    for (uint64_t i = 0; i < C.Data.size(); i++) ASSERT_NEAR(C.Data[i], expected.Data[i], 1e-3f) << "at " << i;
+    TensorParallel::resetConfiguration();
+}
+
+TEST(SparseTests, UnsignedMatrices) {
+    Tensor<uint32_t, 2> dense({6, 6});
+    for (uint64_t i = 0; i < dense.Data.size(); i++) dense.Data[i] = i % 4 == 0 ? static_cast<uint32_t>(i) : 0;
+    auto sparse = SparseTensor<uint32_t>::fromDense(dense);
+    Tensor<uint32_t, 2> B({6, 3});
+    B.fillWithValues(2u);
+    auto C = TensorOps::matmul(sparse, B);
+    auto expected = TensorOps::matmul(dense, B);
+    EXPECT_EQ(C.Data, expected.Data);
+}
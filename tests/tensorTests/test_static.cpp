@@ -0,0 +1,143 @@
+#include <gtest/gtest.h>
+#include <cmath>
+#include <cstdint>
+#include "Tensor/StaticTensor.h"
+#include "Tensor/TensorOps.h"
+
+template <typename T, uint32_t... Dims>
+static StaticTensor<T, Dims...> staticPattern(uint32_t seed) {
+    StaticTensor<T, Dims...> tensor;
+    for (uint64_t i = 0; i < tensor.Data.size(); i++) {
+        tensor.Data[i] = static_cast<T>((i * 7 + seed * 3 + 1) % 11);
+    }
+    return tensor;
+}
+
+// Diagonally dominant, so always invertible
+template <uint32_t Size>
+static StaticTensor<float, Size, Size> invertiblePattern(uint32_t seed) {
+    auto A = staticPattern<float, Size, Size>(seed);
+    for (uint32_t i = 0; i < Size; i++) {
+        A(i, i) += 11.0f * Size;
+    }
+    return A;
+}
+
+template <typename T, uint32_t M, uint32_t K, uint32_t P>
+static void expectStaticMatmul() {
+    auto A = staticPattern<T, M, K>(1);
+    auto B = staticPattern<T, K, P>(2);
+    auto C = StaticOps::matmul(A, B);
+    for (uint32_t i = 0; i < M; i++) {
+        for (uint32_t j = 0; j < P; j++) {
+            T expected = 0;
+            for (uint32_t k = 0; k < K; k++) expected += A(i, k) * B(k, j);
+            ASSERT_EQ(C(i, j), expected) << M << "x" << K << "x" << P << " at " << i << " " << j;
+        }
+    }
+}
+
+template <uint32_t Size>
+static void expectInverse() {
+    auto A = invertiblePattern<Size>(Size);
+    auto product = StaticOps::matmul(A, StaticOps::inverse(A));
+    for (uint32_t i = 0; i < Size; i++) {
+        for (uint32_t j = 0; j < Size; j++) {
+            ASSERT_NEAR(product(i, j), i == j ? 1.0f : 0.0f, 1e-5f) << Size << " at " << i << " " << j;
+        }
+    }
+}
+
+TEST(StaticTensorTests, ShapeAndAccess) {
+    using Pose = StaticTensor<float, 2, 3, 4>;
+    static_assert(Pose::Rank == 3 && Pose::Size == 24);
+    static_assert(Pose::Strides[0] == 12 && Pose::Strides[1] == 4 && Pose::Strides[2] == 1);
+    static_assert(sizeof(StaticTensor<float, 4, 4>) == 16 * sizeof(float));
+    Pose pose;
+    for (float value : pose.Data) ASSERT_EQ(value, 0.0f);
+    pose(1, 2, 3) = 5.0f;
+    EXPECT_EQ(pose.Data[23], 5.0f);
+    pose.fillWithValues(2.0f);
+    EXPECT_EQ(pose(0, 1, 2), 2.0f);
+    EXPECT_DEATH({
+        pose(2, 0, 0) = 1.0f;
+    }, "Index out of bounds");
+}
+
+TEST(StaticTensorTests, AddAndSubtract) {
+    auto A = staticPattern<float, 6, 6>(1);
+    auto B = staticPattern<float, 6, 6>(2);
+    auto sum = A + B;
+    auto difference = A - B;
+    for (uint64_t i = 0; i < A.Data.size(); i++) {
+        ASSERT_EQ(sum.Data[i], A.Data[i] + B.Data[i]);
+        ASSERT_EQ(difference.Data[i], A.Data[i] - B.Data[i]);
+    }
+    auto U = staticPattern<uint16_t, 3, 3>(1);
+    auto V = staticPattern<uint16_t, 3, 3>(2);
+    EXPECT_EQ((U + V)(2, 2), U(2, 2) + V(2, 2));
+}
+
+TEST(StaticTensorTests, Matmul) {
+    expectStaticMatmul<float, 3, 3, 3>();
+    expectStaticMatmul<float, 4, 4, 4>();
+    expectStaticMatmul<float, 6, 6, 6>();
+    expectStaticMatmul<float, 3, 5, 7>();
+    expectStaticMatmul<float, 4, 4, 1>();
+    expectStaticMatmul<uint32_t, 6, 6, 6>();
+    expectStaticMatmul<uint8_t, 3, 3, 3>();
+}
+
+TEST(StaticTensorTests, Transpose) {
+    auto A = staticPattern<float, 4, 4>(1);
+    auto At = StaticOps::transpose(A);
+    auto B = staticPattern<float, 3, 5>(2);
+    auto Bt = StaticOps::transpose(B);
+    for (uint32_t i = 0; i < 4; i++)
+        for (uint32_t j = 0; j < 4; j++) ASSERT_EQ(At(j, i), A(i, j));
+    for (uint32_t i = 0; i < 3; i++)
+        for (uint32_t j = 0; j < 5; j++) ASSERT_EQ(Bt(j, i), B(i, j));
+}
+
+TEST(StaticTensorTests, Inverse) {
+    expectInverse<1>();
+    expectInverse<2>();
+    expectInverse<3>();
+    expectInverse<4>();
+    expectInverse<6>();
+    StaticTensor<float, 3, 3> rotation({0, -1, 0, 1, 0, 0, 0, 0, 1});
+    EXPECT_NEAR(StaticOps::determinant(rotation), 1.0f, 1e-6f);
+    EXPECT_NEAR(StaticOps::determinant(StaticOps::matmul(rotation, rotation)), 1.0f, 1e-6f);
+    StaticTensor<double, 5, 5> singular;
+    EXPECT_EQ(StaticOps::determinant(singular), 0.0);
+    EXPECT_DEATH({
+        StaticOps::inverse(singular);
+    }, "Matrix is singular");
+}
+
+TEST(StaticTensorTests, ViewsInteroperateWithTensor) {
+    Tensor<float, 2> tensor({3, 3});
+    for (uint64_t i = 0; i < tensor.Data.size(); i++) tensor.Data[i] = static_cast<float>(i);
+    StaticTensor<float, 3, 3> fromTensor(tensor);
+    EXPECT_EQ(fromTensor(2, 1), 7.0f);
+
+    auto back = StaticOps::transpose(fromTensor).toTensor();
+    EXPECT_EQ(back(1, 2), 7.0f);
+    auto product = TensorOps::matmul(tensor, back);
+    auto expected = StaticOps::matmul(fromTensor, StaticOps::transpose(fromTensor));
+    for (uint64_t i = 0; i < product.Data.size(); i++) ASSERT_EQ(product.Data[i], expected.Data[i]);
+
+    // Views write through to the storage they look at
+    TensorView<float, 2> view = fromTensor.view();
+    view(0, 0) = 42.0f;
+    EXPECT_EQ(fromTensor(0, 0), 42.0f);
+    TensorView<float, 2> tensorView(tensor);
+    tensorView(1, 1) = -1.0f;
+    EXPECT_EQ(tensor(1, 1), -1.0f);
+
+    using Matrix3 = StaticTensor<float, 3, 3>;
+    Tensor<float, 2> wrongShape({3, 4});
+    EXPECT_DEATH({
+        Matrix3 bad(wrongShape);
+    }, "View must have the dimensions of the StaticTensor");
+}
@@ -41,4 +41,44 @@ TEST(TensorOpsTest, SubstractOps) {
     auto C = TensorOps::substract(A, B);
     EXPECT_FLOAT_EQ(C(0,0), -1.0f);
     EXPECT_FLOAT_EQ(C(1,2), -1.0f);
-}
\ No newline at end of file
+}
+
+TEST(TensorOpsTest, UninitializedConstructorShape) {
+    std::array<uint32_t, 3> dims = {2, 3, 4};
+    Tensor<float, 3> tensor(dims, TensorUninitialized);
+    EXPECT_EQ(tensor.Data.size(), 24);
+    EXPECT_EQ(tensor.getDimensions()[2], 4);
+    tensor(1, 2, 3) = 2.5f;
+    EXPECT_FLOAT_EQ(tensor.Data[23], 2.5f);
+}
+
+TEST(TensorOpsTest, ZeroInitializedConstructor) {
+    std::array<uint32_t, 2> dims = {17, 9};
+    Tensor<uint32_t, 2> tensor(dims);
+    for (uint32_t value : tensor.Data) {
+        EXPECT_EQ(value, 0);
+    }
+}
+
+TEST(TensorOpsTest, FillOddSizeUint8) {
+    // Sizes between two vector widths must not write past the end
+    std::array<uint32_t, 1> dims = {25};
+    auto tensor = TensorOps::full<uint8_t, 1>(dims, 7);
+    EXPECT_EQ(tensor.Data.size(), 25);
+    for (uint8_t value : tensor.Data) {
+        EXPECT_EQ(value, 7);
+    }
+}
+
+TEST(TensorOpsTest, ParallelFillLargeTensor) {
+    // Large enough to be split between threads
+    std::array<uint32_t, 2> dims = {1531, 2053};
+    auto tensor = TensorOps::full<float, 2>(dims, 3.0f);
+    for (float value : tensor.Data) {
+        ASSERT_FLOAT_EQ(value, 3.0f);
+    }
+    auto zeroes = TensorOps::zeroes<uint16_t, 2>(dims);
+    for (uint16_t value : zeroes.Data) {
+        ASSERT_EQ(value, 0);
+    }
+}
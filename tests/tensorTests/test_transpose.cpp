@@ -0,0 +1,202 @@
+#include <cstdint>
+#include <gtest/gtest.h>
+#include <array>
+#include "Tensor/TensorOps.h"
+
+using TensorMatmul::Transpose;
+
+template <typename T>
+static Tensor<T, 2> patternTensor(uint32_t rows, uint32_t cols, uint32_t modulo) {
+    std::array<uint32_t, 2> dims = {rows, cols};
+    Tensor<T, 2> tensor(dims);
+    for (uint64_t i = 0; i < tensor.Data.size(); i++) {
+        tensor.Data[i] = static_cast<T>((i * 7 + 3) % modulo);
+    }
+    return tensor;
+}
+
+// Reference product using only operator(), with the same wrap-around arithmetic as T
+template <typename T>
+static Tensor<T, 2> referenceProduct(const Tensor<T, 2>& A, const Tensor<T, 2>& B, bool transA, bool transB) {
+    uint32_t M = transA ? A.getDimensions()[1] : A.getDimensions()[0];
+    uint32_t N = transA ? A.getDimensions()[0] : A.getDimensions()[1];
+    uint32_t K = transB ? B.getDimensions()[0] : B.getDimensions()[1];
+    std::array<uint32_t, 2> dims = {M, K};
+    Tensor<T, 2> result(dims);
+    for (uint32_t i = 0; i < M; i++) {
+        for (uint32_t j = 0; j < K; j++) {
+            T sum = 0;
+            for (uint32_t k = 0; k < N; k++) {
+                T a = transA ? A(k, i) : A(i, k);
+                T b = transB ? B(j, k) : B(k, j);
+                sum += static_cast<T>(a * b);
+            }
+            result(i, j) = sum;
+        }
+    }
+    return result;
+}
+
+TEST(TransposeTests, TransposeFloatOddShape) {
+    auto A = patternTensor<float>(37, 45, 101);
+    auto At = TensorOps::transpose(A);
+    EXPECT_EQ(At.getDimensions()[0], 45);
+    EXPECT_EQ(At.getDimensions()[1], 37);
+    for (uint32_t i = 0; i < 37; i++) {
+        for (uint32_t j = 0; j < 45; j++) {
+            ASSERT_FLOAT_EQ(A(i, j), At(j, i));
+        }
+    }
+}
+
+TEST(TransposeTests, TransposeUint16Tiles) {
+    auto A = patternTensor<uint16_t>(70, 66, 60000);
+    auto At = TensorOps::transpose(A);
+    for (uint32_t i = 0; i < 70; i++) {
+        for (uint32_t j = 0; j < 66; j++) {
+            ASSERT_EQ(A(i, j), At(j, i));
+        }
+    }
+}
+
+TEST(TransposeTests, TransposeUint8AndLargeUint32) {
+    auto A = patternTensor<uint8_t>(19, 41, 251);
+    auto At = TensorOps::transpose(A);
+    for (uint32_t i = 0; i < 19; i++) {
+        for (uint32_t j = 0; j < 41; j++) {
+            ASSERT_EQ(A(i, j), At(j, i));
+        }
+    }
+    // Large enough to be split between threads
+    auto B = patternTensor<uint32_t>(1031, 517, 100000);
+    auto Bt = TensorOps::transpose(B);
+    for (uint32_t i = 0; i < 1031; i += 7) {
+        for (uint32_t j = 0; j < 517; j++) {
+            ASSERT_EQ(B(i, j), Bt(j, i));
+        }
+    }
+}
+
+TEST(TransposeTests, MatmulTransposedOperandsFloat) {
+    // Inner dimension above KC so partial products are accumulated across blocks
+    auto A = patternTensor<float>(37, 300, 13);
+    auto Bt = patternTensor<float>(29, 300, 11);
+    auto C = TensorOps::matmul(A, Bt, Transpose::No, Transpose::Yes);
+    auto expected = referenceProduct(A, Bt, false, true);
+    ASSERT_EQ(C.getDimensions()[0], 37);
+    ASSERT_EQ(C.getDimensions()[1], 29);
+    for (uint64_t i = 0; i < C.Data.size(); i++) {
+        ASSERT_FLOAT_EQ(C.Data[i], expected.Data[i]);
+    }
+
+    auto At = patternTensor<float>(300, 37, 13);
+    auto B = patternTensor<float>(300, 21, 5);
+    auto D = TensorMatmul::matmul2d(At, B, Transpose::Yes, Transpose::No);
+    auto expectedD = referenceProduct(At, B, true, false);
+    for (uint64_t i = 0; i < D.Data.size(); i++) {
+        ASSERT_FLOAT_EQ(D.Data[i], expectedD.Data[i]);
+    }
+}
+
+TEST(TransposeTests, MatmulBothTransposedIntegers) {
+    auto A32 = patternTensor<uint32_t>(45, 23, 1000);
+    auto B32 = patternTensor<uint32_t>(31, 45, 1000);
+    auto C32 = TensorMatmul::matmul2d(A32, B32, Transpose::Yes, Transpose::Yes);
+    EXPECT_EQ(C32.Data, referenceProduct(A32, B32, true, true).Data);
+
+    auto A16 = patternTensor<uint16_t>(19, 40, 100);
+    auto B16 = patternTensor<uint16_t>(35, 40, 100);
+    auto C16 = TensorMatmul::matmul2d(A16, B16, Transpose::No, Transpose::Yes);
+    EXPECT_EQ(C16.Data, referenceProduct(A16, B16, false, true).Data);
+
+    auto A8 = patternTensor<uint8_t>(40, 9, 7);
+    auto B8 = patternTensor<uint8_t>(40, 50, 7);
+    auto C8 = TensorMatmul::matmul2d(A8, B8, Transpose::Yes, Transpose::No);
+    EXPECT_EQ(C8.Data, referenceProduct(A8, B8, true, false).Data);
+}
+
+TEST(TransposeTests, MatmulTransposedLargeThreaded) {
+    auto A = patternTensor<float>(300, 200, 7);
+    auto Bt = patternTensor<float>(600, 200, 5);
+    auto C = TensorMatmul::matmul2d(A, Bt, Transpose::No, Transpose::Yes);
+    auto expected = referenceProduct(A, Bt, false, true);
+    for (uint64_t i = 0; i < C.Data.size(); i++) {
+        ASSERT_FLOAT_EQ(C.Data[i], expected.Data[i]);
+    }
+}
+
+TEST(TransposeTests, MatmulTransposedWrongDimensions) {
+    auto A = patternTensor<float>(3, 4, 5);
+    auto B = patternTensor<float>(3, 4, 5);
+    EXPECT_DEATH({
+        TensorMatmul::matmul2d(A, B, Transpose::Yes, Transpose::Yes);
+    }, "need to have shapes");
+}
+
+// Reference permute through operator(), element by element
+template <typename T, uint16_t N>
+static void expectPermuted(const Tensor<T, N>& A, const Tensor<T, N>& P, const std::array<uint16_t, N>& axes) {
+    for (TensorIndex<N> index(P.getDimensions()); !index.done(); index.next()) {
+        std::array<uint32_t, N> source;
+        for (uint16_t i = 0; i < N; i++) source[axes[i]] = index.index()[i];
+        uint64_t offset = 0;
+        for (uint16_t i = 0; i < N; i++) offset += static_cast<uint64_t>(source[i]) * A.getStrides()[i];
+        ASSERT_EQ(P.Data[index.offset()], A.Data[offset]) << "at " << index.offset();
+    }
+}
+
+TEST(TransposeTests, PermuteNHWCToNCHW) {
+    std::array<uint32_t, 4> dims = {2, 37, 45, 3};
+    Tensor<float, 4> frames(dims);
+    for (uint64_t i = 0; i < frames.Data.size(); i++) frames.Data[i] = static_cast<float>(i);
+    auto nchw = TensorOps::permute(frames, {0, 3, 1, 2});
+    EXPECT_EQ(nchw.getDimensions(), (std::array<uint32_t, 4>{2, 3, 37, 45}));
+    expectPermuted(frames, nchw, {0, 3, 1, 2});
+    // And back
+    auto nhwc = TensorOps::permute(nchw, {0, 2, 3, 1});
+    EXPECT_EQ(nhwc.Data, frames.Data);
+}
+
+TEST(TransposeTests, PermuteRunsAndSizeOneAxes) {
+    std::array<uint32_t, 5> dims = {3, 1, 5, 7, 11};
+    Tensor<uint8_t, 5> A(dims);
+    for (uint64_t i = 0; i < A.Data.size(); i++) A.Data[i] = static_cast<uint8_t>(i * 13);
+    // Innermost axis stays in place: contiguous runs
+    expectPermuted(A, TensorOps::permute(A, {2, 1, 0, 3, 4}), {2, 1, 0, 3, 4});
+    // Innermost axis moves: blocked transposes
+    expectPermuted(A, TensorOps::permute(A, {4, 2, 1, 3, 0}), {4, 2, 1, 3, 0});
+    expectPermuted(A, TensorOps::permute(A, {3, 4, 0, 1, 2}), {3, 4, 0, 1, 2});
+    // Identity is one copy
+    EXPECT_EQ(TensorOps::permute(A, {0, 1, 2, 3, 4}).Data, A.Data);
+}
+
+TEST(TransposeTests, PermuteLargeMatchesTranspose) {
+    auto A = patternTensor<uint32_t>(1029, 517, 1000);
+    auto P = TensorOps::permute(A, {1, 0});
+    EXPECT_EQ(P.Data, TensorOps::transpose(A).Data);
+
+    using Axes = std::array<uint16_t, 2>;
+    EXPECT_DEATH({ TensorOps::permute(A, Axes{1, 1}); }, "Axes must be a permutation");
+}
+
+TEST(TransposeTests, ReshapeWithoutCopy) {
+    std::array<uint32_t, 3> dims = {4, 6, 5};
+    Tensor<float, 3> A(dims);
+    for (uint64_t i = 0; i < A.Data.size(); i++) A.Data[i] = static_cast<float>(i);
+    const float* storage = A.Data.data();
+
+    auto copy = TensorOps::reshape<2>(A, {24, 5});
+    EXPECT_EQ(copy.Data, A.Data);
+    EXPECT_FLOAT_EQ(copy(7, 3), A(1, 1, 3));
+
+    auto moved = TensorOps::reshape<2>(std::move(A), {4, 30});
+    EXPECT_EQ(moved.Data.data(), storage);
+    EXPECT_FLOAT_EQ(moved(2, 29), 89.0f);
+
+    auto view = TensorOps::reshape<1>(TensorView<float, 2>(moved), {120});
+    EXPECT_EQ(view.data(), storage);
+    EXPECT_FLOAT_EQ(view(61), 61.0f);
+
+    Tensor<float, 1> line({120});
+    EXPECT_DEATH({ TensorOps::reshape<2>(std::move(line), {7, 17}); }, "Data must hold every element");
+}